@@ -0,0 +1,156 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "cutil/btree.h"
+#include "thread_private.h"
+
+#include "test_util/thread.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+/*
+Measures lookup throughput of a btree shared between reader threads.
+The concurrent btree is compared against a regular btree guarded by a single global lock.
+Usage: cutil_bench_btree_concurrent [max_thread_count] [key_count] [lookups_per_thread]
+*/
+
+#define BENCH_MAX_THREADS 64
+#define BENCH_BTREE_ORDER 32
+
+typedef struct {
+    cutil_btree* btree;
+    _rwlock* global_lock;
+    int key_count;
+    int lookup_count;
+    unsigned int seed;
+    int found_count;
+} bench_worker;
+
+static double bench_time_seconds() {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+#endif
+}
+
+static unsigned int bench_next_random(unsigned int* seed) {
+    *seed = *seed * 1103515245U + 12345U;
+    return (*seed >> 8);
+}
+
+static void bench_lookup_worker(void* arg) {
+    bench_worker* worker = (bench_worker*)arg;
+    int i, key, value;
+
+    for (i = 0; i < worker->lookup_count; i++) {
+        key = (int)(bench_next_random(&worker->seed) % (unsigned int)worker->key_count);
+
+        if (worker->global_lock) {
+            rwlock_write_lock_func(worker->global_lock);
+            worker->found_count += cutil_btree_get(worker->btree, &key, &value);
+            rwlock_write_unlock_func(worker->global_lock);
+        }
+        else {
+            worker->found_count += cutil_btree_get(worker->btree, &key, &value);
+        }
+    }
+}
+
+static double bench_run(cutil_btree* btree, _rwlock* global_lock, int thread_count, int key_count, int lookup_count) {
+    cutil_test_thread* threads[BENCH_MAX_THREADS];
+    bench_worker workers[BENCH_MAX_THREADS];
+    double start_time, elapsed_time;
+    int i;
+
+    for (i = 0; i < thread_count; i++) {
+        workers[i].btree = btree;
+        workers[i].global_lock = global_lock;
+        workers[i].key_count = key_count;
+        workers[i].lookup_count = lookup_count;
+        workers[i].seed = 7919U * (unsigned int)(i + 1);
+        workers[i].found_count = 0;
+    }
+
+    start_time = bench_time_seconds();
+
+    for (i = 0; i < thread_count; i++) {
+        threads[i] = cutil_test_thread_create(bench_lookup_worker, &workers[i]);
+    }
+
+    for (i = 0; i < thread_count; i++) {
+        cutil_test_thread_join(threads[i]);
+    }
+
+    elapsed_time = bench_time_seconds() - start_time;
+
+    for (i = 0; i < thread_count; i++) {
+        if (workers[i].found_count != lookup_count) {
+            fprintf(stderr, "thread %d found %d of %d keys\n", i, workers[i].found_count, lookup_count);
+        }
+    }
+
+    return (double)thread_count * (double)lookup_count / elapsed_time;
+}
+
+static void bench_fill(cutil_btree* btree, int key_count) {
+    int i;
+
+    for (i = 0; i < key_count; i++) {
+        cutil_btree_insert(btree, &i, &i);
+    }
+}
+
+int main(int argc, char** argv) {
+    int max_thread_count = argc > 1 ? atoi(argv[1]) : 8;
+    int key_count = argc > 2 ? atoi(argv[2]) : 1000000;
+    int lookup_count = argc > 3 ? atoi(argv[3]) : 1000000;
+    cutil_btree *locked_btree, *concurrent_btree;
+    _rwlock global_lock;
+    int thread_count;
+
+    if (max_thread_count < 1 || max_thread_count > BENCH_MAX_THREADS || key_count < 1 || lookup_count < 1) {
+        fprintf(stderr, "usage: %s [max_thread_count (1-%d)] [key_count] [lookups_per_thread]\n", argv[0], BENCH_MAX_THREADS);
+        return 1;
+    }
+
+    locked_btree = cutil_btree_create(BENCH_BTREE_ORDER, cutil_trait_int(), cutil_trait_int());
+    concurrent_btree = cutil_btree_create_concurrent(BENCH_BTREE_ORDER, cutil_trait_int(), cutil_trait_int());
+    rwlock_init_func(&global_lock);
+
+    bench_fill(locked_btree, key_count);
+    bench_fill(concurrent_btree, key_count);
+
+    printf("keys: %d, lookups per thread: %d\n", key_count, lookup_count);
+    printf("%8s %20s %20s\n", "threads", "global lock (op/s)", "concurrent (op/s)");
+
+    for (thread_count = 1; thread_count <= max_thread_count; thread_count *= 2) {
+        double locked_throughput = bench_run(locked_btree, &global_lock, thread_count, key_count, lookup_count);
+        double concurrent_throughput = bench_run(concurrent_btree, NULL, thread_count, key_count, lookup_count);
+
+        printf("%8d %20.0f %20.0f\n", thread_count, locked_throughput, concurrent_throughput);
+    }
+
+    rwlock_destroy_func(&global_lock);
+    cutil_btree_destroy(concurrent_btree);
+    cutil_btree_destroy(locked_btree);
+
+    return 0;
+}
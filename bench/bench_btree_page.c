@@ -0,0 +1,112 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "cutil/btree.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+/*
+Measures insert and lookup throughput of btrees created with cutil_btree_create_for_page for a range of page sizes and value sizes.
+Keys are inserted in a random order and looked up in a different random order so that most descents miss the cache.
+Usage: cutil_bench_btree_page [item_count] [lookup_count]
+*/
+
+#define BENCH_PAGE_SIZE_COUNT 5
+#define BENCH_VALUE_SIZE_COUNT 3
+#define BENCH_MAX_VALUE_SIZE 128
+
+static double bench_time_seconds() {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+#endif
+}
+
+static unsigned int bench_next_random(unsigned int* seed) {
+    *seed = *seed * 1103515245U + 12345U;
+    return (*seed >> 8);
+}
+
+static void bench_run(size_t page_bytes, cutil_trait* value_trait, int item_count, int lookup_count) {
+    cutil_btree* btree = cutil_btree_create_for_page(page_bytes, cutil_trait_int(), value_trait);
+    unsigned char value[BENCH_MAX_VALUE_SIZE];
+    unsigned int seed = 7919U;
+    double start_time, insert_time, lookup_time;
+    int i, key, found = 0;
+
+    if (!btree) {
+        printf("%8lu %8lu %8s\n", (unsigned long)page_bytes, (unsigned long)value_trait->size, "-");
+        return;
+    }
+
+    memset(value, 0, sizeof(value));
+    start_time = bench_time_seconds();
+
+    for (i = 0; i < item_count; i++) {
+        key = (int)(bench_next_random(&seed) % (unsigned int)item_count);
+        cutil_btree_insert(btree, &key, value);
+    }
+
+    insert_time = bench_time_seconds() - start_time;
+    start_time = bench_time_seconds();
+
+    for (i = 0; i < lookup_count; i++) {
+        key = (int)(bench_next_random(&seed) % (unsigned int)item_count);
+        found += cutil_btree_get(btree, &key, value);
+    }
+
+    lookup_time = bench_time_seconds() - start_time;
+
+    printf("%8lu %8lu %8u %16.0f %16.0f %8d\n", (unsigned long)page_bytes, (unsigned long)value_trait->size, cutil_btree_get_order(btree),
+        (double)item_count / insert_time, (double)lookup_count / lookup_time, found);
+
+    cutil_btree_destroy(btree);
+}
+
+int main(int argc, char** argv) {
+    size_t page_sizes[BENCH_PAGE_SIZE_COUNT] = {256, 512, 1024, 4096, 16384};
+    size_t value_sizes[BENCH_VALUE_SIZE_COUNT] = {sizeof(int), 32, BENCH_MAX_VALUE_SIZE};
+    int item_count = argc > 1 ? atoi(argv[1]) : 1000000;
+    int lookup_count = argc > 2 ? atoi(argv[2]) : 2000000;
+    cutil_trait value_trait;
+    int i, j;
+
+    if (item_count < 1 || lookup_count < 1) {
+        fprintf(stderr, "usage: %s [item_count] [lookup_count]\n", argv[0]);
+        return 1;
+    }
+
+    memset(&value_trait, 0, sizeof(cutil_trait));
+
+    printf("items: %d, lookups: %d\n", item_count, lookup_count);
+    printf("%8s %8s %8s %16s %16s %8s\n", "page", "value", "order", "insert (op/s)", "lookup (op/s)", "found");
+
+    for (i = 0; i < BENCH_VALUE_SIZE_COUNT; i++) {
+        value_trait.size = value_sizes[i];
+
+        for (j = 0; j < BENCH_PAGE_SIZE_COUNT; j++) {
+            bench_run(page_sizes[j], &value_trait, item_count, lookup_count);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,119 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "cutil/btree.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+/*
+Measures the throughput of mixed insert and erase streams with eager and relaxed rebalancing.
+Each stream erases a batch of random keys and inserts them again, which causes eager rebalancing to repeatedly merge and split the same nodes.
+Relaxed btrees are flushed after every flush_interval batches, or only at the end of the stream if it is zero.
+Usage: cutil_bench_btree_rebalance [key_count] [operation_count] [batch_size] [flush_interval]
+*/
+
+#define BENCH_ORDER_COUNT 3
+
+static double bench_time_seconds() {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+#endif
+}
+
+static unsigned int bench_next_random(unsigned int* seed) {
+    *seed = *seed * 1103515245U + 12345U;
+    return (*seed >> 8);
+}
+
+static double bench_run(unsigned int order, int relaxed, int key_count, int operation_count, int batch_size, int flush_interval, int* batch_keys) {
+    cutil_btree* btree = cutil_btree_create(order, cutil_trait_int(), cutil_trait_int());
+    unsigned int seed = 7919U;
+    double start_time, elapsed_time;
+    int i, j, batch_count = 0;
+
+    cutil_btree_set_relaxed_rebalance(btree, relaxed);
+
+    for (i = 0; i < key_count; i++) {
+        cutil_btree_insert(btree, &i, &i);
+    }
+
+    start_time = bench_time_seconds();
+
+    for (i = 0; i < operation_count; i += batch_size * 2) {
+        for (j = 0; j < batch_size; j++) {
+            batch_keys[j] = (int)(bench_next_random(&seed) % (unsigned int)key_count);
+            cutil_btree_erase(btree, &batch_keys[j]);
+        }
+
+        for (j = 0; j < batch_size; j++) {
+            cutil_btree_insert(btree, &batch_keys[j], &batch_keys[j]);
+        }
+
+        if (flush_interval > 0 && ++batch_count % flush_interval == 0) {
+            cutil_btree_flush_rebalance(btree);
+        }
+    }
+
+    /* relaxed btrees are flushed once at the end of the stream so that both modes finish balanced */
+    cutil_btree_flush_rebalance(btree);
+
+    elapsed_time = bench_time_seconds() - start_time;
+
+    if (cutil_btree_size(btree) != (size_t)key_count) {
+        fprintf(stderr, "order %u: expected %d items but found %lu\n", order, key_count, (unsigned long)cutil_btree_size(btree));
+    }
+
+    cutil_btree_destroy(btree);
+
+    return (double)operation_count / elapsed_time;
+}
+
+int main(int argc, char** argv) {
+    unsigned int orders[BENCH_ORDER_COUNT] = {4, 16, 64};
+    int key_count = argc > 1 ? atoi(argv[1]) : 100000;
+    int operation_count = argc > 2 ? atoi(argv[2]) : 2000000;
+    int batch_size = argc > 3 ? atoi(argv[3]) : 64;
+    int flush_interval = argc > 4 ? atoi(argv[4]) : 0;
+    int* batch_keys;
+    int i;
+
+    if (key_count < 1 || operation_count < 1 || batch_size < 1 || flush_interval < 0) {
+        fprintf(stderr, "usage: %s [key_count] [operation_count] [batch_size] [flush_interval]\n", argv[0]);
+        return 1;
+    }
+
+    batch_keys = malloc(batch_size * sizeof(int));
+
+    printf("keys: %d, operations: %d, batch size: %d, flush interval: %d\n", key_count, operation_count, batch_size, flush_interval);
+    printf("%8s %20s %20s\n", "order", "eager (op/s)", "relaxed (op/s)");
+
+    for (i = 0; i < BENCH_ORDER_COUNT; i++) {
+        double eager_throughput = bench_run(orders[i], 0, key_count, operation_count, batch_size, flush_interval, batch_keys);
+        double relaxed_throughput = bench_run(orders[i], 1, key_count, operation_count, batch_size, flush_interval, batch_keys);
+
+        printf("%8u %20.0f %20.0f\n", orders[i], eager_throughput, relaxed_throughput);
+    }
+
+    free(batch_keys);
+
+    return 0;
+}
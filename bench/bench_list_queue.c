@@ -0,0 +1,103 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "cutil/list.h"
+#include "cutil/forward_list.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+/*
+Measures the throughput of lists used as queues, with and without a node cache.
+Each operation pops an item from the front of a queue holding a fixed number of items and pushes a new item to its back.
+Usage: cutil_bench_list_queue [queue_length] [operation_count]
+*/
+
+static double bench_time_seconds() {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+#endif
+}
+
+static double bench_list(unsigned int cache_capacity, int queue_length, int operation_count) {
+    cutil_list* list = cutil_list_create(cutil_trait_int());
+    double start_time, elapsed_time;
+    int i;
+
+    cutil_list_set_node_cache_capacity(list, cache_capacity);
+
+    for (i = 0; i < queue_length; i++) {
+        cutil_list_push_back(list, &i);
+    }
+
+    start_time = bench_time_seconds();
+
+    for (i = 0; i < operation_count; i++) {
+        cutil_list_pop_front(list);
+        cutil_list_push_back(list, &i);
+    }
+
+    elapsed_time = bench_time_seconds() - start_time;
+    cutil_list_destroy(list);
+
+    return (double)operation_count / elapsed_time;
+}
+
+static double bench_forward_list(unsigned int cache_capacity, int queue_length, int operation_count) {
+    cutil_forward_list* list = cutil_forward_list_create(cutil_trait_int());
+    double start_time, elapsed_time;
+    int i;
+
+    cutil_forward_list_set_node_cache_capacity(list, cache_capacity);
+
+    for (i = 0; i < queue_length; i++) {
+        cutil_forward_list_push_back(list, &i);
+    }
+
+    start_time = bench_time_seconds();
+
+    for (i = 0; i < operation_count; i++) {
+        cutil_forward_list_pop_front(list);
+        cutil_forward_list_push_back(list, &i);
+    }
+
+    elapsed_time = bench_time_seconds() - start_time;
+    cutil_forward_list_destroy(list);
+
+    return (double)operation_count / elapsed_time;
+}
+
+int main(int argc, char** argv) {
+    int queue_length = argc > 1 ? atoi(argv[1]) : 1000;
+    int operation_count = argc > 2 ? atoi(argv[2]) : 10000000;
+
+    if (queue_length < 1 || operation_count < 1) {
+        fprintf(stderr, "usage: %s [queue_length] [operation_count]\n", argv[0]);
+        return 1;
+    }
+
+    printf("queue length: %d, operations: %d\n", queue_length, operation_count);
+    printf("%16s %20s %20s\n", "container", "no cache (op/s)", "cache (op/s)");
+    printf("%16s %20.0f %20.0f\n", "list", bench_list(0, queue_length, operation_count), bench_list(64, queue_length, operation_count));
+    printf("%16s %20.0f %20.0f\n", "forward_list", bench_forward_list(0, queue_length, operation_count), bench_forward_list(64, queue_length, operation_count));
+
+    return 0;
+}
@@ -0,0 +1,180 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "cutil/mpsc_queue.h"
+#include "cutil/forward_list.h"
+#include "thread_private.h"
+
+#include "test_util/thread.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+/*
+Measures the throughput of passing items from producer threads to a single consumer thread.
+The lock free mpsc queue is compared against a forward list guarded by a single global lock.
+Usage: cutil_bench_mpsc_queue [max_producer_count] [items_per_producer]
+*/
+
+#define BENCH_MAX_THREADS 64
+#define BENCH_BATCH_SIZE 64
+
+typedef struct {
+    cutil_mpsc_queue* queue;
+    cutil_mpsc_queue_node* nodes;
+    cutil_forward_list* list;
+    _rwlock* global_lock;
+    int item_count;
+} bench_producer;
+
+static double bench_time_seconds() {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+#endif
+}
+
+static void bench_queue_producer(void* arg) {
+    bench_producer* producer = (bench_producer*)arg;
+    int i;
+
+    for (i = 0; i < producer->item_count; i++) {
+        cutil_mpsc_queue_push(producer->queue, &producer->nodes[i]);
+    }
+}
+
+static void bench_list_producer(void* arg) {
+    bench_producer* producer = (bench_producer*)arg;
+    void* item;
+    int i;
+
+    for (i = 0; i < producer->item_count; i++) {
+        item = &producer->nodes[i];
+
+        rwlock_write_lock_func(producer->global_lock);
+        cutil_forward_list_push_back(producer->list, &item);
+        rwlock_write_unlock_func(producer->global_lock);
+    }
+}
+
+static double bench_queue(int producer_count, int item_count, cutil_mpsc_queue_node* nodes) {
+    cutil_test_thread* threads[BENCH_MAX_THREADS];
+    bench_producer producers[BENCH_MAX_THREADS];
+    cutil_mpsc_queue_node* batch[BENCH_BATCH_SIZE];
+    cutil_mpsc_queue* queue = cutil_mpsc_queue_create();
+    int total_count = producer_count * item_count, received = 0;
+    double start_time, elapsed_time;
+    int i;
+
+    start_time = bench_time_seconds();
+
+    for (i = 0; i < producer_count; i++) {
+        producers[i].queue = queue;
+        producers[i].nodes = nodes + i * item_count;
+        producers[i].item_count = item_count;
+        threads[i] = cutil_test_thread_create(bench_queue_producer, &producers[i]);
+    }
+
+    while (received < total_count) {
+        received += (int)cutil_mpsc_queue_pop_batch(queue, batch, BENCH_BATCH_SIZE);
+    }
+
+    elapsed_time = bench_time_seconds() - start_time;
+
+    for (i = 0; i < producer_count; i++) {
+        cutil_test_thread_join(threads[i]);
+    }
+
+    cutil_mpsc_queue_destroy(queue);
+
+    return (double)total_count / elapsed_time;
+}
+
+static double bench_list(int producer_count, int item_count, cutil_mpsc_queue_node* nodes) {
+    cutil_test_thread* threads[BENCH_MAX_THREADS];
+    bench_producer producers[BENCH_MAX_THREADS];
+    cutil_forward_list* list = cutil_forward_list_create(cutil_trait_ptr());
+    int total_count = producer_count * item_count, received = 0;
+    double start_time, elapsed_time;
+    _rwlock global_lock;
+    void* item;
+    int i;
+
+    rwlock_init_func(&global_lock);
+    start_time = bench_time_seconds();
+
+    for (i = 0; i < producer_count; i++) {
+        producers[i].list = list;
+        producers[i].global_lock = &global_lock;
+        producers[i].nodes = nodes + i * item_count;
+        producers[i].item_count = item_count;
+        threads[i] = cutil_test_thread_create(bench_list_producer, &producers[i]);
+    }
+
+    while (received < total_count) {
+        rwlock_write_lock_func(&global_lock);
+
+        for (i = 0; i < BENCH_BATCH_SIZE && cutil_forward_list_front(list, &item); i++) {
+            cutil_forward_list_pop_front(list);
+            received += 1;
+        }
+
+        rwlock_write_unlock_func(&global_lock);
+    }
+
+    elapsed_time = bench_time_seconds() - start_time;
+
+    for (i = 0; i < producer_count; i++) {
+        cutil_test_thread_join(threads[i]);
+    }
+
+    rwlock_destroy_func(&global_lock);
+    cutil_forward_list_destroy(list);
+
+    return (double)total_count / elapsed_time;
+}
+
+int main(int argc, char** argv) {
+    int max_producer_count = argc > 1 ? atoi(argv[1]) : 8;
+    int item_count = argc > 2 ? atoi(argv[2]) : 1000000;
+    cutil_mpsc_queue_node* nodes;
+    int producer_count;
+
+    if (max_producer_count < 1 || max_producer_count > BENCH_MAX_THREADS || item_count < 1) {
+        fprintf(stderr, "usage: %s [max_producer_count] [items_per_producer]\n", argv[0]);
+        return 1;
+    }
+
+    nodes = malloc(sizeof(cutil_mpsc_queue_node) * max_producer_count * item_count);
+
+    printf("items per producer: %d\n", item_count);
+    printf("%10s %20s %20s\n", "producers", "mpsc queue (op/s)", "locked list (op/s)");
+
+    for (producer_count = 1; producer_count <= max_producer_count; producer_count *= 2) {
+        double queue_throughput = bench_queue(producer_count, item_count, nodes);
+        double list_throughput = bench_list(producer_count, item_count, nodes);
+
+        printf("%10d %20.0f %20.0f\n", producer_count, queue_throughput, list_throughput);
+    }
+
+    free(nodes);
+
+    return 0;
+}
@@ -0,0 +1,204 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "cutil/ring.h"
+#include "cutil/forward_list.h"
+#include "thread_private.h"
+
+#include "test_util/thread.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+/*
+Measures the throughput of passing items from producer threads to consumer threads.
+Rings are measured pushing and popping single items and batches, and are compared against a forward list guarded by a single global lock.
+Usage: cutil_bench_ring [max_thread_pairs] [items_per_producer]
+*/
+
+#define BENCH_MAX_THREADS 64
+#define BENCH_BATCH_SIZE 64
+#define BENCH_RING_CAPACITY 1024
+
+typedef struct {
+    cutil_ring* ring;
+    cutil_forward_list* list;
+    _rwlock* global_lock;
+    int item_count;
+    size_t batch_size;
+} bench_worker;
+
+static double bench_time_seconds() {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+#endif
+}
+
+static void bench_ring_producer(void* arg) {
+    bench_worker* worker = (bench_worker*)arg;
+    int items[BENCH_BATCH_SIZE];
+    int i = 0;
+    size_t j;
+
+    for (j = 0; j < BENCH_BATCH_SIZE; j++) {
+        items[j] = (int)j;
+    }
+
+    while (i < worker->item_count) {
+        size_t count = worker->batch_size;
+
+        if ((size_t)(worker->item_count - i) < count) {
+            count = (size_t)(worker->item_count - i);
+        }
+
+        count = cutil_ring_push_batch(worker->ring, items, count);
+
+        if (count == 0) {
+            cutil_test_thread_yield();
+        }
+
+        i += (int)count;
+    }
+}
+
+static void bench_ring_consumer(void* arg) {
+    bench_worker* worker = (bench_worker*)arg;
+    int items[BENCH_BATCH_SIZE];
+    int received = 0;
+
+    while (received < worker->item_count) {
+        size_t count = worker->batch_size;
+
+        if ((size_t)(worker->item_count - received) < count) {
+            count = (size_t)(worker->item_count - received);
+        }
+
+        count = cutil_ring_pop_batch(worker->ring, items, count);
+
+        if (count == 0) {
+            cutil_test_thread_yield();
+        }
+
+        received += (int)count;
+    }
+}
+
+static void bench_list_producer(void* arg) {
+    bench_worker* worker = (bench_worker*)arg;
+    int i;
+
+    for (i = 0; i < worker->item_count; i++) {
+        rwlock_write_lock_func(worker->global_lock);
+        cutil_forward_list_push_back(worker->list, &i);
+        rwlock_write_unlock_func(worker->global_lock);
+    }
+}
+
+static void bench_list_consumer(void* arg) {
+    bench_worker* worker = (bench_worker*)arg;
+    int received = 0;
+
+    while (received < worker->item_count) {
+        rwlock_write_lock_func(worker->global_lock);
+        received += cutil_forward_list_pop_front(worker->list);
+        rwlock_write_unlock_func(worker->global_lock);
+    }
+}
+
+/* Runs thread_pairs producers and consumers over the supplied worker template, returning items passed per second. */
+static double bench_run(bench_worker* worker, int thread_pairs, cutil_test_thread_func producer_func, cutil_test_thread_func consumer_func) {
+    cutil_test_thread* threads[BENCH_MAX_THREADS * 2];
+    double start_time, elapsed_time;
+    int i;
+
+    start_time = bench_time_seconds();
+
+    for (i = 0; i < thread_pairs; i++) {
+        threads[i * 2] = cutil_test_thread_create(producer_func, worker);
+        threads[i * 2 + 1] = cutil_test_thread_create(consumer_func, worker);
+    }
+
+    for (i = 0; i < thread_pairs * 2; i++) {
+        cutil_test_thread_join(threads[i]);
+    }
+
+    elapsed_time = bench_time_seconds() - start_time;
+
+    return (double)thread_pairs * worker->item_count / elapsed_time;
+}
+
+static double bench_ring(int mpmc, int thread_pairs, int item_count, size_t batch_size) {
+    bench_worker worker;
+    double throughput;
+
+    worker.ring = mpmc ? cutil_ring_create_mpmc(cutil_trait_int(), BENCH_RING_CAPACITY) : cutil_ring_create(cutil_trait_int(), BENCH_RING_CAPACITY);
+    worker.item_count = item_count;
+    worker.batch_size = batch_size;
+
+    throughput = bench_run(&worker, thread_pairs, bench_ring_producer, bench_ring_consumer);
+
+    cutil_ring_destroy(worker.ring);
+
+    return throughput;
+}
+
+static double bench_list(int thread_pairs, int item_count) {
+    bench_worker worker;
+    _rwlock global_lock;
+    double throughput;
+
+    rwlock_init_func(&global_lock);
+    worker.list = cutil_forward_list_create(cutil_trait_int());
+    worker.global_lock = &global_lock;
+    worker.item_count = item_count;
+
+    throughput = bench_run(&worker, thread_pairs, bench_list_producer, bench_list_consumer);
+
+    cutil_forward_list_destroy(worker.list);
+    rwlock_destroy_func(&global_lock);
+
+    return throughput;
+}
+
+int main(int argc, char** argv) {
+    int max_thread_pairs = argc > 1 ? atoi(argv[1]) : 4;
+    int item_count = argc > 2 ? atoi(argv[2]) : 1000000;
+    int thread_pairs;
+
+    if (max_thread_pairs < 1 || max_thread_pairs > BENCH_MAX_THREADS || item_count < 1) {
+        fprintf(stderr, "usage: %s [max_thread_pairs] [items_per_producer]\n", argv[0]);
+        return 1;
+    }
+
+    printf("items per producer: %d, ring capacity: %d, batch size: %d\n", item_count, BENCH_RING_CAPACITY, BENCH_BATCH_SIZE);
+    printf("spsc ring (op/s): %.0f single, %.0f batch\n", bench_ring(0, 1, item_count, 1), bench_ring(0, 1, item_count, BENCH_BATCH_SIZE));
+    printf("%12s %20s %20s %20s\n", "thread pairs", "mpmc single (op/s)", "mpmc batch (op/s)", "locked list (op/s)");
+
+    for (thread_pairs = 1; thread_pairs <= max_thread_pairs; thread_pairs *= 2) {
+        double single_throughput = bench_ring(1, thread_pairs, item_count, 1);
+        double batch_throughput = bench_ring(1, thread_pairs, item_count, BENCH_BATCH_SIZE);
+        double list_throughput = bench_list(thread_pairs, item_count);
+
+        printf("%12d %20.0f %20.0f %20.0f\n", thread_pairs, single_throughput, batch_throughput, list_throughput);
+    }
+
+    return 0;
+}
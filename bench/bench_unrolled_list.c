@@ -0,0 +1,129 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "cutil/list.h"
+#include "cutil/unrolled_list.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+/*
+Compares cutil_list with cutil_unrolled_list for lists of ints.
+Each list is filled with push_back, scanned with foreach and with an iterator, and then emptied with pop_front.
+Usage: cutil_bench_unrolled_list [item_count]
+*/
+
+static double bench_time_seconds() {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+#endif
+}
+
+static int bench_sum(void* item, void* user_data) {
+    *(unsigned long*)user_data += (unsigned long)*(int*)item;
+    return 1;
+}
+
+static void bench_print(const char* name, int item_count, double* times, unsigned long sum) {
+    printf("%16s %16.0f %16.0f %16.0f %16.0f %16lu\n", name,
+        (double)item_count / times[0], (double)item_count / times[1], (double)item_count / times[2], (double)item_count / times[3], sum);
+}
+
+static void bench_list(int item_count) {
+    cutil_list* list = cutil_list_create(cutil_trait_int());
+    cutil_list_itr itr;
+    double times[4], start_time;
+    unsigned long sum = 0;
+    int i, value;
+
+    start_time = bench_time_seconds();
+    for (i = 0; i < item_count; i++) {
+        cutil_list_push_back(list, &i);
+    }
+    times[0] = bench_time_seconds() - start_time;
+
+    start_time = bench_time_seconds();
+    cutil_list_foreach(list, bench_sum, &sum);
+    times[1] = bench_time_seconds() - start_time;
+
+    start_time = bench_time_seconds();
+    cutil_list_itr_init(&itr, list);
+    while (cutil_list_itr_next(&itr, &value)) {
+        sum += (unsigned long)value;
+    }
+    times[2] = bench_time_seconds() - start_time;
+
+    start_time = bench_time_seconds();
+    while (cutil_list_pop_front(list));
+    times[3] = bench_time_seconds() - start_time;
+
+    bench_print("list", item_count, times, sum);
+    cutil_list_destroy(list);
+}
+
+static void bench_unrolled_list(int item_count) {
+    cutil_unrolled_list* list = cutil_unrolled_list_create(cutil_trait_int());
+    cutil_unrolled_list_itr itr;
+    double times[4], start_time;
+    unsigned long sum = 0;
+    int i, value;
+
+    start_time = bench_time_seconds();
+    for (i = 0; i < item_count; i++) {
+        cutil_unrolled_list_push_back(list, &i);
+    }
+    times[0] = bench_time_seconds() - start_time;
+
+    start_time = bench_time_seconds();
+    cutil_unrolled_list_foreach(list, bench_sum, &sum);
+    times[1] = bench_time_seconds() - start_time;
+
+    start_time = bench_time_seconds();
+    cutil_unrolled_list_itr_init(&itr, list);
+    while (cutil_unrolled_list_itr_next(&itr, &value)) {
+        sum += (unsigned long)value;
+    }
+    times[2] = bench_time_seconds() - start_time;
+
+    start_time = bench_time_seconds();
+    while (cutil_unrolled_list_pop_front(list));
+    times[3] = bench_time_seconds() - start_time;
+
+    bench_print("unrolled_list", item_count, times, sum);
+    cutil_unrolled_list_destroy(list);
+}
+
+int main(int argc, char** argv) {
+    int item_count = argc > 1 ? atoi(argv[1]) : 5000000;
+
+    if (item_count < 1) {
+        fprintf(stderr, "usage: %s [item_count]\n", argv[0]);
+        return 1;
+    }
+
+    printf("items: %d\n", item_count);
+    printf("%16s %16s %16s %16s %16s %16s\n", "container", "push (op/s)", "foreach (op/s)", "iterate (op/s)", "pop (op/s)", "checksum");
+
+    bench_list(item_count);
+    bench_unrolled_list(item_count);
+
+    return 0;
+}
@@ -4,10 +4,100 @@
 /** \file btree.h */
 
 #include "trait.h"
+#include "stream.h"
 
 typedef struct cutil_btree cutil_btree;
 typedef struct cutil_btree_itr cutil_btree_itr;
 
+/** Maximum height of a btree that can be iterated.  A btree of order 3 with this height holds at least 2^32 - 1 items. */
+#define CUTIL_BTREE_ITR_MAX_DEPTH 32
+
+/**
+A position in a btree.
+The iterator records the path from the root to its current node rather than following parent pointers, which are not valid in snapshots.
+The structure is exposed so that iterators can be declared on the stack and initialized with cutil_btree_itr_init, which performs no allocation.
+Its members are private and should not be accessed directly.
+*/
+struct cutil_btree_itr {
+    struct _btree_node* node;
+    cutil_btree* btree;
+    unsigned int node_pos;
+    unsigned int depth;
+    struct _btree_node* path_nodes[CUTIL_BTREE_ITR_MAX_DEPTH];
+    unsigned int path_positions[CUTIL_BTREE_ITR_MAX_DEPTH];
+};
+
+/**
+Callback used by cutil_btree_upsert to update a value in place.
+\param value pointer of type T* where T is the type described by the btree's value trait.  This points directly to the value stored in the tree.
+\param inserted non zero value if the item was newly inserted.  In this case the value is zero initialized and the callback is responsible for initializing it.
+\param user_data user data supplied to cutil_btree_upsert.
+*/
+typedef void (*cutil_btree_upsert_func)(void* value, int inserted, void* user_data);
+
+/**
+Callback used when combining btrees to merge the values of items whose keys are present in both btrees.
+\param value pointer of type T* where T is the type described by the btree's value trait.  This points to a copy of the value from the first btree which will be stored in the result.
+\param other_value pointer of type T* to the value from the second btree.  This value should not be modified.
+\param user_data user data supplied along with the callback.
+*/
+typedef void (*cutil_btree_merge_func)(void* value, void* other_value, void* user_data);
+
+/**
+Callback used by cutil_btree_foreach to visit each item of a btree.
+\param key pointer of type K* where K is the type described by the btree's key trait.  This points directly to the key stored in the tree and should not be modified.
+\param value pointer of type V* where V is the type described by the btree's value trait.  This points directly to the value stored in the tree, which may be shared with snapshots, and should not be modified.
+\param user_data user data supplied to cutil_btree_foreach.
+\returns non zero value to continue the traversal or zero to stop it.
+*/
+typedef int (*cutil_btree_foreach_func)(void* key, void* value, void* user_data);
+
+/** Maximum number of levels whose node counts are reported by cutil_btree_stats. */
+#define CUTIL_BTREE_STATS_MAX_LEVELS 32
+
+/**
+Describes the structure and memory usage of a btree.
+The fill of a node is the number of items it holds divided by the maximum number of items a node can hold.
+\see cutil_btree_stats
+*/
+typedef struct {
+    /** Number of levels in the btree.  A btree consisting of a single root node has a height of one. */
+    unsigned int height;
+
+    /** Number of nodes on each level of the btree, starting with the root level at index zero. */
+    size_t level_node_counts[CUTIL_BTREE_STATS_MAX_LEVELS];
+
+    /** Total number of nodes in the btree. */
+    size_t node_count;
+
+    /** Total number of items in the btree. */
+    size_t item_count;
+
+    /** Number of items in the btree divided by the number of items its nodes are able to hold. */
+    double average_fill;
+
+    /** Lowest fill of any node other than the root.  For a btree consisting of a single node this is the fill of the root. */
+    double min_fill;
+
+    /** Bytes allocated for keys, including unused key slots and any key prefixes kept by the nodes. */
+    size_t key_bytes;
+
+    /** Bytes allocated for values, including unused value slots. */
+    size_t value_bytes;
+
+    /** Bytes allocated for child pointers. */
+    size_t branch_bytes;
+
+    /** Bytes allocated for node headers and latches, along with the padding which aligns nodes and the arrays within them. */
+    size_t node_bytes;
+
+    /** Total bytes allocated by the btree, including the btree object itself. */
+    size_t total_bytes;
+
+    /** Number of separate allocations held by the btree. */
+    size_t allocation_count;
+} cutil_btree_statistics;
+
 /** @name Btree Functions
 */
 /**@{*/
@@ -21,11 +111,123 @@ Creates a new btree configured with the specified order and key / value traits.
 */
 cutil_btree* cutil_btree_create(unsigned int order, cutil_trait* key_trait, cutil_trait* value_trait);
 
+/**
+Creates a new btree whose keys are strings described by the trait returned by cutil_trait_cstring().
+Nodes keep the first 16 bytes of each key next to the key pointer, so searches only follow key pointers and compare whole strings for keys sharing that prefix with the search key.
+This costs 16 bytes per key slot of every node, which is worthwhile when keys are compared far more often than the tree is modified, and when keys tend to differ within their first 16 bytes.
+\param order The order to use for this btree.  Note that this value must be >= 3.
+\param value_trait trait object describing the values of the container.
+\returns pointer to newly created btree.  If creation failed then this function will return NULL.
+*/
+cutil_btree* cutil_btree_create_string(unsigned int order, cutil_trait* value_trait);
+
+/**
+Creates a new btree whose order is chosen so that each node fits in the specified number of bytes.
+Each node is a single allocation aligned to a 64 byte cache line, holding the node header followed by its key, value and branch arrays.
+The order is the largest for which this block, excluding the alignment padding, is no larger than page_bytes.
+Sizes which are a multiple of the cache line size, such as 256 or the 4096 byte page size, let each search touch whole lines.
+\param page_bytes The target size of each node in bytes.
+\param key_trait trait object describing the keys of the container.  Note that this trait must define a comparison function.
+\param value_trait trait object describing the values of the container.
+\returns pointer to newly created btree.  If a node of order 3 does not fit in page_bytes or creation failed then this function will return NULL.
+*/
+cutil_btree* cutil_btree_create_for_page(size_t page_bytes, cutil_trait* key_trait, cutil_trait* value_trait);
+
+/**
+Creates a new btree that may be accessed by multiple threads at the same time.
+Each node carries a reader / writer latch.  Lookups only hold latches on two nodes at a time, so readers do not block each other, and writers only latch the nodes they modify.
+Insert, upsert, get, get_many, contains, erase, clear and size may be called concurrently from any number of threads.
+Iteration, comparison and destruction require that no other thread is modifying the btree.
+Note that values returned by lookups are copies of the stored values, if the value trait owns memory it may be released by a concurrent erase.
+Concurrent btrees cannot be snapshotted and cutil_btree_get_or_insert always returns NULL for them, use cutil_btree_upsert instead.
+\param order The order to use for this btree.  Note that this value must be >= 3.
+\param key_trait trait object describing the keys of the container.  Note that this trait must define a comparison function.
+\param value_trait trait object describing the keys of the container.
+\returns pointer to newly created btree.  If creation failed then this function will return NULL.
+*/
+cutil_btree* cutil_btree_create_concurrent(unsigned int order, cutil_trait* key_trait, cutil_trait* value_trait);
+
+/**
+Checks if a btree was created with cutil_btree_create_concurrent.
+\returns non zero value if the btree supports concurrent access, otherwise zero.
+*/
+int cutil_btree_is_concurrent(cutil_btree* btree);
+
 /**
 Destroys a btree, freeing all resources used by it.
 */
 void cutil_btree_destroy(cutil_btree* btree);
 
+/**
+Creates a read only snapshot of the current contents of a btree.
+The snapshot shares all of its nodes with the btree, so creating one does not copy any items.
+When the btree is subsequently modified, the nodes along the path of the modification are copied first, leaving the snapshot unchanged.
+Functions that modify a btree have no effect when called on a snapshot.
+Snapshots must be created from the thread that modifies the btree, however they may be read and destroyed from any thread while the btree continues to be modified.
+Snapshots are destroyed with cutil_btree_destroy and may outlive the btree they were created from.
+\param btree the btree or snapshot to create a snapshot of.
+\returns pointer to a new read only btree, or NULL if the btree is concurrent or mapped.
+*/
+cutil_btree* cutil_btree_snapshot(cutil_btree* btree);
+
+/**
+Checks if a btree is a read only snapshot.
+\returns non zero value if the btree was created with cutil_btree_snapshot, otherwise zero.
+*/
+int cutil_btree_is_snapshot(cutil_btree* btree);
+
+/**
+Writes the contents of a btree to a file which can later be opened with cutil_btree_open_mapped.
+Nodes are stored in fixed size records containing the raw bytes of their keys and values, so both of the btree's traits must describe plain data types that do not define copy or destroy functions.
+The file is only readable on platforms with the same data layout as the one that wrote it.
+The btree must not be modified by another thread while it is being saved.
+\param btree the btree to save.
+\param path the path of the file to write.  An existing file will be overwritten.
+\returns non zero value if the file was written successfully, otherwise zero.
+*/
+int cutil_btree_save(cutil_btree* btree, const char* path);
+
+/**
+Opens a file written by cutil_btree_save as a read only btree.
+The file is memory mapped and the keys and values are read directly from the mapping, only the node child pointers are built when the file is opened.
+Multiple processes which open the same file share its pages in the operating system's page cache.
+Functions that modify a btree have no effect when called on a mapped btree and mapped btrees cannot be snapshotted.
+The file must not be modified while it is mapped.  Mapped btrees are destroyed with cutil_btree_destroy, which also unmaps the file.
+The structure of the file is validated when it is opened.  Files whose nodes do not form a balanced tree of at most CUTIL_BTREE_ITR_MAX_DEPTH levels holding the recorded number of items are rejected.  The order of the keys is not validated, so a file with unordered keys opens but gives incorrect search results.
+\param path the path of the file to open.
+\param key_trait trait describing the keys stored in the file.  It must match the key trait of the btree that was saved.
+\param value_trait trait describing the values stored in the file.  It must match the value trait of the btree that was saved.
+\returns pointer to a new read only btree, or NULL if the file could not be opened or does not match the supplied traits.
+*/
+cutil_btree* cutil_btree_open_mapped(const char* path, cutil_trait* key_trait, cutil_trait* value_trait);
+
+/**
+Checks if a btree was opened with cutil_btree_open_mapped.
+\returns non zero value if the btree is backed by a mapped file, otherwise zero.
+*/
+int cutil_btree_is_mapped(cutil_btree* btree);
+
+/**
+Writes the items of a btree to a stream in key order.
+Keys and values are written with their trait's serialize function.  If a trait does not define one, the raw bytes of its items are written.
+Traits which define a copy or destroy function must define a serialize function in order to be written.
+The btree must not be modified by another thread while it is being written.  The writer is flushed once all items have been written.
+\param btree the btree to write.
+\param writer the writer that will receive the btree's items.
+\returns non zero value if the btree was written successfully, otherwise zero.
+*/
+int cutil_btree_write(cutil_btree* btree, cutil_writer* writer);
+
+/**
+Creates a new btree containing items that were written with cutil_btree_write.
+The new btree has the same order as the btree that was written.
+\param reader the reader to read items from.
+\param key_trait trait describing the keys in the stream.  Note that this trait must define a comparison function.
+\param value_trait trait describing the values in the stream.
+\returns pointer to a newly created btree, or NULL if the items could not be read.
+*/
+cutil_btree* cutil_btree_read(cutil_reader* reader, cutil_trait* key_trait, cutil_trait* value_trait);
+
 /**
 Gets the order set at btree creation.
 */
@@ -55,6 +257,30 @@ Inserts a new element into the btree.  If there is an existing item present for
 */
 void cutil_btree_insert(cutil_btree* btree, void* key, void* value);
 
+/**
+Gets a pointer to the value stored in the tree for the supplied key, inserting a new item if the key is not present.
+The tree is only searched once, making this more efficient than calling cutil_btree_get followed by cutil_btree_insert.
+Note that the returned pointer is owned by the container and is only valid until the btree is next modified.
+\param key pointer of type T* where T is the type described by the btree's key trait.
+\param default_value pointer of type T* where T is the type described by the btree's value trait.  It will be copied into the tree if the key is not present.
+\param inserted optional pointer that receives a non zero value if a new item was inserted, otherwise zero.
+\returns pointer of type T* to the value stored in the tree where T is the type described by the btree's value trait, or NULL if the btree is a snapshot or concurrent.
+*/
+void* cutil_btree_get_or_insert(cutil_btree* btree, void* key, void* default_value, int* inserted);
+
+/**
+Updates the value stored for the supplied key in place, inserting a new item if the key is not present.
+The tree is only searched once and existing values are not destroyed or copied.
+If the key is not present, it will be copied into the tree along with a zero initialized value which the update function is responsible for initializing.
+\param key pointer of type T* where T is the type described by the btree's key trait.
+\param update_func function that will be called with a pointer to the value stored in the tree.
+\param user_data user data that will be passed to the update function.
+For concurrent btrees the update function is called while the node holding the value is latched.
+A newly inserted value is initialized by the update function before it is placed in the tree.
+\returns non zero value if a new item was inserted, otherwise zero.
+*/
+int cutil_btree_upsert(cutil_btree* btree, void* key, cutil_btree_upsert_func update_func, void* user_data);
+
 /**
 Gets a reference to the value stored in the continer for the given key.
 Note that the pointer placed in the out parameter is owned by the container and should be copied if it needs to be persisted beyond its lifetime.
@@ -64,6 +290,18 @@ Note that the pointer placed in the out parameter is owned by the container and
 */
 int cutil_btree_get(cutil_btree* btree, void* key, void* out);
 
+/**
+Gets the values for a batch of keys.
+Each search resumes from the node where the previous key was located, so probing keys in sorted order, or in groups of nearby keys, avoids repeating the upper levels of the descent.
+Note that the values placed in the out_values array are owned by the container and should be copied if they need to be persisted beyond its lifetime.
+\param keys array of count elements of type T where T is the type described by the btree's key trait.
+\param count the number of keys to look up.
+\param out_values array of count elements of type T where T is the type described by the btree's value trait.  Elements for keys which are not found are left untouched.
+\param found_mask optional array of count elements.  Each element is set to a non zero value if the corresponding key was found, otherwise zero.
+\returns the number of keys that were found in the btree.
+*/
+size_t cutil_btree_get_many(cutil_btree* btree, void* keys, size_t count, void* out_values, unsigned char* found_mask);
+
 /**
 Checks if the supplied key is present in the btree
 \param key pointer of type T* where T is the type described by the btree's key trait.
@@ -88,6 +326,118 @@ Removes an item from the btree with the supplied key.
 */
 int cutil_btree_erase(cutil_btree* btree, void* key);
 
+/**
+Removes all items with keys in the range [lo, hi] from the btree.
+Subtrees which lie entirely within the range are released without being searched or rebalanced, and the tree is repaired once along the boundaries of the range.
+This is considerably faster than erasing the keys one at a time when the range covers many items.
+\param lo pointer of type T* where T is the type described by the btree's key trait.  If this value is NULL, all keys less than or equal to hi are removed.
+\param hi pointer of type T* where T is the type described by the btree's key trait.  If this value is NULL, all keys greater than or equal to lo are removed.
+\returns the number of items that were removed.  Snapshots, mapped btrees and concurrent btrees are not modified and zero is returned.
+*/
+size_t cutil_btree_erase_range(cutil_btree* btree, void* lo, void* hi);
+
+/**
+Moves all items with keys greater than or equal to the supplied key into a new btree.
+The tree is cut along the path to the key and only the nodes along the cut are modified, so the items are not copied or reinserted.
+Nodes do not record the number of items beneath them, so the size of the smaller of the two resulting btrees is counted by visiting its nodes.
+\param key pointer of type T* where T is the type described by the btree's key trait.  The key does not need to be present in the btree.
+\param out_right pointer that receives the new btree.  It has the same order, traits and key prefix mode as the supplied btree and must be destroyed with cutil_btree_destroy.
+\returns non zero value if the btree was split, otherwise zero.  Snapshots, mapped btrees and concurrent btrees cannot be split.
+*/
+int cutil_btree_split(cutil_btree* btree, void* key, cutil_btree** out_right);
+
+/**
+Moves all items of the right btree into the left btree, leaving the right btree empty.
+Every key of the right btree must be greater than every key of the left btree.
+The smaller btree is grafted onto the border of the larger one, so this takes time proportional to the height of the btrees.
+Snapshots of either btree are not affected.
+\param left the btree that will receive the items.
+\param right the btree whose items will be moved.  It must have the same order and traits as the left btree, and must have been created with cutil_btree_create_string only if the left btree was.
+\returns non zero value if the btrees were joined, or zero if the btrees are incompatible, their keys overlap or either of them cannot be modified.
+*/
+int cutil_btree_join(cutil_btree* left, cutil_btree* right);
+
+/**
+Rebuilds a btree so that its nodes are packed in key order, releasing the memory held by nodes left sparsely filled by erases.
+Items are moved into the new nodes rather than copied, except for items of nodes shared with snapshots, which are copied with the btree's traits.  Snapshots are not affected.
+\param btree the btree to compact.
+\param target_fill the fraction of each node's capacity to fill, in the range (0, 1].  Values below one leave room for later inserts.  Nodes are never filled below the minimum item count of the btree's order.
+\returns non zero value if the btree was compacted, or zero if the target fill is out of range or the btree is a snapshot, mapped or concurrent.
+*/
+int cutil_btree_compact(cutil_btree* btree, double target_fill);
+
+/**
+Enables or disables relaxed rebalancing of a btree.
+By default every erase that leaves a node with fewer than the minimum number of items immediately borrows from or merges with a sibling, which may continue up to the root.
+In relaxed mode an erase only repairs nodes which become empty, and other short nodes are left in place until cutil_btree_flush_rebalance is called.
+This avoids repeated borrowing and merging in workloads which erase keys and insert them again shortly after.
+Erasing a range of keys, splitting and joining flush the btree before modifying it.  Disabling relaxed mode also flushes the btree.
+\param btree the btree to configure.
+\param relaxed non zero value to enable relaxed rebalancing, zero to disable it.
+\returns non zero value if the mode was set, or zero if the btree is a snapshot, mapped or concurrent.
+*/
+int cutil_btree_set_relaxed_rebalance(cutil_btree* btree, int relaxed);
+
+/**
+Repairs the nodes left short by erases while in relaxed mode, so that every node other than the root holds at least the minimum number of items for the btree's order.
+This function returns immediately if no erase has left a short node since the last flush.  Snapshots, mapped btrees and concurrent btrees are not modified.
+\param btree the btree to repair.
+*/
+void cutil_btree_flush_rebalance(cutil_btree* btree);
+
+/**
+Gathers statistics describing the structure and memory usage of a btree.
+Nodes shared with snapshots are counted by every btree that can reach them.
+The keys and values of mapped btrees are stored in the mapped file and are not included in the memory totals.
+As with iteration, no other thread may modify a concurrent btree while its statistics are gathered.
+\param btree the btree to examine.
+\param stats receives the statistics of the btree.
+*/
+void cutil_btree_stats(cutil_btree* btree, cutil_btree_statistics* stats);
+
+/**@}*/
+
+/** @name Btree Set Functions
+The items of both btrees are visited once in key order and the result is built directly from the sorted items, so combining btrees of size n and m takes O(n + m) time.
+Both btrees must have the same key and value traits and neither may be concurrent.  Items placed in the result are copied with the btrees' traits.
+When a key is present in both btrees the value from the second btree is used, unless a merge function is supplied to combine the two values.
+Results are created with the order of the first btree, and keep key prefixes if it was created with cutil_btree_create_string.
+*/
+/**@{*/
+
+/**
+Adds all of the items of the source btree to the destination btree.
+The destination is rebuilt from the combined items, any snapshots of it are not affected.
+\param dest the btree that will receive the items.
+\param src the btree whose items will be added.  It is not modified.
+\param merge_func optional function used to combine the values of keys that are present in both btrees.  The value from the destination is passed as the first value.
+\param user_data user data that will be passed to the merge function.
+\returns non zero value if the btrees were merged, or zero if the traits do not match or the destination cannot be modified.
+*/
+int cutil_btree_merge(cutil_btree* dest, cutil_btree* src, cutil_btree_merge_func merge_func, void* user_data);
+
+/**
+Creates a new btree containing the items of both btrees.
+\param merge_func optional function used to combine the values of keys that are present in both btrees.
+\param user_data user data that will be passed to the merge function.
+\returns pointer to a new btree, or NULL if the btrees cannot be combined.
+*/
+cutil_btree* cutil_btree_union(cutil_btree* a, cutil_btree* b, cutil_btree_merge_func merge_func, void* user_data);
+
+/**
+Creates a new btree containing the items whose keys are present in both btrees.
+\param merge_func optional function used to combine the values of the two btrees.
+\param user_data user data that will be passed to the merge function.
+\returns pointer to a new btree, or NULL if the btrees cannot be combined.
+*/
+cutil_btree* cutil_btree_intersection(cutil_btree* a, cutil_btree* b, cutil_btree_merge_func merge_func, void* user_data);
+
+/**
+Creates a new btree containing the items of the first btree whose keys are not present in the second btree.
+\returns pointer to a new btree, or NULL if the btrees cannot be combined.
+*/
+cutil_btree* cutil_btree_difference(cutil_btree* a, cutil_btree* b);
+
 /**@}*/
 
 /** @name Btree Iterator Functions
@@ -101,7 +451,15 @@ Creates a new forward iterator positioned before the first item in the supplied
 cutil_btree_itr* cutil_btree_itr_create(cutil_btree* btree);
 
 /**
-Destroys a btree iterator, freeing all resources used by it.
+Initializes an iterator in caller provided storage, positioning it before the first item in the supplied btree.
+The iterator holds no resources, so it is not passed to cutil_btree_itr_destroy.
+\param itr the iterator to initialize.
+\param btree the btree to iterate over.
+*/
+void cutil_btree_itr_init(cutil_btree_itr* itr, cutil_btree* btree);
+
+/**
+Destroys a btree iterator created with cutil_btree_itr_create, freeing all resources used by it.
 */
 void cutil_btree_itr_destroy(cutil_btree_itr* itr);
 
@@ -127,6 +485,16 @@ Note that the pointer placed in the value parameter is owned by the container an
 */
 int cutil_btree_itr_get_value(cutil_btree_itr* itr, void* value);
 
+/**
+Calls a function with pointers to the key and value of each item of the btree, in key order.
+The nodes of the btree are walked directly and items are visited in place without being copied, which is considerably faster than iterating for a full scan.
+The btree must not be modified while it is traversed, either by the callback or by another thread.
+\param callback function called for each item.  Returning zero from it stops the traversal.
+\param user_data user data passed to the callback.
+\returns the number of items the callback was called with.
+*/
+size_t cutil_btree_foreach(cutil_btree* btree, cutil_btree_foreach_func callback, void* user_data);
+
 /**@}*/
 
 #endif
@@ -4,12 +4,31 @@
 /** \file forward_list.h */
 
 #include "trait.h"
+#include "stream.h"
 
 #include <stddef.h>
 
 typedef struct cutil_forward_list cutil_forward_list;
 typedef struct cutil_forward_list_itr cutil_forward_list_itr;
 
+/**
+A position in a forward list.
+The structure is exposed so that iterators can be declared on the stack and initialized with cutil_forward_list_itr_init, which performs no allocation.
+Its members are private and should not be accessed directly.
+*/
+struct cutil_forward_list_itr {
+    cutil_forward_list* list;
+    struct cutil_forward_list_node* node;
+};
+
+/**
+Callback used by cutil_forward_list_foreach to visit each item of a list.
+\param item pointer of type T* where T is the type described by the list's trait.  This points directly to the item stored in the list.
+\param user_data user data supplied to cutil_forward_list_foreach.
+\returns non zero value to continue the traversal or zero to stop it.
+*/
+typedef int (*cutil_forward_list_foreach_func)(void* item, void* user_data);
+
 /** @name List Functions
 */
 /**@{*/
@@ -37,6 +56,11 @@ Gets whether the list contains any items.
 */
 int cutil_forward_list_empty(cutil_forward_list* list);
 
+/**
+Returns the number of elements in the list
+*/
+unsigned int cutil_forward_list_size(cutil_forward_list* list);
+
 /**
 Gets a reference to the element at the front of the list.
 Note that the pointer placed in the out parameter is owned by the container and should be copied if it needs to be persisted beyond its lifetime.
@@ -57,6 +81,80 @@ Pushes data to a new element at the front of the list.
 */
 void cutil_forward_list_push_front(cutil_forward_list* list, void* data);
 
+/**
+Pushes data to a new element at the back of the list.
+The list keeps track of its last node, so this does not traverse the list.  Together with cutil_forward_list_pop_front this allows the list to be used as a queue.
+\param data pointer to data of Type T* where T is the type described by the list's trait.
+*/
+void cutil_forward_list_push_back(cutil_forward_list* list, void* data);
+
+/**
+Calls a function with a pointer to each item of the list, from front to back.
+The items are visited in place without being copied, which is considerably faster than iterating for a full scan.
+The list must not be modified by the callback.
+\param callback function called for each item.  Returning zero from it stops the traversal.
+\param user_data user data passed to the callback.
+\returns the number of items the callback was called with.
+*/
+size_t cutil_forward_list_foreach(cutil_forward_list* list, cutil_forward_list_foreach_func callback, void* user_data);
+
+/**
+Sorts the items of the list in ascending order using the trait's comparison function.
+The sort is stable, so equal items keep their relative order.  Nodes are relinked in place without allocating or copying items, and existing iterators remain positioned at the same items.
+\returns non zero value if the list was sorted, or zero if its trait does not define a comparison function.
+*/
+int cutil_forward_list_sort(cutil_forward_list* list);
+
+/**
+Writes the items of a list to a stream, from front to back.
+Items are written with the trait's serialize function.  If the trait does not define one, the raw bytes of the items are written.
+Traits which define a copy or destroy function must define a serialize function in order to be written.
+The writer is flushed once all items have been written.
+\returns non zero value if the list was written successfully, otherwise zero.
+*/
+int cutil_forward_list_write(cutil_forward_list* list, cutil_writer* writer);
+
+/**
+Creates a new list containing items that were written with cutil_forward_list_write.
+Items are read directly into newly allocated list nodes without being copied.
+\param trait trait object describing the items in the stream.  Its size must match the size of the items that were written.
+\returns pointer to a newly created list, or NULL if the items could not be read.
+*/
+cutil_forward_list* cutil_forward_list_read(cutil_reader* reader, cutil_trait* trait);
+
+/**
+Sets the maximum number of nodes the list keeps for reuse after their items are removed.
+Removed items are destroyed as usual, but their nodes and item storage are kept and reused by later insertions, so a list which alternates insertions and removals performs no allocation once the cache is warm.
+The cache is disabled by default.  Reducing the capacity frees cached nodes beyond it, and a capacity of zero frees the whole cache.
+\param capacity the maximum number of cached nodes.
+*/
+void cutil_forward_list_set_node_cache_capacity(cutil_forward_list* list, unsigned int capacity);
+
+/**
+Returns the maximum number of nodes the list keeps for reuse.
+*/
+unsigned int cutil_forward_list_get_node_cache_capacity(cutil_forward_list* list);
+
+/**
+Returns the number of nodes currently held for reuse.
+*/
+unsigned int cutil_forward_list_node_cache_size(cutil_forward_list* list);
+
+/**
+Returns the number of insertions which reused a cached node.
+*/
+size_t cutil_forward_list_node_cache_hit_count(cutil_forward_list* list);
+
+/**
+Returns the number of insertions which allocated a new node.
+*/
+size_t cutil_forward_list_node_cache_miss_count(cutil_forward_list* list);
+
+/**
+Sets the node cache hit and miss counters to zero.
+*/
+void cutil_forward_list_reset_node_cache_counters(cutil_forward_list* list);
+
 /**@}*/
 
 /** @name List Iterator Functions
@@ -70,7 +168,15 @@ Creates a new forward iterator positioned before the front of the supplied list.
 cutil_forward_list_itr* cutil_forward_list_itr_create(cutil_forward_list* list);
 
 /**
-Destroys a list iterator, freeing all resources used by it.
+Initializes an iterator in caller provided storage, positioning it before the front of the supplied list.
+The iterator holds no resources, so it is not passed to cutil_forward_list_itr_destroy.
+\param itr the iterator to initialize.
+\param list the list to iterate over.
+*/
+void cutil_forward_list_itr_init(cutil_forward_list_itr* itr, cutil_forward_list* list);
+
+/**
+Destroys a list iterator created with cutil_forward_list_itr_create, freeing all resources used by it.
 \param itr the iterator to destroy.
 */
 void cutil_forward_list_itr_destroy(cutil_forward_list_itr* itr);
@@ -87,6 +193,23 @@ Note that the pointer placed in the out parameter is owned by the container and
 \returns non zero value if data was written to the out pointer otherwise zero.
 */
 int cutil_forward_list_itr_next(cutil_forward_list_itr* itr, void* out);
+
+/**
+Inserts an item after the iterator's current item.
+An iterator which is positioned before the front of the list inserts the item at the front of the list.
+The iterator remains at its current item, so the inserted item is returned by a subsequent call to cutil_forward_list_itr_next.
+\param itr iterator marking the position to insert at.
+\param data pointer to data of Type T* where T is the type described by the list's trait.
+*/
+void cutil_forward_list_insert_after(cutil_forward_list_itr* itr, void* data);
+
+/**
+Removes the item following the iterator's current item.
+The iterator remains at its current item, so a subsequent call to cutil_forward_list_itr_next returns the item which followed the removed item.
+\param itr iterator positioned before the item to remove.
+\returns non zero value if an item was removed, or zero if the iterator was at the last item of the list.
+*/
+int cutil_forward_list_erase_after(cutil_forward_list_itr* itr);
 /**@}*/
 
 #endif
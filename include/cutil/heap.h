@@ -4,6 +4,7 @@
 /** \file heap.h */
 
 #include "trait.h"
+#include "stream.h"
 
 #include <stddef.h>
 
@@ -64,4 +65,20 @@ This function will not deallocate any memory or adjust the vector's capacity.
 void cutil_heap_clear(cutil_heap* heap);
 
 
+/**
+Writes the items of a heap to a stream in their heap order.
+Items are written with the trait's serialize function.  If the trait does not define one, the raw bytes of the items are written.
+Traits which define a copy or destroy function must define a serialize function in order to be written.
+\returns non zero value if the heap was written successfully, otherwise zero.
+*/
+int cutil_heap_write(cutil_heap* heap, cutil_writer* writer);
+
+/**
+Creates a new heap containing items that were written with cutil_heap_write.
+The items are restored in the order they were written, so no comparisons are performed.
+\param trait trait object describing the items in the stream.  Note that this trait must define a comparison function.
+\returns pointer to a newly created heap, or NULL if the trait has no comparison function or the items could not be read.
+*/
+cutil_heap* cutil_heap_read(cutil_reader* reader, cutil_trait* trait);
+
 #endif
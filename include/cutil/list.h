@@ -1,125 +1,256 @@
-#ifndef CUTIL_LIST_H
-#define CUTIL_LIST_H
-
-/** \file list.h */
-
-#include "trait.h"
-
-#include <stddef.h>
-
-typedef struct cutil_list cutil_list;
-typedef struct cutil_list_itr cutil_list_itr;
-
-/** @name List Functions
-*/
-/**@{*/
-
-/**
-Creates a new list configured to store items as described by the passed in trait.
-\param trait trait object describing the items that will be stored by the list.
-\returns pointer to newly created list.  If creation failed then this function will return NULL.
-*/
-cutil_list* cutil_list_create(cutil_trait* trait);
-
-/**
-Destroys a list, freeing all resources used by it.
-*/
-void cutil_list_destroy(cutil_list* list);
-
-/**
-Returns the number of elements in the list
-*/
-unsigned int cutil_list_size(cutil_list* list);
-
-/**
-Removes all items in the list.
-*/
-void cutil_list_clear(cutil_list* list);
-
-/**
-Removes the item at the front of the list.
-\returns non zero value if the list has a front element, otherwise zero.
-*/
-int cutil_list_pop_front(cutil_list* list);
-
-/**
-Removes the item at the back of the list.
-\returns non zero value if the list has a back element, otherwise zero.
-*/
-int cutil_list_pop_back(cutil_list* list);
-
-/**
-Gets a reference to the element at the front of the list.
-Note that the pointer placed in the out parameter is owned by the container and should be copied if it needs to be persisted beyond its lifetime.
-\param out pointer of type T* where T is the type described by the list's trait.
-\returns non zero value if the list has a front element, otherwise zero.
-*/
-int cutil_list_front(cutil_list* list, void* out);
-
-/**
-Gets a reference to the element at the back of the list.
-Note that the pointer placed in the out parameter is owned by the container and should be copied if it needs to be persisted beyond its lifetime.
-\param out pointer of type T* where T is the type described by the list's trait.
-\returns non zero value if the list has a back element, otherwise zero.
-*/
-int cutil_list_back(cutil_list* list, void* out);
-
-/**
-Pushes data to a new element at the front of the list.
-\param data pointer to data of Type T* where T is the type described by the list's trait.
-*/
-void cutil_list_push_front(cutil_list* list, void* data);
-
-/**
-Pushes data to a new element at the back of the list.
-\param data pointer to data of Type T* where T is the type described by the list's trait.
-*/
-void cutil_list_push_back(cutil_list* list, void* data);
-
-/**@}*/
-
-/** @name List Iterator Functions
-*/
-/**@{*/
-
-/**
-Creates a new forward iterator positioned before the front of the supplied list.
-\param list the list to iterate over.
-*/
-cutil_list_itr* cutil_list_itr_create(cutil_list* list);
-
-/**
-Destroys a list iterator, freeing all resources used by it.
-\param itr the iterator to destroy.
-*/
-void cutil_list_itr_destroy(cutil_list_itr* itr);
-
-/**
-Returns a non zero value if the iterator is not at the end of the list.
-*/
-int cutil_list_itr_has_next(cutil_list_itr* itr);
-
-/**
-Advances the iterator position and gets the data at the next element in the iterated list.  If this method is called when the iterator is passed the end of the list, the out parameter will be untouched.
-Note that the pointer placed in the out parameter is owned by the container and should be copied if it needs to be persisted beyond its lifetime.
-\param out pointer of type T* where T is the type described by the iterator's list trait.
-\returns non zero value if data was written to the out pointer otherwise zero.
-*/
-int cutil_list_itr_next(cutil_list_itr* itr, void* out);
-
-/**
-Returns a non zero value if the iterator is not at the beginning of the list.
-*/
-int cutil_list_itr_has_prev(cutil_list_itr* itr);
-
-/**
-Decrements the iterator position and gets the data at the previous element in the iterated list.  If this method is called when the iterator is at the beginning of the list, the out parameter will be untouched.
-Note that the pointer placed in the out parameter is owned by the container and should be copied if it needs to be persisted beyond its lifetime.
-\param out pointer of type T* where T is the type described by the iterator's list trait.
-\returns non zero value if data was written to the out pointer otherwise zero.
-*/
-int cutil_list_itr_prev(cutil_list_itr* itr, void* out);
-
-/**@}*/
-
-#endif
+#ifndef CUTIL_LIST_H
+#define CUTIL_LIST_H
+
+/** \file list.h */
+
+#include "trait.h"
+#include "stream.h"
+
+#include <stddef.h>
+
+typedef struct cutil_list cutil_list;
+typedef struct cutil_list_itr cutil_list_itr;
+
+/**
+A position in a list.
+The structure is exposed so that iterators can be declared on the stack and initialized with cutil_list_itr_init, which performs no allocation.
+Its members are private and should not be accessed directly.
+*/
+struct cutil_list_itr {
+    cutil_list* list;
+    struct cutil_list_node* node;
+};
+
+/**
+Callback used by cutil_list_foreach to visit each item of a list.
+\param item pointer of type T* where T is the type described by the list's trait.  This points directly to the item stored in the list.
+\param user_data user data supplied to cutil_list_foreach.
+\returns non zero value to continue the traversal or zero to stop it.
+*/
+typedef int (*cutil_list_foreach_func)(void* item, void* user_data);
+
+/** @name List Functions
+*/
+/**@{*/
+
+/**
+Creates a new list configured to store items as described by the passed in trait.
+\param trait trait object describing the items that will be stored by the list.
+\returns pointer to newly created list.  If creation failed then this function will return NULL.
+*/
+cutil_list* cutil_list_create(cutil_trait* trait);
+
+/**
+Destroys a list, freeing all resources used by it.
+*/
+void cutil_list_destroy(cutil_list* list);
+
+/**
+Returns the number of elements in the list
+*/
+unsigned int cutil_list_size(cutil_list* list);
+
+/**
+Removes all items in the list.
+*/
+void cutil_list_clear(cutil_list* list);
+
+/**
+Removes the item at the front of the list.
+\returns non zero value if the list has a front element, otherwise zero.
+*/
+int cutil_list_pop_front(cutil_list* list);
+
+/**
+Removes the item at the back of the list.
+\returns non zero value if the list has a back element, otherwise zero.
+*/
+int cutil_list_pop_back(cutil_list* list);
+
+/**
+Gets a reference to the element at the front of the list.
+Note that the pointer placed in the out parameter is owned by the container and should be copied if it needs to be persisted beyond its lifetime.
+\param out pointer of type T* where T is the type described by the list's trait.
+\returns non zero value if the list has a front element, otherwise zero.
+*/
+int cutil_list_front(cutil_list* list, void* out);
+
+/**
+Gets a reference to the element at the back of the list.
+Note that the pointer placed in the out parameter is owned by the container and should be copied if it needs to be persisted beyond its lifetime.
+\param out pointer of type T* where T is the type described by the list's trait.
+\returns non zero value if the list has a back element, otherwise zero.
+*/
+int cutil_list_back(cutil_list* list, void* out);
+
+/**
+Pushes data to a new element at the front of the list.
+\param data pointer to data of Type T* where T is the type described by the list's trait.
+*/
+void cutil_list_push_front(cutil_list* list, void* data);
+
+/**
+Pushes data to a new element at the back of the list.
+\param data pointer to data of Type T* where T is the type described by the list's trait.
+*/
+void cutil_list_push_back(cutil_list* list, void* data);
+
+/**
+Calls a function with a pointer to each item of the list, from front to back.
+The items are visited in place without being copied, which is considerably faster than iterating for a full scan.
+The list must not be modified by the callback.
+\param callback function called for each item.  Returning zero from it stops the traversal.
+\param user_data user data passed to the callback.
+\returns the number of items the callback was called with.
+*/
+size_t cutil_list_foreach(cutil_list* list, cutil_list_foreach_func callback, void* user_data);
+
+/**
+Sorts the items of the list in ascending order using the trait's comparison function.
+The sort is stable, so equal items keep their relative order.  Nodes are relinked in place without allocating or copying items, and existing iterators remain positioned at the same items.
+\returns non zero value if the list was sorted, or zero if its trait does not define a comparison function.
+*/
+int cutil_list_sort(cutil_list* list);
+
+/**
+Moves the items of another list into this list, keeping both sets of items in sorted order.
+Both lists must already be sorted by their trait's comparison function.  Items of this list are placed before equal items of the other list.
+Nodes are relinked without allocating or copying items, and the other list is left empty.
+\param other the list whose items are moved.  It must use the same trait as this list.
+\returns non zero value if the lists were merged, or zero if the lists have different traits or the trait does not define a comparison function.
+*/
+int cutil_list_merge(cutil_list* list, cutil_list* other);
+
+/**
+Writes the items of a list to a stream, from front to back.
+Items are written with the trait's serialize function.  If the trait does not define one, the raw bytes of the items are written.
+Traits which define a copy or destroy function must define a serialize function in order to be written.
+The writer is flushed once all items have been written.
+\returns non zero value if the list was written successfully, otherwise zero.
+*/
+int cutil_list_write(cutil_list* list, cutil_writer* writer);
+
+/**
+Creates a new list containing items that were written with cutil_list_write.
+Items are read directly into newly allocated list nodes without being copied.
+\param trait trait object describing the items in the stream.  Its size must match the size of the items that were written.
+\returns pointer to a newly created list, or NULL if the items could not be read.
+*/
+cutil_list* cutil_list_read(cutil_reader* reader, cutil_trait* trait);
+
+/**
+Sets the maximum number of nodes the list keeps for reuse after their items are removed.
+Removed items are destroyed as usual, but their nodes and item storage are kept and reused by later insertions, so a list which alternates insertions and removals performs no allocation once the cache is warm.
+The cache is disabled by default.  Reducing the capacity frees cached nodes beyond it, and a capacity of zero frees the whole cache.
+\param capacity the maximum number of cached nodes.
+*/
+void cutil_list_set_node_cache_capacity(cutil_list* list, unsigned int capacity);
+
+/**
+Returns the maximum number of nodes the list keeps for reuse.
+*/
+unsigned int cutil_list_get_node_cache_capacity(cutil_list* list);
+
+/**
+Returns the number of nodes currently held for reuse.
+*/
+unsigned int cutil_list_node_cache_size(cutil_list* list);
+
+/**
+Returns the number of insertions which reused a cached node.
+*/
+size_t cutil_list_node_cache_hit_count(cutil_list* list);
+
+/**
+Returns the number of insertions which allocated a new node.
+*/
+size_t cutil_list_node_cache_miss_count(cutil_list* list);
+
+/**
+Sets the node cache hit and miss counters to zero.
+*/
+void cutil_list_reset_node_cache_counters(cutil_list* list);
+
+/**@}*/
+
+/** @name List Iterator Functions
+*/
+/**@{*/
+
+/**
+Creates a new forward iterator positioned before the front of the supplied list.
+\param list the list to iterate over.
+*/
+cutil_list_itr* cutil_list_itr_create(cutil_list* list);
+
+/**
+Initializes an iterator in caller provided storage, positioning it before the front of the supplied list.
+The iterator holds no resources, so it is not passed to cutil_list_itr_destroy.
+\param itr the iterator to initialize.
+\param list the list to iterate over.
+*/
+void cutil_list_itr_init(cutil_list_itr* itr, cutil_list* list);
+
+/**
+Destroys a list iterator created with cutil_list_itr_create, freeing all resources used by it.
+\param itr the iterator to destroy.
+*/
+void cutil_list_itr_destroy(cutil_list_itr* itr);
+
+/**
+Returns a non zero value if the iterator is not at the end of the list.
+*/
+int cutil_list_itr_has_next(cutil_list_itr* itr);
+
+/**
+Advances the iterator position and gets the data at the next element in the iterated list.  If this method is called when the iterator is passed the end of the list, the out parameter will be untouched.
+Note that the pointer placed in the out parameter is owned by the container and should be copied if it needs to be persisted beyond its lifetime.
+\param out pointer of type T* where T is the type described by the iterator's list trait.
+\returns non zero value if data was written to the out pointer otherwise zero.
+*/
+int cutil_list_itr_next(cutil_list_itr* itr, void* out);
+
+/**
+Returns a non zero value if the iterator is not at the beginning of the list.
+*/
+int cutil_list_itr_has_prev(cutil_list_itr* itr);
+
+/**
+Decrements the iterator position and gets the data at the previous element in the iterated list.  If this method is called when the iterator is at the beginning of the list, the out parameter will be untouched.
+Note that the pointer placed in the out parameter is owned by the container and should be copied if it needs to be persisted beyond its lifetime.
+\param out pointer of type T* where T is the type described by the iterator's list trait.
+\returns non zero value if data was written to the out pointer otherwise zero.
+*/
+int cutil_list_itr_prev(cutil_list_itr* itr, void* out);
+
+/**
+Inserts an item in front of the iterator's current item.
+An iterator which is positioned before the front of the list inserts the item at the back of the list.
+The iterator remains at its current item, so the inserted item is returned by a subsequent call to cutil_list_itr_prev.
+\param itr iterator marking the position to insert at.
+\param data pointer to data of Type T* where T is the type described by the list's trait.
+*/
+void cutil_list_insert_before(cutil_list_itr* itr, void* data);
+
+/**
+Removes the iterator's current item from its list.
+The iterator is moved to the item preceding the removed item, so a subsequent call to cutil_list_itr_next returns the item which followed it.
+\param itr iterator positioned at the item to remove.
+\returns non zero value if an item was removed, or zero if the iterator was not positioned at an item.
+*/
+int cutil_list_erase(cutil_list_itr* itr);
+
+/**
+Moves the source iterator's current item in front of the destination iterator's current item.
+The item's node is relinked without allocating or copying the item.  The source and destination may be the same list, which allows an item to be moved within a list in constant time.
+The source iterator is moved to the item preceding the moved item, as with cutil_list_erase.  The destination iterator remains at its current item.
+\param dst_itr iterator marking the position to move the item to.  An iterator positioned before the front of its list moves the item to the back.
+\param src_list the list containing the item to move.  It must use the same trait as the destination list.
+\param src_itr iterator of src_list positioned at the item to move.
+\returns non zero value if the item was moved, or zero if the source iterator was not positioned at an item of src_list or the lists have different traits.
+*/
+int cutil_list_splice(cutil_list_itr* dst_itr, cutil_list* src_list, cutil_list_itr* src_itr);
+
+/**@}*/
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef CUTIL_LRU_CACHE_H
+#define CUTIL_LRU_CACHE_H
+
+/** \file lru_cache.h */
+
+#include "trait.h"
+
+#include <stddef.h>
+
+/**
+The lru cache maps keys to values and holds a bounded number of items, evicting the least recently used item to make room for new ones.
+Items are kept in a doubly linked list ordered by recency and indexed by a hash table, so lookups, insertions and evictions take constant time.
+Each item is stored in a single allocation holding its key and value.  Evicted and erased allocations are reused for new items, so a full cache performs no allocations.
+*/
+typedef struct cutil_lru_cache cutil_lru_cache;
+
+/**
+Callback used by caches created with cutil_lru_cache_create_with_byte_limit to determine how many bytes an item counts against the limit.
+\param key pointer of type K* where K is the type described by the cache's key trait.
+\param value pointer of type V* where V is the type described by the cache's value trait.
+\param user_data user data supplied to cutil_lru_cache_create_with_byte_limit.
+\returns the number of bytes the item counts against the limit.
+*/
+typedef size_t (*cutil_lru_cache_size_func)(void* key, void* value, void* user_data);
+
+/**
+Creates a new cache holding at most the specified number of items.
+Keys are hashed with the key trait's hash function, or by their raw bytes if it does not define one, and compared with its comparison function, or by their raw bytes if it does not define one.
+\param key_trait trait object describing the keys of the cache.  Traits which define a copy function must also define a hash function.
+\param value_trait trait object describing the values of the cache.
+\param max_count the maximum number of items held by the cache.  Note that this value must be greater than zero.
+\returns pointer to newly created cache.  If creation failed then this function will return NULL.
+*/
+cutil_lru_cache* cutil_lru_cache_create(cutil_trait* key_trait, cutil_trait* value_trait, size_t max_count);
+
+/**
+Creates a new cache whose items count against a limit in bytes rather than a limit on their number.
+\param key_trait trait object describing the keys of the cache.  Traits which define a copy function must also define a hash function.
+\param value_trait trait object describing the values of the cache.
+\param max_bytes the maximum total size of the items held by the cache.  Note that this value must be greater than zero.
+\param size_func function returning the size of an item.  If it is NULL each item counts as the combined size of the key and value traits.
+\param user_data user data passed to the size function.
+\returns pointer to newly created cache.  If creation failed then this function will return NULL.
+*/
+cutil_lru_cache* cutil_lru_cache_create_with_byte_limit(cutil_trait* key_trait, cutil_trait* value_trait, size_t max_bytes, cutil_lru_cache_size_func size_func, void* user_data);
+
+/**
+Destroys a cache, freeing all resources used by it.
+*/
+void cutil_lru_cache_destroy(cutil_lru_cache* cache);
+
+/**
+Returns the number of items in the cache.
+*/
+size_t cutil_lru_cache_size(cutil_lru_cache* cache);
+
+/**
+Returns the total size of the items in the cache, as counted against its byte limit.
+*/
+size_t cutil_lru_cache_byte_size(cutil_lru_cache* cache);
+
+/**
+Removes all items from the cache and frees the memory held for them.
+The hit, miss and eviction counters are not reset.
+*/
+void cutil_lru_cache_clear(cutil_lru_cache* cache);
+
+/**
+Inserts an item into the cache, or replaces the value of the item with an equal key, and marks it as the most recently used item.
+The key and value are copied with the cache's traits.  Least recently used items are evicted until the new item fits within the cache's limits.
+\param key pointer of type K* where K is the type described by the cache's key trait.
+\param value pointer of type V* where V is the type described by the cache's value trait.
+\returns non zero value if the item was stored, or zero if it is larger than the cache's byte limit.  In this case the cache is unchanged.
+*/
+int cutil_lru_cache_put(cutil_lru_cache* cache, void* key, void* value);
+
+/**
+Gets the value of the item with the supplied key and marks it as the most recently used item.
+Each call counts as either a hit or a miss.
+Note that the value placed in the out parameter is owned by the container and should be copied if it needs to be persisted beyond its lifetime.
+\param key pointer of type K* where K is the type described by the cache's key trait.
+\param out pointer of type V* where V is the type described by the cache's value trait.
+\returns non zero value if the key was found, otherwise zero.
+*/
+int cutil_lru_cache_get(cutil_lru_cache* cache, void* key, void* out);
+
+/**
+Checks if the cache holds an item with the supplied key without marking it as recently used or counting a hit or miss.
+\param key pointer of type K* where K is the type described by the cache's key trait.
+\returns non zero value if the key was found, otherwise zero.
+*/
+int cutil_lru_cache_contains(cutil_lru_cache* cache, void* key);
+
+/**
+Removes the item with the supplied key from the cache.
+Its memory is kept for reuse by a later insertion until the cache is cleared or destroyed.
+\param key pointer of type K* where K is the type described by the cache's key trait.
+\returns non zero value if an item was removed, otherwise zero.
+*/
+int cutil_lru_cache_erase(cutil_lru_cache* cache, void* key);
+
+/**
+Returns the number of calls to cutil_lru_cache_get that found their key.
+*/
+size_t cutil_lru_cache_hit_count(cutil_lru_cache* cache);
+
+/**
+Returns the number of calls to cutil_lru_cache_get that did not find their key.
+*/
+size_t cutil_lru_cache_miss_count(cutil_lru_cache* cache);
+
+/**
+Returns the number of items that have been evicted to make room for new items.
+*/
+size_t cutil_lru_cache_eviction_count(cutil_lru_cache* cache);
+
+/**
+Sets the hit, miss and eviction counters to zero.
+*/
+void cutil_lru_cache_reset_counters(cutil_lru_cache* cache);
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef CUTIL_MPSC_QUEUE_H
+#define CUTIL_MPSC_QUEUE_H
+
+/** \file mpsc_queue.h */
+
+#include <stddef.h>
+
+/**
+The mpsc queue passes nodes from any number of producer threads to a single consumer thread without locking.
+The queue is intrusive: nodes are supplied by the caller and linked into the queue directly, so pushing and popping perform no allocation.
+A node must remain valid and must not be pushed again until it has been popped.
+On compilers without atomic operations the queue remains safe to share between threads, but pushing and popping take a lock shared by the whole library.
+*/
+typedef struct cutil_mpsc_queue cutil_mpsc_queue;
+typedef struct cutil_mpsc_queue_node cutil_mpsc_queue_node;
+
+/**
+A node of an mpsc queue, which shares its layout with the nodes of a forward list.
+The data member is free for the caller to use, typically to point at the item being passed between threads.  Alternatively the node may be embedded in a larger structure.
+The next member is private and should not be accessed directly.
+*/
+struct cutil_mpsc_queue_node {
+    void* data;
+    cutil_mpsc_queue_node* next;
+};
+
+/**
+Creates a new empty queue.
+\returns pointer to newly created queue.  If creation failed then this function will return NULL.
+*/
+cutil_mpsc_queue* cutil_mpsc_queue_create();
+
+/**
+Destroys a queue, freeing all resources used by it.
+Nodes remaining in the queue are owned by the caller and are not freed.
+*/
+void cutil_mpsc_queue_destroy(cutil_mpsc_queue* queue);
+
+/**
+Pushes a node to the back of the queue.
+This function may be called from any thread and completes in a bounded number of steps.
+\param node the node to push.  Its data member is left unchanged.
+*/
+void cutil_mpsc_queue_push(cutil_mpsc_queue* queue, cutil_mpsc_queue_node* node);
+
+/**
+Pops the node at the front of the queue.
+This function may only be called from the consumer thread.
+A push which is in progress on another thread may briefly hide the nodes pushed after it, in which case this function returns NULL until the push completes.
+\returns the popped node, or NULL if no node is available.
+*/
+cutil_mpsc_queue_node* cutil_mpsc_queue_pop(cutil_mpsc_queue* queue);
+
+/**
+Pops up to the specified number of nodes from the front of the queue, stopping early once no node is available.
+This function may only be called from the consumer thread.
+\param nodes array receiving the popped nodes in the order they were pushed.
+\param max_count the maximum number of nodes to pop.
+\returns the number of nodes placed in the array.
+*/
+size_t cutil_mpsc_queue_pop_batch(cutil_mpsc_queue* queue, cutil_mpsc_queue_node** nodes, size_t max_count);
+
+/**
+Returns a non zero value if the queue holds no nodes.
+This function may only be called from the consumer thread.  Nodes may be pushed by other threads at any time, so the result is only a snapshot.
+*/
+int cutil_mpsc_queue_empty(cutil_mpsc_queue* queue);
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef CUTIL_RING_H
+#define CUTIL_RING_H
+
+/** \file ring.h */
+
+#include "trait.h"
+
+#include <stddef.h>
+
+/**
+The ring is a bounded queue which stores its items in a fixed, contiguous array of slots and passes them between threads without locking.
+Rings created with cutil_ring_create may be shared by one producer thread and one consumer thread.  Rings created with cutil_ring_create_mpmc may be shared by any number of producer and consumer threads.
+Items are copied into the ring with the trait's copy function when pushed.  Popping an item moves it out of the ring, transferring ownership of any resources it holds to the caller.
+The producer and consumer positions are kept on separate cache lines so that threads at either end of the ring do not slow each other down.
+On compilers without atomic operations the ring remains safe to share between threads, but pushing and popping take a lock shared by the whole library.
+*/
+typedef struct cutil_ring cutil_ring;
+
+/**
+Creates a new ring for a single producer thread and a single consumer thread.
+\param trait trait object describing the items that will be stored by the ring.
+\param capacity the number of items the ring can hold.  It is rounded up to the next power of two.
+\returns pointer to newly created ring.  If creation failed then this function will return NULL.
+*/
+cutil_ring* cutil_ring_create(cutil_trait* trait, size_t capacity);
+
+/**
+Creates a new ring which may be shared by any number of producer and consumer threads.
+Each slot holds a sequence number which records whether it is waiting to be written or read, which lets threads claim slots with a single compare exchange.
+\param trait trait object describing the items that will be stored by the ring.
+\param capacity the number of items the ring can hold.  It is rounded up to the next power of two.
+\returns pointer to newly created ring.  If creation failed then this function will return NULL.
+*/
+cutil_ring* cutil_ring_create_mpmc(cutil_trait* trait, size_t capacity);
+
+/**
+Destroys a ring, freeing all resources used by it.
+If the ring's trait includes a destroy function, it will be called for every item remaining in the ring.
+No other thread may be using the ring.
+*/
+void cutil_ring_destroy(cutil_ring* ring);
+
+/**
+Returns a non zero value if the ring may be shared by multiple producer and consumer threads.
+*/
+int cutil_ring_is_mpmc(cutil_ring* ring);
+
+/**
+Returns the number of items the ring can hold.
+*/
+size_t cutil_ring_capacity(cutil_ring* ring);
+
+/**
+Returns the number of items in the ring.
+Other threads may push or pop items at any time, so the result is only a snapshot.
+*/
+size_t cutil_ring_size(cutil_ring* ring);
+
+/**
+Pushes an item to the back of the ring.
+\param data pointer to data of Type T* where T is the type described by the ring's trait.
+\returns non zero value if the item was pushed, or zero if the ring is full.
+*/
+int cutil_ring_push(cutil_ring* ring, void* data);
+
+/**
+Pops the item at the front of the ring.
+\param out pointer of type T* where T is the type described by the ring's trait.  The item is moved into it and is no longer owned by the ring.
+\returns non zero value if an item was popped, or zero if the ring is empty.
+*/
+int cutil_ring_pop(cutil_ring* ring, void* out);
+
+/**
+Pushes as many items from an array as will fit in the ring, in order.
+The slots for all of the items are claimed at once, which is considerably faster than pushing them individually.
+\param data array of type T where T is the type described by the ring's trait.
+\param count the number of items in the array.
+\returns the number of items that were pushed, which is less than count if the ring became full.
+*/
+size_t cutil_ring_push_batch(cutil_ring* ring, void* data, size_t count);
+
+/**
+Pops up to the specified number of items from the front of the ring into an array, in order.
+The slots for all of the items are claimed at once, which is considerably faster than popping them individually.
+\param out array of type T where T is the type described by the ring's trait.  The items are moved into it and are no longer owned by the ring.
+\param count the maximum number of items to pop.
+\returns the number of items that were popped, which is less than count if the ring became empty.
+*/
+size_t cutil_ring_pop_batch(cutil_ring* ring, void* out, size_t count);
+
+#endif
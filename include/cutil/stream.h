@@ -0,0 +1,136 @@
+#ifndef CUTIL_STREAM_H
+#define CUTIL_STREAM_H
+
+/** \file stream.h */
+
+#include <stddef.h>
+
+/**
+Stream function used by a writer to output data.
+\param data pointer to the bytes that should be written.
+\param size the number of bytes that should be written.
+\param user_data user specified data supplied when the writer was created.
+\returns the number of bytes that were written.  Returning a value less than size indicates that an error occurred.
+*/
+typedef size_t (*cutil_stream_write_func)(void* data, size_t size, void* user_data);
+
+/**
+Stream function used by a reader to request data.
+\param buffer pointer to memory that the data should be copied into.
+\param size the maximum number of bytes that should be read.
+\param user_data user specified data supplied when the reader was created.
+\returns the number of bytes that were copied into the buffer, which may be less than size.  Returning zero indicates that the end of the stream was reached or an error occurred.
+*/
+typedef size_t (*cutil_stream_read_func)(void* buffer, size_t size, void* user_data);
+
+/**
+The writer collects small writes into a buffer and passes them to its stream function in large chunks.
+Writes that are larger than the buffer are passed directly to the stream function without being copied.
+*/
+typedef struct cutil_writer cutil_writer;
+
+/**
+The reader requests data from its stream function in large chunks.
+A reader may request more data than has been consumed, so once a reader has been used to read from a stream, all subsequent reads from that stream should be made through the same reader.
+*/
+typedef struct cutil_reader cutil_reader;
+
+/** Buffer size used by writers and readers which are created with a buffer size of zero. */
+#define CUTIL_STREAM_DEFAULT_BUFFER_SIZE 65536
+
+/** @name Writer Functions
+*/
+/**@{*/
+
+/**
+Creates a new buffered writer.
+\param write_func function that will receive the buffered data.
+\param user_data user data that will be passed to the write function.
+\param buffer_size the size of the writer's buffer in bytes.  If this value is zero, CUTIL_STREAM_DEFAULT_BUFFER_SIZE will be used.
+\returns pointer to a new writer, or NULL if write_func is NULL.
+*/
+cutil_writer* cutil_writer_create(cutil_stream_write_func write_func, void* user_data, size_t buffer_size);
+
+/**
+Destroys a writer, freeing all resources used by it.
+Note that any buffered data that has not been flushed is discarded.
+*/
+void cutil_writer_destroy(cutil_writer* writer);
+
+/**
+Writes data to the stream.  Data may remain in the writer's buffer until cutil_writer_flush is called.
+Once a write has failed all subsequent writes will also fail.
+\param data pointer to the bytes that should be written.
+\param size the number of bytes to write.
+\returns non zero value if the data was written, otherwise zero.
+*/
+int cutil_writer_write(cutil_writer* writer, void* data, size_t size);
+
+/**
+Writes a size value to the stream.  Sizes are always encoded using 8 bytes in little endian order.
+\returns non zero value if the data was written, otherwise zero.
+*/
+int cutil_writer_write_size(cutil_writer* writer, size_t value);
+
+/**
+Passes all buffered data to the writer's stream function.
+\returns non zero value if all data written to the writer was successfully passed to the stream function, otherwise zero.
+*/
+int cutil_writer_flush(cutil_writer* writer);
+
+/**@}*/
+
+/** @name Reader Functions
+*/
+/**@{*/
+
+/**
+Creates a new buffered reader.
+\param read_func function that will supply data to the reader.
+\param user_data user data that will be passed to the read function.
+\param buffer_size the size of the reader's buffer in bytes.  If this value is zero, CUTIL_STREAM_DEFAULT_BUFFER_SIZE will be used.
+\returns pointer to a new reader, or NULL if read_func is NULL.
+*/
+cutil_reader* cutil_reader_create(cutil_stream_read_func read_func, void* user_data, size_t buffer_size);
+
+/**
+Destroys a reader, freeing all resources used by it.
+*/
+void cutil_reader_destroy(cutil_reader* reader);
+
+/**
+Reads data from the stream.
+\param data pointer to memory that the data should be copied into.
+\param size the number of bytes to read.
+\returns non zero value if size bytes were read, otherwise zero.
+*/
+int cutil_reader_read(cutil_reader* reader, void* data, size_t size);
+
+/**
+Reads a size value that was written with cutil_writer_write_size.
+\param value pointer that will receive the size.
+\returns non zero value if the size was read and can be represented by a size_t, otherwise zero.
+*/
+int cutil_reader_read_size(cutil_reader* reader, size_t* value);
+
+/**@}*/
+
+/** @name File Stream Functions
+*/
+/**@{*/
+
+/**
+Stream function that writes to a file.
+The user data supplied to cutil_writer_create must be a FILE* opened for writing in binary mode.
+*/
+size_t cutil_stream_file_write(void* data, size_t size, void* user_data);
+
+/**
+Stream function that reads from a file.
+The user data supplied to cutil_reader_create must be a FILE* opened for reading in binary mode.
+*/
+size_t cutil_stream_file_read(void* buffer, size_t size, void* user_data);
+
+/**@}*/
+
+#endif
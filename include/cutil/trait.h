@@ -3,6 +3,8 @@
 
 /** \file trait.h */
 
+#include "stream.h"
+
 #include <stddef.h>
 
 /**
@@ -36,10 +38,43 @@ This function will be called when an element is added to a collection.
 */
 typedef void (*cutil_trait_copy_func)(void* dest, void* src, void* user_data);
 
+/**
+Trait function for writing an element to a stream.
+For a trait describing type T, the item parameter passed into this function will be of T*.
+This function is used by the container write functions.  If a trait does not define it, the raw bytes of each element are written.
+\param item Pointer to the item that should be written.
+\param writer The writer that the item should be written to.
+\param user_data User specified data attached to the trait object.
+\returns non zero value if the item was written successfully, otherwise zero.
+*/
+typedef int (*cutil_trait_serialize_func)(void* item, cutil_writer* writer, void* user_data);
+
+/**
+Trait function for reading an element from a stream.
+For a trait describing type T, the item parameter passed into this function will be of T*.
+This function is used by the container read functions.  If a trait does not define it, the raw bytes of each element are read.
+\param item Pointer to uninitialized memory that should receive the item.  It's size will be equal to the size parameter of the trait object.
+\param reader The reader that the item should be read from.
+\param user_data User specified data attached to the trait object.
+\returns non zero value if the item was read successfully, otherwise zero.  If reading fails the item must not hold any resources.
+*/
+typedef int (*cutil_trait_deserialize_func)(void* item, cutil_reader* reader, void* user_data);
+
+/**
+Computes a hash of an element.
+Given a type T, the item parameter passed into this function will be of T*.
+This function is used by hashed containers.  Items which compare equal must have the same hash.  If a trait does not define it, the raw bytes of each element are hashed.
+\param item Pointer to the item to hash.
+\param user_data User specified data attached to the trait object.
+\returns the hash of the item.
+*/
+typedef size_t (*cutil_trait_hash_func)(void* item, void* user_data);
+
 /**
 The trait structure describes an arbitrary type of data.
 This structure is used by containers to work with generic data.
 All members of this structure are optional except for the size.
+User defined traits must be zero initialized, for example with memset, before setting the members they use, so that optional members added in later versions of the library are NULL rather than left uninitialized.
 Some containers require specific functions are defined for a type.
 Using an incompatible trait will result in the constructor for the container failing if all required functions are not present.
 */
@@ -58,6 +93,15 @@ typedef struct {
 
     /** Arbitrary data that will be passed to trait functions. This member is optional. */
     void* user_data;
+
+    /** Function used to write an element to a stream. This member is optional and may be NULL.  It is required in order to write elements of traits which define a copy or destroy function. */
+    cutil_trait_serialize_func serialize_func;
+
+    /** Function used to read an element from a stream. This member is optional and may be NULL.  It is required in order to read elements of traits which define a copy or destroy function. */
+    cutil_trait_deserialize_func deserialize_func;
+
+    /** Function used to hash an element. This member is optional and may be NULL.  It is required in order to hash elements of traits which define a copy function. */
+    cutil_trait_hash_func hash_func;
 } cutil_trait;
 
 /**
@@ -95,6 +139,7 @@ Returns a trait describing a basic cstring.
 cstring data will be copied when it is added to a container
 When retrieving cstrings from a container, the value placed in out parameters will be a pointer to the container owned cstring.  If this string needs to be perissted beyond the life of the container it should be copied.
 The pointed to string will be freed when the pointer goes out of scope.
+cstrings are written to streams as their length followed by their characters.
 Subsequent calls to this function will return the same trait object.
 \see cutil_trait_destroy()
 */
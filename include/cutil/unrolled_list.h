@@ -0,0 +1,184 @@
+#ifndef CUTIL_UNROLLED_LIST_H
+#define CUTIL_UNROLLED_LIST_H
+
+/** \file unrolled_list.h */
+
+#include "trait.h"
+
+#include <stddef.h>
+
+/**
+The unrolled list is a doubly linked list whose nodes each hold a small array of items.
+Nodes are sized to a multiple of the cache line size, so small items carry far less link and allocation overhead than in cutil_list, and a traversal touches items stored contiguously.
+Items may be pushed and popped at either end in constant time.
+*/
+typedef struct cutil_unrolled_list cutil_unrolled_list;
+typedef struct cutil_unrolled_list_itr cutil_unrolled_list_itr;
+
+/**
+A position in an unrolled list.
+The structure is exposed so that iterators can be declared on the stack and initialized with cutil_unrolled_list_itr_init, which performs no allocation.
+Its members are private and should not be accessed directly.
+*/
+struct cutil_unrolled_list_itr {
+    cutil_unrolled_list* list;
+    struct cutil_unrolled_list_node* node;
+    unsigned int index;
+};
+
+/**
+Callback used by cutil_unrolled_list_foreach to visit each item of a list.
+\param item pointer of type T* where T is the type described by the list's trait.  This points directly to the item stored in the list.
+\param user_data user data supplied to cutil_unrolled_list_foreach.
+\returns non zero value to continue the traversal or zero to stop it.
+*/
+typedef int (*cutil_unrolled_list_foreach_func)(void* item, void* user_data);
+
+/** @name List Functions
+*/
+/**@{*/
+
+/**
+Creates a new unrolled list configured to store items as described by the passed in trait.
+Nodes occupy four cache lines, or more if required to hold at least four items.
+\param trait trait object describing the items that will be stored by the list.
+\returns pointer to newly created list.  If creation failed then this function will return NULL.
+*/
+cutil_unrolled_list* cutil_unrolled_list_create(cutil_trait* trait);
+
+/**
+Creates a new unrolled list whose nodes occupy the specified number of bytes, rounded up to a multiple of the cache line size.
+\param trait trait object describing the items that will be stored by the list.
+\param node_bytes the size of each node, including its links.
+\returns pointer to newly created list.  If a node of the requested size cannot hold a single item then this function will return NULL.
+*/
+cutil_unrolled_list* cutil_unrolled_list_create_with_node_size(cutil_trait* trait, size_t node_bytes);
+
+/**
+Destroys a list, freeing all resources used by it.
+*/
+void cutil_unrolled_list_destroy(cutil_unrolled_list* list);
+
+/**
+Returns the number of elements in the list
+*/
+unsigned int cutil_unrolled_list_size(cutil_unrolled_list* list);
+
+/**
+Returns the number of items which each node of the list can hold.
+*/
+unsigned int cutil_unrolled_list_node_capacity(cutil_unrolled_list* list);
+
+/**
+Removes all items in the list.
+*/
+void cutil_unrolled_list_clear(cutil_unrolled_list* list);
+
+/**
+Removes the item at the front of the list.
+\returns non zero value if the list has a front element, otherwise zero.
+*/
+int cutil_unrolled_list_pop_front(cutil_unrolled_list* list);
+
+/**
+Removes the item at the back of the list.
+\returns non zero value if the list has a back element, otherwise zero.
+*/
+int cutil_unrolled_list_pop_back(cutil_unrolled_list* list);
+
+/**
+Gets a reference to the element at the front of the list.
+Note that the pointer placed in the out parameter is owned by the container and should be copied if it needs to be persisted beyond its lifetime.
+\param out pointer of type T* where T is the type described by the list's trait.
+\returns non zero value if the list has a front element, otherwise zero.
+*/
+int cutil_unrolled_list_front(cutil_unrolled_list* list, void* out);
+
+/**
+Gets a reference to the element at the back of the list.
+Note that the pointer placed in the out parameter is owned by the container and should be copied if it needs to be persisted beyond its lifetime.
+\param out pointer of type T* where T is the type described by the list's trait.
+\returns non zero value if the list has a back element, otherwise zero.
+*/
+int cutil_unrolled_list_back(cutil_unrolled_list* list, void* out);
+
+/**
+Pushes data to a new element at the front of the list.
+A new node is only allocated when the front node has no room before its first item.
+\param data pointer to data of Type T* where T is the type described by the list's trait.
+*/
+void cutil_unrolled_list_push_front(cutil_unrolled_list* list, void* data);
+
+/**
+Pushes data to a new element at the back of the list.
+A new node is only allocated when the back node has no room after its last item.
+\param data pointer to data of Type T* where T is the type described by the list's trait.
+*/
+void cutil_unrolled_list_push_back(cutil_unrolled_list* list, void* data);
+
+/**
+Calls a function with a pointer to each item of the list, from front to back.
+The items are visited in place without being copied, which is considerably faster than iterating for a full scan.
+The list must not be modified by the callback.
+\param callback function called for each item.  Returning zero from it stops the traversal.
+\param user_data user data passed to the callback.
+\returns the number of items the callback was called with.
+*/
+size_t cutil_unrolled_list_foreach(cutil_unrolled_list* list, cutil_unrolled_list_foreach_func callback, void* user_data);
+
+/**@}*/
+
+/** @name List Iterator Functions
+Pushing or popping items invalidates the iterators of a list.
+*/
+/**@{*/
+
+/**
+Creates a new iterator positioned before the front of the supplied list.
+\param list the list to iterate over.
+*/
+cutil_unrolled_list_itr* cutil_unrolled_list_itr_create(cutil_unrolled_list* list);
+
+/**
+Initializes an iterator in caller provided storage, positioning it before the front of the supplied list.
+The iterator holds no resources, so it is not passed to cutil_unrolled_list_itr_destroy.
+\param itr the iterator to initialize.
+\param list the list to iterate over.
+*/
+void cutil_unrolled_list_itr_init(cutil_unrolled_list_itr* itr, cutil_unrolled_list* list);
+
+/**
+Destroys an iterator created with cutil_unrolled_list_itr_create, freeing all resources used by it.
+\param itr the iterator to destroy.
+*/
+void cutil_unrolled_list_itr_destroy(cutil_unrolled_list_itr* itr);
+
+/**
+Returns a non zero value if the iterator is not at the end of the list.
+*/
+int cutil_unrolled_list_itr_has_next(cutil_unrolled_list_itr* itr);
+
+/**
+Advances the iterator position and gets the data at the next element in the iterated list.  If this method is called when the iterator is passed the end of the list, the out parameter will be untouched.
+Note that the pointer placed in the out parameter is owned by the container and should be copied if it needs to be persisted beyond its lifetime.
+\param out pointer of type T* where T is the type described by the iterator's list trait.
+\returns non zero value if data was written to the out pointer otherwise zero.
+*/
+int cutil_unrolled_list_itr_next(cutil_unrolled_list_itr* itr, void* out);
+
+/**
+Returns a non zero value if the iterator is not at the beginning of the list.
+*/
+int cutil_unrolled_list_itr_has_prev(cutil_unrolled_list_itr* itr);
+
+/**
+Decrements the iterator position and gets the data at the previous element in the iterated list.  If this method is called when the iterator is at the beginning of the list, the out parameter will be untouched.
+Note that the pointer placed in the out parameter is owned by the container and should be copied if it needs to be persisted beyond its lifetime.
+\param out pointer of type T* where T is the type described by the iterator's list trait.
+\returns non zero value if data was written to the out pointer otherwise zero.
+*/
+int cutil_unrolled_list_itr_prev(cutil_unrolled_list_itr* itr, void* out);
+
+/**@}*/
+
+#endif
@@ -4,6 +4,7 @@
 /** \file vector.h */
 
 #include "trait.h"
+#include "stream.h"
 
 /**
 The vector is an array that can grow dynamically in size as items are added to it.
@@ -11,6 +12,14 @@ Items in the vecotr are stored contiguously in memory.
 */
 typedef struct cutil_vector cutil_vector;
 
+/**
+Callback used by cutil_vector_foreach to visit each item of a vector.
+\param item pointer of type T* where T is the type described by the vector's trait.  This points directly to the item stored in the vector.
+\param user_data user data supplied to cutil_vector_foreach.
+\returns non zero value to continue the traversal or zero to stop it.
+*/
+typedef int (*cutil_vector_foreach_func)(void* item, void* user_data);
+
 /**
 Creates a new vector configured to store items as described by the passed in trait.
 \param trait trait object describing the items that will be stored by the vector.
@@ -109,6 +118,16 @@ Gets the trait assocaited with this vector.  It should not be modified.
 */
 cutil_trait* cutil_vector_trait(cutil_vector* vector);
 
+/**
+Calls a function with a pointer to each item of the vector, in index order.
+The items are visited in place without being copied, which is considerably faster than iterating for a full scan.
+The vector must not be modified by the callback.
+\param callback function called for each item.  Returning zero from it stops the traversal.
+\param user_data user data passed to the callback.
+\returns the number of items the callback was called with.
+*/
+size_t cutil_vector_foreach(cutil_vector* vector, cutil_vector_foreach_func callback, void* user_data);
+
 /**
 Gets the current capactiy of the vector.
 */
@@ -122,4 +141,24 @@ If no comparison function is defined the underlying data buffers will be compare
 */
 int cutil_vector_equals(cutil_vector* a, cutil_vector* b);
 
+/**
+Writes the items of a vector to a stream.
+Items are written with the trait's serialize function.  If the trait does not define one, the raw bytes of the items are written in a single block.
+Traits which define a copy or destroy function must define a serialize function in order to be written.
+The writer is flushed once all items have been written.
+\param vector the vector to write.
+\param writer the writer that will receive the vector's items.
+\returns non zero value if the vector was written successfully, otherwise zero.
+*/
+int cutil_vector_write(cutil_vector* vector, cutil_writer* writer);
+
+/**
+Creates a new vector containing items that were written with cutil_vector_write.
+Storage for all items is allocated up front and items are read directly into it.
+\param reader the reader to read items from.
+\param trait trait object describing the items in the stream.  Its size must match the size of the items that were written.
+\returns pointer to a newly created vector, or NULL if the items could not be read.
+*/
+cutil_vector* cutil_vector_read(cutil_reader* reader, cutil_trait* trait);
+
 #endif
@@ -0,0 +1,96 @@
+#include "atomic_private.h"
+#include "thread_private.h"
+
+/*
+Every locked operation shares this lock, so operations on different counters also exclude each other.
+Loads take the lock for reading so that they still see a completed store along with the writes which preceded it.
+*/
+static _rwlock atomic_lock = RWLOCK_INITIALIZER;
+
+int _atomic_locked_int_add(int* ptr, int delta) {
+    int result;
+
+    rwlock_write_lock_func(&atomic_lock);
+    result = *ptr += delta;
+    rwlock_write_unlock_func(&atomic_lock);
+
+    return result;
+}
+
+int _atomic_locked_int_load(int* ptr) {
+    int result;
+
+    rwlock_read_lock_func(&atomic_lock);
+    result = *ptr;
+    rwlock_read_unlock_func(&atomic_lock);
+
+    return result;
+}
+
+size_t _atomic_locked_size_add(size_t* ptr, size_t delta) {
+    size_t result;
+
+    rwlock_write_lock_func(&atomic_lock);
+    result = *ptr += delta;
+    rwlock_write_unlock_func(&atomic_lock);
+
+    return result;
+}
+
+size_t _atomic_locked_size_load(size_t* ptr) {
+    size_t result;
+
+    rwlock_read_lock_func(&atomic_lock);
+    result = *ptr;
+    rwlock_read_unlock_func(&atomic_lock);
+
+    return result;
+}
+
+void _atomic_locked_size_store(size_t* ptr, size_t value) {
+    rwlock_write_lock_func(&atomic_lock);
+    *ptr = value;
+    rwlock_write_unlock_func(&atomic_lock);
+}
+
+int _atomic_locked_size_compare_exchange(size_t* ptr, size_t expected, size_t desired) {
+    int exchanged;
+
+    rwlock_write_lock_func(&atomic_lock);
+    exchanged = *ptr == expected;
+
+    if (exchanged) {
+        *ptr = desired;
+    }
+
+    rwlock_write_unlock_func(&atomic_lock);
+
+    return exchanged;
+}
+
+void* _atomic_locked_ptr_load(void** ptr) {
+    void* result;
+
+    rwlock_read_lock_func(&atomic_lock);
+    result = *ptr;
+    rwlock_read_unlock_func(&atomic_lock);
+
+    return result;
+}
+
+void _atomic_locked_ptr_store(void** ptr, void* value) {
+    rwlock_write_lock_func(&atomic_lock);
+    *ptr = value;
+    rwlock_write_unlock_func(&atomic_lock);
+}
+
+void* _atomic_locked_ptr_exchange(void** ptr, void* value) {
+    void* previous;
+
+    rwlock_write_lock_func(&atomic_lock);
+    previous = *ptr;
+    *ptr = value;
+    rwlock_write_unlock_func(&atomic_lock);
+
+    return previous;
+}
@@ -0,0 +1,88 @@
+#ifndef CUTIL_ATOMIC_PRIVATE_H
+#define CUTIL_ATOMIC_PRIVATE_H
+
+#include <stddef.h>
+
+/*
+Minimal set of atomic operations used for counters shared between threads.
+Increment and decrement return the updated value and act as full memory barriers.
+The size variants operate on size_t counters.  Compare exchange stores the desired value only if the counter holds the expected value, and returns non zero if it did.
+The pointer variants operate on pointers shared between threads, loads acquire and stores release, while exchange acts as a full memory barrier and returns the previous value.
+*/
+
+#if defined(_MSC_VER)
+    #include <intrin.h>
+
+    typedef volatile long _atomic_int;
+
+    #define atomic_increment_func(ptr) _InterlockedIncrement(ptr)
+    #define atomic_decrement_func(ptr) _InterlockedDecrement(ptr)
+    #define atomic_load_func(ptr) (*(ptr))
+
+    #ifdef _WIN64
+        #define atomic_size_increment_func(ptr) ((size_t)_InterlockedIncrement64((volatile __int64*)(ptr)))
+        #define atomic_size_decrement_func(ptr) ((size_t)_InterlockedDecrement64((volatile __int64*)(ptr)))
+        #define atomic_size_compare_exchange_func(ptr, expected, desired) (_InterlockedCompareExchange64((volatile __int64*)(ptr), (__int64)(desired), (__int64)(expected)) == (__int64)(expected))
+    #else
+        #define atomic_size_increment_func(ptr) ((size_t)_InterlockedIncrement((volatile long*)(ptr)))
+        #define atomic_size_decrement_func(ptr) ((size_t)_InterlockedDecrement((volatile long*)(ptr)))
+        #define atomic_size_compare_exchange_func(ptr, expected, desired) (_InterlockedCompareExchange((volatile long*)(ptr), (long)(desired), (long)(expected)) == (long)(expected))
+    #endif
+    #define atomic_size_load_func(ptr) (*(volatile size_t*)(ptr))
+    #define atomic_size_store_func(ptr, value) (*(volatile size_t*)(ptr) = (value))
+
+    #define atomic_ptr_load_func(ptr) (*(void* volatile*)(ptr))
+    #define atomic_ptr_store_func(ptr, value) (*(void* volatile*)(ptr) = (value))
+    #define atomic_ptr_exchange_func(ptr, value) _InterlockedExchangePointer((void* volatile*)(ptr), (value))
+#elif defined(__GNUC__) || defined(__clang__)
+    typedef int _atomic_int;
+
+    #define atomic_increment_func(ptr) __sync_add_and_fetch((ptr), 1)
+    #define atomic_decrement_func(ptr) __sync_sub_and_fetch((ptr), 1)
+    #define atomic_load_func(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+
+    #define atomic_size_increment_func(ptr) __sync_add_and_fetch((ptr), (size_t)1)
+    #define atomic_size_decrement_func(ptr) __sync_sub_and_fetch((ptr), (size_t)1)
+    #define atomic_size_load_func(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+    #define atomic_size_store_func(ptr, value) __atomic_store_n((ptr), (size_t)(value), __ATOMIC_RELEASE)
+    #define atomic_size_compare_exchange_func(ptr, expected, desired) __sync_bool_compare_and_swap((ptr), (size_t)(expected), (size_t)(desired))
+
+    #define atomic_ptr_load_func(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+    #define atomic_ptr_store_func(ptr, value) __atomic_store_n((ptr), (value), __ATOMIC_RELEASE)
+    #define atomic_ptr_exchange_func(ptr, value) __atomic_exchange_n((ptr), (value), __ATOMIC_SEQ_CST)
+#else
+    /* no atomic operations for this compiler, every operation takes a lock shared by the whole library */
+    typedef int _atomic_int;
+
+    #define atomic_increment_func(ptr) _atomic_locked_int_add((ptr), 1)
+    #define atomic_decrement_func(ptr) _atomic_locked_int_add((ptr), -1)
+    #define atomic_load_func(ptr) _atomic_locked_int_load(ptr)
+
+    #define atomic_size_increment_func(ptr) _atomic_locked_size_add((ptr), 1)
+    #define atomic_size_decrement_func(ptr) _atomic_locked_size_add((ptr), (size_t)-1)
+    #define atomic_size_load_func(ptr) _atomic_locked_size_load(ptr)
+    #define atomic_size_store_func(ptr, value) _atomic_locked_size_store((ptr), (value))
+    #define atomic_size_compare_exchange_func(ptr, expected, desired) _atomic_locked_size_compare_exchange((ptr), (expected), (desired))
+
+    #define atomic_ptr_load_func(ptr) _atomic_locked_ptr_load((void**)(ptr))
+    #define atomic_ptr_store_func(ptr, value) _atomic_locked_ptr_store((void**)(ptr), (value))
+    #define atomic_ptr_exchange_func(ptr, value) _atomic_locked_ptr_exchange((void**)(ptr), (value))
+#endif
+
+/*
+Lock based versions of the operations above, defined in atomic.c.
+They are used in place of the atomic operations on compilers which do not provide them, and are built on every compiler so that every build checks them.
+*/
+int _atomic_locked_int_add(int* ptr, int delta);
+int _atomic_locked_int_load(int* ptr);
+
+size_t _atomic_locked_size_add(size_t* ptr, size_t delta);
+size_t _atomic_locked_size_load(size_t* ptr);
+void _atomic_locked_size_store(size_t* ptr, size_t value);
+int _atomic_locked_size_compare_exchange(size_t* ptr, size_t expected, size_t desired);
+
+void* _atomic_locked_ptr_load(void** ptr);
+void _atomic_locked_ptr_store(void** ptr, void* value);
+void* _atomic_locked_ptr_exchange(void** ptr, void* value);
+
+#endif
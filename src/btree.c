@@ -13,17 +13,8 @@
 
 void _node_clear_empty_branch_ptrs(cutil_btree* btree, _btree_node* node);
 
-void _btree_node_recursive_delete(cutil_btree* btree, _btree_node* node);
 _btree_node* _btree_find_node_for_key(cutil_btree* btree, _btree_node* node, void* key);
 
-_btree_node* _node_right_sibling(_btree_node* node);
-_btree_node* _node_left_sibling(_btree_node* node);
-
-void _set_node_child(_btree_node* parent, _btree_node* child, int index);
-void _push_up_one_level(cutil_btree* btree, _btree_node* parent, _btree_node* left_node, _btree_node* right_node, void* key, void* value);
-
-void _rebalance_node(cutil_btree* btree, _btree_node* node);
-
 unsigned int _get_pivot_index(cutil_btree* btree) {
     return (btree->order - 1) / 2 + ((btree->order - 1) % 2 != 0);
 }
@@ -59,18 +50,70 @@ cutil_trait* cutil_btree_get_value_trait(cutil_btree* btree){
     return btree->value_trait;
 }
 
+size_t _btree_align_size(size_t size, size_t alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+void _btree_node_layout_init(_btree_node_layout* layout, unsigned int order, size_t key_size, size_t value_size, int key_prefixes, int concurrent) {
+    size_t offset = _btree_align_size(sizeof(_btree_node), BTREE_NODE_ARRAY_ALIGNMENT);
+
+    layout->keys_offset = offset;
+    offset = _btree_align_size(offset + (order - 1) * key_size, BTREE_NODE_ARRAY_ALIGNMENT);
+
+    layout->values_offset = offset;
+    offset = _btree_align_size(offset + (order - 1) * value_size, BTREE_NODE_ARRAY_ALIGNMENT);
+
+    layout->branches_offset = offset;
+    offset = _btree_align_size(offset + order * sizeof(_btree_node*), BTREE_NODE_ARRAY_ALIGNMENT);
+
+    layout->key_prefixes_offset = 0;
+    layout->latch_offset = 0;
+
+    if (key_prefixes) {
+        layout->key_prefixes_offset = offset;
+        offset = _btree_align_size(offset + (order - 1) * BTREE_KEY_PREFIX_SIZE, BTREE_NODE_ARRAY_ALIGNMENT);
+    }
+
+    if (concurrent) {
+        layout->latch_offset = offset;
+        offset = _btree_align_size(offset + sizeof(_rwlock), BTREE_NODE_ARRAY_ALIGNMENT);
+    }
+
+    layout->size = offset;
+}
+
 _btree_node* _node_create(cutil_btree* btree) {
     cutil_allocator* allocator = cutil_current_allocator();
-    _btree_node* node = allocator->malloc(sizeof(_btree_node), allocator->user_data);
-
+    _btree_node_layout* layout = &btree->node_layout;
+    void* allocation = allocator->malloc(layout->size + BTREE_NODE_ALIGNMENT - 1, allocator->user_data);
+    size_t misalignment = (size_t)allocation % BTREE_NODE_ALIGNMENT;
+    char* block = (char*)allocation + (misalignment ? BTREE_NODE_ALIGNMENT - misalignment : 0);
+    _btree_node* node = (_btree_node*)block;
+
+    /* only the branches are read past the item count, leaf detection relies on branches[0] being NULL */
+    memset(block + layout->branches_offset, 0, btree->order * sizeof(_btree_node*));
+
+    node->ref_count = 1;
+    node->rebalance_pending = 0;
+    node->latch = NULL;
     node->parent = NULL;
     node->position = 0;
     node->item_count = 0;
+    node->allocation = allocation;
+
+    node->keys = block + layout->keys_offset;
+    node->values = block + layout->values_offset;
+    node->branches = (_btree_node**)(block + layout->branches_offset);
+    node->key_prefixes = NULL;
 
-    node->keys = calloc(btree->order - 1, btree->key_trait->size);
-    node->values = calloc(btree->order - 1, btree->value_trait->size);
+    if (layout->key_prefixes_offset) {
+        node->key_prefixes = (unsigned char*)block + layout->key_prefixes_offset;
+    }
 
-    node->branches = calloc(btree->order, sizeof(_btree_node* ));
+    if (layout->latch_offset) {
+        node->latch = (_rwlock*)(block + layout->latch_offset);
+        rwlock_init_func(node->latch);
+    }
 
     return node;
 }
@@ -79,13 +122,14 @@ void _node_destroy(cutil_btree* btree, _btree_node* node) {
     cutil_allocator* allocator = cutil_current_allocator();
     (void)btree;
 
-    allocator->free(node->values, allocator->user_data);
-    allocator->free(node->keys, allocator->user_data);
-    allocator->free(node->branches, allocator->user_data);
-    allocator->free(node, allocator->user_data);
+    if (node->latch) {
+        rwlock_destroy_func(node->latch);
+    }
+
+    allocator->free(node->allocation, allocator->user_data);
 }
 
-cutil_btree* cutil_btree_create(unsigned int order, cutil_trait* key_trait, cutil_trait* value_trait) {
+cutil_btree* _btree_create(unsigned int order, cutil_trait* key_trait, cutil_trait* value_trait, int concurrent, int key_prefixes) {
     cutil_allocator* allocator = cutil_current_allocator();
     cutil_btree* btree = NULL;
 
@@ -107,22 +151,131 @@ cutil_btree* cutil_btree_create(unsigned int order, cutil_trait* key_trait, cuti
     btree->size = 0;
     btree->key_trait = key_trait;
     btree->value_trait = value_trait;
+    btree->key_search_func = _btree_key_search_func_for_trait(key_trait);
+    btree->key_prefixes = key_prefixes;
+    btree->read_only = 0;
+    _btree_node_layout_init(&btree->node_layout, order, key_trait->size, value_trait->size, btree->key_prefixes, concurrent);
+    btree->relaxed_rebalance = 0;
+    btree->rebalance_pending = 0;
+    btree->concurrent = concurrent;
+    btree->root_latch = NULL;
+    btree->mapping = NULL;
+
+    if (concurrent) {
+        btree->root_latch = allocator->malloc(sizeof(_rwlock), allocator->user_data);
+        rwlock_init_func(btree->root_latch);
+    }
+
     btree->root = _node_create(btree);
 
     return btree;
 }
 
+cutil_btree* cutil_btree_create(unsigned int order, cutil_trait* key_trait, cutil_trait* value_trait) {
+    return _btree_create(order, key_trait, value_trait, 0, 0);
+}
+
+cutil_btree* cutil_btree_create_string(unsigned int order, cutil_trait* value_trait) {
+    return _btree_create(order, cutil_trait_cstring(), value_trait, 0, 1);
+}
+
+cutil_btree* cutil_btree_create_concurrent(unsigned int order, cutil_trait* key_trait, cutil_trait* value_trait) {
+    return _btree_create(order, key_trait, value_trait, 1, 0);
+}
+
+/*
+Returns the largest order whose nodes fit in the supplied number of bytes, or 2 if a node of order 3 does not fit.
+Every item adds at least one branch pointer to a node, which bounds the search.
+*/
+unsigned int _btree_order_for_node_size(size_t node_size, cutil_trait* key_trait, cutil_trait* value_trait) {
+    size_t max_order = node_size / sizeof(_btree_node*) + 1;
+    unsigned int low = 2, high;
+    _btree_node_layout layout;
+
+    high = max_order < UINT_MAX ? (unsigned int)max_order : UINT_MAX;
+
+    while (low < high) {
+        unsigned int order = low + (high - low + 1) / 2;
+
+        _btree_node_layout_init(&layout, order, key_trait->size, value_trait->size, 0, 0);
+
+        if (layout.size <= node_size) {
+            low = order;
+        }
+        else {
+            high = order - 1;
+        }
+    }
+
+    return low;
+}
+
+cutil_btree* cutil_btree_create_for_page(size_t page_bytes, cutil_trait* key_trait, cutil_trait* value_trait) {
+    if (key_trait == NULL || value_trait == NULL) {
+        return NULL;
+    }
+
+    return _btree_create(_btree_order_for_node_size(page_bytes, key_trait, value_trait), key_trait, value_trait, 0, 0);
+}
+
 void cutil_btree_destroy(cutil_btree* btree) {
     cutil_allocator* allocator = cutil_current_allocator();
 
-    _btree_node_recursive_delete(btree, btree->root);
+    if (btree->mapping) {
+        _btree_mapping_close(btree->mapping);
+    }
+    else {
+        _node_release(btree, btree->root);
+    }
+
+    if (btree->root_latch) {
+        rwlock_destroy_func(btree->root_latch);
+        allocator->free(btree->root_latch, allocator->user_data);
+    }
+
     allocator->free(btree, allocator->user_data);
 }
 
-void _btree_node_recursive_delete(cutil_btree* btree, _btree_node* node) {
+int cutil_btree_is_concurrent(cutil_btree* btree) {
+    return btree->concurrent;
+}
+
+cutil_btree* cutil_btree_snapshot(cutil_btree* btree) {
+    cutil_allocator* allocator = cutil_current_allocator();
+    cutil_btree* snapshot;
+
+    /* writers of concurrent btrees do not hold latches on every ancestor of the nodes they modify, so nodes cannot be path copied */
+    if (btree->concurrent) {
+        return NULL;
+    }
+
+    /* mapped btrees can never be modified, so there is no need to snapshot them */
+    if (btree->mapping) {
+        return NULL;
+    }
+
+    snapshot = allocator->malloc(sizeof(cutil_btree), allocator->user_data);
+
+    memcpy(snapshot, btree, sizeof(cutil_btree));
+    snapshot->read_only = 1;
+
+    atomic_increment_func(&btree->root->ref_count);
+
+    return snapshot;
+}
+
+int cutil_btree_is_snapshot(cutil_btree* btree) {
+    return btree->read_only && btree->mapping == NULL;
+}
+
+void _node_release(cutil_btree* btree, _btree_node* node) {
     cutil_trait* trait = btree->key_trait;
     unsigned int i;
 
+    if (atomic_decrement_func(&node->ref_count) > 0) {
+        return;
+    }
+
     if (trait->destroy_func) {
         for (i = 0; i < node->item_count; i++) {
             trait->destroy_func(_node_get_key(node, trait, i), trait->user_data);
@@ -138,13 +291,71 @@ void _btree_node_recursive_delete(cutil_btree* btree, _btree_node* node) {
 
     if (!_node_is_leaf(node)) {
         for (i = 0; i <= node->item_count; i++) {
-            _btree_node_recursive_delete(btree, node->branches[i]);
+            _node_release(btree, node->branches[i]);
         }
     }
 
     _node_destroy(btree, node);
 }
 
+/*
+Creates a copy of a node that owns copies of all its items and holds a new reference to each of its children.
+The children's parent pointers are updated to point at the new node.
+*/
+_btree_node* _node_clone(cutil_btree* btree, _btree_node* node) {
+    _btree_node* clone = _node_create(btree);
+    unsigned int i;
+
+    for (i = 0; i < node->item_count; i++) {
+        _copy_with_trait(_node_get_key(clone, btree->key_trait, i), _node_get_key(node, btree->key_trait, i), btree->key_trait);
+        _copy_with_trait(_node_get_value(clone, btree->value_trait, i), _node_get_value(node, btree->value_trait, i), btree->value_trait);
+    }
+
+    if (node->key_prefixes) {
+        memcpy(clone->key_prefixes, node->key_prefixes, node->item_count * BTREE_KEY_PREFIX_SIZE);
+    }
+
+    clone->item_count = node->item_count;
+    clone->rebalance_pending = node->rebalance_pending;
+
+    if (!_node_is_leaf(node)) {
+        for (i = 0; i <= node->item_count; i++) {
+            atomic_increment_func(&node->branches[i]->ref_count);
+            _set_node_child(clone, node->branches[i], i);
+        }
+    }
+
+    return clone;
+}
+
+_btree_node* _btree_node_unshare(cutil_btree* btree, _btree_node* node) {
+    _btree_node* parent = NULL;
+    _btree_node* clone;
+
+    /* copying a shared ancestor adds a reference to each of its children, so the path is unshared from the root down */
+    if (!_node_is_root(node)) {
+        parent = _btree_node_unshare(btree, node->parent);
+    }
+
+    if (atomic_load_func(&node->ref_count) == 1) {
+        return node;
+    }
+
+    clone = _node_clone(btree, node);
+
+    if (parent) {
+        _set_node_child(parent, clone, node->position);
+    }
+    else {
+        btree->root = clone;
+    }
+
+    /* a snapshot may have been destroyed since the reference count was checked, so this may be the last reference */
+    _node_release(btree, node);
+
+    return clone;
+}
+
 /*
 The leaf node must be split, and the position of the new item is greater than the pivot index of the node.
 This means the new item will be located in the new split node.
@@ -168,8 +379,7 @@ void _split_node_right(cutil_btree* btree, _btree_node* interior_node, _btree_no
     }
 
     /* insert the new item in the new split node */
-    memcpy(_node_get_key(split_node, btree->key_trait, split_node_key_index), key, btree->key_trait->size);
-    memcpy(_node_get_value(split_node, btree->value_trait, split_node_key_index), value, btree->value_trait->size);
+    _node_set_item(btree, split_node, split_node_key_index, key, value);
 
     /* copy items after the new item's position */
     item_count = (int)interior_node->item_count - insert_position;
@@ -263,8 +473,7 @@ void _split_node_left(cutil_btree* btree, _btree_node* interior_node, _btree_nod
     }
 
     /* add in the new key and its children to the interior node*/
-    memcpy(_node_get_key(interior_node, btree->key_trait, insert_position), key, btree->key_trait->size);
-    memcpy(_node_get_value(interior_node, btree->value_trait, insert_position), value, btree->value_trait->size);
+    _node_set_item(btree, interior_node, insert_position, key, value);
 
     interior_node->item_count = pivot_index;
     _node_clear_empty_branch_ptrs(btree, interior_node);
@@ -286,6 +495,9 @@ void _split_interior_node(cutil_btree* btree, _btree_node* interior_node, _btree
 
     _btree_node* split_node = _node_create(btree);
 
+    /* either half may receive the marked children of a relaxed btree */
+    split_node->rebalance_pending = interior_node->rebalance_pending;
+
     /* the newly inserted key appears in the new split node. */
     if (insert_position > pivot_index) {
         memcpy(pivot_key, _node_get_key(interior_node, btree->key_trait, pivot_index), btree->key_trait->size);
@@ -312,9 +524,9 @@ void _split_interior_node(cutil_btree* btree, _btree_node* interior_node, _btree
 
         btree->root = new_root_node;
         new_root_node->item_count = 1;
+        new_root_node->rebalance_pending = interior_node->rebalance_pending;
 
-        memcpy(new_root_node->keys, pivot_key, btree->key_trait->size);
-        memcpy(new_root_node->values, pivot_value, btree->value_trait->size);
+        _node_set_item(btree, new_root_node, 0, pivot_key, pivot_value);
 
         _set_node_child(new_root_node, interior_node, 0);
         _set_node_child(new_root_node, split_node, 1);
@@ -348,8 +560,7 @@ void _push_up_one_level(cutil_btree* btree, _btree_node* parent, _btree_node* le
             _set_node_child(parent, parent->branches[i - 1], i);
         }
 
-        memcpy(_node_get_key(parent, btree->key_trait, insertion_point), key, btree->key_trait->size);
-        memcpy(_node_get_value(parent, btree->value_trait, insertion_point), value, btree->value_trait->size);
+        _node_set_item(btree, parent, insertion_point, key, value);
 
         _set_node_child(parent, left_node, insertion_point);
         _set_node_child(parent, right_node, insertion_point + 1);
@@ -361,8 +572,9 @@ void _push_up_one_level(cutil_btree* btree, _btree_node* parent, _btree_node* le
 /*
 Called when the target node for insertion cannot accommodate a new new item.
 The node can be split in three ways, depending on the relationship between the insertion position and pivot index of the node.
+Returns the new node holding the items to the right of the pivot.
 */
-void _split_leaf_node(cutil_btree* btree, _btree_node* node, void* key, void* value, unsigned int insert_position) {
+_btree_node* _split_leaf_node(cutil_btree* btree, _btree_node* node, void* key, void* value, unsigned int insert_position) {
     /* get key that will be pushed up (ceil) */
     unsigned int pivot_index = _get_pivot_index(btree);
     _btree_node* new_right_node = _node_create(btree);
@@ -390,10 +602,10 @@ void _split_leaf_node(cutil_btree* btree, _btree_node* node, void* key, void* va
     if (_node_is_root(node)) {
         _btree_node*  new_root = _node_create(btree);
 
-        memcpy(new_root->keys, pivot_key, btree->key_trait->size);
-        memcpy(new_root->values, pivot_value, btree->value_trait->size);
+        _node_set_item(btree, new_root, 0, pivot_key, pivot_value);
 
         new_root->item_count = 1;
+        new_root->rebalance_pending = node->rebalance_pending;
 
         _set_node_child(new_root, node, 0);
         _set_node_child(new_root, new_right_node, 1);
@@ -403,6 +615,8 @@ void _split_leaf_node(cutil_btree* btree, _btree_node* node, void* key, void* va
     else {
         _push_up_one_level(btree, node->parent, node, new_right_node, pivot_key, pivot_value);
     }
+
+    return new_right_node;
 }
 
 
@@ -416,6 +630,19 @@ void _node_copy_item(cutil_btree* btree, _btree_node* dest_node, size_t dest_ind
     src_ptr = _node_get_value(src_node, btree->value_trait, src_index);
 
     memcpy(dest_ptr, src_ptr, btree->value_trait->size);
+
+    if (dest_node->key_prefixes) {
+        memmove(dest_node->key_prefixes + dest_index * BTREE_KEY_PREFIX_SIZE, src_node->key_prefixes + src_index * BTREE_KEY_PREFIX_SIZE, BTREE_KEY_PREFIX_SIZE);
+    }
+}
+
+void _node_set_item(cutil_btree* btree, _btree_node* node, size_t index, void* key, void* value) {
+    memcpy(_node_get_key(node, btree->key_trait, index), key, btree->key_trait->size);
+    memcpy(_node_get_value(node, btree->value_trait, index), value, btree->value_trait->size);
+
+    if (node->key_prefixes) {
+        _btree_key_prefix(node->key_prefixes + index * BTREE_KEY_PREFIX_SIZE, key);
+    }
 }
 
 /*
@@ -433,9 +660,46 @@ void _copy_with_trait(void* dest, void* src, cutil_trait* trait) {
 }
 
 
+/*
+Inserts an item into a leaf node at the supplied position, splitting the node if it is full.
+The key and value are moved into the tree as is, callers are responsible for copying them with their traits beforehand.
+Returns the new right node if the node was split, otherwise NULL.
+*/
+_btree_node* _btree_leaf_insert(cutil_btree* btree, _btree_node* node, unsigned int insert_position, void* key, void* value) {
+    if (_node_full(btree, node)) {
+        return _split_leaf_node(btree, node, key, value, insert_position);
+    }
+    else {
+        unsigned int i;
+
+        /* make room for new key in leaf node */
+        for (i = node->item_count; i > insert_position; i--) {
+            _node_copy_item(btree, node, i, node, i - 1);
+        }
+
+        _node_set_item(btree, node, insert_position, key, value);
+
+        node->item_count += 1;
+    }
+
+    return NULL;
+}
+
 void cutil_btree_insert(cutil_btree* btree, void* key, void* value) {
-    _btree_node* node = _btree_find_node_for_key(btree, btree->root, key);
-    unsigned int i, insert_position = _node_get_insertion_position(btree, node, key);
+    _btree_node* node;
+    unsigned int insert_position;
+    void* new_key, *new_value;
+
+    if (btree->read_only) {
+        return;
+    }
+    else if (btree->concurrent) {
+        _btree_concurrent_insert(btree, key, value);
+        return;
+    }
+
+    node = _btree_node_unshare(btree, _btree_find_node_for_key(btree, btree->root, key));
+    insert_position = _node_get_insertion_position(btree, node, key);
 
     /* if the key is already present in the btree then we just need to replace the value */
     if (insert_position >= btree->order) {
@@ -449,42 +713,117 @@ void cutil_btree_insert(cutil_btree* btree, void* key, void* value) {
         return;
     }
 
-    if (_node_full(btree, node)) {
-        cutil_allocator* allocator = cutil_current_allocator();
-        void* copied_key = allocator->malloc(sizeof(btree->key_trait->size), allocator->user_data);
-        void* copied_value = allocator->malloc(sizeof(btree->value_trait->size), allocator->user_data);
+    new_key = alloca_func(btree->key_trait->size);
+    new_value = alloca_func(btree->value_trait->size);
 
-        _copy_with_trait(copied_key, key, btree->key_trait);
-        _copy_with_trait(copied_value, value, btree->value_trait);
+    _copy_with_trait(new_key, key, btree->key_trait);
+    _copy_with_trait(new_value, value, btree->value_trait);
 
-        _split_leaf_node(btree, node, copied_key, copied_value, insert_position);
+    _btree_leaf_insert(btree, node, insert_position, new_key, new_value);
+    btree->size += 1;
+}
+
+/*
+Inserts a key that is known to not be present in the tree and returns a pointer to its value slot.
+The key will be copied according to the key trait, the value is moved into the tree as is.
+*/
+void* _btree_insert_new_item(cutil_btree* btree, _btree_node* node, unsigned int insert_position, void* key, void* value) {
+    void* new_key = alloca_func(btree->key_trait->size);
+    unsigned int pivot_index = _get_pivot_index(btree);
+    _btree_node* new_right_node;
 
-        allocator->free(copied_key, allocator->user_data);
-        allocator->free(copied_value, allocator->user_data);
+    _copy_with_trait(new_key, key, btree->key_trait);
+    new_right_node = _btree_leaf_insert(btree, node, insert_position, new_key, value);
+    btree->size += 1;
+
+    if (new_right_node == NULL || insert_position < pivot_index) {
+        return _node_get_value(node, btree->value_trait, insert_position);
+    }
+    else if (insert_position > pivot_index) {
+        return _node_get_value(new_right_node, btree->value_trait, insert_position - pivot_index - 1);
     }
-    else {
-        void* new_key, *new_value;
 
-        /* make room for new key in leaf node */
-        for (i = node->item_count; i > insert_position; i--) {
-            _node_copy_item(btree, node, i, node, i - 1);
+    /* the new item became the pivot, which separates the node from the new right node in their closest common ancestor */
+    while (node->position == node->parent->item_count) {
+        node = node->parent;
+    }
+
+    return _node_get_value(node->parent, btree->value_trait, node->position);
+}
+
+void* cutil_btree_get_or_insert(cutil_btree* btree, void* key, void* default_value, int* inserted) {
+    _btree_node* node;
+    unsigned int insert_position;
+    void* new_value;
+
+    /* pointers into a concurrent btree may be invalidated by other threads at any time */
+    if (btree->read_only || btree->concurrent) {
+        return NULL;
+    }
+
+    node = _btree_node_unshare(btree, _btree_find_node_for_key(btree, btree->root, key));
+    insert_position = _node_get_insertion_position(btree, node, key);
+
+    if (insert_position >= btree->order) {
+        if (inserted) {
+            *inserted = 0;
         }
 
-        new_key = _node_get_key(node, btree->key_trait, insert_position);
-        new_value = _node_get_value(node, btree->value_trait, insert_position);
+        return _node_get_value(node, btree->value_trait, insert_position - btree->order);
+    }
 
-        _copy_with_trait(new_key, key, btree->key_trait);
-        _copy_with_trait(new_value, value, btree->value_trait);
+    if (inserted) {
+        *inserted = 1;
+    }
 
-        node->item_count += 1;
+    new_value = alloca_func(btree->value_trait->size);
+    _copy_with_trait(new_value, default_value, btree->value_trait);
+
+    return _btree_insert_new_item(btree, node, insert_position, key, new_value);
+}
+
+int cutil_btree_upsert(cutil_btree* btree, void* key, cutil_btree_upsert_func update_func, void* user_data) {
+    _btree_node* node;
+    unsigned int insert_position;
+    void* value;
+
+    if (btree->read_only) {
+        return 0;
+    }
+    else if (btree->concurrent) {
+        return _btree_concurrent_upsert(btree, key, update_func, user_data);
     }
 
-    btree->size += 1;
+    node = _btree_node_unshare(btree, _btree_find_node_for_key(btree, btree->root, key));
+    insert_position = _node_get_insertion_position(btree, node, key);
+
+    if (insert_position >= btree->order) {
+        value = _node_get_value(node, btree->value_trait, insert_position - btree->order);
+        update_func(value, 0, user_data);
+
+        return 0;
+    }
+
+    /* the update function is responsible for initializing the value of a newly inserted item */
+    value = alloca_func(btree->value_trait->size);
+    memset(value, 0, btree->value_trait->size);
+
+    value = _btree_insert_new_item(btree, node, insert_position, key, value);
+    update_func(value, 1, user_data);
+
+    return 1;
 }
 
 int cutil_btree_get(cutil_btree* btree, void* key, void* value) {
-    _btree_node*  node = _btree_find_node_for_key(btree, btree->root, key);
-    int position = _node_key_position(btree, node, key);
+    _btree_node* node;
+    int position;
+
+    if (btree->concurrent) {
+        return _btree_concurrent_get(btree, key, value);
+    }
+
+    node = _btree_find_node_for_key(btree, btree->root, key);
+    position = _node_key_position(btree, node, key);
 
     if (position == ITEM_NOT_PRESENT) {
         return 0;
@@ -497,28 +836,116 @@ int cutil_btree_get(cutil_btree* btree, void* key, void* value) {
     }
 }
 
+void _btree_prefetch_node(cutil_btree* btree, _btree_node* node) {
+    _btree_node_layout* layout = &btree->node_layout;
+    char* block = (char*)node;
+
+    prefetch_func(block);
+
+    /* nodes of mapped btrees are not laid out in a single block */
+    if (layout->size == 0) {
+        return;
+    }
+
+    prefetch_func(block + layout->keys_offset);
+    prefetch_func(block + layout->branches_offset);
+
+    if (layout->key_prefixes_offset) {
+        prefetch_func(block + layout->key_prefixes_offset);
+    }
+
+    if (layout->latch_offset) {
+        prefetch_func(block + layout->latch_offset);
+    }
+}
+
 _btree_node* _btree_find_node_for_key(cutil_btree* btree, _btree_node* node, void* key) {
     if (_node_is_leaf(node)) {
         return node;
     }
     else {
         /* find the correct branch to traverse down */
-        unsigned int i;
-        for (i = 0; i < node->item_count; i++) {
-            void* item_key = _node_get_key(node, btree->key_trait, i);
-            int key_comp = btree->key_trait->compare_func(key, item_key, btree->key_trait->user_data);
+        int found;
+        unsigned int position;
 
-            if (key_comp < 0) {
-                return _btree_find_node_for_key(btree, node->branches[i], key);
+        position = _btree_search_node(btree, node, key, &found);
+
+        if (found) {
+            return node;
+        }
+
+        _btree_prefetch_node(btree, node->branches[position]);
+
+        return _btree_find_node_for_key(btree, node->branches[position], key);
+    }
+}
+
+/*
+Walks up the tree from a node located by a previous search until reaching a node whose key range contains the supplied key.
+Searching from the returned node instead of the root avoids repeating the upper levels of the descent for keys that are close together.
+*/
+_btree_node* _btree_find_search_start(cutil_btree* btree, _btree_node* node, void* key) {
+    cutil_trait* key_trait = btree->key_trait;
+
+    while (!_node_is_root(node)) {
+        _btree_node* parent = node->parent;
+
+        /* nodes at the edges of their parent have a bound that is defined further up the tree */
+        if (node->position > 0 && node->position < parent->item_count) {
+            void* lower_bound = _node_get_key(parent, key_trait, node->position - 1);
+            void* upper_bound = _node_get_key(parent, key_trait, node->position);
+
+            if (key_trait->compare_func(key, lower_bound, key_trait->user_data) > 0 &&
+                key_trait->compare_func(key, upper_bound, key_trait->user_data) < 0) {
+                break;
             }
-            else if (key_comp == 0){
-                return node;
+        }
+
+        node = parent;
+    }
+
+    return node;
+}
+
+size_t cutil_btree_get_many(cutil_btree* btree, void* keys, size_t count, void* out_values, unsigned char* found_mask) {
+    _btree_node* node = btree->concurrent ? NULL : btree->root;
+    size_t key_size = btree->key_trait->size;
+    size_t value_size = btree->value_trait->size;
+    size_t i, found_count = 0;
+
+    for (i = 0; i < count; i++) {
+        void* key = (char*)keys + i * key_size;
+        unsigned int position;
+
+        /* nodes of a concurrent btree may change between searches, so each key is located independently */
+        if (btree->concurrent) {
+            int found = _btree_concurrent_get(btree, key, (char*)out_values + i * value_size);
+
+            found_count += found;
+
+            if (found_mask) {
+                found_mask[i] = (unsigned char)found;
             }
+
+            continue;
         }
 
-        /* search key is greater than the largest item in this node */
-        return _btree_find_node_for_key(btree, node->branches[node->item_count], key);
+        /* parent pointers are not maintained for snapshots so each search must begin at the root */
+        node = btree->read_only ? btree->root : _btree_find_search_start(btree, node, key);
+        node = _btree_find_node_for_key(btree, node, key);
+        position = _node_key_position(btree, node, key);
+
+        if (position != ITEM_NOT_PRESENT) {
+            memcpy((char*)out_values + i * value_size, _node_get_value(node, btree->value_trait, position), value_size);
+            found_count += 1;
+        }
+
+        if (found_mask) {
+            found_mask[i] = (unsigned char)(position != ITEM_NOT_PRESENT);
+        }
     }
+
+    return found_count;
 }
 
 /* TODO: use integer ceiling */
@@ -596,7 +1023,10 @@ void _btree_borrow_from_left_sibling(cutil_btree* btree, _btree_node* node, _btr
     unsigned int i;
     for (i = node->item_count; i >= 1; i--) {
         _node_copy_item(btree, node, i, node, i - 1);
-        node->branches[i + 1] = node->branches[i];
+    }
+
+    for (i = node->item_count + 1; i >= 1; i--) {
+        _set_node_child(node, node->branches[i - 1], i);
     }
 
     /* move the corresponding key from the parent to the first item of the node's key array */
@@ -616,7 +1046,6 @@ void _btree_borrow_from_left_sibling(cutil_btree* btree, _btree_node* node, _btr
     the lowest value key from the sibling will be borrowed so that a value from the nodes parent can be used to ensure the target has enough keys*/
 void _btree_borrow_from_right_sibling(cutil_btree* btree, _btree_node* node, _btree_node* right_sibling) {
     unsigned int i;
-    unsigned int copy_count = _node_is_leaf(node) ? right_sibling->item_count -1 : right_sibling->item_count;
 
     /* first take our corresponding key from our parent and add it to the end of our key list and increment our item count */
     _node_copy_item(btree, node, node->item_count++, node->parent, node->position);
@@ -629,11 +1058,15 @@ void _btree_borrow_from_right_sibling(cutil_btree* btree, _btree_node* node, _bt
 
     /* adjust the remaining keys and branches for the right sibling */
 
-    for (i = 1; i <= copy_count; i++) {
+    for (i = 1; i < right_sibling->item_count; i++) {
         _node_copy_item(btree, right_sibling, i - 1, right_sibling, i);
+    }
+
+    for (i = 1; i <= right_sibling->item_count; i++) {
         _set_node_child(right_sibling, right_sibling->branches[i], i - 1);
     }
 
+    right_sibling->branches[right_sibling->item_count] = NULL;
     right_sibling->item_count -= 1;
 }
 
@@ -642,11 +1075,25 @@ if we are rebalancing the root and it has no keys, then we need to promote its c
 if the rebalanced node is short on keys then we will need to either borrow or steal one from our neighbor
 first we check if we can borrow from the left or right, if not, then we will merge */
 void _rebalance_node(cutil_btree* btree, _btree_node* node) {
+    _btree_rebalance_node_below(btree, node, _btree_rebalance_threshold(btree));
+}
+
+void _btree_rebalance_node_below(cutil_btree* btree, _btree_node* node, unsigned int threshold) {
     unsigned int min_item_count = _btree_node_min_item_count(btree);
+
     if (node->item_count >= min_item_count) {
         return;
     }
 
+    /* relaxed btrees leave short nodes in place until they are flushed */
+    if (node->item_count >= threshold) {
+        if (node != btree->root) {
+            _btree_rebalance_mark(btree, node);
+        }
+
+        return;
+    }
+
     if (node == btree->root) {
         if (node->item_count == 0 && !_node_is_leaf(node)) {
             _btree_node* old_root = btree->root;
@@ -659,20 +1106,53 @@ void _rebalance_node(cutil_btree* btree, _btree_node* node) {
     else {
         _btree_node* right_sibling = _node_right_sibling(node);
         _btree_node* left_sibling = _node_left_sibling(node);
+        _btree_node* moved_child;
 
-        if (right_sibling && right_sibling->item_count > min_item_count) {
+        /* the node and its ancestors have already been unshared, but the sibling that is modified may still be shared with a snapshot */
+        if (right_sibling && right_sibling->item_count > threshold) {
+            right_sibling = _btree_node_unshare(btree, right_sibling);
             _btree_borrow_from_right_sibling(btree, node, right_sibling);
+
+            /* a relaxed borrow may leave either node short, or move a marked subtree to the node */
+            if (threshold < min_item_count) {
+                moved_child = node->branches[node->item_count];
+                _btree_rebalance_mark_moved(btree, node, right_sibling, moved_child && moved_child->rebalance_pending);
+            }
         }
-        else if (left_sibling && left_sibling->item_count > min_item_count) {
+        else if (left_sibling && left_sibling->item_count > threshold) {
+            left_sibling = _btree_node_unshare(btree, left_sibling);
             _btree_borrow_from_left_sibling(btree, node, left_sibling);
+
+            if (threshold < min_item_count) {
+                moved_child = node->branches[0];
+                _btree_rebalance_mark_moved(btree, node, left_sibling, moved_child && moved_child->rebalance_pending);
+            }
         }
         else if (node->position == 0) {
-            _btree_node* next_node = _btree_merge_node_with_right_sibling(btree, node);
-            _rebalance_node(btree, next_node->parent);
+            _btree_node* next_node;
+            unsigned int moved_pending;
+
+            right_sibling = _btree_node_unshare(btree, right_sibling);
+            moved_pending = right_sibling->rebalance_pending;
+            next_node = _btree_merge_node_with_right_sibling(btree, node);
+
+            if (threshold < min_item_count) {
+                _btree_rebalance_mark_moved(btree, next_node, NULL, moved_pending);
+            }
+
+            _btree_rebalance_node_below(btree, next_node->parent, threshold);
         }
         else {
-            _btree_node* next_node = _btree_merge_node_with_right_sibling(btree, _node_left_sibling(node));
-            _rebalance_node(btree, next_node->parent);
+            _btree_node* next_node;
+            unsigned int moved_pending = node->rebalance_pending;
+
+            next_node = _btree_merge_node_with_right_sibling(btree, _btree_node_unshare(btree, left_sibling));
+
+            if (threshold < min_item_count) {
+                _btree_rebalance_mark_moved(btree, next_node, NULL, moved_pending);
+            }
+
+            _btree_rebalance_node_below(btree, next_node->parent, threshold);
         }
     }
 }
@@ -695,6 +1175,8 @@ void _btree_delete_from_interior(cutil_btree* btree, _btree_node* node, unsigned
         max_leaf = max_leaf->branches[max_leaf->item_count];
     }
 
+    max_leaf = _btree_node_unshare(btree, max_leaf);
+
     /* place the greatest value of maxnode in the deleted item's position */
     _node_copy_item(btree, node, item_pos, max_leaf, max_leaf->item_count - 1);
     max_leaf->item_count -= 1;
@@ -703,10 +1185,21 @@ void _btree_delete_from_interior(cutil_btree* btree, _btree_node* node, unsigned
 }
 
 int cutil_btree_erase(cutil_btree* btree, void* key) {
-    _btree_node*  node = _btree_find_node_for_key(btree, btree->root, key);
-    unsigned int item_pos = _node_key_position(btree, node, key);
+    _btree_node* node;
+    unsigned int item_pos;
+
+    if (btree->read_only) {
+        return 0;
+    }
+    else if (btree->concurrent) {
+        return _btree_concurrent_erase(btree, key);
+    }
+
+    node = _btree_find_node_for_key(btree, btree->root, key);
+    item_pos = _node_key_position(btree, node, key);
 
     if (item_pos != ITEM_NOT_PRESENT) {
+        node = _btree_node_unshare(btree, node);
 
         if (btree->key_trait->destroy_func) {
             void* item_key = _node_get_key(node, btree->key_trait, item_pos);
@@ -735,20 +1228,40 @@ int cutil_btree_erase(cutil_btree* btree, void* key) {
 }
 
 int cutil_btree_contains(cutil_btree* btree, void* key) {
-    _btree_node* node = _btree_find_node_for_key(btree, btree->root, key);
-    unsigned int insert_position = _node_get_insertion_position(btree, node, key);
+    _btree_node* node;
+    unsigned int insert_position;
+
+    if (btree->concurrent) {
+        return _btree_concurrent_get(btree, key, NULL);
+    }
+
+    node = _btree_find_node_for_key(btree, btree->root, key);
+    insert_position = _node_get_insertion_position(btree, node, key);
 
     return insert_position >= btree->order;
 }
 
 void cutil_btree_clear(cutil_btree* btree) {
-    _btree_node_recursive_delete(btree, btree->root);
+    if (btree->read_only) {
+        return;
+    }
+    else if (btree->concurrent) {
+        _btree_concurrent_clear(btree);
+        return;
+    }
+
+    _node_release(btree, btree->root);
 
     btree->root = _node_create(btree);
     btree->size = 0;
+    btree->rebalance_pending = 0;
 }
 
 size_t cutil_btree_size(cutil_btree* btree) {
+    if (btree->concurrent) {
+        return atomic_size_load_func(&btree->size);
+    }
+
     return btree->size;
 }
 
@@ -761,40 +1274,17 @@ int _node_is_interior(_btree_node*  node) {
 }
 
 unsigned int _node_get_insertion_position(cutil_btree* btree, _btree_node* node, void* key) {
-    unsigned int i, insert_pos = 0;
+    int found;
+    unsigned int position = _btree_search_node(btree, node, key, &found);
 
-    for (i = 0; i < node->item_count; i++) {
-        void* item_key = _node_get_key(node, btree->key_trait, i);
-        int key_comp = btree->key_trait->compare_func(key, item_key, btree->key_trait->user_data);
-
-        if (key_comp == 0) {
-            insert_pos = btree->order + i;
-            break;
-        }
-        else if (key_comp < 0) {
-            insert_pos = i;
-            break;
-        }
-        else {
-            insert_pos = i + 1;
-        }
-    }
-
-    return insert_pos;
+    return found ? btree->order + position : position;
 }
 
 unsigned int _node_key_position(cutil_btree* btree, _btree_node* node, void* key) {
-    unsigned int i;
-    for (i = 0; i < node->item_count; i++) {
-        void* item_key = _node_get_key(node, btree->key_trait, i);
-        int key_comp = btree->key_trait->compare_func(key, item_key, btree->key_trait->user_data);
-
-        if (key_comp == 0) {
-            return i;
-        }
-    }
+    int found;
+    unsigned int position = _btree_search_node(btree, node, key, &found);
 
-    return ITEM_NOT_PRESENT;
+    return found ? position : ITEM_NOT_PRESENT;
 }
 
 int _node_full(cutil_btree* btree, _btree_node*  node) {
@@ -806,7 +1296,10 @@ int _node_is_root(_btree_node*  node) {
 }
 
 int _compare_btree_nodes(cutil_btree* tree_a, _btree_node* a, cutil_btree* tree_b, _btree_node* b) {
-    if (a->item_count != b->item_count) {
+    if (a == b) { /* nodes shared between a btree and its snapshot */
+        return 1;
+    }
+    else if (a->item_count != b->item_count) {
         return 0;
     }
     else {
@@ -0,0 +1,76 @@
+#include "cutil/btree.h"
+#include "btree_private.h"
+#include "defs_private.h"
+
+#include <math.h>
+
+/*
+Appends the items of a subtree to the builder in key order.
+Nodes which are not shared with a snapshot are owned by the btree, their items are moved into the builder and the nodes are destroyed as they are visited.
+Items of shared nodes are copied with the btree's traits and the reference held by the btree is released once the subtree has been visited.
+*/
+void _btree_compact_node(_btree_builder* builder, _btree_node* node, int owned) {
+    cutil_btree* btree = builder->btree;
+    int copy_items = !owned || atomic_load_func(&node->ref_count) > 1;
+    void* key_copy = alloca_func(btree->key_trait->size);
+    void* value_copy = alloca_func(btree->value_trait->size);
+    unsigned int i;
+
+    for (i = 0; i <= node->item_count; i++) {
+        if (!_node_is_leaf(node)) {
+            _btree_compact_node(builder, node->branches[i], !copy_items);
+        }
+
+        if (i == node->item_count) {
+            break;
+        }
+
+        if (copy_items) {
+            _copy_with_trait(key_copy, _node_get_key(node, btree->key_trait, i), btree->key_trait);
+            _copy_with_trait(value_copy, _node_get_value(node, btree->value_trait, i), btree->value_trait);
+            _btree_builder_append(builder, key_copy, value_copy);
+        }
+        else {
+            _btree_builder_append(builder, _node_get_key(node, btree->key_trait, i), _node_get_value(node, btree->value_trait, i));
+        }
+    }
+
+    if (!owned) {
+        return;
+    }
+
+    /* the first shared node on a path holds the only references to its descendants that the btree owns */
+    if (copy_items) {
+        _node_release(btree, node);
+    }
+    else {
+        _node_destroy(btree, node);
+    }
+}
+
+int cutil_btree_compact(cutil_btree* btree, double target_fill) {
+    unsigned int max_item_count = btree->order - 1;
+    unsigned int min_item_count = _btree_node_min_item_count(btree);
+    _btree_node* root = btree->root;
+    _btree_builder builder;
+
+    if (btree->read_only || btree->concurrent || target_fill <= 0.0 || target_fill > 1.0) {
+        return 0;
+    }
+
+    btree->root = _node_create(btree);
+    btree->size = 0;
+    btree->rebalance_pending = 0;
+    _btree_builder_init(&builder, btree);
+
+    builder.node_capacity = (unsigned int)ceil(target_fill * (double)max_item_count);
+
+    if (builder.node_capacity < min_item_count) {
+        builder.node_capacity = min_item_count;
+    }
+
+    _btree_compact_node(&builder, root, 1);
+    _btree_builder_finish(&builder);
+
+    return 1;
+}
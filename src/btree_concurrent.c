@@ -0,0 +1,543 @@
+#include "cutil/btree.h"
+#include "btree_private.h"
+#include "defs_private.h"
+
+#include <string.h>
+
+/* A writer holds at most one latch per level of the tree, plus the node containing an item being erased. */
+#define BTREE_LATCH_PATH_SIZE (BTREE_ITR_MAX_DEPTH + 1)
+
+/*
+Records the write latches held by a writer that may need to modify multiple levels of the tree.
+Nodes are stored in the order they were latched, from the top of the tree down.
+*/
+typedef struct {
+    _btree_node* nodes[BTREE_LATCH_PATH_SIZE];
+    unsigned int count;
+    int root_latched;
+} _btree_latch_path;
+
+void _latch_path_init(cutil_btree* btree, _btree_latch_path* path) {
+    rwlock_write_lock_func(btree->root_latch);
+
+    path->count = 0;
+    path->root_latched = 1;
+}
+
+void _latch_path_push(_btree_latch_path* path, _btree_node* node) {
+    rwlock_write_lock_func(node->latch);
+    path->nodes[path->count++] = node;
+}
+
+/* Releases the latch on a node that is held by the path.  This must be done before the node is destroyed. */
+void _latch_path_remove(_btree_latch_path* path, _btree_node* node) {
+    unsigned int i;
+
+    for (i = 0; i < path->count; i++) {
+        if (path->nodes[i] == node) {
+            rwlock_write_unlock_func(node->latch);
+            memmove(path->nodes + i, path->nodes + i + 1, (path->count - i - 1) * sizeof(_btree_node*));
+            path->count -= 1;
+            break;
+        }
+    }
+}
+
+/*
+Called when the most recently latched node is safe: the pending operation cannot modify anything above it.
+Releases the root latch and the latches of all nodes above it, except for the pinned node which is still required by the operation.
+*/
+void _latch_path_release_ancestors(cutil_btree* btree, _btree_latch_path* path, _btree_node* pinned) {
+    unsigned int i, kept = 0;
+
+    if (path->root_latched) {
+        rwlock_write_unlock_func(btree->root_latch);
+        path->root_latched = 0;
+    }
+
+    for (i = 0; i < path->count - 1; i++) {
+        if (path->nodes[i] == pinned) {
+            path->nodes[kept++] = pinned;
+        }
+        else {
+            rwlock_write_unlock_func(path->nodes[i]->latch);
+        }
+    }
+
+    path->nodes[kept++] = path->nodes[path->count - 1];
+    path->count = kept;
+}
+
+void _latch_path_release(cutil_btree* btree, _btree_latch_path* path) {
+    unsigned int i;
+
+    for (i = 0; i < path->count; i++) {
+        rwlock_write_unlock_func(path->nodes[i]->latch);
+    }
+
+    if (path->root_latched) {
+        rwlock_write_unlock_func(btree->root_latch);
+    }
+
+    path->count = 0;
+    path->root_latched = 0;
+}
+
+/* Releases the read latch protecting a node while descending: the parent's latch, or the root latch if the node is the root. */
+void _btree_concurrent_read_unlock_parent(cutil_btree* btree, _btree_node* parent) {
+    if (parent) {
+        rwlock_read_unlock_func(parent->latch);
+    }
+    else {
+        rwlock_read_unlock_func(btree->root_latch);
+    }
+}
+
+/*
+Descends to the leaf node that would contain the key using read latches, and returns it with its write latch held.
+The parent's read latch is held while the leaf's latch is upgraded, so the leaf cannot be split or merged in the meantime.
+Returns NULL if the key is located in an interior node, in which case no latches are held.
+*/
+_btree_node* _btree_concurrent_latch_leaf(cutil_btree* btree, void* key) {
+    _btree_node* parent = NULL;
+    _btree_node* node;
+
+    rwlock_read_lock_func(btree->root_latch);
+    node = btree->root;
+    rwlock_read_lock_func(node->latch);
+
+    while (!_node_is_leaf(node)) {
+        int found;
+        unsigned int position = _btree_search_node(btree, node, key, &found);
+        _btree_node* child;
+
+        if (found) {
+            rwlock_read_unlock_func(node->latch);
+            _btree_concurrent_read_unlock_parent(btree, parent);
+
+            return NULL;
+        }
+
+        child = node->branches[position];
+        _btree_prefetch_node(btree, child);
+        rwlock_read_lock_func(child->latch);
+        _btree_concurrent_read_unlock_parent(btree, parent);
+
+        parent = node;
+        node = child;
+    }
+
+    rwlock_read_unlock_func(node->latch);
+    rwlock_write_lock_func(node->latch);
+    _btree_concurrent_read_unlock_parent(btree, parent);
+
+    return node;
+}
+
+/*
+Write latches the path to the node containing the key, or the leaf it should be inserted into.
+Latches above a node that is not full are released because an insertion below it cannot split it.
+*/
+_btree_node* _btree_concurrent_insert_descend(cutil_btree* btree, _btree_latch_path* path, void* key, unsigned int* position, int* found) {
+    _btree_node* node = btree->root;
+
+    for (;;) {
+        _latch_path_push(path, node);
+
+        if (!_node_full(btree, node)) {
+            _latch_path_release_ancestors(btree, path, NULL);
+        }
+
+        *position = _btree_search_node(btree, node, key, found);
+
+        if (*found || _node_is_leaf(node)) {
+            return node;
+        }
+
+        node = node->branches[*position];
+    }
+}
+
+/*
+Write latches the path to the node containing the key.
+If the key is located in an interior node, the descent continues to the leaf holding its predecessor, which will replace it.
+Latches above a node with more than the minimum number of items are released because a removal below it cannot cause it to be merged.
+The node containing the key remains latched regardless.
+*/
+_btree_node* _btree_concurrent_erase_descend(cutil_btree* btree, _btree_latch_path* path, void* key, unsigned int* position, _btree_node** max_leaf) {
+    unsigned int min_item_count = _btree_node_min_item_count(btree);
+    _btree_node* root = btree->root;
+    _btree_node* node = root;
+    _btree_node* item_node = NULL;
+    int found;
+
+    *max_leaf = NULL;
+
+    for (;;) {
+        int safe;
+
+        _latch_path_push(path, node);
+
+        /* the root may hold any number of items, but it is replaced by its child when its last item is removed */
+        if (node == root) {
+            safe = _node_is_leaf(node) || node->item_count > 1;
+        }
+        else {
+            safe = node->item_count > min_item_count;
+        }
+
+        if (safe) {
+            _latch_path_release_ancestors(btree, path, item_node);
+        }
+
+        if (item_node) {
+            if (_node_is_leaf(node)) {
+                *max_leaf = node;
+                return item_node;
+            }
+
+            node = node->branches[node->item_count];
+        }
+        else {
+            *position = _btree_search_node(btree, node, key, &found);
+
+            if (found && _node_is_leaf(node)) {
+                return node;
+            }
+            else if (found) {
+                item_node = node;
+                node = node->branches[*position];
+            }
+            else if (_node_is_leaf(node)) {
+                return NULL;
+            }
+            else {
+                node = node->branches[*position];
+            }
+        }
+    }
+}
+
+/*
+Writes a key and value into a write latched node, taking ownership of both.
+If the key is present, the existing value is destroyed and replaced, otherwise the item is inserted at the supplied position.
+Returns non zero if a new item was inserted.
+*/
+int _btree_concurrent_write_item(cutil_btree* btree, _btree_node* node, unsigned int position, int found, void* key, void* value) {
+    if (found) {
+        void* node_value = _node_get_value(node, btree->value_trait, position);
+
+        if (btree->key_trait->destroy_func) {
+            btree->key_trait->destroy_func(key, btree->key_trait->user_data);
+        }
+
+        if (btree->value_trait->destroy_func) {
+            btree->value_trait->destroy_func(node_value, btree->value_trait->user_data);
+        }
+
+        memcpy(node_value, value, btree->value_trait->size);
+
+        return 0;
+    }
+
+    _btree_leaf_insert(btree, node, position, key, value);
+    atomic_size_increment_func(&btree->size);
+
+    return 1;
+}
+
+/*
+Inserts a prepared key and value, taking ownership of both.
+The leaf is first latched optimistically, the path from the root is only write latched if the leaf needs to be split.
+*/
+int _btree_concurrent_insert_item(cutil_btree* btree, void* key, void* value) {
+    _btree_node* node = _btree_concurrent_latch_leaf(btree, key);
+    _btree_latch_path path;
+    unsigned int position;
+    int found, inserted;
+
+    if (node) {
+        position = _btree_search_node(btree, node, key, &found);
+
+        if (found || !_node_full(btree, node)) {
+            inserted = _btree_concurrent_write_item(btree, node, position, found, key, value);
+            rwlock_write_unlock_func(node->latch);
+
+            return inserted;
+        }
+
+        rwlock_write_unlock_func(node->latch);
+    }
+
+    _latch_path_init(btree, &path);
+    node = _btree_concurrent_insert_descend(btree, &path, key, &position, &found);
+    inserted = _btree_concurrent_write_item(btree, node, position, found, key, value);
+    _latch_path_release(btree, &path);
+
+    return inserted;
+}
+
+void _btree_concurrent_insert(cutil_btree* btree, void* key, void* value) {
+    void* new_key = alloca_func(btree->key_trait->size);
+    void* new_value = alloca_func(btree->value_trait->size);
+
+    _copy_with_trait(new_key, key, btree->key_trait);
+    _copy_with_trait(new_value, value, btree->value_trait);
+
+    _btree_concurrent_insert_item(btree, new_key, new_value);
+}
+
+int _btree_concurrent_upsert(cutil_btree* btree, void* key, cutil_btree_upsert_func update_func, void* user_data) {
+    _btree_node* node = _btree_concurrent_latch_leaf(btree, key);
+    _btree_latch_path path;
+    unsigned int position;
+    int found;
+    void* new_key, *new_value;
+
+    path.count = 0;
+    path.root_latched = 0;
+
+    if (node) {
+        position = _btree_search_node(btree, node, key, &found);
+
+        if (!found && _node_full(btree, node)) {
+            rwlock_write_unlock_func(node->latch);
+            node = NULL;
+        }
+    }
+
+    if (!node) {
+        _latch_path_init(btree, &path);
+        node = _btree_concurrent_insert_descend(btree, &path, key, &position, &found);
+    }
+
+    if (found) {
+        update_func(_node_get_value(node, btree->value_trait, position), 0, user_data);
+    }
+    else {
+        /* the new value is initialized before it is placed in the tree because a split may move it to another node */
+        new_key = alloca_func(btree->key_trait->size);
+        new_value = alloca_func(btree->value_trait->size);
+
+        _copy_with_trait(new_key, key, btree->key_trait);
+        memset(new_value, 0, btree->value_trait->size);
+        update_func(new_value, 1, user_data);
+
+        _btree_concurrent_write_item(btree, node, position, 0, new_key, new_value);
+    }
+
+    if (path.root_latched || path.count > 0) {
+        _latch_path_release(btree, &path);
+    }
+    else {
+        rwlock_write_unlock_func(node->latch);
+    }
+
+    return !found;
+}
+
+int _btree_concurrent_get(cutil_btree* btree, void* key, void* value) {
+    _btree_node* node;
+    _btree_node* child;
+    unsigned int position;
+    int found;
+
+    rwlock_read_lock_func(btree->root_latch);
+    node = btree->root;
+    rwlock_read_lock_func(node->latch);
+    rwlock_read_unlock_func(btree->root_latch);
+
+    for (;;) {
+        position = _btree_search_node(btree, node, key, &found);
+
+        if (found || _node_is_leaf(node)) {
+            break;
+        }
+
+        child = node->branches[position];
+        _btree_prefetch_node(btree, child);
+        rwlock_read_lock_func(child->latch);
+        rwlock_read_unlock_func(node->latch);
+        node = child;
+    }
+
+    if (found && value) {
+        memcpy(value, _node_get_value(node, btree->value_trait, position), btree->value_trait->size);
+    }
+
+    rwlock_read_unlock_func(node->latch);
+
+    return found;
+}
+
+/*
+Rebalances a node after an item has been removed from it.
+The node, and every ancestor that may be modified as a result, is write latched by the path.
+Siblings are latched before they are inspected because writers below the parent may be modifying them.
+*/
+void _btree_concurrent_rebalance_node(cutil_btree* btree, _btree_latch_path* path, _btree_node* node) {
+    unsigned int min_item_count = _btree_node_min_item_count(btree);
+    _btree_node* parent, *right_sibling, *left_sibling;
+
+    if (node->item_count >= min_item_count) {
+        return;
+    }
+
+    if (_node_is_root(node)) {
+        if (node->item_count == 0 && !_node_is_leaf(node)) {
+            btree->root = node->branches[0];
+            btree->root->parent = NULL;
+
+            _latch_path_remove(path, node);
+            _node_destroy(btree, node);
+        }
+
+        return;
+    }
+
+    /*
+    Siblings are only latched while the parent is write latched.
+    Any other thread holding a sibling latch entered it before the parent was latched and is only moving down the tree, so it cannot be waiting on a latch held here.
+    */
+    parent = node->parent;
+    right_sibling = _node_right_sibling(node);
+    left_sibling = _node_left_sibling(node);
+
+    if (right_sibling) {
+        rwlock_write_lock_func(right_sibling->latch);
+    }
+
+    if (left_sibling) {
+        rwlock_write_lock_func(left_sibling->latch);
+    }
+
+    if (right_sibling && right_sibling->item_count > min_item_count) {
+        _btree_borrow_from_right_sibling(btree, node, right_sibling);
+    }
+    else if (left_sibling && left_sibling->item_count > min_item_count) {
+        _btree_borrow_from_left_sibling(btree, node, left_sibling);
+    }
+    else if (node->position == 0) {
+        /* the right sibling is destroyed by the merge, no other thread can be waiting on it while the parent is latched */
+        rwlock_write_unlock_func(right_sibling->latch);
+        right_sibling = NULL;
+
+        _btree_merge_node_with_right_sibling(btree, node);
+    }
+    else {
+        _latch_path_remove(path, node);
+        _btree_merge_node_with_right_sibling(btree, left_sibling);
+    }
+
+    if (right_sibling) {
+        rwlock_write_unlock_func(right_sibling->latch);
+    }
+
+    if (left_sibling) {
+        rwlock_write_unlock_func(left_sibling->latch);
+    }
+
+    _btree_concurrent_rebalance_node(btree, path, parent);
+}
+
+/* Removes an item from a write latched node, the item's key and value have already been destroyed. */
+void _btree_concurrent_remove_item(cutil_btree* btree, _btree_latch_path* path, _btree_node* node, unsigned int position, _btree_node* max_leaf) {
+    unsigned int i;
+
+    if (max_leaf) {
+        /* replace the item with its predecessor */
+        _node_copy_item(btree, node, position, max_leaf, max_leaf->item_count - 1);
+        node = max_leaf;
+    }
+    else {
+        for (i = position + 1; i < node->item_count; i++) {
+            _node_copy_item(btree, node, i - 1, node, i);
+        }
+    }
+
+    node->item_count -= 1;
+
+    if (path) {
+        _btree_concurrent_rebalance_node(btree, path, node);
+    }
+}
+
+void _btree_concurrent_destroy_item(cutil_btree* btree, _btree_node* node, unsigned int position) {
+    if (btree->key_trait->destroy_func) {
+        btree->key_trait->destroy_func(_node_get_key(node, btree->key_trait, position), btree->key_trait->user_data);
+    }
+
+    if (btree->value_trait->destroy_func) {
+        btree->value_trait->destroy_func(_node_get_value(node, btree->value_trait, position), btree->value_trait->user_data);
+    }
+}
+
+int _btree_concurrent_erase(cutil_btree* btree, void* key) {
+    _btree_node* node = _btree_concurrent_latch_leaf(btree, key);
+    _btree_node* max_leaf;
+    _btree_latch_path path;
+    unsigned int position;
+    int found;
+
+    if (node) {
+        position = _btree_search_node(btree, node, key, &found);
+
+        /* removing an item from this leaf will not require it to be merged */
+        if (!found || node->item_count > _btree_node_min_item_count(btree)) {
+            if (found) {
+                _btree_concurrent_destroy_item(btree, node, position);
+                _btree_concurrent_remove_item(btree, NULL, node, position, NULL);
+                atomic_size_decrement_func(&btree->size);
+            }
+
+            rwlock_write_unlock_func(node->latch);
+
+            return found;
+        }
+
+        rwlock_write_unlock_func(node->latch);
+    }
+
+    _latch_path_init(btree, &path);
+    node = _btree_concurrent_erase_descend(btree, &path, key, &position, &max_leaf);
+
+    if (node) {
+        _btree_concurrent_destroy_item(btree, node, position);
+        _btree_concurrent_remove_item(btree, &path, node, position, max_leaf);
+        atomic_size_decrement_func(&btree->size);
+    }
+
+    _latch_path_release(btree, &path);
+
+    return node != NULL;
+}
+
+/*
+Waits for all threads to leave the subtree rooted at a node.
+No new threads can enter the subtree because its parent, or the root latch, is write latched.
+*/
+void _btree_concurrent_drain_node(_btree_node* node) {
+    unsigned int i;
+
+    rwlock_write_lock_func(node->latch);
+
+    if (!_node_is_leaf(node)) {
+        for (i = 0; i <= node->item_count; i++) {
+            _btree_concurrent_drain_node(node->branches[i]);
+        }
+    }
+
+    rwlock_write_unlock_func(node->latch);
+}
+
+void _btree_concurrent_clear(cutil_btree* btree) {
+    rwlock_write_lock_func(btree->root_latch);
+
+    _btree_concurrent_drain_node(btree->root);
+    _node_release(btree, btree->root);
+
+    btree->root = _node_create(btree);
+    atomic_size_store_func(&btree->size, 0);
+
+    rwlock_write_unlock_func(btree->root_latch);
+}
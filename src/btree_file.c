@@ -0,0 +1,534 @@
+#include "cutil/btree.h"
+#include "btree_private.h"
+#include "btree_file_private.h"
+#include "stream_private.h"
+#include "defs_private.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+struct _btree_mapping {
+    void* data;
+    size_t size;
+    _btree_node* nodes;
+    _btree_node** branches;
+
+#ifdef _WIN32
+    HANDLE file_handle;
+    HANDLE mapping_handle;
+#endif
+};
+
+size_t _btree_file_align(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+void _btree_file_compute_layout(_btree_file_layout* layout, unsigned int order, size_t key_size, size_t value_size) {
+    size_t data_size, record_size;
+
+    layout->branches_offset = sizeof(_btree_file_node);
+    layout->keys_offset = _btree_file_align(layout->branches_offset + order * sizeof(size_t), BTREE_FILE_ITEM_ALIGNMENT);
+    layout->values_offset = _btree_file_align(layout->keys_offset + (order - 1) * key_size, BTREE_FILE_ITEM_ALIGNMENT);
+    data_size = layout->values_offset + (order - 1) * value_size;
+
+    if (data_size > BTREE_FILE_PAGE_SIZE) {
+        layout->record_size = _btree_file_align(data_size, BTREE_FILE_PAGE_SIZE);
+    }
+    else {
+        record_size = BTREE_FILE_MIN_RECORD_SIZE;
+
+        while (record_size < data_size) {
+            record_size *= 2;
+        }
+
+        layout->record_size = record_size;
+    }
+}
+
+/* Keys and values are written as raw bytes, so traits which own memory cannot be saved */
+int _btree_file_traits_supported(cutil_trait* key_trait, cutil_trait* value_trait) {
+    return key_trait->copy_func == NULL && key_trait->destroy_func == NULL &&
+           value_trait->copy_func == NULL && value_trait->destroy_func == NULL;
+}
+
+size_t _btree_file_count_nodes(_btree_node* node) {
+    size_t count = 1;
+    unsigned int i;
+
+    if (!_node_is_leaf(node)) {
+        for (i = 0; i <= node->item_count; i++) {
+            count += _btree_file_count_nodes(node->branches[i]);
+        }
+    }
+
+    return count;
+}
+
+int _btree_file_write_nodes(cutil_btree* btree, FILE* file, _btree_file_layout* layout, _btree_node** queue, size_t node_count, char* record) {
+    size_t i, queue_end = 1;
+    unsigned int j;
+
+    queue[0] = btree->root;
+
+    for (i = 0; i < node_count; i++) {
+        _btree_node* node = queue[i];
+        _btree_file_node* file_node = (_btree_file_node*)record;
+        size_t* branches = (size_t*)(record + layout->branches_offset);
+
+        memset(record, 0, layout->record_size);
+        file_node->item_count = node->item_count;
+        file_node->is_leaf = _node_is_leaf(node);
+
+        if (!file_node->is_leaf) {
+            for (j = 0; j <= node->item_count; j++) {
+                branches[j] = queue_end;
+                queue[queue_end++] = node->branches[j];
+            }
+        }
+
+        memcpy(record + layout->keys_offset, node->keys, node->item_count * btree->key_trait->size);
+        memcpy(record + layout->values_offset, node->values, node->item_count * btree->value_trait->size);
+
+        if (fwrite(record, layout->record_size, 1, file) != 1) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+int cutil_btree_save(cutil_btree* btree, const char* path) {
+    cutil_allocator* allocator = cutil_current_allocator();
+    _btree_file_header header;
+    _btree_file_layout layout;
+    _btree_node** queue;
+    char* record;
+    FILE* file;
+    size_t node_count, buffer_size;
+    int result = 0;
+
+    if (!_btree_file_traits_supported(btree->key_trait, btree->value_trait)) {
+        return 0;
+    }
+
+    _btree_file_compute_layout(&layout, btree->order, btree->key_trait->size, btree->value_trait->size);
+    node_count = _btree_file_count_nodes(btree->root);
+
+    memset(&header, 0, sizeof(_btree_file_header));
+    memcpy(header.magic, BTREE_FILE_MAGIC, sizeof(BTREE_FILE_MAGIC));
+    header.version = BTREE_FILE_VERSION;
+    header.header_size = sizeof(_btree_file_header);
+    header.order = btree->order;
+    header.page_size = BTREE_FILE_PAGE_SIZE;
+    header.key_size = btree->key_trait->size;
+    header.value_size = btree->value_trait->size;
+    header.item_count = cutil_btree_size(btree);
+    header.node_count = node_count;
+    header.record_size = layout.record_size;
+
+    file = fopen(path, "wb");
+    if (!file) {
+        return 0;
+    }
+
+    /* the record buffer is also used to write the header page */
+    buffer_size = layout.record_size > BTREE_FILE_PAGE_SIZE ? layout.record_size : BTREE_FILE_PAGE_SIZE;
+    record = allocator->malloc(buffer_size, allocator->user_data);
+    queue = allocator->malloc(node_count * sizeof(_btree_node*), allocator->user_data);
+
+    memset(record, 0, BTREE_FILE_PAGE_SIZE);
+    memcpy(record, &header, sizeof(_btree_file_header));
+
+    if (fwrite(record, BTREE_FILE_PAGE_SIZE, 1, file) == 1) {
+        result = _btree_file_write_nodes(btree, file, &layout, queue, node_count, record);
+    }
+
+    allocator->free(queue, allocator->user_data);
+    allocator->free(record, allocator->user_data);
+
+    if (fclose(file) != 0) {
+        result = 0;
+    }
+
+    return result;
+}
+
+int _btree_mapping_open(struct _btree_mapping* mapping, const char* path) {
+#ifdef _WIN32
+    LARGE_INTEGER file_size;
+
+    mapping->file_handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (mapping->file_handle == INVALID_HANDLE_VALUE) {
+        return 0;
+    }
+
+    if (!GetFileSizeEx(mapping->file_handle, &file_size) || file_size.QuadPart < BTREE_FILE_PAGE_SIZE) {
+        CloseHandle(mapping->file_handle);
+        return 0;
+    }
+
+    mapping->mapping_handle = CreateFileMappingA(mapping->file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping->mapping_handle == NULL) {
+        CloseHandle(mapping->file_handle);
+        return 0;
+    }
+
+    mapping->data = MapViewOfFile(mapping->mapping_handle, FILE_MAP_READ, 0, 0, 0);
+    if (mapping->data == NULL) {
+        CloseHandle(mapping->mapping_handle);
+        CloseHandle(mapping->file_handle);
+        return 0;
+    }
+
+    mapping->size = (size_t)file_size.QuadPart;
+
+    return 1;
+#else
+    struct stat file_stat;
+    int fd = open(path, O_RDONLY);
+
+    if (fd == -1) {
+        return 0;
+    }
+
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size < BTREE_FILE_PAGE_SIZE) {
+        close(fd);
+        return 0;
+    }
+
+    mapping->size = (size_t)file_stat.st_size;
+    mapping->data = mmap(NULL, mapping->size, PROT_READ, MAP_SHARED, fd, 0);
+
+    /* the mapping remains valid after the file descriptor is closed */
+    close(fd);
+
+    return mapping->data != MAP_FAILED;
+#endif
+}
+
+void _btree_mapping_unmap(struct _btree_mapping* mapping) {
+#ifdef _WIN32
+    UnmapViewOfFile(mapping->data);
+    CloseHandle(mapping->mapping_handle);
+    CloseHandle(mapping->file_handle);
+#else
+    munmap(mapping->data, mapping->size);
+#endif
+}
+
+void _btree_mapping_close(struct _btree_mapping* mapping) {
+    cutil_allocator* allocator = cutil_current_allocator();
+
+    _btree_mapping_unmap(mapping);
+
+    allocator->free(mapping->branches, allocator->user_data);
+    allocator->free(mapping->nodes, allocator->user_data);
+    allocator->free(mapping, allocator->user_data);
+}
+
+int _btree_file_header_valid(_btree_file_header* header, size_t file_size, cutil_trait* key_trait, cutil_trait* value_trait) {
+    _btree_file_layout layout;
+
+    if (memcmp(header->magic, BTREE_FILE_MAGIC, sizeof(BTREE_FILE_MAGIC)) != 0 || header->version != BTREE_FILE_VERSION ||
+        header->header_size != sizeof(_btree_file_header) || header->page_size != BTREE_FILE_PAGE_SIZE) {
+        return 0;
+    }
+
+    if (header->order < 3 || header->key_size != key_trait->size || header->value_size != value_trait->size) {
+        return 0;
+    }
+
+    _btree_file_compute_layout(&layout, header->order, header->key_size, header->value_size);
+
+    if (header->record_size != layout.record_size || header->node_count == 0) {
+        return 0;
+    }
+
+    return header->node_count <= (file_size - BTREE_FILE_PAGE_SIZE) / header->record_size;
+}
+
+/*
+Builds the in memory node structures for a mapped file.
+Keys and values are read directly from the mapped records, only the child pointers need to be resolved.
+The file is not trusted, so its structure is validated while linking:
+- children are always written after their parent and each node other than the root is the child of exactly one node, so the resolved nodes form a tree.
+- every node is reachable from the root.
+- every leaf is at the same depth, which is limited to the depth supported by iterators.
+- only a root leaf may be empty, and the items of all nodes add up to the size recorded in the header.
+The order of the keys is not validated, a file with unordered keys gives incorrect search results but cannot cause invalid memory accesses.
+*/
+int _btree_mapping_link_nodes(struct _btree_mapping* mapping, _btree_file_header* header) {
+    cutil_allocator* allocator = cutil_current_allocator();
+    _btree_file_layout layout;
+    size_t i, interior_count = 0, item_count = 0;
+    unsigned int j, leaf_depth = 0;
+    char* records = (char*)mapping->data + BTREE_FILE_PAGE_SIZE;
+    _btree_node** branches;
+    _btree_node** leaf_branches;
+    unsigned int* depths;
+    int valid = 1;
+
+    _btree_file_compute_layout(&layout, header->order, header->key_size, header->value_size);
+
+    for (i = 0; i < header->node_count; i++) {
+        _btree_file_node* file_node = (_btree_file_node*)(records + i * layout.record_size);
+
+        if (file_node->item_count > header->order - 1 || (file_node->item_count == 0 && (i > 0 || !file_node->is_leaf))) {
+            return 0;
+        }
+
+        interior_count += !file_node->is_leaf;
+        item_count += file_node->item_count;
+    }
+
+    if (item_count != header->item_count) {
+        return 0;
+    }
+
+    mapping->nodes = allocator->malloc(header->node_count * sizeof(_btree_node), allocator->user_data);
+    mapping->branches = allocator->malloc((interior_count + 1) * header->order * sizeof(_btree_node*), allocator->user_data);
+    depths = allocator->malloc(header->node_count * sizeof(unsigned int), allocator->user_data);
+
+    /* all leaf nodes share a single array of null branches */
+    branches = mapping->branches;
+    leaf_branches = mapping->branches + interior_count * header->order;
+    memset(leaf_branches, 0, header->order * sizeof(_btree_node*));
+
+    /* a node's parent is set when it is first referenced, which detects nodes referenced more than once */
+    for (i = 0; i < header->node_count; i++) {
+        mapping->nodes[i].parent = NULL;
+    }
+
+    mapping->nodes[0].position = 0;
+    depths[0] = 1;
+
+    for (i = 0; i < header->node_count && valid; i++) {
+        char* record = records + i * layout.record_size;
+        _btree_file_node* file_node = (_btree_file_node*)record;
+        size_t* child_indices = (size_t*)(record + layout.branches_offset);
+        _btree_node* node = mapping->nodes + i;
+
+        /* parents are written before their children, so a node that has not been referenced yet is unreachable */
+        if (i > 0 && node->parent == NULL) {
+            valid = 0;
+            break;
+        }
+
+        node->ref_count = 1;
+        node->rebalance_pending = 0;
+        node->latch = NULL;
+        node->item_count = file_node->item_count;
+        node->keys = record + layout.keys_offset;
+        node->values = record + layout.values_offset;
+        node->key_prefixes = NULL;
+        node->allocation = NULL;
+
+        if (file_node->is_leaf) {
+            node->branches = leaf_branches;
+
+            if (leaf_depth == 0) {
+                leaf_depth = depths[i];
+            }
+
+            valid = depths[i] == leaf_depth;
+            continue;
+        }
+
+        node->branches = branches;
+        branches += header->order;
+        memset(node->branches, 0, header->order * sizeof(_btree_node*));
+
+        /* children of this node would be deeper than an iterator can track */
+        if (depths[i] >= BTREE_ITR_MAX_DEPTH) {
+            valid = 0;
+            break;
+        }
+
+        for (j = 0; j <= node->item_count; j++) {
+            size_t child_index = child_indices[j];
+
+            if (child_index <= i || child_index >= header->node_count || mapping->nodes[child_index].parent != NULL) {
+                valid = 0;
+                break;
+            }
+
+            node->branches[j] = mapping->nodes + child_index;
+            node->branches[j]->parent = node;
+            node->branches[j]->position = j;
+            depths[child_index] = depths[i] + 1;
+        }
+    }
+
+    allocator->free(depths, allocator->user_data);
+
+    return valid;
+}
+
+cutil_btree* cutil_btree_open_mapped(const char* path, cutil_trait* key_trait, cutil_trait* value_trait) {
+    cutil_allocator* allocator = cutil_current_allocator();
+    struct _btree_mapping* mapping;
+    _btree_file_header* header;
+    cutil_btree* btree;
+
+    if (key_trait == NULL || key_trait->compare_func == NULL || value_trait == NULL) {
+        return NULL;
+    }
+
+    if (!_btree_file_traits_supported(key_trait, value_trait)) {
+        return NULL;
+    }
+
+    mapping = allocator->malloc(sizeof(struct _btree_mapping), allocator->user_data);
+    mapping->nodes = NULL;
+    mapping->branches = NULL;
+
+    if (!_btree_mapping_open(mapping, path)) {
+        allocator->free(mapping, allocator->user_data);
+        return NULL;
+    }
+
+    header = (_btree_file_header*)mapping->data;
+
+    if (!_btree_file_header_valid(header, mapping->size, key_trait, value_trait) || !_btree_mapping_link_nodes(mapping, header)) {
+        _btree_mapping_close(mapping);
+        return NULL;
+    }
+
+    btree = allocator->malloc(sizeof(cutil_btree), allocator->user_data);
+
+    btree->root = mapping->nodes;
+    btree->size = header->item_count;
+    btree->order = header->order;
+    btree->key_trait = key_trait;
+    btree->value_trait = value_trait;
+    btree->key_search_func = _btree_key_search_func_for_trait(key_trait);
+    btree->key_prefixes = 0;
+    btree->read_only = 1;
+    memset(&btree->node_layout, 0, sizeof(_btree_node_layout));
+    btree->relaxed_rebalance = 0;
+    btree->rebalance_pending = 0;
+    btree->concurrent = 0;
+    btree->root_latch = NULL;
+    btree->mapping = mapping;
+
+    return btree;
+}
+
+int cutil_btree_is_mapped(cutil_btree* btree) {
+    return btree->mapping != NULL;
+}
+
+int _btree_write_node_items(cutil_btree* btree, _btree_node* node, cutil_writer* writer) {
+    unsigned int i;
+
+    for (i = 0; i < node->item_count; i++) {
+        if (!_node_is_leaf(node) && !_btree_write_node_items(btree, node->branches[i], writer)) {
+            return 0;
+        }
+
+        if (!_stream_write_item(writer, btree->key_trait, _node_get_key(node, btree->key_trait, i)) ||
+            !_stream_write_item(writer, btree->value_trait, _node_get_value(node, btree->value_trait, i))) {
+            return 0;
+        }
+    }
+
+    if (!_node_is_leaf(node)) {
+        return _btree_write_node_items(btree, node->branches[node->item_count], writer);
+    }
+
+    return 1;
+}
+
+int cutil_btree_write(cutil_btree* btree, cutil_writer* writer) {
+    if (!_stream_trait_writable(btree->key_trait) || !_stream_trait_writable(btree->value_trait)) {
+        return 0;
+    }
+
+    if (!_stream_write_header(writer, btree->key_trait, cutil_btree_size(btree)) ||
+        !cutil_writer_write_size(writer, btree->value_trait->size) ||
+        !cutil_writer_write_size(writer, btree->order)) {
+        return 0;
+    }
+
+    if (!_btree_write_node_items(btree, btree->root, writer)) {
+        return 0;
+    }
+
+    return cutil_writer_flush(writer);
+}
+
+/* Destroys an item that was read from a stream once it has been copied into the btree */
+void _btree_destroy_read_item(cutil_trait* trait, void* item) {
+    if (trait->destroy_func) {
+        trait->destroy_func(item, trait->user_data);
+    }
+}
+
+int _btree_read_items(cutil_btree* btree, cutil_reader* reader, size_t count) {
+    void* key = alloca_func(btree->key_trait->size);
+    void* value = alloca_func(btree->value_trait->size);
+
+    while (count > 0) {
+        if (!_stream_read_item(reader, btree->key_trait, key)) {
+            return 0;
+        }
+
+        if (!_stream_read_item(reader, btree->value_trait, value)) {
+            _btree_destroy_read_item(btree->key_trait, key);
+            return 0;
+        }
+
+        cutil_btree_insert(btree, key, value);
+
+        _btree_destroy_read_item(btree->key_trait, key);
+        _btree_destroy_read_item(btree->value_trait, value);
+
+        count -= 1;
+    }
+
+    return 1;
+}
+
+cutil_btree* cutil_btree_read(cutil_reader* reader, cutil_trait* key_trait, cutil_trait* value_trait) {
+    cutil_btree* btree;
+    size_t count, value_size, order;
+
+    if (key_trait == NULL || key_trait->compare_func == NULL || value_trait == NULL) {
+        return NULL;
+    }
+
+    if (!_stream_trait_readable(key_trait) || !_stream_trait_readable(value_trait)) {
+        return NULL;
+    }
+
+    if (!_stream_read_header(reader, key_trait, &count) || !cutil_reader_read_size(reader, &value_size) || !cutil_reader_read_size(reader, &order)) {
+        return NULL;
+    }
+
+    if (value_size != value_trait->size || order > UINT_MAX) {
+        return NULL;
+    }
+
+    btree = cutil_btree_create((unsigned int)order, key_trait, value_trait);
+    if (btree == NULL) {
+        return NULL;
+    }
+
+    if (!_btree_read_items(btree, reader, count)) {
+        cutil_btree_destroy(btree);
+        return NULL;
+    }
+
+    return btree;
+}
@@ -0,0 +1,47 @@
+#ifndef CUTIL_BTREE_FILE_PRIVATE_H
+#define CUTIL_BTREE_FILE_PRIVATE_H
+
+#include <stddef.h>
+
+/*
+The btree file begins with a header page followed by one fixed size record for every node.
+Nodes are written breadth first, so the root is always the first record and the upper levels of the tree share the first few pages of the file.
+Each record holds the item count, the indices of the node's children and the raw bytes of its keys and values.
+Records are padded to a power of two size so that a record never spans a page boundary unless it is larger than a page.
+*/
+
+#define BTREE_FILE_MAGIC "CUTILBT"
+#define BTREE_FILE_VERSION 1
+#define BTREE_FILE_PAGE_SIZE 4096
+#define BTREE_FILE_MIN_RECORD_SIZE 64
+#define BTREE_FILE_ITEM_ALIGNMENT 16
+
+typedef struct {
+    char magic[8];
+    unsigned int version;
+    unsigned int header_size;
+    unsigned int order;
+    unsigned int page_size;
+    size_t key_size;
+    size_t value_size;
+    size_t item_count;
+    size_t node_count;
+    size_t record_size;
+} _btree_file_header;
+
+typedef struct {
+    unsigned int item_count;
+    unsigned int is_leaf;
+} _btree_file_node;
+
+typedef struct {
+    size_t branches_offset;
+    size_t keys_offset;
+    size_t values_offset;
+    size_t record_size;
+} _btree_file_layout;
+
+/* Computes the offsets of the arrays within a node record and the size of each record. */
+void _btree_file_compute_layout(_btree_file_layout* layout, unsigned int order, size_t key_size, size_t value_size);
+
+#endif
@@ -7,18 +7,24 @@
 
 #define ITR_POS_UNINIT INT_MAX
 
-_btree_node*  _itr_find_next_leaf_node(_btree_node* node);
+void _itr_find_next_leaf_node(cutil_btree_itr* itr, _btree_node* node);
 void _itr_set_next_parent_node(cutil_btree_itr* itr);
 
 
 cutil_btree_itr* cutil_btree_itr_create(cutil_btree* btree) {
     cutil_allocator* allocator = cutil_current_allocator();
     cutil_btree_itr* itr = allocator->malloc(sizeof(cutil_btree_itr), allocator->user_data);
+
+    cutil_btree_itr_init(itr, btree);
+
+    return itr;
+}
+
+void cutil_btree_itr_init(cutil_btree_itr* itr, cutil_btree* btree) {
     itr->node = NULL;
     itr->btree = btree;
     itr->node_pos = ITR_POS_UNINIT;
-
-    return itr;
+    itr->depth = 0;
 }
 
 void cutil_btree_itr_destroy(cutil_btree_itr* itr) {
@@ -28,27 +34,36 @@ void cutil_btree_itr_destroy(cutil_btree_itr* itr) {
 
 void _find_starting_node_pos(cutil_btree_itr* itr) {
     if (cutil_btree_size(itr->btree) > 0) {
-        itr->node = _itr_find_next_leaf_node(itr->btree->root);
+        _itr_find_next_leaf_node(itr, itr->btree->root);
     }
 
     itr->node_pos = 0;
 }
 
-_btree_node*  _itr_find_next_leaf_node(_btree_node* node) {
-    _btree_node* leaf = node;
+/* descends to the left most leaf of the subtree rooted at node, recording the path taken */
+void _itr_find_next_leaf_node(cutil_btree_itr* itr, _btree_node* node) {
+    while (node->branches[0]) {
+        itr->path_nodes[itr->depth] = node;
+        itr->path_positions[itr->depth] = 0;
+        itr->depth += 1;
 
-    while (leaf->branches[0]) {
-        leaf = leaf->branches[0];
+        node = node->branches[0];
     }
 
-    return leaf;
+    itr->node = node;
 }
 
 void _itr_set_next_parent_node(cutil_btree_itr* itr) {
     do {
-        itr->node_pos = itr->node->position;
-        itr->node = itr->node->parent;
-    } while ((itr->node != NULL) && (itr->node_pos >= itr->node->item_count));
+        if (itr->depth == 0) {
+            itr->node = NULL;
+            break;
+        }
+
+        itr->depth -= 1;
+        itr->node = itr->path_nodes[itr->depth];
+        itr->node_pos = itr->path_positions[itr->depth];
+    } while (itr->node_pos >= itr->node->item_count);
 }
 
 int cutil_btree_itr_next(cutil_btree_itr* itr) {
@@ -61,6 +76,9 @@ int cutil_btree_itr_next(cutil_btree_itr* itr) {
             return 0;
         }
     }
+    else if (itr->node == NULL) {
+        return 0;
+    }
     else {
         itr->node_pos += 1;
 
@@ -72,13 +90,14 @@ int cutil_btree_itr_next(cutil_btree_itr* itr) {
         }
         else {
             /* explore the next branch in this tree */
-            if (itr->node->branches[itr->node_pos]) {
-                itr->node = _itr_find_next_leaf_node(itr->node->branches[itr->node_pos]);
-                itr->node_pos = 0;
-            }
-            else { /* no branches left, head up */
-                _itr_set_next_parent_node(itr);
-            }
+            _btree_node* branch = itr->node->branches[itr->node_pos];
+
+            itr->path_nodes[itr->depth] = itr->node;
+            itr->path_positions[itr->depth] = itr->node_pos;
+            itr->depth += 1;
+
+            _itr_find_next_leaf_node(itr, branch);
+            itr->node_pos = 0;
         }
     }
 
@@ -112,3 +131,39 @@ int cutil_btree_itr_get_value(cutil_btree_itr* itr, void* value) {
         return 0;
     }
 }
+
+/*
+Visits the items of the subtree rooted at the supplied node in key order, adding the number of visited items to count.
+Returns zero if the callback stopped the traversal.
+*/
+int _btree_foreach_node(cutil_btree* btree, _btree_node* node, cutil_btree_foreach_func callback, void* user_data, size_t* count) {
+    cutil_trait* key_trait = btree->key_trait;
+    cutil_trait* value_trait = btree->value_trait;
+    unsigned int i;
+
+    for (i = 0; i <= node->item_count; i++) {
+        if (!_node_is_leaf(node) && !_btree_foreach_node(btree, node->branches[i], callback, user_data, count)) {
+            return 0;
+        }
+
+        if (i == node->item_count) {
+            break;
+        }
+
+        *count += 1;
+
+        if (!callback(_node_get_key(node, key_trait, i), _node_get_value(node, value_trait, i), user_data)) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+size_t cutil_btree_foreach(cutil_btree* btree, cutil_btree_foreach_func callback, void* user_data) {
+    size_t count = 0;
+
+    _btree_foreach_node(btree, btree->root, callback, user_data, &count);
+
+    return count;
+}
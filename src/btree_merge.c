@@ -0,0 +1,211 @@
+#include "cutil/btree.h"
+#include "cutil/allocator.h"
+#include "btree_private.h"
+#include "defs_private.h"
+
+#define BTREE_MERGE_UNION 0
+#define BTREE_MERGE_INTERSECTION 1
+#define BTREE_MERGE_DIFFERENCE 2
+
+void _btree_builder_init(_btree_builder* builder, cutil_btree* btree) {
+    builder->btree = btree;
+    builder->height = 1;
+    builder->node_capacity = btree->order - 1;
+    builder->count = 0;
+    builder->spine[0] = btree->root;
+}
+
+/*
+Adds an item to the rightmost node of a level.
+When the node has reached the node capacity the item is passed up to the next level as the separator of a new rightmost node, which receives the child as its first branch.
+*/
+void _btree_builder_add(_btree_builder* builder, unsigned int level, void* key, void* value, _btree_node* child) {
+    cutil_btree* btree = builder->btree;
+    _btree_node* node = builder->spine[level];
+
+    if (node->item_count == builder->node_capacity) {
+        _btree_node* next_node = _node_create(btree);
+
+        if (child) {
+            _set_node_child(next_node, child, 0);
+        }
+
+        builder->spine[level] = next_node;
+
+        if (level + 1 == builder->height) {
+            _btree_node* root = _node_create(btree);
+
+            _set_node_child(root, node, 0);
+            builder->spine[builder->height++] = root;
+        }
+
+        _btree_builder_add(builder, level + 1, key, value, next_node);
+    }
+    else {
+        _node_set_item(btree, node, node->item_count, key, value);
+
+        if (child) {
+            _set_node_child(node, child, node->item_count + 1);
+        }
+
+        node->item_count += 1;
+    }
+}
+
+void _btree_builder_append(_btree_builder* builder, void* key, void* value) {
+    _btree_builder_add(builder, 0, key, value, NULL);
+    builder->count += 1;
+}
+
+void _btree_builder_finish(_btree_builder* builder) {
+    cutil_btree* btree = builder->btree;
+
+    btree->root = builder->spine[builder->height - 1];
+    btree->size += builder->count;
+
+    _btree_fix_right_border(btree);
+}
+
+/* Copies an item into the builder.  If a merge function is supplied it combines the other value with a copy of the value. */
+void _btree_builder_append_copy(_btree_builder* builder, void* key, void* value, void* other_value, cutil_btree_merge_func merge_func, void* user_data) {
+    cutil_btree* btree = builder->btree;
+    void* key_copy = alloca_func(btree->key_trait->size);
+    void* value_copy = alloca_func(btree->value_trait->size);
+
+    _copy_with_trait(key_copy, key, btree->key_trait);
+
+    if (other_value && merge_func) {
+        _copy_with_trait(value_copy, value, btree->value_trait);
+        merge_func(value_copy, other_value, user_data);
+    }
+    else {
+        _copy_with_trait(value_copy, other_value ? other_value : value, btree->value_trait);
+    }
+
+    _btree_builder_append(builder, key_copy, value_copy);
+}
+
+int _btree_can_merge(cutil_btree* a, cutil_btree* b) {
+    return a->key_trait == b->key_trait && a->value_trait == b->value_trait && !a->concurrent && !b->concurrent;
+}
+
+int _btree_itr_advance(cutil_btree_itr* itr, void** key, void** value) {
+    if (cutil_btree_itr_next(itr)) {
+        *key = _node_get_key(itr->node, itr->btree->key_trait, itr->node_pos);
+        *value = _node_get_value(itr->node, itr->btree->value_trait, itr->node_pos);
+    }
+    else {
+        *key = NULL;
+        *value = NULL;
+    }
+
+    return *key != NULL;
+}
+
+/*
+Walks the items of both btrees in key order, appending the items selected by the operation to a new btree with the order of the first btree.
+Each item of the result is copied with the btrees' traits.
+*/
+cutil_btree* _btree_merge_items(cutil_btree* a, cutil_btree* b, int operation, cutil_btree_merge_func merge_func, void* user_data) {
+    cutil_trait* key_trait = a->key_trait;
+    cutil_btree_itr itr_a, itr_b;
+    void *key_a, *value_a, *key_b, *value_b;
+    _btree_builder builder;
+    cutil_btree* result;
+
+    if (!_btree_can_merge(a, b)) {
+        return NULL;
+    }
+
+    result = _btree_create(a->order, a->key_trait, a->value_trait, 0, a->key_prefixes);
+    _btree_builder_init(&builder, result);
+
+    cutil_btree_itr_init(&itr_a, a);
+    cutil_btree_itr_init(&itr_b, b);
+
+    _btree_itr_advance(&itr_a, &key_a, &value_a);
+    _btree_itr_advance(&itr_b, &key_b, &value_b);
+
+    while (key_a || key_b) {
+        int comparison;
+
+        if (key_a == NULL) {
+            comparison = 1;
+        }
+        else if (key_b == NULL) {
+            comparison = -1;
+        }
+        else {
+            comparison = key_trait->compare_func(key_a, key_b, key_trait->user_data);
+        }
+
+        if (comparison < 0) {
+            if (operation != BTREE_MERGE_INTERSECTION) {
+                _btree_builder_append_copy(&builder, key_a, value_a, NULL, NULL, NULL);
+            }
+            else if (key_b == NULL) {
+                break;
+            }
+
+            _btree_itr_advance(&itr_a, &key_a, &value_a);
+        }
+        else if (comparison > 0) {
+            if (operation == BTREE_MERGE_UNION) {
+                _btree_builder_append_copy(&builder, key_b, value_b, NULL, NULL, NULL);
+            }
+            else if (key_a == NULL) {
+                break;
+            }
+
+            _btree_itr_advance(&itr_b, &key_b, &value_b);
+        }
+        else {
+            if (operation != BTREE_MERGE_DIFFERENCE) {
+                _btree_builder_append_copy(&builder, key_a, value_a, value_b, merge_func, user_data);
+            }
+
+            _btree_itr_advance(&itr_a, &key_a, &value_a);
+            _btree_itr_advance(&itr_b, &key_b, &value_b);
+        }
+    }
+
+    _btree_builder_finish(&builder);
+
+    return result;
+}
+
+int cutil_btree_merge(cutil_btree* dest, cutil_btree* src, cutil_btree_merge_func merge_func, void* user_data) {
+    cutil_allocator* allocator = cutil_current_allocator();
+    cutil_btree* result;
+
+    if (dest->read_only) {
+        return 0;
+    }
+
+    result = _btree_merge_items(dest, src, BTREE_MERGE_UNION, merge_func, user_data);
+    if (result == NULL) {
+        return 0;
+    }
+
+    /* snapshots of the destination keep their references to the previous nodes */
+    _node_release(dest, dest->root);
+    dest->root = result->root;
+    dest->size = result->size;
+    dest->rebalance_pending = 0;
+
+    allocator->free(result, allocator->user_data);
+
+    return 1;
+}
+
+cutil_btree* cutil_btree_union(cutil_btree* a, cutil_btree* b, cutil_btree_merge_func merge_func, void* user_data) {
+    return _btree_merge_items(a, b, BTREE_MERGE_UNION, merge_func, user_data);
+}
+
+cutil_btree* cutil_btree_intersection(cutil_btree* a, cutil_btree* b, cutil_btree_merge_func merge_func, void* user_data) {
+    return _btree_merge_items(a, b, BTREE_MERGE_INTERSECTION, merge_func, user_data);
+}
+
+cutil_btree* cutil_btree_difference(cutil_btree* a, cutil_btree* b) {
+    return _btree_merge_items(a, b, BTREE_MERGE_DIFFERENCE, NULL, NULL);
+}
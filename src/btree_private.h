@@ -2,20 +2,68 @@
 #define CUTIL_BTREE_PRIVATE_H
 
 #include "cutil/allocator.h"
+#include "atomic_private.h"
+#include "thread_private.h"
 
 /*
 This header contains private functions for use by the btree class and its associated test harness.
 */
 
+/*
+Nodes are reference counted so that they can be shared between a btree and its snapshots.
+A node with a reference count greater than one, or one that is reachable through a shared node, must be copied before it is modified.
+The parent and position fields are only maintained for nodes reachable from a writable btree and are not valid in snapshots.
+Nodes of concurrent btrees have a latch which must be held while the node is accessed.
+The rebalance_pending field of a node in a relaxed btree is set when the node or one of its descendants may hold fewer than the minimum number of items.  Every ancestor of a marked node is also marked.
+Nodes of btrees created with cutil_btree_create_string hold a fixed width prefix of each key so that most comparisons can be decided without following the key pointer.
+Nodes created with _node_create are a single cache line aligned allocation holding the header followed by the arrays described by the btree's node layout.
+The allocation field points at the start of the block returned by the allocator, which may precede the aligned node.
+*/
 typedef struct _btree_node {
+    _atomic_int ref_count;
+    unsigned int rebalance_pending;
+    _rwlock* latch;
     struct _btree_node* parent;
     unsigned int item_count;
     unsigned int position;
     void* keys;
     void* values;
     struct _btree_node** branches;
+    unsigned char* key_prefixes;
+    void* allocation;
 } _btree_node;
 
+/* Number of leading bytes of each string key stored in a node.  Shorter keys are padded with zeros. */
+#define BTREE_KEY_PREFIX_SIZE 16
+
+/* Alignment of node allocations.  Nodes start on a cache line boundary so that a node of n cache lines touches exactly n lines. */
+#define BTREE_NODE_ALIGNMENT 64
+
+/* Alignment of each array within a node allocation. */
+#define BTREE_NODE_ARRAY_ALIGNMENT 16
+
+/*
+Byte offsets of the arrays within a node allocation, relative to the start of the node header.
+Offsets of arrays that are not used by the btree are zero.  The size includes the header and all arrays but not the padding needed to align the allocation.
+*/
+typedef struct {
+    size_t keys_offset;
+    size_t values_offset;
+    size_t branches_offset;
+    size_t key_prefixes_offset;
+    size_t latch_offset;
+    size_t size;
+} _btree_node_layout;
+
+/* Computes the layout of the nodes of a btree with the supplied order and key and value sizes. */
+void _btree_node_layout_init(_btree_node_layout* layout, unsigned int order, size_t key_size, size_t value_size, int key_prefixes, int concurrent);
+
+/*
+Starts fetching the header of a node along with the first cache line of its keys, branches, key prefixes and latch.
+The arrays are located with the btree's node layout, so all of the lines are requested at once instead of after the header has been read.
+*/
+void _btree_prefetch_node(cutil_btree* btree, _btree_node* node);
+
 unsigned int _btree_node_min_item_count(cutil_btree* btree);
 int _node_full(cutil_btree* btree, _btree_node* node);
 int _node_is_root(_btree_node* node);
@@ -32,6 +80,17 @@ Destroys an individual btree node and frees all memory held
 */
 void _node_destroy(cutil_btree* btree, _btree_node* node);
 
+/*
+Releases a reference to a node.  When the last reference is released the node's items are destroyed and its children are released.
+*/
+void _node_release(cutil_btree* btree, _btree_node* node);
+
+/*
+Ensures that a node reachable from a writable btree is not shared with any snapshot, copying it and any shared ancestors as needed.
+Returns the node that should be modified in place of the supplied node.
+*/
+_btree_node* _btree_node_unshare(cutil_btree* btree, _btree_node* node);
+
 /*
 Gets a pointer to the key in the node with the supplied index.
 Precondition: index < node->item_count
@@ -44,18 +103,186 @@ Precondition: index < node->item_count
 */
 void* _node_get_value(_btree_node* node, cutil_trait* trait, size_t index);
 
+/*
+Searches the sorted keys of a node and returns the number of keys which are less than the supplied key.
+found is set to a non zero value if the key at the returned position compares equal to the supplied key.
+*/
+typedef unsigned int (*_btree_key_search_func)(void* keys, unsigned int count, void* key, int* found);
+
+/*
+Returns a specialized search function for the built in int, uint and float key traits or NULL if the trait has no specialized search function.
+Specialized functions use SIMD instructions where they are supported by the running cpu.
+*/
+_btree_key_search_func _btree_key_search_func_for_trait(cutil_trait* key_trait);
+
+/*
+Searches the keys of a node using the key trait's comparison function.
+*/
+unsigned int _btree_search_generic(cutil_trait* trait, void* keys, unsigned int count, void* key, int* found);
+
+/*
+Writes the prefix of a string key into a buffer of BTREE_KEY_PREFIX_SIZE bytes.
+Because the padding bytes are zero, comparing two prefixes with memcmp orders them the same way as strcmp orders the keys whenever the prefixes differ.
+*/
+void _btree_key_prefix(unsigned char* prefix, void* key);
+
+/*
+Searches the keys of a node using their prefixes.  The key trait's comparison function is only called when a prefix matches the prefix of the search key.
+*/
+unsigned int _btree_search_prefixed(cutil_trait* trait, unsigned char* key_prefixes, void* keys, unsigned int count, void* key, int* found);
+
+/*
+Creates an empty btree.  Nodes of btrees created with key_prefixes set hold a prefix of each key, which requires keys described by the cstring trait.
+*/
+cutil_btree* _btree_create(unsigned int order, cutil_trait* key_trait, cutil_trait* value_trait, int concurrent, int key_prefixes);
+
 struct cutil_btree {
     _btree_node* root;
     size_t size;
     unsigned int order;
     cutil_trait* key_trait;
     cutil_trait* value_trait;
+    _btree_key_search_func key_search_func;
+    /* set for btrees created with cutil_btree_create_string */
+    int key_prefixes;
+    int read_only;
+
+    /* layout of nodes created with _node_create.  The size is zero for mapped btrees, whose nodes are owned by the mapping. */
+    _btree_node_layout node_layout;
+
+    /* set for btrees in relaxed rebalance mode.  rebalance_pending is set when an erase leaves a node other than the root with fewer than the minimum number of items, and the node is marked with _btree_rebalance_mark. */
+    int relaxed_rebalance;
+    int rebalance_pending;
+
+    /* set for btrees created with cutil_btree_create_concurrent.  The root latch protects the root pointer. */
+    int concurrent;
+    _rwlock* root_latch;
+
+    /* set for read only btrees opened with cutil_btree_open_mapped.  The nodes are owned by the mapping rather than reference counted. */
+    struct _btree_mapping* mapping;
 };
 
-struct cutil_btree_itr {
-    _btree_node* node;
+/*
+Searches the keys of a node using the btree's specialized search function if it has one.
+\see _btree_key_search_func
+*/
+unsigned int _btree_search_node(cutil_btree* btree, _btree_node* node, void* key, int* found);
+
+#define BTREE_ITR_MAX_DEPTH CUTIL_BTREE_ITR_MAX_DEPTH
+
+/*
+Functions shared between the btree implementation files.
+*/
+void _copy_with_trait(void* dest, void* src, cutil_trait* trait);
+void _node_copy_item(cutil_btree* btree, _btree_node* dest_node, size_t dest_index, _btree_node* src_node, size_t src_index);
+void _node_set_item(cutil_btree* btree, _btree_node* node, size_t index, void* key, void* value);
+_btree_node* _btree_leaf_insert(cutil_btree* btree, _btree_node* node, unsigned int insert_position, void* key, void* value);
+_btree_node* _node_right_sibling(_btree_node* node);
+_btree_node* _node_left_sibling(_btree_node* node);
+_btree_node* _btree_merge_node_with_right_sibling(cutil_btree* btree, _btree_node* node);
+void _btree_borrow_from_left_sibling(cutil_btree* btree, _btree_node* node, _btree_node* left_sibling);
+void _btree_borrow_from_right_sibling(cutil_btree* btree, _btree_node* node, _btree_node* right_sibling);
+void _set_node_child(_btree_node* parent, _btree_node* child, int index);
+void _push_up_one_level(cutil_btree* btree, _btree_node* parent, _btree_node* left_node, _btree_node* right_node, void* key, void* value);
+void _rebalance_node(cutil_btree* btree, _btree_node* node);
+
+/*
+Repairs a node holding fewer items than the threshold by borrowing from or merging with a sibling, continuing with its ancestors as needed.
+The threshold must not be greater than the minimum item count.  Code which requires every node to hold the minimum item count passes the minimum regardless of the btree's mode.
+*/
+void _btree_rebalance_node_below(cutil_btree* btree, _btree_node* node, unsigned int threshold);
+
+/*
+Returns the item count below which _rebalance_node repairs a node after an erase.
+This is the minimum item count of the btree's order unless the btree is in relaxed rebalance mode, in which case only empty nodes are repaired.
+*/
+unsigned int _btree_rebalance_threshold(cutil_btree* btree);
+
+/*
+Marks a node which may hold fewer than the minimum number of items, or which has received a marked subtree, along with its ancestors.
+The node and its ancestors must already have been unshared.
+*/
+void _btree_rebalance_mark(cutil_btree* btree, _btree_node* node);
+
+/*
+Marks the nodes involved in a borrow or merge during a relaxed erase.
+The node is marked if it is short or has received a marked subtree, and the sibling it borrowed from, which may be NULL, is marked if it was left short.
+*/
+void _btree_rebalance_mark_moved(cutil_btree* btree, _btree_node* node, _btree_node* sibling, unsigned int received_pending);
+
+/*
+Repairs every node left with fewer than the minimum number of items by a relaxed erase.
+Only the marked nodes are visited, and their marks are cleared.
+Functions which rely on every node holding the minimum number of items call this before modifying a relaxed btree.
+*/
+void _btree_flush_rebalance(cutil_btree* btree);
+
+/*
+Splitting and joining operate on btree structures which share the traits and order of the btree being modified.
+The size of the btrees is not maintained, callers are responsible for updating it.
+*/
+
+/*
+Moves every item greater than or equal to the key into a new root which is stored in the right btree.
+If inclusive is non zero an item equal to the key remains in the btree.
+The border nodes of both btrees may be left with any number of items and must be repaired before the btrees are used.
+*/
+void _btree_split_nodes(cutil_btree* btree, cutil_btree* right, void* key, int inclusive);
+
+/*
+Repairs the border nodes left by _btree_split_nodes.  The right border of the left btree and the left border of the right btree are repaired.
+*/
+void _btree_fix_right_border(cutil_btree* btree);
+void _btree_fix_left_border(cutil_btree* btree);
+
+/*
+Moves the nodes of the right btree into the left btree.  Every key in the right btree must be greater than the keys of the left btree.
+The root of the right btree is set to NULL.
+*/
+void _btree_join(cutil_btree* left, cutil_btree* right);
+
+/*
+Counts the items in a node and all of its descendants.
+*/
+size_t _btree_node_count_items(_btree_node* node);
+
+/*
+Implementations of the public btree functions for concurrent btrees.
+Readers descend the tree by latch coupling: a child's latch is acquired before the parent's latch is released.
+Writers first descend with read latches and only write latch the leaf, falling back to holding write latches on every node that may be modified when the leaf may need to be split or merged.
+*/
+void _btree_concurrent_insert(cutil_btree* btree, void* key, void* value);
+int _btree_concurrent_upsert(cutil_btree* btree, void* key, cutil_btree_upsert_func update_func, void* user_data);
+int _btree_concurrent_get(cutil_btree* btree, void* key, void* value);
+int _btree_concurrent_erase(cutil_btree* btree, void* key);
+void _btree_concurrent_clear(cutil_btree* btree);
+
+/*
+Builds the nodes of a btree from items supplied in ascending key order without searching or splitting.
+Each node is filled up to the node capacity before the next one is started, and the nodes along the right border are repaired once all items have been added.
+The node capacity defaults to the maximum number of items of a node and may be lowered after initialization to leave room for later inserts, though not below the minimum item count.
+The btree must be empty when the builder is initialized and must not be accessed until the builder is finished.
+*/
+typedef struct {
     cutil_btree* btree;
-    unsigned int node_pos;
-};
+    unsigned int height;
+    unsigned int node_capacity;
+    size_t count;
+    _btree_node* spine[BTREE_ITR_MAX_DEPTH];
+} _btree_builder;
+
+void _btree_builder_init(_btree_builder* builder, cutil_btree* btree);
+
+/*
+Appends an item to the btree.  Its key must be greater than the keys of all previously appended items.
+The key and value are moved into the tree as is, callers are responsible for copying them with their traits beforehand.
+*/
+void _btree_builder_append(_btree_builder* builder, void* key, void* value);
+void _btree_builder_finish(_btree_builder* builder);
+
+/*
+Unmaps the file backing a btree opened with cutil_btree_open_mapped and frees its nodes.
+*/
+void _btree_mapping_close(struct _btree_mapping* mapping);
 
 #endif
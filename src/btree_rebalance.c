@@ -0,0 +1,154 @@
+#include "cutil/btree.h"
+#include "btree_private.h"
+
+unsigned int _btree_rebalance_threshold(cutil_btree* btree) {
+    return btree->relaxed_rebalance ? 1 : _btree_node_min_item_count(btree);
+}
+
+void _btree_rebalance_mark(cutil_btree* btree, _btree_node* node) {
+    /* ancestors of a marked node are already marked */
+    while (node && !node->rebalance_pending) {
+        node->rebalance_pending = 1;
+        node = node->parent;
+    }
+
+    btree->rebalance_pending = 1;
+}
+
+void _btree_rebalance_mark_moved(cutil_btree* btree, _btree_node* node, _btree_node* sibling, unsigned int received_pending) {
+    unsigned int min_item_count = _btree_node_min_item_count(btree);
+
+    if (node->item_count < min_item_count || received_pending) {
+        _btree_rebalance_mark(btree, node);
+    }
+
+    if (sibling && sibling->item_count < min_item_count) {
+        _btree_rebalance_mark(btree, sibling);
+    }
+}
+
+void _btree_repair_children(cutil_btree* btree, _btree_node* node);
+
+/*
+Brings the child at the supplied position up to the minimum item count by borrowing from a sibling holding more than the minimum or by merging with it.
+The node must already have been unshared, so it is not replaced while its children are modified.
+A node which held no items during the repair of its children may still have a short child, which it passes on when it borrows or merges.
+The children of a node which has gained branches this way are repaired again before the node itself is checked, which may leave it short once more.
+Returns the position of the next child to repair.
+*/
+unsigned int _btree_repair_child(cutil_btree* btree, _btree_node* node, unsigned int position) {
+    unsigned int min_item_count = _btree_node_min_item_count(btree);
+    _btree_node* child = node->branches[position];
+    int repair_children = 0;
+
+    for (;;) {
+        if (repair_children && !_node_is_leaf(child)) {
+            _btree_repair_children(btree, child);
+        }
+
+        if (child->item_count >= min_item_count || node->item_count == 0) {
+            break;
+        }
+
+        repair_children = 0;
+        child = _btree_node_unshare(btree, child);
+
+        if (position < node->item_count) {
+            _btree_node* sibling = _btree_node_unshare(btree, node->branches[position + 1]);
+
+            repair_children = child->item_count == 0 || sibling->item_count <= min_item_count;
+
+            if (sibling->item_count > min_item_count) {
+                _btree_borrow_from_right_sibling(btree, child, sibling);
+            }
+            else {
+                _btree_merge_node_with_right_sibling(btree, child);
+            }
+        }
+        else {
+            _btree_node* sibling = _btree_node_unshare(btree, node->branches[position - 1]);
+
+            repair_children = child->item_count == 0 || sibling->item_count <= min_item_count;
+
+            if (sibling->item_count > min_item_count) {
+                _btree_borrow_from_left_sibling(btree, child, sibling);
+            }
+            else {
+                /* the merged node takes the place of the child */
+                child = _btree_merge_node_with_right_sibling(btree, sibling);
+                position -= 1;
+            }
+        }
+    }
+
+    return position + 1;
+}
+
+/* Repairs each child of the node, the children of each child must already have been repaired. */
+void _btree_repair_children(cutil_btree* btree, _btree_node* node) {
+    unsigned int i = 0;
+
+    while (i <= node->item_count) {
+        i = _btree_repair_child(btree, node, i);
+    }
+}
+
+/*
+Repairs the marked subtree below an unshared node in post order, so that borrowing and merging only move subtrees which have already been repaired.
+Unmarked children hold no short nodes and are only checked by the repair of their parent.
+Repairing the children of a node may leave the node itself short, it is repaired along with its siblings by its parent.
+*/
+void _btree_flush_subtree(cutil_btree* btree, _btree_node* node) {
+    unsigned int i;
+
+    node->rebalance_pending = 0;
+
+    if (_node_is_leaf(node)) {
+        return;
+    }
+
+    for (i = 0; i <= node->item_count; i++) {
+        if (node->branches[i]->rebalance_pending) {
+            _btree_flush_subtree(btree, _btree_node_unshare(btree, node->branches[i]));
+        }
+    }
+
+    _btree_repair_children(btree, node);
+}
+
+void _btree_flush_rebalance(cutil_btree* btree) {
+    if (!btree->rebalance_pending) {
+        return;
+    }
+
+    _btree_flush_subtree(btree, _btree_node_unshare(btree, btree->root));
+
+    /* merging the children of the root may leave it empty */
+    while (btree->root->item_count == 0 && !_node_is_leaf(btree->root)) {
+        _btree_rebalance_node_below(btree, btree->root, 1);
+    }
+
+    btree->rebalance_pending = 0;
+}
+
+int cutil_btree_set_relaxed_rebalance(cutil_btree* btree, int relaxed) {
+    if (btree->read_only || btree->concurrent) {
+        return 0;
+    }
+
+    if (!relaxed) {
+        _btree_flush_rebalance(btree);
+    }
+
+    btree->relaxed_rebalance = relaxed != 0;
+
+    return 1;
+}
+
+void cutil_btree_flush_rebalance(cutil_btree* btree) {
+    if (btree->read_only || btree->concurrent) {
+        return;
+    }
+
+    _btree_flush_rebalance(btree);
+}
@@ -0,0 +1,363 @@
+#include "cutil/btree.h"
+#include "btree_private.h"
+#include "trait_private.h"
+
+#include <limits.h>
+#include <string.h>
+
+/*
+SIMD kernels are compiled for x86 targets when the compiler provides the required intrinsics.
+SSE2 is part of the x86-64 baseline, AVX2 support is detected at runtime before it is used.
+*/
+#if !defined(CUTIL_NO_SIMD)
+    #if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+        #define CUTIL_BTREE_SEARCH_SSE2
+        #define CUTIL_BTREE_SEARCH_AVX2
+        #define CUTIL_AVX2_FUNC __attribute__((target("avx2")))
+    #elif defined(_MSC_VER) && (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+        #define CUTIL_BTREE_SEARCH_SSE2
+        #define CUTIL_BTREE_SEARCH_AVX2
+        #define CUTIL_AVX2_FUNC
+        #include <intrin.h>
+    #endif
+#endif
+
+#ifdef CUTIL_BTREE_SEARCH_SSE2
+    #include <emmintrin.h>
+#endif
+
+#ifdef CUTIL_BTREE_SEARCH_AVX2
+    #include <immintrin.h>
+#endif
+
+unsigned int _btree_search_generic(cutil_trait* trait, void* keys, unsigned int count, void* key, int* found) {
+    unsigned int i;
+
+    for (i = 0; i < count; i++) {
+        int key_comp = trait->compare_func(key, (char*)keys + trait->size * i, trait->user_data);
+
+        if (key_comp <= 0) {
+            *found = key_comp == 0;
+            return i;
+        }
+    }
+
+    *found = 0;
+    return count;
+}
+
+void _btree_key_prefix(unsigned char* prefix, void* key) {
+    unsigned char* str = *(unsigned char**)key;
+    unsigned int i;
+
+    for (i = 0; i < BTREE_KEY_PREFIX_SIZE && str[i] != 0; i++) {
+        prefix[i] = str[i];
+    }
+
+    for (; i < BTREE_KEY_PREFIX_SIZE; i++) {
+        prefix[i] = 0;
+    }
+}
+
+unsigned int _btree_search_prefixed(cutil_trait* trait, unsigned char* key_prefixes, void* keys, unsigned int count, void* key, int* found) {
+    unsigned char search_prefix[BTREE_KEY_PREFIX_SIZE];
+    unsigned int i;
+
+    _btree_key_prefix(search_prefix, key);
+
+    for (i = 0; i < count; i++) {
+        int key_comp = memcmp(search_prefix, key_prefixes + i * BTREE_KEY_PREFIX_SIZE, BTREE_KEY_PREFIX_SIZE);
+
+        /* the keys share a prefix, so the remainder of the strings decides the comparison */
+        if (key_comp == 0) {
+            key_comp = trait->compare_func(key, (char*)keys + trait->size * i, trait->user_data);
+        }
+
+        if (key_comp <= 0) {
+            *found = key_comp == 0;
+            return i;
+        }
+    }
+
+    *found = 0;
+    return count;
+}
+
+/*
+The scalar kernels count the keys which are less than the search key.
+Because the keys in a node are sorted, this count is the position of the search key in the node.
+The loops are branch free so that the compiler is able to vectorize them on targets without a dedicated kernel.
+*/
+unsigned int _btree_search_int_scalar(void* keys, unsigned int count, void* key, int* found) {
+    int* int_keys = (int*)keys;
+    int search_key = *(int*)key;
+    unsigned int i, less = 0;
+
+    for (i = 0; i < count; i++) {
+        less += int_keys[i] < search_key;
+    }
+
+    *found = less < count && int_keys[less] == search_key;
+    return less;
+}
+
+unsigned int _btree_search_uint_scalar(void* keys, unsigned int count, void* key, int* found) {
+    unsigned int* uint_keys = (unsigned int*)keys;
+    unsigned int search_key = *(unsigned int*)key;
+    unsigned int i, less = 0;
+
+    for (i = 0; i < count; i++) {
+        less += uint_keys[i] < search_key;
+    }
+
+    *found = less < count && uint_keys[less] == search_key;
+    return less;
+}
+
+/*
+The float trait's comparison function considers NaN equal to every value, a NaN search key therefore matches the first key in the node.
+*/
+unsigned int _btree_search_float_nan(unsigned int count, int* found) {
+    *found = count > 0;
+    return 0;
+}
+
+unsigned int _btree_search_float_scalar(void* keys, unsigned int count, void* key, int* found) {
+    float* float_keys = (float*)keys;
+    float search_key = *(float*)key;
+    unsigned int i, less = 0;
+
+    if (search_key != search_key) {
+        return _btree_search_float_nan(count, found);
+    }
+
+    for (i = 0; i < count; i++) {
+        less += float_keys[i] < search_key;
+    }
+
+    *found = less < count && float_keys[less] == search_key;
+    return less;
+}
+
+#ifdef CUTIL_BTREE_SEARCH_SSE2
+
+/* number of set bits in each possible 4 bit lane mask */
+static const unsigned char lane_mask_bit_count[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+
+unsigned int _btree_search_int_sse2(void* keys, unsigned int count, void* key, int* found) {
+    int* int_keys = (int*)keys;
+    int search_key = *(int*)key;
+    __m128i search_vec = _mm_set1_epi32(search_key);
+    unsigned int i = 0, less = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        __m128i key_vec = _mm_loadu_si128((const __m128i*)(int_keys + i));
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(key_vec, search_vec)));
+        less += lane_mask_bit_count[mask];
+    }
+
+    for (; i < count; i++) {
+        less += int_keys[i] < search_key;
+    }
+
+    *found = less < count && int_keys[less] == search_key;
+    return less;
+}
+
+unsigned int _btree_search_uint_sse2(void* keys, unsigned int count, void* key, int* found) {
+    unsigned int* uint_keys = (unsigned int*)keys;
+    unsigned int search_key = *(unsigned int*)key;
+
+    /* SSE2 only provides signed comparisons, flipping the sign bit of both operands preserves unsigned ordering */
+    __m128i sign_bit = _mm_set1_epi32(INT_MIN);
+    __m128i search_vec = _mm_xor_si128(_mm_set1_epi32((int)search_key), sign_bit);
+    unsigned int i = 0, less = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        __m128i key_vec = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(uint_keys + i)), sign_bit);
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(key_vec, search_vec)));
+        less += lane_mask_bit_count[mask];
+    }
+
+    for (; i < count; i++) {
+        less += uint_keys[i] < search_key;
+    }
+
+    *found = less < count && uint_keys[less] == search_key;
+    return less;
+}
+
+unsigned int _btree_search_float_sse2(void* keys, unsigned int count, void* key, int* found) {
+    float* float_keys = (float*)keys;
+    float search_key = *(float*)key;
+    __m128 search_vec = _mm_set1_ps(search_key);
+    unsigned int i = 0, less = 0;
+
+    if (search_key != search_key) {
+        return _btree_search_float_nan(count, found);
+    }
+
+    for (; i + 4 <= count; i += 4) {
+        int mask = _mm_movemask_ps(_mm_cmplt_ps(_mm_loadu_ps(float_keys + i), search_vec));
+        less += lane_mask_bit_count[mask];
+    }
+
+    for (; i < count; i++) {
+        less += float_keys[i] < search_key;
+    }
+
+    *found = less < count && float_keys[less] == search_key;
+    return less;
+}
+
+#endif
+
+#ifdef CUTIL_BTREE_SEARCH_AVX2
+
+CUTIL_AVX2_FUNC unsigned int _btree_search_int_avx2(void* keys, unsigned int count, void* key, int* found) {
+    int* int_keys = (int*)keys;
+    int search_key = *(int*)key;
+    __m256i search_vec = _mm256_set1_epi32(search_key);
+    unsigned int i = 0, less = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m256i key_vec = _mm256_loadu_si256((const __m256i*)(int_keys + i));
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(search_vec, key_vec)));
+        less += lane_mask_bit_count[mask & 0xF] + lane_mask_bit_count[mask >> 4];
+    }
+
+    for (; i < count; i++) {
+        less += int_keys[i] < search_key;
+    }
+
+    *found = less < count && int_keys[less] == search_key;
+    return less;
+}
+
+CUTIL_AVX2_FUNC unsigned int _btree_search_uint_avx2(void* keys, unsigned int count, void* key, int* found) {
+    unsigned int* uint_keys = (unsigned int*)keys;
+    unsigned int search_key = *(unsigned int*)key;
+    __m256i sign_bit = _mm256_set1_epi32(INT_MIN);
+    __m256i search_vec = _mm256_xor_si256(_mm256_set1_epi32((int)search_key), sign_bit);
+    unsigned int i = 0, less = 0;
+
+    for (; i + 8 <= count; i += 8) {
+        __m256i key_vec = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(uint_keys + i)), sign_bit);
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(search_vec, key_vec)));
+        less += lane_mask_bit_count[mask & 0xF] + lane_mask_bit_count[mask >> 4];
+    }
+
+    for (; i < count; i++) {
+        less += uint_keys[i] < search_key;
+    }
+
+    *found = less < count && uint_keys[less] == search_key;
+    return less;
+}
+
+CUTIL_AVX2_FUNC unsigned int _btree_search_float_avx2(void* keys, unsigned int count, void* key, int* found) {
+    float* float_keys = (float*)keys;
+    float search_key = *(float*)key;
+    __m256 search_vec = _mm256_set1_ps(search_key);
+    unsigned int i = 0, less = 0;
+
+    if (search_key != search_key) {
+        return _btree_search_float_nan(count, found);
+    }
+
+    for (; i + 8 <= count; i += 8) {
+        int mask = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(float_keys + i), search_vec, _CMP_LT_OQ));
+        less += lane_mask_bit_count[mask & 0xF] + lane_mask_bit_count[mask >> 4];
+    }
+
+    for (; i < count; i++) {
+        less += float_keys[i] < search_key;
+    }
+
+    *found = less < count && float_keys[less] == search_key;
+    return less;
+}
+
+int _cpu_supports_avx2() {
+#if defined(_MSC_VER)
+    int cpu_info[4];
+
+    /* AVX requires the OS to save the extended register state (OSXSAVE) */
+    __cpuid(cpu_info, 1);
+    if ((cpu_info[2] & (1 << 27)) == 0 || (cpu_info[2] & (1 << 28)) == 0) {
+        return 0;
+    }
+
+    if ((_xgetbv(0) & 6) != 6) {
+        return 0;
+    }
+
+    __cpuidex(cpu_info, 7, 0);
+    return (cpu_info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+/* Selects the best kernel available for the running cpu */
+_btree_key_search_func _select_key_search_func(_btree_key_search_func scalar_func, _btree_key_search_func sse2_func, _btree_key_search_func avx2_func) {
+#ifdef CUTIL_BTREE_SEARCH_AVX2
+    static int avx2_supported = -1;
+
+    if (avx2_supported == -1) {
+        avx2_supported = _cpu_supports_avx2();
+    }
+
+    if (avx2_supported) {
+        return avx2_func;
+    }
+#else
+    (void)avx2_func;
+#endif
+
+#ifdef CUTIL_BTREE_SEARCH_SSE2
+    (void)scalar_func;
+    return sse2_func;
+#else
+    (void)sse2_func;
+    return scalar_func;
+#endif
+}
+
+#if defined(CUTIL_BTREE_SEARCH_AVX2)
+    #define SELECT_KEY_SEARCH_FUNC(type) _select_key_search_func(_btree_search_##type##_scalar, _btree_search_##type##_sse2, _btree_search_##type##_avx2)
+#elif defined(CUTIL_BTREE_SEARCH_SSE2)
+    #define SELECT_KEY_SEARCH_FUNC(type) _select_key_search_func(_btree_search_##type##_scalar, _btree_search_##type##_sse2, NULL)
+#else
+    #define SELECT_KEY_SEARCH_FUNC(type) _select_key_search_func(_btree_search_##type##_scalar, NULL, NULL)
+#endif
+
+_btree_key_search_func _btree_key_search_func_for_trait(cutil_trait* key_trait) {
+    if (key_trait->compare_func == cutil_trait_int_compare && key_trait->size == sizeof(int)) {
+        return SELECT_KEY_SEARCH_FUNC(int);
+    }
+    else if (key_trait->compare_func == cutil_trait_uint_compare && key_trait->size == sizeof(unsigned int)) {
+        return SELECT_KEY_SEARCH_FUNC(uint);
+    }
+    else if (key_trait->compare_func == cutil_trait_float_compare && key_trait->size == sizeof(float)) {
+        return SELECT_KEY_SEARCH_FUNC(float);
+    }
+    else {
+        return NULL;
+    }
+}
+
+unsigned int _btree_search_node(cutil_btree* btree, _btree_node* node, void* key, int* found) {
+    if (btree->key_search_func) {
+        return btree->key_search_func(node->keys, node->item_count, key, found);
+    }
+    else if (node->key_prefixes) {
+        return _btree_search_prefixed(btree->key_trait, node->key_prefixes, node->keys, node->item_count, key, found);
+    }
+    else {
+        return _btree_search_generic(btree->key_trait, node->keys, node->item_count, key, found);
+    }
+}
@@ -0,0 +1,472 @@
+#include "cutil/btree.h"
+#include "btree_private.h"
+#include "defs_private.h"
+
+#include <string.h>
+
+/*
+Splitting cuts every node along the path to the split key into a left and right half.
+The halves are fresh or unshared nodes which may hold any number of items, including none, so they are repaired afterwards by working along the border of each tree.
+*/
+
+unsigned int _btree_node_height(_btree_node* node) {
+    unsigned int height = 0;
+
+    while (!_node_is_leaf(node)) {
+        node = node->branches[0];
+        height += 1;
+    }
+
+    return height;
+}
+
+size_t _btree_node_count_items(_btree_node* node) {
+    size_t count = node->item_count;
+    unsigned int i;
+
+    if (!_node_is_leaf(node)) {
+        for (i = 0; i <= node->item_count; i++) {
+            count += _btree_node_count_items(node->branches[i]);
+        }
+    }
+
+    return count;
+}
+
+void _btree_split_nodes(cutil_btree* btree, cutil_btree* right, void* key, int inclusive) {
+    _btree_node* node = _btree_node_unshare(btree, btree->root);
+    _btree_node* right_node = _node_create(btree);
+    unsigned int i, position, count;
+    int found;
+
+    right->root = right_node;
+
+    for (;;) {
+        position = _btree_search_node(btree, node, key, &found);
+
+        if (found && inclusive) {
+            position += 1;
+        }
+
+        count = node->item_count - position;
+
+        for (i = 0; i < count; i++) {
+            _node_copy_item(btree, right_node, i, node, position + i);
+        }
+
+        right_node->item_count = count;
+        node->item_count = position;
+
+        if (_node_is_leaf(node)) {
+            break;
+        }
+
+        for (i = 1; i <= count; i++) {
+            _set_node_child(right_node, node->branches[position + i], i);
+            node->branches[position + i] = NULL;
+        }
+
+        /* the branch at the split position may hold keys on both sides of the split key, so it is cut at the next level */
+        _set_node_child(right_node, _node_create(btree), 0);
+        right_node = right_node->branches[0];
+        node = _btree_node_unshare(btree, node->branches[position]);
+    }
+}
+
+/* Removes interior roots which have no items.  An empty tree is left with an empty leaf as its root. */
+void _btree_trim_root(cutil_btree* btree) {
+    while (btree->root->item_count == 0 && !_node_is_leaf(btree->root)) {
+        _btree_node* old_root = btree->root;
+
+        btree->root = old_root->branches[0];
+        btree->root->parent = NULL;
+
+        _node_destroy(btree, old_root);
+    }
+}
+
+/*
+After the border has been stocked, a node may have been left with the minimum number of items and then lost one when its children were merged.
+These nodes have a sibling at the minimum count at most, so the regular rebalance borrows or merges them in a single step.
+The deepest short node is repaired first because repairing it may cascade into its ancestors.
+*/
+void _btree_repair_border(cutil_btree* btree, int right_border) {
+    unsigned int min_item_count = _btree_node_min_item_count(btree);
+
+    for (;;) {
+        _btree_node* node = btree->root;
+        _btree_node* short_node = NULL;
+
+        while (!_node_is_leaf(node)) {
+            node = right_border ? node->branches[node->item_count] : node->branches[0];
+
+            if (node->item_count < min_item_count) {
+                short_node = node;
+            }
+        }
+
+        if (short_node == NULL) {
+            break;
+        }
+
+        _btree_rebalance_node_below(btree, short_node, min_item_count);
+    }
+}
+
+void _btree_fix_right_border(cutil_btree* btree) {
+    unsigned int min_item_count = _btree_node_min_item_count(btree);
+    _btree_node* node;
+
+    _btree_trim_root(btree);
+    node = btree->root;
+
+    /* each border child either merges with its left sibling or borrows from it until it holds more than the minimum, so that a merge on the next level leaves it valid */
+    while (!_node_is_leaf(node)) {
+        _btree_node* child = node->branches[node->item_count];
+        _btree_node* sibling = _btree_node_unshare(btree, node->branches[node->item_count - 1]);
+
+        if (sibling->item_count + child->item_count < btree->order - 1) {
+            node = _btree_merge_node_with_right_sibling(btree, sibling);
+        }
+        else {
+            while (child->item_count <= min_item_count && sibling->item_count > min_item_count) {
+                _btree_borrow_from_left_sibling(btree, child, sibling);
+            }
+
+            node = child;
+        }
+    }
+
+    _btree_trim_root(btree);
+    _btree_repair_border(btree, 1);
+}
+
+void _btree_fix_left_border(cutil_btree* btree) {
+    unsigned int min_item_count = _btree_node_min_item_count(btree);
+    _btree_node* node;
+
+    _btree_trim_root(btree);
+    node = btree->root;
+
+    while (!_node_is_leaf(node)) {
+        _btree_node* child = node->branches[0];
+        _btree_node* sibling = _btree_node_unshare(btree, node->branches[1]);
+
+        if (sibling->item_count + child->item_count < btree->order - 1) {
+            node = _btree_merge_node_with_right_sibling(btree, child);
+        }
+        else {
+            while (child->item_count <= min_item_count && sibling->item_count > min_item_count) {
+                _btree_borrow_from_right_sibling(btree, child, sibling);
+            }
+
+            node = child;
+        }
+    }
+
+    _btree_trim_root(btree);
+    _btree_repair_border(btree, 0);
+}
+
+/* Appends an item followed by the items and branches of the source node to the destination node.  The source node is destroyed. */
+void _btree_append_node(cutil_btree* btree, _btree_node* dest, void* key, void* value, _btree_node* src) {
+    unsigned int i, insert_pos;
+
+    _node_set_item(btree, dest, dest->item_count, key, value);
+    dest->item_count += 1;
+
+    insert_pos = dest->item_count;
+
+    for (i = 0; i < src->item_count; i++) {
+        _node_copy_item(btree, dest, insert_pos + i, src, i);
+    }
+
+    for (i = 0; i <= src->item_count; i++) {
+        _set_node_child(dest, src->branches[i], insert_pos + i);
+    }
+
+    dest->item_count += src->item_count;
+
+    _node_destroy(btree, src);
+}
+
+/*
+Grafts the shorter tree onto the border of the taller one at the level where their heights match.
+Both nodes meeting at the graft are then stocked from each other, which is always possible because together they hold at least order - 1 items.
+*/
+void _btree_join_with_item(cutil_btree* left, cutil_btree* right, void* key, void* value) {
+    unsigned int min_item_count = _btree_node_min_item_count(left);
+    unsigned int left_height = _btree_node_height(left->root);
+    unsigned int right_height = _btree_node_height(right->root);
+    _btree_node *parent, *left_node, *right_node;
+    unsigned int i;
+
+    if (left_height >= right_height) {
+        parent = left->root;
+
+        if (left_height == right_height) {
+            /* the trees are joined under a new root, which is removed again if the two roots merge */
+            left->root = _node_create(left);
+            _set_node_child(left->root, parent, 0);
+            parent = left->root;
+        }
+        else {
+            for (i = right_height + 1; i < left_height; i++) {
+                parent = parent->branches[parent->item_count];
+            }
+
+            parent = _btree_node_unshare(left, parent);
+        }
+
+        left_node = _btree_node_unshare(left, parent->branches[parent->item_count]);
+        right_node = _btree_node_unshare(right, right->root);
+    }
+    else {
+        parent = right->root;
+
+        for (i = left_height + 1; i < right_height; i++) {
+            parent = parent->branches[0];
+        }
+
+        parent = _btree_node_unshare(right, parent);
+        left_node = _btree_node_unshare(left, left->root);
+        right_node = _btree_node_unshare(right, parent->branches[0]);
+
+        /* the right tree receives the left tree's nodes and is handed back through the left tree */
+        left->root = right->root;
+    }
+
+    right->root = NULL;
+
+    if (left_node->item_count + right_node->item_count < left->order - 1) {
+        int graft_left = _node_is_root(left_node);
+
+        _btree_append_node(left, left_node, key, value, right_node);
+
+        if (graft_left) {
+            _set_node_child(parent, left_node, 0);
+        }
+    }
+    else {
+        _push_up_one_level(left, parent, left_node, right_node, key, value);
+
+        while (right_node->item_count < min_item_count && left_node->item_count > min_item_count) {
+            _btree_borrow_from_left_sibling(left, right_node, left_node);
+        }
+
+        while (left_node->item_count < min_item_count && right_node->item_count > min_item_count) {
+            _btree_borrow_from_right_sibling(left, left_node, right_node);
+        }
+    }
+
+    _btree_trim_root(left);
+}
+
+void _btree_join(cutil_btree* left, cutil_btree* right) {
+    _btree_node* node;
+    void* key;
+    void* value;
+    unsigned int i;
+
+    if (right->root->item_count == 0) {
+        _node_release(right, right->root);
+        right->root = NULL;
+        return;
+    }
+
+    if (left->root->item_count == 0) {
+        _node_release(left, left->root);
+        left->root = right->root;
+        right->root = NULL;
+        return;
+    }
+
+    /* the smallest item of the right tree becomes the item that separates the two trees */
+    node = right->root;
+    while (!_node_is_leaf(node)) {
+        node = node->branches[0];
+    }
+
+    node = _btree_node_unshare(right, node);
+
+    key = alloca_func(right->key_trait->size);
+    value = alloca_func(right->value_trait->size);
+    memcpy(key, _node_get_key(node, right->key_trait, 0), right->key_trait->size);
+    memcpy(value, _node_get_value(node, right->value_trait, 0), right->value_trait->size);
+
+    for (i = 1; i < node->item_count; i++) {
+        _node_copy_item(right, node, i - 1, node, i);
+    }
+
+    node->item_count -= 1;
+    _btree_rebalance_node_below(right, node, _btree_node_min_item_count(right));
+
+    _btree_join_with_item(left, right, key, value);
+}
+
+size_t cutil_btree_erase_range(cutil_btree* btree, void* lo, void* hi) {
+    cutil_btree middle, right;
+    size_t erase_count;
+
+    if (btree->read_only || btree->concurrent) {
+        return 0;
+    }
+
+    if (lo && hi && btree->key_trait->compare_func(lo, hi, btree->key_trait->user_data) > 0) {
+        return 0;
+    }
+
+    _btree_flush_rebalance(btree);
+
+    memcpy(&middle, btree, sizeof(cutil_btree));
+    memcpy(&right, btree, sizeof(cutil_btree));
+
+    if (lo) {
+        _btree_split_nodes(btree, &middle, lo, 0);
+    }
+    else {
+        middle.root = btree->root;
+        btree->root = _node_create(btree);
+    }
+
+    if (hi) {
+        _btree_split_nodes(&middle, &right, hi, 1);
+    }
+    else {
+        right.root = _node_create(btree);
+    }
+
+    /* the removed items are released along with their nodes, their subtrees are never searched or rebalanced */
+    erase_count = _btree_node_count_items(middle.root);
+    _node_release(&middle, middle.root);
+
+    _btree_fix_right_border(btree);
+    _btree_fix_left_border(&right);
+    _btree_join(btree, &right);
+
+    btree->size -= erase_count;
+
+    return erase_count;
+}
+
+/*
+Counts the items of a tree one node at a time so that two trees can be counted in lockstep.
+Returns zero once every node has been visited.
+*/
+typedef struct {
+    _btree_node* nodes[BTREE_ITR_MAX_DEPTH];
+    unsigned int positions[BTREE_ITR_MAX_DEPTH];
+    unsigned int depth;
+    size_t count;
+} _btree_count_state;
+
+void _btree_count_init(_btree_count_state* state, _btree_node* root) {
+    state->nodes[0] = root;
+    state->positions[0] = 0;
+    state->depth = 1;
+    state->count = root->item_count;
+}
+
+int _btree_count_step(_btree_count_state* state) {
+    while (state->depth > 0) {
+        _btree_node* node = state->nodes[state->depth - 1];
+
+        if (_node_is_leaf(node) || state->positions[state->depth - 1] > node->item_count) {
+            state->depth -= 1;
+        }
+        else {
+            _btree_node* child = node->branches[state->positions[state->depth - 1]++];
+
+            state->nodes[state->depth] = child;
+            state->positions[state->depth] = 0;
+            state->depth += 1;
+            state->count += child->item_count;
+
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+int cutil_btree_split(cutil_btree* btree, void* key, cutil_btree** out_right) {
+    _btree_count_state left_count, right_count;
+    cutil_btree* right;
+    int left_counting, right_counting;
+
+    if (btree->read_only || btree->concurrent) {
+        return 0;
+    }
+
+    _btree_flush_rebalance(btree);
+
+    right = _btree_create(btree->order, btree->key_trait, btree->value_trait, 0, btree->key_prefixes);
+    right->relaxed_rebalance = btree->relaxed_rebalance;
+    _node_release(right, right->root);
+
+    _btree_split_nodes(btree, right, key, 0);
+    _btree_fix_right_border(btree);
+    _btree_fix_left_border(right);
+
+    /* nodes do not record the size of their subtrees, so only the smaller of the two trees is counted */
+    _btree_count_init(&left_count, btree->root);
+    _btree_count_init(&right_count, right->root);
+
+    do {
+        left_counting = _btree_count_step(&left_count);
+        right_counting = _btree_count_step(&right_count);
+    } while (left_counting && right_counting);
+
+    if (!left_counting) {
+        right->size = btree->size - left_count.count;
+    }
+    else {
+        right->size = right_count.count;
+    }
+
+    btree->size -= right->size;
+    *out_right = right;
+
+    return 1;
+}
+
+int cutil_btree_join(cutil_btree* left, cutil_btree* right) {
+    cutil_trait* key_trait = left->key_trait;
+    _btree_node *max_node, *min_node;
+
+    if (left == right || left->read_only || right->read_only || left->concurrent || right->concurrent) {
+        return 0;
+    }
+
+    /* nodes are moved between the btrees, so they must share a node layout */
+    if (left->order != right->order || left->key_trait != right->key_trait || left->value_trait != right->value_trait || left->key_prefixes != right->key_prefixes) {
+        return 0;
+    }
+
+    if (left->size > 0 && right->size > 0) {
+        max_node = left->root;
+        while (!_node_is_leaf(max_node)) {
+            max_node = max_node->branches[max_node->item_count];
+        }
+
+        min_node = right->root;
+        while (!_node_is_leaf(min_node)) {
+            min_node = min_node->branches[0];
+        }
+
+        if (key_trait->compare_func(_node_get_key(max_node, key_trait, max_node->item_count - 1), _node_get_key(min_node, key_trait, 0), key_trait->user_data) >= 0) {
+            return 0;
+        }
+    }
+
+    _btree_flush_rebalance(left);
+    _btree_flush_rebalance(right);
+
+    _btree_join(left, right);
+    right->root = _node_create(right);
+
+    left->size += right->size;
+    right->size = 0;
+
+    return 1;
+}
@@ -0,0 +1,98 @@
+#include "cutil/btree.h"
+#include "btree_private.h"
+
+#include <string.h>
+
+/*
+Counts the nodes and items of the subtree rooted at the supplied node.
+The smallest item count of any node other than the root is recorded in min_items and the number of nodes with children is added to interior_count.
+*/
+void _btree_stats_visit(cutil_btree* btree, _btree_node* node, unsigned int level, cutil_btree_statistics* stats, unsigned int* min_items, size_t* interior_count) {
+    unsigned int i;
+
+    if (level < CUTIL_BTREE_STATS_MAX_LEVELS) {
+        stats->level_node_counts[level] += 1;
+    }
+
+    if (level + 1 > stats->height) {
+        stats->height = level + 1;
+    }
+
+    stats->node_count += 1;
+    stats->item_count += node->item_count;
+
+    if (level > 0 && node->item_count < *min_items) {
+        *min_items = node->item_count;
+    }
+
+    if (!_node_is_leaf(node)) {
+        *interior_count += 1;
+
+        for (i = 0; i <= node->item_count; i++) {
+            _btree_stats_visit(btree, node->branches[i], level + 1, stats, min_items, interior_count);
+        }
+    }
+}
+
+/*
+Adds the memory used by nodes allocated with _node_create.
+Each node is a single allocation, the bytes which are not used by the key, value and branch arrays are counted as node bytes.
+*/
+void _btree_stats_node_memory(cutil_btree* btree, cutil_btree_statistics* stats) {
+    size_t node_count = stats->node_count;
+    size_t allocation_size = btree->node_layout.size + BTREE_NODE_ALIGNMENT - 1;
+
+    stats->key_bytes = node_count * (btree->order - 1) * btree->key_trait->size;
+    stats->value_bytes = node_count * (btree->order - 1) * btree->value_trait->size;
+    stats->branch_bytes = node_count * btree->order * sizeof(_btree_node*);
+
+    if (btree->key_prefixes) {
+        stats->key_bytes += node_count * (btree->order - 1) * BTREE_KEY_PREFIX_SIZE;
+    }
+
+    stats->node_bytes = node_count * allocation_size - stats->key_bytes - stats->value_bytes - stats->branch_bytes;
+    stats->allocation_count = node_count;
+}
+
+/*
+Adds the memory used by the nodes of a mapped btree.
+Node headers are held in a single array and all leaves share one array of null branches.
+The mapping and its two arrays are counted as allocations, the mapped file itself is not.
+*/
+void _btree_stats_mapped_memory(cutil_btree* btree, cutil_btree_statistics* stats, size_t interior_count) {
+    stats->branch_bytes = (interior_count + 1) * btree->order * sizeof(_btree_node*);
+    stats->node_bytes = stats->node_count * sizeof(_btree_node);
+    stats->allocation_count = 3;
+}
+
+void cutil_btree_stats(cutil_btree* btree, cutil_btree_statistics* stats) {
+    unsigned int min_items = btree->order - 1;
+    size_t capacity, interior_count = 0;
+
+    memset(stats, 0, sizeof(cutil_btree_statistics));
+
+    _btree_stats_visit(btree, btree->root, 0, stats, &min_items, &interior_count);
+
+    if (stats->height == 1) {
+        min_items = btree->root->item_count;
+    }
+
+    capacity = stats->node_count * (btree->order - 1);
+    stats->average_fill = (double)stats->item_count / (double)capacity;
+    stats->min_fill = (double)min_items / (double)(btree->order - 1);
+
+    if (btree->mapping) {
+        _btree_stats_mapped_memory(btree, stats, interior_count);
+    }
+    else {
+        _btree_stats_node_memory(btree, stats);
+    }
+
+    stats->allocation_count += 1;
+    stats->total_bytes = stats->key_bytes + stats->value_bytes + stats->branch_bytes + stats->node_bytes + sizeof(cutil_btree);
+
+    if (btree->root_latch) {
+        stats->allocation_count += 1;
+        stats->total_bytes += sizeof(_rwlock);
+    }
+}
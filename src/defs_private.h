@@ -9,4 +9,13 @@
     #define alloca_func alloca
 #endif
 
+#if defined(__GNUC__) || defined(__clang__)
+    #define prefetch_func(ptr) __builtin_prefetch(ptr)
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+    #include <xmmintrin.h>
+    #define prefetch_func(ptr) _mm_prefetch((const char*)(ptr), _MM_HINT_T0)
+#else
+    #define prefetch_func(ptr)
+#endif
+
 #endif
@@ -1,5 +1,6 @@
 #include "cutil/forward_list.h"
 #include "cutil/allocator.h"
+#include "stream_private.h"
 
 #include <stddef.h>
 #include <string.h>
@@ -11,12 +12,16 @@ typedef struct cutil_forward_list_node {
 
 struct cutil_forward_list {
     cutil_forward_list_node before_begin;
+    cutil_forward_list_node* tail;
+    unsigned int size;
     cutil_trait* trait;
-};
 
-struct cutil_forward_list_itr {
-    cutil_forward_list* list;
-    cutil_forward_list_node* node;
+    /* nodes of removed items, linked through next, which are reused along with their data storage */
+    cutil_forward_list_node* node_cache;
+    unsigned int node_cache_size;
+    unsigned int node_cache_capacity;
+    size_t node_cache_hit_count;
+    size_t node_cache_miss_count;
 };
 
 void cutil_forward_list_node_destroy(cutil_forward_list* list, cutil_forward_list_node* list_node);
@@ -28,8 +33,16 @@ cutil_forward_list* cutil_forward_list_create(cutil_trait* trait) {
     
     list->before_begin.next = &list->before_begin;
     list->before_begin.data = NULL;
+    list->tail = &list->before_begin;
+    list->size = 0;
     list->trait = trait;
 
+    list->node_cache = NULL;
+    list->node_cache_size = 0;
+    list->node_cache_capacity = 0;
+    list->node_cache_hit_count = 0;
+    list->node_cache_miss_count = 0;
+
     return list;
 }
 
@@ -37,6 +50,7 @@ void cutil_forward_list_destroy(cutil_forward_list* list) {
     cutil_allocator* allocator = cutil_current_allocator();
 
     cutil_forward_list_clear(list);
+    cutil_forward_list_set_node_cache_capacity(list, 0);
     allocator->free(list, allocator->user_data);
 }
 
@@ -51,6 +65,8 @@ void cutil_forward_list_clear(cutil_forward_list* list) {
         }
 
         list->before_begin.next = &list->before_begin;
+        list->tail = &list->before_begin;
+        list->size = 0;
     }
 }
 
@@ -58,10 +74,24 @@ int cutil_forward_list_empty(cutil_forward_list* list) {
     return list->before_begin.next == &list->before_begin;
 }
 
+unsigned int cutil_forward_list_size(cutil_forward_list* list) {
+    return list->size;
+}
+
 cutil_forward_list_node* cutil_forward_list_node_create(cutil_forward_list* list, void* data) {
     cutil_allocator* allocator = cutil_current_allocator();
-    cutil_forward_list_node* new_node = allocator->malloc(sizeof(cutil_forward_list_node), allocator->user_data);
-    new_node->data = allocator->malloc(list->trait->size, allocator->user_data);
+    cutil_forward_list_node* new_node = list->node_cache;
+
+    if (new_node) {
+        list->node_cache = new_node->next;
+        list->node_cache_size -= 1;
+        list->node_cache_hit_count += 1;
+    }
+    else {
+        new_node = allocator->malloc(sizeof(cutil_forward_list_node), allocator->user_data);
+        new_node->data = allocator->malloc(list->trait->size, allocator->user_data);
+        list->node_cache_miss_count += 1;
+    }
 
     if (list->trait->copy_func) {
         list->trait->copy_func(new_node->data, data, list->trait->user_data);
@@ -82,10 +112,54 @@ void cutil_forward_list_node_destroy(cutil_forward_list* list, cutil_forward_lis
         list->trait->destroy_func(list_node->data, list->trait->user_data);
     }
 
+    if (list->node_cache_size < list->node_cache_capacity) {
+        list_node->next = list->node_cache;
+        list->node_cache = list_node;
+        list->node_cache_size += 1;
+        return;
+    }
+
     allocator->free(list_node->data, allocator->user_data);
     allocator->free(list_node, allocator->user_data);
 }
 
+void cutil_forward_list_set_node_cache_capacity(cutil_forward_list* list, unsigned int capacity) {
+    cutil_allocator* allocator = cutil_current_allocator();
+
+    list->node_cache_capacity = capacity;
+
+    while (list->node_cache_size > capacity) {
+        cutil_forward_list_node* node = list->node_cache;
+
+        list->node_cache = node->next;
+        list->node_cache_size -= 1;
+
+        allocator->free(node->data, allocator->user_data);
+        allocator->free(node, allocator->user_data);
+    }
+}
+
+unsigned int cutil_forward_list_get_node_cache_capacity(cutil_forward_list* list) {
+    return list->node_cache_capacity;
+}
+
+unsigned int cutil_forward_list_node_cache_size(cutil_forward_list* list) {
+    return list->node_cache_size;
+}
+
+size_t cutil_forward_list_node_cache_hit_count(cutil_forward_list* list) {
+    return list->node_cache_hit_count;
+}
+
+size_t cutil_forward_list_node_cache_miss_count(cutil_forward_list* list) {
+    return list->node_cache_miss_count;
+}
+
+void cutil_forward_list_reset_node_cache_counters(cutil_forward_list* list) {
+    list->node_cache_hit_count = 0;
+    list->node_cache_miss_count = 0;
+}
+
 void cutil_forward_list_push_front(cutil_forward_list* list, void* data) {
     cutil_forward_list_node* new_node = cutil_forward_list_node_create(list, data);
 
@@ -93,6 +167,7 @@ void cutil_forward_list_push_front(cutil_forward_list* list, void* data) {
     if (cutil_forward_list_empty(list)) {
         new_node->next = &list->before_begin;
         list->before_begin.next = new_node;
+        list->tail = new_node;
     }
     else { /* first item added to the list */
         cutil_forward_list_node* current_front_node = list->before_begin.next;
@@ -100,6 +175,35 @@ void cutil_forward_list_push_front(cutil_forward_list* list, void* data) {
         new_node->next = current_front_node;
         list->before_begin.next = new_node;
     }
+
+    list->size += 1;
+}
+
+void cutil_forward_list_push_back(cutil_forward_list* list, void* data) {
+    cutil_forward_list_node* new_node = cutil_forward_list_node_create(list, data);
+
+    new_node->next = &list->before_begin;
+    list->tail->next = new_node;
+    list->tail = new_node;
+
+    list->size += 1;
+}
+
+size_t cutil_forward_list_foreach(cutil_forward_list* list, cutil_forward_list_foreach_func callback, void* user_data) {
+    cutil_forward_list_node* node = list->before_begin.next;
+    size_t count = 0;
+
+    while (node != &list->before_begin) {
+        count += 1;
+
+        if (!callback(node->data, user_data)) {
+            break;
+        }
+
+        node = node->next;
+    }
+
+    return count;
 }
 
 int cutil_forward_list_front(cutil_forward_list* list, void* out) {
@@ -123,9 +227,11 @@ int cutil_forward_list_pop_front(cutil_forward_list* list) {
         }
         else { /* no items left in the list */
             list->before_begin.next = &list->before_begin;
+            list->tail = &list->before_begin;
         }
 
         cutil_forward_list_node_destroy(list, node_to_delete);
+        list->size -= 1;
 
         return 1;
     }
@@ -134,21 +240,117 @@ int cutil_forward_list_pop_front(cutil_forward_list* list) {
     }
 }
 
+int cutil_forward_list_write(cutil_forward_list* list, cutil_writer* writer) {
+    cutil_forward_list_node* node;
+
+    if (!_stream_trait_writable(list->trait) || !_stream_write_header(writer, list->trait, list->size)) {
+        return 0;
+    }
+
+    for (node = list->before_begin.next; node != &list->before_begin; node = node->next) {
+        if (!_stream_write_item(writer, list->trait, node->data)) {
+            return 0;
+        }
+    }
+
+    return cutil_writer_flush(writer);
+}
+
+/* Items are read directly into the storage of new nodes which are linked after the tail of the list */
+int _cutil_forward_list_read_items(cutil_forward_list* list, cutil_reader* reader) {
+    cutil_allocator* allocator = cutil_current_allocator();
+    cutil_forward_list_node* new_node;
+    size_t count;
+
+    if (!_stream_trait_readable(list->trait) || !_stream_read_header(reader, list->trait, &count)) {
+        return 0;
+    }
+
+    while (count > 0) {
+        new_node = allocator->malloc(sizeof(cutil_forward_list_node), allocator->user_data);
+        new_node->data = allocator->malloc(list->trait->size, allocator->user_data);
+
+        if (!_stream_read_item(reader, list->trait, new_node->data)) {
+            allocator->free(new_node->data, allocator->user_data);
+            allocator->free(new_node, allocator->user_data);
+            return 0;
+        }
+
+        new_node->next = &list->before_begin;
+        list->tail->next = new_node;
+        list->tail = new_node;
+
+        list->size += 1;
+        count -= 1;
+    }
+
+    return 1;
+}
+
+cutil_forward_list* cutil_forward_list_read(cutil_reader* reader, cutil_trait* trait) {
+    cutil_forward_list* list = cutil_forward_list_create(trait);
+
+    if (!_cutil_forward_list_read_items(list, reader)) {
+        cutil_forward_list_destroy(list);
+        return NULL;
+    }
+
+    return list;
+}
+
 cutil_forward_list_itr* cutil_forward_list_itr_create(cutil_forward_list* list) {
     cutil_allocator* allocator = cutil_current_allocator();
     cutil_forward_list_itr* itr = allocator->malloc(sizeof(cutil_forward_list_itr), allocator->user_data);
 
-    itr->list = list;
-    itr->node = &list->before_begin;
+    cutil_forward_list_itr_init(itr, list);
 
     return itr;
 }
 
+void cutil_forward_list_itr_init(cutil_forward_list_itr* itr, cutil_forward_list* list) {
+    itr->list = list;
+    itr->node = &list->before_begin;
+}
+
 void cutil_forward_list_itr_destroy(cutil_forward_list_itr* itr) {
     cutil_allocator* allocator = cutil_current_allocator();
     allocator->free(itr, allocator->user_data);
 }
 
+void cutil_forward_list_insert_after(cutil_forward_list_itr* itr, void* data) {
+    cutil_forward_list* list = itr->list;
+    cutil_forward_list_node* new_node = cutil_forward_list_node_create(list, data);
+
+    new_node->next = itr->node->next;
+    itr->node->next = new_node;
+
+    if (list->tail == itr->node) {
+        list->tail = new_node;
+    }
+
+    list->size += 1;
+}
+
+int cutil_forward_list_erase_after(cutil_forward_list_itr* itr) {
+    cutil_forward_list* list = itr->list;
+    cutil_forward_list_node* node_to_delete = itr->node->next;
+
+    if (node_to_delete == &list->before_begin) {
+        return 0;
+    }
+
+    itr->node->next = node_to_delete->next;
+
+    if (list->tail == node_to_delete) {
+        list->tail = itr->node;
+    }
+
+    cutil_forward_list_node_destroy(list, node_to_delete);
+    list->size -= 1;
+
+    return 1;
+}
+
 int cutil_forward_list_itr_has_next(cutil_forward_list_itr* itr) {
     return (itr->node->next->data != NULL);
 }
@@ -166,3 +368,85 @@ int cutil_forward_list_itr_next(cutil_forward_list_itr* itr, void* out) {
 
     return 0;
 }
+
+/*
+Merges two chains of nodes terminated by NULL, each sorted by the trait's comparison function.
+Items from the first chain are placed before equal items from the second, which keeps the sort stable.
+*/
+cutil_forward_list_node* _cutil_forward_list_merge_chains(cutil_trait* trait, cutil_forward_list_node* a, cutil_forward_list_node* b) {
+    cutil_forward_list_node head;
+    cutil_forward_list_node* tail = &head;
+
+    while (a && b) {
+        if (trait->compare_func(b->data, a->data, trait->user_data) < 0) {
+            tail->next = b;
+            b = b->next;
+        }
+        else {
+            tail->next = a;
+            a = a->next;
+        }
+
+        tail = tail->next;
+    }
+
+    tail->next = a ? a : b;
+
+    return head.next;
+}
+
+/*
+Sorts the list bottom up, in the same manner as a binary counter.
+Each slot holds either nothing or a sorted run of 2^i nodes which came before every node that has not been placed yet.
+Nodes are taken from the front of the list one at a time and merged with the occupied slots beginning at the lowest, until an empty slot is reached.
+*/
+int cutil_forward_list_sort(cutil_forward_list* list) {
+    cutil_forward_list_node* runs[sizeof(size_t) * 8];
+    cutil_forward_list_node* node = list->before_begin.next;
+    cutil_forward_list_node* run;
+    size_t run_count = 0;
+    size_t i;
+
+    if (list->trait->compare_func == NULL) {
+        return 0;
+    }
+
+    while (node != &list->before_begin) {
+        run = node;
+        node = node->next;
+        run->next = NULL;
+
+        for (i = 0; i < run_count && runs[i]; i++) {
+            run = _cutil_forward_list_merge_chains(list->trait, runs[i], run);
+            runs[i] = NULL;
+        }
+
+        if (i == run_count) {
+            run_count += 1;
+        }
+
+        runs[i] = run;
+    }
+
+    run = NULL;
+
+    for (i = 0; i < run_count; i++) {
+        if (runs[i]) {
+            run = _cutil_forward_list_merge_chains(list->trait, runs[i], run);
+        }
+    }
+
+    /* relink the sorted chain into the list, an empty chain leaves the list empty */
+    node = &list->before_begin;
+
+    while (run) {
+        node->next = run;
+        node = run;
+        run = run->next;
+    }
+
+    node->next = &list->before_begin;
+    list->tail = node;
+
+    return 1;
+}
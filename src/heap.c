@@ -156,3 +156,24 @@ void cutil_heap_reset(cutil_heap* heap) {
 void cutil_heap_clear(cutil_heap* heap) {
     cutil_vector_clear(heap->vector);
 }
+
+int cutil_heap_write(cutil_heap* heap, cutil_writer* writer) {
+    return cutil_vector_write(heap->vector, writer);
+}
+
+cutil_heap* cutil_heap_read(cutil_reader* reader, cutil_trait* trait) {
+    cutil_allocator* allocator = cutil_current_allocator();
+    cutil_heap* heap = NULL;
+    cutil_vector* vector;
+
+    if (trait->compare_func == NULL) return heap;
+
+    /* items are restored in their stored order, which is already a valid heap */
+    vector = cutil_vector_read(reader, trait);
+    if (vector == NULL) return heap;
+
+    heap = allocator->malloc(sizeof(cutil_heap), allocator->user_data);
+    heap->vector = vector;
+
+    return heap;
+}
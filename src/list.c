@@ -1,261 +1,593 @@
-#include "cutil/list.h"
-#include "cutil/allocator.h"
-
-#include <stddef.h>
-#include <string.h>
-
-typedef struct cutil_list_node {
-    void* data;
-    struct cutil_list_node* next;
-    struct cutil_list_node* prev;
-} cutil_list_node;
-
-struct cutil_list {
-    unsigned int size;
-    cutil_list_node base;
-    cutil_trait* trait;
-};
-
-struct cutil_list_itr {
-    cutil_list* list;
-    cutil_list_node* node;
-};
-
-void cutil_list_node_destroy(cutil_list* list, cutil_list_node* list_node);
-cutil_list_node* cutil_list_node_create(cutil_list* list, void* data);
-
-cutil_list* cutil_list_create(cutil_trait* trait) {
-    cutil_allocator* allocator = cutil_current_allocator();
-    cutil_list* list = allocator->malloc(sizeof(cutil_list), allocator->user_data);
-
-    list->size = 0;
-    list->base.prev = &list->base;
-    list->base.next = &list->base;
-    list->base.data = NULL;
-    list->trait = trait;
-
-    return list;
-}
-
-void cutil_list_destroy(cutil_list* list) {
-    cutil_allocator* allocator = cutil_current_allocator();
-
-    cutil_list_clear(list);
-    allocator->free(list, allocator->user_data);
-}
-
-void cutil_list_clear(cutil_list* list) {
-    if (list->size > 0) {
-        cutil_list_node* node_to_delete = list->base.next;
-
-        while (node_to_delete != &list->base) {
-            cutil_list_node* next_node = node_to_delete->next;
-            cutil_list_node_destroy(list, node_to_delete);
-            node_to_delete = next_node;
-        }
-
-        list->size = 0;
-        list->base.next = &list->base;
-        list->base.prev = &list->base;
-    }
-}
-
-unsigned int cutil_list_size(cutil_list* list) {
-    return list->size;
-}
-
-cutil_list_node* cutil_list_node_create(cutil_list* list, void* data) {
-    cutil_allocator* allocator = cutil_current_allocator();
-    cutil_list_node* new_node = allocator->malloc(sizeof(cutil_list_node), allocator->user_data);
-    new_node->data = allocator->malloc(list->trait->size, allocator->user_data);
-    
-    if (list->trait->copy_func) {
-        list->trait->copy_func(new_node->data, data, list->trait->user_data);
-    }
-    else {
-        memcpy(new_node->data, data, list->trait->size);
-    }
-
-    new_node->prev = NULL;
-    new_node->next = NULL;
-
-    return new_node;
-}
-
-void cutil_list_node_destroy(cutil_list* list, cutil_list_node* list_node){
-    cutil_allocator* allocator = cutil_current_allocator();
-
-    if (list->trait->destroy_func) {
-        list->trait->destroy_func(list_node->data, list->trait->user_data);
-    }
-    
-    allocator->free(list_node->data, allocator->user_data);
-    allocator->free(list_node, allocator->user_data);
-}
-
-void _cutil_list_push_add_first(cutil_list* list, cutil_list_node* new_node) {
-    new_node->prev = &list->base;
-    new_node->next = &list->base;
-
-    list->base.prev = new_node;
-    list->base.next = new_node;
-}
-
-void cutil_list_push_front(cutil_list* list, void* data) {
-    cutil_list_node* new_node = cutil_list_node_create(list, data);
-
-    cutil_list_node* current_front_node = list->base.next;
-
-    /* at least one item already in list */
-    if (list->size > 0) {
-        new_node->next = current_front_node;
-        new_node->prev = &list->base;
-
-        list->base.next = new_node;
-        current_front_node->prev = new_node;
-    }
-    else { /* first item added to the list */
-        _cutil_list_push_add_first(list, new_node);
-    }
-
-    list->size += 1;
-}
-
-int cutil_list_front(cutil_list* list, void* out) {
-    if (list->size > 0) {
-        memcpy(out, list->base.next->data, list->trait->size);
-        return 1;
-    }
-    else {
-        return 0;
-    }
-}
-
-int cutil_list_back(cutil_list* list, void* out) {
-    if (list->size > 0) {
-        memcpy(out, list->base.prev->data, list->trait->size);
-        return 1;
-    }
-    else {
-        return 0;
-    }
-}
-
-void cutil_list_push_back(cutil_list* list, void* data) {
-    cutil_list_node* new_node = cutil_list_node_create(list, data);
-
-    if (list->size > 0) {
-        cutil_list_node* current_back_node = list->base.prev;
-        new_node->next = &list->base;
-        new_node->prev = current_back_node;
-
-        current_back_node->next = new_node;
-        list->base.prev = new_node;
-    }
-    else {
-        _cutil_list_push_add_first(list, new_node);
-    }
-
-    list->size += 1;
-}
-
-int cutil_list_pop_front(cutil_list* list) {
-    if (list->size > 0) {
-        cutil_list_node* node_to_delete = list->base.next;
-        cutil_list_node* new_front = node_to_delete->next;
-
-        /* additional node in the list, make it the new "first" node */
-        if (new_front != &list->base) {
-            list->base.next = new_front;
-            new_front->prev = &list->base;
-        }
-        else { /* no items left in the list */
-            list->base.next = &list->base;
-            list->base.prev = &list->base;
-        }
-
-        cutil_list_node_destroy(list, node_to_delete);
-        list->size -= 1;
-
-        return 1;
-    }
-    else {
-        return 0;
-    }
-}
-
-int cutil_list_pop_back(cutil_list* list) {
-    if (list->size > 0) {
-        cutil_list_node* node_to_delete = list->base.prev;
-        cutil_list_node* new_back = node_to_delete->prev;
-
-        /* addtional node in the list, bake it the new "back" node */
-        if (new_back != &list->base) {
-            new_back->next = &list->base;
-            list->base.prev = new_back;
-        }
-        else { /* no items left in the list */
-            list->base.next = &list->base;
-            list->base.prev = &list->base;
-        }
-
-        cutil_list_node_destroy(list, node_to_delete);
-        list->size -= 1;
-
-        return 1;
-    }
-    else {
-        return 0;
-    }
-}
-
-cutil_list_itr* cutil_list_itr_create(cutil_list* list) {
-    cutil_allocator* allocator = cutil_current_allocator();
-    cutil_list_itr* itr = allocator->malloc(sizeof(cutil_list_itr), allocator->user_data);
-    
-    itr->list = list;
-    itr->node = &list->base;
-
-    return itr;
-}
-
-void cutil_list_itr_destroy(cutil_list_itr* itr) {
-    cutil_allocator* allocator = cutil_current_allocator();
-    allocator->free(itr, allocator->user_data);
-}
-
-int cutil_list_itr_has_next(cutil_list_itr* itr) {
-    return (itr->node->next->data != NULL);
-}
-
-int cutil_list_itr_next(cutil_list_itr* itr, void* out) {
-    if (cutil_list_itr_has_next(itr)) {
-        itr->node = itr->node->next;
-
-        if (out) {
-            memcpy(out, itr->node->data, itr->list->trait->size);
-        }
-
-        return 1;
-    }
-
-    return 0;
-}
-
-int cutil_list_itr_has_prev(cutil_list_itr* itr) {
-    return (itr->node->prev->data != NULL);
-}
-
-int cutil_list_itr_prev(cutil_list_itr* itr, void* out) {
-    if (cutil_list_itr_has_prev(itr)) {
-        itr->node = itr->node->prev;
-
-        if (out) {
-            memcpy(out, itr->node->data, itr->list->trait->size);
-        }
-
-        return 1;
-    }
-
-    return 0;
-}
+#include "cutil/list.h"
+#include "cutil/allocator.h"
+#include "stream_private.h"
+
+#include <stddef.h>
+#include <string.h>
+
+typedef struct cutil_list_node {
+    void* data;
+    struct cutil_list_node* next;
+    struct cutil_list_node* prev;
+} cutil_list_node;
+
+struct cutil_list {
+    unsigned int size;
+    cutil_list_node base;
+    cutil_trait* trait;
+
+    /* nodes of removed items, linked through next, which are reused along with their data storage */
+    cutil_list_node* node_cache;
+    unsigned int node_cache_size;
+    unsigned int node_cache_capacity;
+    size_t node_cache_hit_count;
+    size_t node_cache_miss_count;
+};
+
+void cutil_list_node_destroy(cutil_list* list, cutil_list_node* list_node);
+cutil_list_node* cutil_list_node_create(cutil_list* list, void* data);
+
+cutil_list* cutil_list_create(cutil_trait* trait) {
+    cutil_allocator* allocator = cutil_current_allocator();
+    cutil_list* list = allocator->malloc(sizeof(cutil_list), allocator->user_data);
+
+    list->size = 0;
+    list->base.prev = &list->base;
+    list->base.next = &list->base;
+    list->base.data = NULL;
+    list->trait = trait;
+
+    list->node_cache = NULL;
+    list->node_cache_size = 0;
+    list->node_cache_capacity = 0;
+    list->node_cache_hit_count = 0;
+    list->node_cache_miss_count = 0;
+
+    return list;
+}
+
+void cutil_list_destroy(cutil_list* list) {
+    cutil_allocator* allocator = cutil_current_allocator();
+
+    cutil_list_clear(list);
+    cutil_list_set_node_cache_capacity(list, 0);
+    allocator->free(list, allocator->user_data);
+}
+
+void cutil_list_clear(cutil_list* list) {
+    if (list->size > 0) {
+        cutil_list_node* node_to_delete = list->base.next;
+
+        while (node_to_delete != &list->base) {
+            cutil_list_node* next_node = node_to_delete->next;
+            cutil_list_node_destroy(list, node_to_delete);
+            node_to_delete = next_node;
+        }
+
+        list->size = 0;
+        list->base.next = &list->base;
+        list->base.prev = &list->base;
+    }
+}
+
+unsigned int cutil_list_size(cutil_list* list) {
+    return list->size;
+}
+
+cutil_list_node* cutil_list_node_create(cutil_list* list, void* data) {
+    cutil_allocator* allocator = cutil_current_allocator();
+    cutil_list_node* new_node = list->node_cache;
+
+    if (new_node) {
+        list->node_cache = new_node->next;
+        list->node_cache_size -= 1;
+        list->node_cache_hit_count += 1;
+    }
+    else {
+        new_node = allocator->malloc(sizeof(cutil_list_node), allocator->user_data);
+        new_node->data = allocator->malloc(list->trait->size, allocator->user_data);
+        list->node_cache_miss_count += 1;
+    }
+
+    if (list->trait->copy_func) {
+        list->trait->copy_func(new_node->data, data, list->trait->user_data);
+    }
+    else {
+        memcpy(new_node->data, data, list->trait->size);
+    }
+
+    new_node->prev = NULL;
+    new_node->next = NULL;
+
+    return new_node;
+}
+
+void cutil_list_node_destroy(cutil_list* list, cutil_list_node* list_node){
+    cutil_allocator* allocator = cutil_current_allocator();
+
+    if (list->trait->destroy_func) {
+        list->trait->destroy_func(list_node->data, list->trait->user_data);
+    }
+
+    if (list->node_cache_size < list->node_cache_capacity) {
+        list_node->next = list->node_cache;
+        list->node_cache = list_node;
+        list->node_cache_size += 1;
+        return;
+    }
+    
+    allocator->free(list_node->data, allocator->user_data);
+    allocator->free(list_node, allocator->user_data);
+}
+
+void cutil_list_set_node_cache_capacity(cutil_list* list, unsigned int capacity) {
+    cutil_allocator* allocator = cutil_current_allocator();
+
+    list->node_cache_capacity = capacity;
+
+    while (list->node_cache_size > capacity) {
+        cutil_list_node* node = list->node_cache;
+
+        list->node_cache = node->next;
+        list->node_cache_size -= 1;
+
+        allocator->free(node->data, allocator->user_data);
+        allocator->free(node, allocator->user_data);
+    }
+}
+
+unsigned int cutil_list_get_node_cache_capacity(cutil_list* list) {
+    return list->node_cache_capacity;
+}
+
+unsigned int cutil_list_node_cache_size(cutil_list* list) {
+    return list->node_cache_size;
+}
+
+size_t cutil_list_node_cache_hit_count(cutil_list* list) {
+    return list->node_cache_hit_count;
+}
+
+size_t cutil_list_node_cache_miss_count(cutil_list* list) {
+    return list->node_cache_miss_count;
+}
+
+void cutil_list_reset_node_cache_counters(cutil_list* list) {
+    list->node_cache_hit_count = 0;
+    list->node_cache_miss_count = 0;
+}
+
+void _cutil_list_push_add_first(cutil_list* list, cutil_list_node* new_node) {
+    new_node->prev = &list->base;
+    new_node->next = &list->base;
+
+    list->base.prev = new_node;
+    list->base.next = new_node;
+}
+
+void cutil_list_push_front(cutil_list* list, void* data) {
+    cutil_list_node* new_node = cutil_list_node_create(list, data);
+
+    cutil_list_node* current_front_node = list->base.next;
+
+    /* at least one item already in list */
+    if (list->size > 0) {
+        new_node->next = current_front_node;
+        new_node->prev = &list->base;
+
+        list->base.next = new_node;
+        current_front_node->prev = new_node;
+    }
+    else { /* first item added to the list */
+        _cutil_list_push_add_first(list, new_node);
+    }
+
+    list->size += 1;
+}
+
+int cutil_list_front(cutil_list* list, void* out) {
+    if (list->size > 0) {
+        memcpy(out, list->base.next->data, list->trait->size);
+        return 1;
+    }
+    else {
+        return 0;
+    }
+}
+
+int cutil_list_back(cutil_list* list, void* out) {
+    if (list->size > 0) {
+        memcpy(out, list->base.prev->data, list->trait->size);
+        return 1;
+    }
+    else {
+        return 0;
+    }
+}
+
+void cutil_list_push_back(cutil_list* list, void* data) {
+    cutil_list_node* new_node = cutil_list_node_create(list, data);
+
+    if (list->size > 0) {
+        cutil_list_node* current_back_node = list->base.prev;
+        new_node->next = &list->base;
+        new_node->prev = current_back_node;
+
+        current_back_node->next = new_node;
+        list->base.prev = new_node;
+    }
+    else {
+        _cutil_list_push_add_first(list, new_node);
+    }
+
+    list->size += 1;
+}
+
+size_t cutil_list_foreach(cutil_list* list, cutil_list_foreach_func callback, void* user_data) {
+    cutil_list_node* node = list->base.next;
+    size_t count = 0;
+
+    while (node != &list->base) {
+        count += 1;
+
+        if (!callback(node->data, user_data)) {
+            break;
+        }
+
+        node = node->next;
+    }
+
+    return count;
+}
+
+int cutil_list_pop_front(cutil_list* list) {
+    if (list->size > 0) {
+        cutil_list_node* node_to_delete = list->base.next;
+        cutil_list_node* new_front = node_to_delete->next;
+
+        /* additional node in the list, make it the new "first" node */
+        if (new_front != &list->base) {
+            list->base.next = new_front;
+            new_front->prev = &list->base;
+        }
+        else { /* no items left in the list */
+            list->base.next = &list->base;
+            list->base.prev = &list->base;
+        }
+
+        cutil_list_node_destroy(list, node_to_delete);
+        list->size -= 1;
+
+        return 1;
+    }
+    else {
+        return 0;
+    }
+}
+
+int cutil_list_pop_back(cutil_list* list) {
+    if (list->size > 0) {
+        cutil_list_node* node_to_delete = list->base.prev;
+        cutil_list_node* new_back = node_to_delete->prev;
+
+        /* addtional node in the list, bake it the new "back" node */
+        if (new_back != &list->base) {
+            new_back->next = &list->base;
+            list->base.prev = new_back;
+        }
+        else { /* no items left in the list */
+            list->base.next = &list->base;
+            list->base.prev = &list->base;
+        }
+
+        cutil_list_node_destroy(list, node_to_delete);
+        list->size -= 1;
+
+        return 1;
+    }
+    else {
+        return 0;
+    }
+}
+
+int cutil_list_write(cutil_list* list, cutil_writer* writer) {
+    cutil_list_node* node = list->base.next;
+
+    if (!_stream_trait_writable(list->trait) || !_stream_write_header(writer, list->trait, list->size)) {
+        return 0;
+    }
+
+    while (node != &list->base) {
+        if (!_stream_write_item(writer, list->trait, node->data)) {
+            return 0;
+        }
+
+        node = node->next;
+    }
+
+    return cutil_writer_flush(writer);
+}
+
+/* Items are read directly into the storage of new nodes which are appended to the back of the list */
+int _cutil_list_read_items(cutil_list* list, cutil_reader* reader) {
+    cutil_allocator* allocator = cutil_current_allocator();
+    cutil_list_node* new_node;
+    size_t count;
+
+    if (!_stream_trait_readable(list->trait) || !_stream_read_header(reader, list->trait, &count)) {
+        return 0;
+    }
+
+    while (count > 0) {
+        new_node = allocator->malloc(sizeof(cutil_list_node), allocator->user_data);
+        new_node->data = allocator->malloc(list->trait->size, allocator->user_data);
+
+        if (!_stream_read_item(reader, list->trait, new_node->data)) {
+            allocator->free(new_node->data, allocator->user_data);
+            allocator->free(new_node, allocator->user_data);
+            return 0;
+        }
+
+        new_node->next = &list->base;
+        new_node->prev = list->base.prev;
+        list->base.prev->next = new_node;
+        list->base.prev = new_node;
+
+        list->size += 1;
+        count -= 1;
+    }
+
+    return 1;
+}
+
+cutil_list* cutil_list_read(cutil_reader* reader, cutil_trait* trait) {
+    cutil_list* list = cutil_list_create(trait);
+
+    if (!_cutil_list_read_items(list, reader)) {
+        cutil_list_destroy(list);
+        return NULL;
+    }
+
+    return list;
+}
+
+cutil_list_itr* cutil_list_itr_create(cutil_list* list) {
+    cutil_allocator* allocator = cutil_current_allocator();
+    cutil_list_itr* itr = allocator->malloc(sizeof(cutil_list_itr), allocator->user_data);
+
+    cutil_list_itr_init(itr, list);
+
+    return itr;
+}
+
+void cutil_list_itr_init(cutil_list_itr* itr, cutil_list* list) {
+    itr->list = list;
+    itr->node = &list->base;
+}
+
+void cutil_list_itr_destroy(cutil_list_itr* itr) {
+    cutil_allocator* allocator = cutil_current_allocator();
+    allocator->free(itr, allocator->user_data);
+}
+
+/* Links a node into a list in front of the supplied position, which may be the list's base node. */
+void _cutil_list_link_before(cutil_list_node* position, cutil_list_node* node) {
+    node->prev = position->prev;
+    node->next = position;
+
+    position->prev->next = node;
+    position->prev = node;
+}
+
+void _cutil_list_unlink(cutil_list_node* node) {
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+}
+
+void cutil_list_insert_before(cutil_list_itr* itr, void* data) {
+    cutil_list_node* new_node = cutil_list_node_create(itr->list, data);
+
+    _cutil_list_link_before(itr->node, new_node);
+    itr->list->size += 1;
+}
+
+int cutil_list_erase(cutil_list_itr* itr) {
+    cutil_list_node* node_to_delete = itr->node;
+
+    if (node_to_delete == &itr->list->base) {
+        return 0;
+    }
+
+    itr->node = node_to_delete->prev;
+    _cutil_list_unlink(node_to_delete);
+
+    cutil_list_node_destroy(itr->list, node_to_delete);
+    itr->list->size -= 1;
+
+    return 1;
+}
+
+int cutil_list_splice(cutil_list_itr* dst_itr, cutil_list* src_list, cutil_list_itr* src_itr) {
+    cutil_list_node* node = src_itr->node;
+
+    if (src_itr->list != src_list || node == &src_list->base || dst_itr->list->trait != src_list->trait) {
+        return 0;
+    }
+
+    src_itr->node = node->prev;
+
+    /* the node is already in front of the destination */
+    if (node == dst_itr->node || node->next == dst_itr->node) {
+        return 1;
+    }
+
+    _cutil_list_unlink(node);
+    src_list->size -= 1;
+
+    _cutil_list_link_before(dst_itr->node, node);
+    dst_itr->list->size += 1;
+
+    return 1;
+}
+
+int cutil_list_itr_has_next(cutil_list_itr* itr) {
+    return (itr->node->next->data != NULL);
+}
+
+int cutil_list_itr_next(cutil_list_itr* itr, void* out) {
+    if (cutil_list_itr_has_next(itr)) {
+        itr->node = itr->node->next;
+
+        if (out) {
+            memcpy(out, itr->node->data, itr->list->trait->size);
+        }
+
+        return 1;
+    }
+
+    return 0;
+}
+
+int cutil_list_itr_has_prev(cutil_list_itr* itr) {
+    return (itr->node->prev->data != NULL);
+}
+
+int cutil_list_itr_prev(cutil_list_itr* itr, void* out) {
+    if (cutil_list_itr_has_prev(itr)) {
+        itr->node = itr->node->prev;
+
+        if (out) {
+            memcpy(out, itr->node->data, itr->list->trait->size);
+        }
+
+        return 1;
+    }
+
+    return 0;
+}
+
+/*
+Merges two chains of nodes linked through next and terminated by NULL, each sorted by the trait's comparison function.
+Items from the first chain are placed before equal items from the second, which keeps the sort stable.
+*/
+cutil_list_node* _cutil_list_merge_chains(cutil_trait* trait, cutil_list_node* a, cutil_list_node* b) {
+    cutil_list_node head;
+    cutil_list_node* tail = &head;
+
+    while (a && b) {
+        if (trait->compare_func(b->data, a->data, trait->user_data) < 0) {
+            tail->next = b;
+            b = b->next;
+        }
+        else {
+            tail->next = a;
+            a = a->next;
+        }
+
+        tail = tail->next;
+    }
+
+    tail->next = a ? a : b;
+
+    return head.next;
+}
+
+/* Links a chain of nodes terminated by NULL into the list in place of its current items and restores the prev links. */
+void _cutil_list_relink_chain(cutil_list* list, cutil_list_node* chain) {
+    cutil_list_node* prev = &list->base;
+
+    while (chain) {
+        prev->next = chain;
+        chain->prev = prev;
+
+        prev = chain;
+        chain = chain->next;
+    }
+
+    prev->next = &list->base;
+    list->base.prev = prev;
+}
+
+/*
+Sorts the list bottom up, in the same manner as a binary counter.
+Each slot holds either nothing or a sorted run of 2^i nodes which came before every node that has not been placed yet.
+Nodes are taken from the front of the list one at a time and merged with the occupied slots beginning at the lowest, until an empty slot is reached.
+*/
+int cutil_list_sort(cutil_list* list) {
+    cutil_list_node* runs[sizeof(size_t) * 8];
+    cutil_list_node* node;
+    cutil_list_node* run;
+    size_t run_count = 0;
+    size_t i;
+
+    if (list->trait->compare_func == NULL) {
+        return 0;
+    }
+
+    if (list->size < 2) {
+        return 1;
+    }
+
+    node = list->base.next;
+    list->base.prev->next = NULL;
+
+    while (node) {
+        run = node;
+        node = node->next;
+        run->next = NULL;
+
+        for (i = 0; i < run_count && runs[i]; i++) {
+            run = _cutil_list_merge_chains(list->trait, runs[i], run);
+            runs[i] = NULL;
+        }
+
+        if (i == run_count) {
+            run_count += 1;
+        }
+
+        runs[i] = run;
+    }
+
+    run = NULL;
+
+    for (i = 0; i < run_count; i++) {
+        if (runs[i]) {
+            run = _cutil_list_merge_chains(list->trait, runs[i], run);
+        }
+    }
+
+    _cutil_list_relink_chain(list, run);
+
+    return 1;
+}
+
+int cutil_list_merge(cutil_list* list, cutil_list* other) {
+    cutil_list_node* chain;
+
+    if (list->trait != other->trait || list->trait->compare_func == NULL) {
+        return 0;
+    }
+
+    if (list == other || other->size == 0) {
+        return 1;
+    }
+
+    if (list->size > 0) {
+        list->base.prev->next = NULL;
+        other->base.prev->next = NULL;
+        chain = _cutil_list_merge_chains(list->trait, list->base.next, other->base.next);
+    }
+    else {
+        other->base.prev->next = NULL;
+        chain = other->base.next;
+    }
+
+    _cutil_list_relink_chain(list, chain);
+    list->size += other->size;
+
+    other->size = 0;
+    other->base.next = &other->base;
+    other->base.prev = &other->base;
+
+    return 1;
+}
@@ -0,0 +1,407 @@
+#include "cutil/lru_cache.h"
+#include "cutil/allocator.h"
+#include "trait_private.h"
+
+#include <string.h>
+
+#define LRU_CACHE_ALIGNMENT 16
+#define LRU_CACHE_MIN_BUCKET_COUNT 16
+#define LRU_CACHE_MAX_INITIAL_BUCKET_COUNT 4096
+
+/*
+Each entry is a single allocation holding this header followed by the key and value.
+Entries are linked into a circular recency list around the cache's base entry, with the most recently used entry following the base.
+Entries with the same bucket are chained through hash_next.  Entries which are not in use are chained through next on the cache's free list.
+*/
+typedef struct _lru_cache_entry {
+    struct _lru_cache_entry* prev;
+    struct _lru_cache_entry* next;
+    struct _lru_cache_entry* hash_next;
+    size_t hash;
+    size_t byte_size;
+} _lru_cache_entry;
+
+struct cutil_lru_cache {
+    _lru_cache_entry base;
+    _lru_cache_entry** buckets;
+    size_t bucket_count;
+    _lru_cache_entry* free_entries;
+
+    cutil_trait* key_trait;
+    cutil_trait* value_trait;
+    size_t key_offset;
+    size_t value_offset;
+    size_t entry_size;
+
+    size_t size;
+    size_t byte_size;
+    size_t max_count;
+    size_t max_bytes;
+    cutil_lru_cache_size_func size_func;
+    void* size_user_data;
+
+    size_t hit_count;
+    size_t miss_count;
+    size_t eviction_count;
+};
+
+size_t _lru_cache_align(size_t size) {
+    return (size + LRU_CACHE_ALIGNMENT - 1) / LRU_CACHE_ALIGNMENT * LRU_CACHE_ALIGNMENT;
+}
+
+void* _lru_cache_entry_key(cutil_lru_cache* cache, _lru_cache_entry* entry) {
+    return (char*)entry + cache->key_offset;
+}
+
+void* _lru_cache_entry_value(cutil_lru_cache* cache, _lru_cache_entry* entry) {
+    return (char*)entry + cache->value_offset;
+}
+
+/* Mixes the bits of a hash so that hash functions which only vary in their upper bits still spread over the buckets. */
+size_t _lru_cache_bucket_index(cutil_lru_cache* cache, size_t hash) {
+    unsigned long mixed = (unsigned long)(hash ^ (hash >> 16)) & 0xFFFFFFFFUL;
+
+    mixed = (mixed * 0x45D9F3BUL) & 0xFFFFFFFFUL;
+    mixed ^= mixed >> 16;
+
+    return (size_t)mixed & (cache->bucket_count - 1);
+}
+
+void _lru_cache_copy_with_trait(void* dest, void* src, cutil_trait* trait) {
+    if (trait->copy_func) {
+        trait->copy_func(dest, src, trait->user_data);
+    }
+    else {
+        memcpy(dest, src, trait->size);
+    }
+}
+
+void _lru_cache_destroy_with_trait(void* item, cutil_trait* trait) {
+    if (trait->destroy_func) {
+        trait->destroy_func(item, trait->user_data);
+    }
+}
+
+int _lru_cache_keys_equal(cutil_lru_cache* cache, void* a, void* b) {
+    cutil_trait* key_trait = cache->key_trait;
+
+    if (key_trait->compare_func) {
+        return key_trait->compare_func(a, b, key_trait->user_data) == 0;
+    }
+
+    return memcmp(a, b, key_trait->size) == 0;
+}
+
+size_t _lru_cache_item_byte_size(cutil_lru_cache* cache, void* key, void* value) {
+    if (cache->size_func) {
+        return cache->size_func(key, value, cache->size_user_data);
+    }
+
+    return cache->key_trait->size + cache->value_trait->size;
+}
+
+void _lru_cache_link_front(cutil_lru_cache* cache, _lru_cache_entry* entry) {
+    entry->prev = &cache->base;
+    entry->next = cache->base.next;
+
+    cache->base.next->prev = entry;
+    cache->base.next = entry;
+}
+
+void _lru_cache_unlink(_lru_cache_entry* entry) {
+    entry->prev->next = entry->next;
+    entry->next->prev = entry->prev;
+}
+
+_lru_cache_entry* _lru_cache_find(cutil_lru_cache* cache, void* key, size_t hash) {
+    _lru_cache_entry* entry = cache->buckets[_lru_cache_bucket_index(cache, hash)];
+
+    while (entry) {
+        if (entry->hash == hash && _lru_cache_keys_equal(cache, _lru_cache_entry_key(cache, entry), key)) {
+            return entry;
+        }
+
+        entry = entry->hash_next;
+    }
+
+    return NULL;
+}
+
+void _lru_cache_remove_from_bucket(cutil_lru_cache* cache, _lru_cache_entry* entry) {
+    _lru_cache_entry** link = &cache->buckets[_lru_cache_bucket_index(cache, entry->hash)];
+
+    while (*link != entry) {
+        link = &(*link)->hash_next;
+    }
+
+    *link = entry->hash_next;
+}
+
+/* Removes an entry from the cache, destroys its item and places it on the free list. */
+void _lru_cache_release_entry(cutil_lru_cache* cache, _lru_cache_entry* entry) {
+    _lru_cache_unlink(entry);
+    _lru_cache_remove_from_bucket(cache, entry);
+
+    _lru_cache_destroy_with_trait(_lru_cache_entry_key(cache, entry), cache->key_trait);
+    _lru_cache_destroy_with_trait(_lru_cache_entry_value(cache, entry), cache->value_trait);
+
+    cache->size -= 1;
+    cache->byte_size -= entry->byte_size;
+
+    entry->next = cache->free_entries;
+    cache->free_entries = entry;
+}
+
+/* Evicts least recently used entries other than the supplied entry until an item of the given size fits in the cache. */
+void _lru_cache_evict(cutil_lru_cache* cache, _lru_cache_entry* keep, size_t count, size_t byte_size) {
+    _lru_cache_entry* entry = cache->base.prev;
+
+    while (entry != &cache->base && (cache->size + count > cache->max_count || cache->byte_size + byte_size > cache->max_bytes)) {
+        _lru_cache_entry* prev = entry->prev;
+
+        if (entry != keep) {
+            _lru_cache_release_entry(cache, entry);
+            cache->eviction_count += 1;
+        }
+
+        entry = prev;
+    }
+}
+
+/* Doubles the number of buckets and redistributes the entries.  If the buckets cannot be allocated the cache keeps its current buckets. */
+void _lru_cache_grow_buckets(cutil_lru_cache* cache) {
+    cutil_allocator* allocator = cutil_current_allocator();
+    _lru_cache_entry** old_buckets = cache->buckets;
+    size_t old_bucket_count = cache->bucket_count;
+    _lru_cache_entry** buckets = allocator->calloc(old_bucket_count * 2, sizeof(_lru_cache_entry*), allocator->user_data);
+    size_t i;
+
+    if (buckets == NULL) {
+        return;
+    }
+
+    cache->buckets = buckets;
+    cache->bucket_count = old_bucket_count * 2;
+
+    for (i = 0; i < old_bucket_count; i++) {
+        _lru_cache_entry* entry = old_buckets[i];
+
+        while (entry) {
+            _lru_cache_entry* next = entry->hash_next;
+            size_t index = _lru_cache_bucket_index(cache, entry->hash);
+
+            entry->hash_next = buckets[index];
+            buckets[index] = entry;
+            entry = next;
+        }
+    }
+
+    allocator->free(old_buckets, allocator->user_data);
+}
+
+cutil_lru_cache* _lru_cache_create(cutil_trait* key_trait, cutil_trait* value_trait, size_t max_count, size_t max_bytes, cutil_lru_cache_size_func size_func, void* user_data) {
+    cutil_allocator* allocator = cutil_current_allocator();
+    cutil_lru_cache* cache;
+    size_t bucket_count = LRU_CACHE_MIN_BUCKET_COUNT;
+
+    if (key_trait == NULL || value_trait == NULL || !_trait_hashable(key_trait) || max_count == 0 || max_bytes == 0) {
+        return NULL;
+    }
+
+    /* small caches limited by count never need to grow their buckets */
+    while (bucket_count < max_count && bucket_count < LRU_CACHE_MAX_INITIAL_BUCKET_COUNT) {
+        bucket_count *= 2;
+    }
+
+    cache = allocator->malloc(sizeof(cutil_lru_cache), allocator->user_data);
+    cache->buckets = allocator->calloc(bucket_count, sizeof(_lru_cache_entry*), allocator->user_data);
+
+    if (cache->buckets == NULL) {
+        allocator->free(cache, allocator->user_data);
+        return NULL;
+    }
+
+    cache->base.prev = &cache->base;
+    cache->base.next = &cache->base;
+    cache->base.hash_next = NULL;
+    cache->bucket_count = bucket_count;
+    cache->free_entries = NULL;
+
+    cache->key_trait = key_trait;
+    cache->value_trait = value_trait;
+    cache->key_offset = _lru_cache_align(sizeof(_lru_cache_entry));
+    cache->value_offset = _lru_cache_align(cache->key_offset + key_trait->size);
+    cache->entry_size = cache->value_offset + value_trait->size;
+
+    cache->size = 0;
+    cache->byte_size = 0;
+    cache->max_count = max_count;
+    cache->max_bytes = max_bytes;
+    cache->size_func = size_func;
+    cache->size_user_data = user_data;
+
+    cache->hit_count = 0;
+    cache->miss_count = 0;
+    cache->eviction_count = 0;
+
+    return cache;
+}
+
+cutil_lru_cache* cutil_lru_cache_create(cutil_trait* key_trait, cutil_trait* value_trait, size_t max_count) {
+    return _lru_cache_create(key_trait, value_trait, max_count, (size_t)-1, NULL, NULL);
+}
+
+cutil_lru_cache* cutil_lru_cache_create_with_byte_limit(cutil_trait* key_trait, cutil_trait* value_trait, size_t max_bytes, cutil_lru_cache_size_func size_func, void* user_data) {
+    return _lru_cache_create(key_trait, value_trait, (size_t)-1, max_bytes, size_func, user_data);
+}
+
+void _lru_cache_free_entries(cutil_lru_cache* cache) {
+    cutil_allocator* allocator = cutil_current_allocator();
+
+    while (cache->free_entries) {
+        _lru_cache_entry* next = cache->free_entries->next;
+
+        allocator->free(cache->free_entries, allocator->user_data);
+        cache->free_entries = next;
+    }
+}
+
+void cutil_lru_cache_destroy(cutil_lru_cache* cache) {
+    cutil_allocator* allocator = cutil_current_allocator();
+
+    cutil_lru_cache_clear(cache);
+
+    allocator->free(cache->buckets, allocator->user_data);
+    allocator->free(cache, allocator->user_data);
+}
+
+size_t cutil_lru_cache_size(cutil_lru_cache* cache) {
+    return cache->size;
+}
+
+size_t cutil_lru_cache_byte_size(cutil_lru_cache* cache) {
+    return cache->byte_size;
+}
+
+void cutil_lru_cache_clear(cutil_lru_cache* cache) {
+    while (cache->base.next != &cache->base) {
+        _lru_cache_release_entry(cache, cache->base.next);
+    }
+
+    _lru_cache_free_entries(cache);
+}
+
+int cutil_lru_cache_put(cutil_lru_cache* cache, void* key, void* value) {
+    cutil_allocator* allocator = cutil_current_allocator();
+    size_t hash = _trait_hash_item(cache->key_trait, key);
+    size_t byte_size = _lru_cache_item_byte_size(cache, key, value);
+    _lru_cache_entry* entry = _lru_cache_find(cache, key, hash);
+    size_t index;
+
+    if (byte_size > cache->max_bytes) {
+        return 0;
+    }
+
+    if (entry) {
+        void* entry_value = _lru_cache_entry_value(cache, entry);
+
+        _lru_cache_destroy_with_trait(entry_value, cache->value_trait);
+        _lru_cache_copy_with_trait(entry_value, value, cache->value_trait);
+
+        cache->byte_size = cache->byte_size - entry->byte_size + byte_size;
+        entry->byte_size = byte_size;
+
+        _lru_cache_unlink(entry);
+        _lru_cache_link_front(cache, entry);
+        _lru_cache_evict(cache, entry, 0, 0);
+
+        return 1;
+    }
+
+    _lru_cache_evict(cache, NULL, 1, byte_size);
+
+    if (cache->free_entries) {
+        entry = cache->free_entries;
+        cache->free_entries = entry->next;
+    }
+    else {
+        entry = allocator->malloc(cache->entry_size, allocator->user_data);
+
+        if (entry == NULL) {
+            return 0;
+        }
+    }
+
+    _lru_cache_copy_with_trait(_lru_cache_entry_key(cache, entry), key, cache->key_trait);
+    _lru_cache_copy_with_trait(_lru_cache_entry_value(cache, entry), value, cache->value_trait);
+    entry->hash = hash;
+    entry->byte_size = byte_size;
+
+    if (cache->size >= cache->bucket_count) {
+        _lru_cache_grow_buckets(cache);
+    }
+
+    index = _lru_cache_bucket_index(cache, hash);
+    entry->hash_next = cache->buckets[index];
+    cache->buckets[index] = entry;
+
+    _lru_cache_link_front(cache, entry);
+    cache->size += 1;
+    cache->byte_size += byte_size;
+
+    return 1;
+}
+
+int cutil_lru_cache_get(cutil_lru_cache* cache, void* key, void* out) {
+    _lru_cache_entry* entry = _lru_cache_find(cache, key, _trait_hash_item(cache->key_trait, key));
+
+    if (entry == NULL) {
+        cache->miss_count += 1;
+        return 0;
+    }
+
+    cache->hit_count += 1;
+
+    if (cache->base.next != entry) {
+        _lru_cache_unlink(entry);
+        _lru_cache_link_front(cache, entry);
+    }
+
+    memcpy(out, _lru_cache_entry_value(cache, entry), cache->value_trait->size);
+
+    return 1;
+}
+
+int cutil_lru_cache_contains(cutil_lru_cache* cache, void* key) {
+    return _lru_cache_find(cache, key, _trait_hash_item(cache->key_trait, key)) != NULL;
+}
+
+int cutil_lru_cache_erase(cutil_lru_cache* cache, void* key) {
+    _lru_cache_entry* entry = _lru_cache_find(cache, key, _trait_hash_item(cache->key_trait, key));
+
+    if (entry == NULL) {
+        return 0;
+    }
+
+    _lru_cache_release_entry(cache, entry);
+
+    return 1;
+}
+
+size_t cutil_lru_cache_hit_count(cutil_lru_cache* cache) {
+    return cache->hit_count;
+}
+
+size_t cutil_lru_cache_miss_count(cutil_lru_cache* cache) {
+    return cache->miss_count;
+}
+
+size_t cutil_lru_cache_eviction_count(cutil_lru_cache* cache) {
+    return cache->eviction_count;
+}
+
+void cutil_lru_cache_reset_counters(cutil_lru_cache* cache) {
+    cache->hit_count = 0;
+    cache->miss_count = 0;
+    cache->eviction_count = 0;
+}
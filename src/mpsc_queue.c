@@ -0,0 +1,102 @@
+#include "cutil/mpsc_queue.h"
+#include "cutil/allocator.h"
+#include "atomic_private.h"
+
+#define MPSC_QUEUE_CACHE_LINE_SIZE 64
+
+/*
+Nodes form a singly linked list from the tail, which the consumer pops from, to the head, which producers push to.
+A producer claims its place by exchanging the head for its node and then links the previous head to it.  Between these steps the list is broken, and the consumer waits for the link rather than skipping over it.
+The stub node keeps the list from becoming empty, so the consumer never has to update the head.  It is pushed again whenever the consumer needs to pop the last node.
+The head is written by every producer, so it is kept on a separate cache line from the consumer's tail.
+*/
+struct cutil_mpsc_queue {
+    cutil_mpsc_queue_node* head;
+    char head_padding[MPSC_QUEUE_CACHE_LINE_SIZE - sizeof(cutil_mpsc_queue_node*)];
+    cutil_mpsc_queue_node* tail;
+    cutil_mpsc_queue_node stub;
+};
+
+cutil_mpsc_queue* cutil_mpsc_queue_create() {
+    cutil_allocator* allocator = cutil_current_allocator();
+    cutil_mpsc_queue* queue = allocator->malloc(sizeof(cutil_mpsc_queue), allocator->user_data);
+
+    queue->stub.data = NULL;
+    queue->stub.next = NULL;
+    queue->head = &queue->stub;
+    queue->tail = &queue->stub;
+
+    return queue;
+}
+
+void cutil_mpsc_queue_destroy(cutil_mpsc_queue* queue) {
+    cutil_allocator* allocator = cutil_current_allocator();
+    allocator->free(queue, allocator->user_data);
+}
+
+void cutil_mpsc_queue_push(cutil_mpsc_queue* queue, cutil_mpsc_queue_node* node) {
+    cutil_mpsc_queue_node* previous;
+
+    node->next = NULL;
+    previous = atomic_ptr_exchange_func(&queue->head, node);
+    atomic_ptr_store_func(&previous->next, node);
+}
+
+cutil_mpsc_queue_node* cutil_mpsc_queue_pop(cutil_mpsc_queue* queue) {
+    cutil_mpsc_queue_node* tail = queue->tail;
+    cutil_mpsc_queue_node* next = atomic_ptr_load_func(&tail->next);
+
+    /* skip over the stub, which only needs to remain in the list while it is the last node */
+    if (tail == &queue->stub) {
+        if (next == NULL) {
+            return NULL;
+        }
+
+        queue->tail = next;
+        tail = next;
+        next = atomic_ptr_load_func(&tail->next);
+    }
+
+    if (next) {
+        queue->tail = next;
+        return tail;
+    }
+
+    /* a producer has claimed the head but not yet linked it to the tail */
+    if (tail != atomic_ptr_load_func(&queue->head)) {
+        return NULL;
+    }
+
+    /* the tail is the last node, pushing the stub behind it allows it to be popped */
+    cutil_mpsc_queue_push(queue, &queue->stub);
+    next = atomic_ptr_load_func(&tail->next);
+
+    if (next) {
+        queue->tail = next;
+        return tail;
+    }
+
+    return NULL;
+}
+
+size_t cutil_mpsc_queue_pop_batch(cutil_mpsc_queue* queue, cutil_mpsc_queue_node** nodes, size_t max_count) {
+    size_t count = 0;
+
+    while (count < max_count) {
+        cutil_mpsc_queue_node* node = cutil_mpsc_queue_pop(queue);
+
+        if (node == NULL) {
+            break;
+        }
+
+        nodes[count++] = node;
+    }
+
+    return count;
+}
+
+int cutil_mpsc_queue_empty(cutil_mpsc_queue* queue) {
+    cutil_mpsc_queue_node* tail = queue->tail;
+
+    return tail == &queue->stub && atomic_ptr_load_func(&tail->next) == NULL && atomic_ptr_load_func(&queue->head) == &queue->stub;
+}
@@ -0,0 +1,292 @@
+#include "cutil/ring.h"
+#include "cutil/allocator.h"
+#include "atomic_private.h"
+
+#include <string.h>
+
+#define RING_CACHE_LINE_SIZE 64
+#define RING_MIN_CAPACITY 2
+
+/*
+Positions increase without wrapping around the capacity, the slot for a position is found by masking it.
+The producer owns the tail and the consumer owns the head.  Each also keeps its last reading of the other's position, which only needs to be read again once the ring appears full or empty.
+Padding keeps the read only configuration, the producer fields and the consumer fields on separate cache lines.
+
+In mpmc rings each slot begins with a sequence number.  A slot at position p holds p while it is waiting to be written, p + 1 once it has been written, and p + capacity once it has been read, which is the value the next writer of the slot waits for.
+A thread claims a run of slots by checking their sequence numbers and then advancing the shared position with a compare exchange.  The head and tail are then shared between threads, so the cached positions are unused.
+*/
+struct cutil_ring {
+    cutil_trait* trait;
+    char* slots;
+    size_t capacity;
+    size_t mask;
+    size_t slot_size;
+    size_t item_offset;
+    int mpmc;
+    char config_padding[RING_CACHE_LINE_SIZE];
+
+    size_t tail;
+    size_t cached_head;
+    char producer_padding[RING_CACHE_LINE_SIZE];
+
+    size_t head;
+    size_t cached_tail;
+    char consumer_padding[RING_CACHE_LINE_SIZE];
+};
+
+size_t _ring_round_up(size_t size, size_t multiple) {
+    return (size + multiple - 1) / multiple * multiple;
+}
+
+size_t* _ring_slot_sequence(cutil_ring* ring, size_t position) {
+    return (size_t*)(ring->slots + (position & ring->mask) * ring->slot_size);
+}
+
+void* _ring_slot_item(cutil_ring* ring, size_t position) {
+    return ring->slots + (position & ring->mask) * ring->slot_size + ring->item_offset;
+}
+
+void _ring_copy_in(cutil_ring* ring, size_t position, void* data) {
+    void* item = _ring_slot_item(ring, position);
+
+    if (ring->trait->copy_func) {
+        ring->trait->copy_func(item, data, ring->trait->user_data);
+    }
+    else {
+        memcpy(item, data, ring->trait->size);
+    }
+}
+
+cutil_ring* _ring_create(cutil_trait* trait, size_t capacity, int mpmc) {
+    cutil_allocator* allocator = cutil_current_allocator();
+    cutil_ring* ring;
+    size_t rounded_capacity = RING_MIN_CAPACITY;
+    size_t item_offset, slot_size;
+    size_t i;
+
+    if (trait == NULL || trait->size == 0 || capacity == 0) {
+        return NULL;
+    }
+
+    while (rounded_capacity < capacity) {
+        if (rounded_capacity > ((size_t)-1 >> 1)) {
+            return NULL;
+        }
+
+        rounded_capacity <<= 1;
+    }
+
+    item_offset = mpmc ? sizeof(size_t) : 0;
+    slot_size = mpmc ? _ring_round_up(item_offset + trait->size, sizeof(size_t)) : trait->size;
+
+    if (rounded_capacity > (size_t)-1 / slot_size) {
+        return NULL;
+    }
+
+    ring = allocator->malloc(sizeof(cutil_ring), allocator->user_data);
+    ring->slots = allocator->malloc(rounded_capacity * slot_size, allocator->user_data);
+
+    ring->trait = trait;
+    ring->capacity = rounded_capacity;
+    ring->mask = rounded_capacity - 1;
+    ring->slot_size = slot_size;
+    ring->item_offset = item_offset;
+    ring->mpmc = mpmc;
+
+    ring->tail = 0;
+    ring->cached_head = 0;
+    ring->head = 0;
+    ring->cached_tail = 0;
+
+    if (mpmc) {
+        for (i = 0; i < rounded_capacity; i++) {
+            *_ring_slot_sequence(ring, i) = i;
+        }
+    }
+
+    return ring;
+}
+
+cutil_ring* cutil_ring_create(cutil_trait* trait, size_t capacity) {
+    return _ring_create(trait, capacity, 0);
+}
+
+cutil_ring* cutil_ring_create_mpmc(cutil_trait* trait, size_t capacity) {
+    return _ring_create(trait, capacity, 1);
+}
+
+void cutil_ring_destroy(cutil_ring* ring) {
+    cutil_allocator* allocator = cutil_current_allocator();
+    size_t position;
+
+    if (ring->trait->destroy_func) {
+        for (position = ring->head; position != ring->tail; position++) {
+            ring->trait->destroy_func(_ring_slot_item(ring, position), ring->trait->user_data);
+        }
+    }
+
+    allocator->free(ring->slots, allocator->user_data);
+    allocator->free(ring, allocator->user_data);
+}
+
+int cutil_ring_is_mpmc(cutil_ring* ring) {
+    return ring->mpmc;
+}
+
+size_t cutil_ring_capacity(cutil_ring* ring) {
+    return ring->capacity;
+}
+
+size_t cutil_ring_size(cutil_ring* ring) {
+    /* the head is read first, as it can never pass the tail */
+    size_t head = atomic_size_load_func(&ring->head);
+    size_t tail = atomic_size_load_func(&ring->tail);
+
+    return tail - head;
+}
+
+size_t _ring_spsc_push_batch(cutil_ring* ring, char* data, size_t count) {
+    size_t tail = ring->tail;
+    size_t free_count = ring->capacity - (tail - ring->cached_head);
+    size_t i;
+
+    if (free_count < count) {
+        ring->cached_head = atomic_size_load_func(&ring->head);
+        free_count = ring->capacity - (tail - ring->cached_head);
+    }
+
+    if (count > free_count) {
+        count = free_count;
+    }
+
+    for (i = 0; i < count; i++) {
+        _ring_copy_in(ring, tail + i, data + i * ring->trait->size);
+    }
+
+    if (count > 0) {
+        atomic_size_store_func(&ring->tail, tail + count);
+    }
+
+    return count;
+}
+
+size_t _ring_spsc_pop_batch(cutil_ring* ring, char* out, size_t count) {
+    size_t head = ring->head;
+    size_t item_count = ring->cached_tail - head;
+    size_t i;
+
+    if (item_count < count) {
+        ring->cached_tail = atomic_size_load_func(&ring->tail);
+        item_count = ring->cached_tail - head;
+    }
+
+    if (count > item_count) {
+        count = item_count;
+    }
+
+    for (i = 0; i < count; i++) {
+        memcpy(out + i * ring->trait->size, _ring_slot_item(ring, head + i), ring->trait->size);
+    }
+
+    if (count > 0) {
+        atomic_size_store_func(&ring->head, head + count);
+    }
+
+    return count;
+}
+
+/*
+Claims a run of up to count slots from the shared position, each of whose sequence number must equal its position plus the supplied offset.
+Producers claim slots with an offset of zero and consumers with an offset of one.
+Returns the number of slots claimed, placing the first claimed position in the out parameter.
+*/
+size_t _ring_mpmc_claim(cutil_ring* ring, size_t* shared_position, size_t offset, size_t count, size_t* out_position) {
+    for (;;) {
+        size_t position = atomic_size_load_func(shared_position);
+        size_t sequence = 0;
+        size_t i;
+
+        for (i = 0; i < count; i++) {
+            sequence = atomic_size_load_func(_ring_slot_sequence(ring, position + i));
+
+            if (sequence != position + i + offset) {
+                break;
+            }
+        }
+
+        if (i == 0) {
+            /* the first slot has not yet been released by the other side of the ring, so the ring is full or empty */
+            if ((ptrdiff_t)(sequence - (position + offset)) < 0) {
+                return 0;
+            }
+
+            /* another thread has claimed the slot */
+            continue;
+        }
+
+        if (atomic_size_compare_exchange_func(shared_position, position, position + i)) {
+            *out_position = position;
+            return i;
+        }
+    }
+}
+
+size_t _ring_mpmc_push_batch(cutil_ring* ring, char* data, size_t count) {
+    size_t position = 0;
+    size_t i;
+
+    count = _ring_mpmc_claim(ring, &ring->tail, 0, count, &position);
+
+    for (i = 0; i < count; i++) {
+        _ring_copy_in(ring, position + i, data + i * ring->trait->size);
+        atomic_size_store_func(_ring_slot_sequence(ring, position + i), position + i + 1);
+    }
+
+    return count;
+}
+
+size_t _ring_mpmc_pop_batch(cutil_ring* ring, char* out, size_t count) {
+    size_t position = 0;
+    size_t i;
+
+    count = _ring_mpmc_claim(ring, &ring->head, 1, count, &position);
+
+    for (i = 0; i < count; i++) {
+        memcpy(out + i * ring->trait->size, _ring_slot_item(ring, position + i), ring->trait->size);
+        atomic_size_store_func(_ring_slot_sequence(ring, position + i), position + i + ring->capacity);
+    }
+
+    return count;
+}
+
+size_t cutil_ring_push_batch(cutil_ring* ring, void* data, size_t count) {
+    if (count == 0) {
+        return 0;
+    }
+
+    if (ring->mpmc) {
+        return _ring_mpmc_push_batch(ring, (char*)data, count);
+    }
+
+    return _ring_spsc_push_batch(ring, (char*)data, count);
+}
+
+size_t cutil_ring_pop_batch(cutil_ring* ring, void* out, size_t count) {
+    if (count == 0) {
+        return 0;
+    }
+
+    if (ring->mpmc) {
+        return _ring_mpmc_pop_batch(ring, (char*)out, count);
+    }
+
+    return _ring_spsc_pop_batch(ring, (char*)out, count);
+}
+
+int cutil_ring_push(cutil_ring* ring, void* data) {
+    return cutil_ring_push_batch(ring, data, 1) != 0;
+}
+
+int cutil_ring_pop(cutil_ring* ring, void* out) {
+    return cutil_ring_pop_batch(ring, out, 1) != 0;
+}
@@ -0,0 +1,251 @@
+#include "cutil/stream.h"
+#include "cutil/allocator.h"
+#include "stream_private.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define STREAM_SIZE_BYTES 8
+
+struct cutil_writer {
+    cutil_stream_write_func write_func;
+    void* user_data;
+    char* buffer;
+    size_t capacity;
+    size_t used;
+    int failed;
+};
+
+struct cutil_reader {
+    cutil_stream_read_func read_func;
+    void* user_data;
+    char* buffer;
+    size_t capacity;
+    size_t position;
+    size_t end;
+};
+
+cutil_writer* cutil_writer_create(cutil_stream_write_func write_func, void* user_data, size_t buffer_size) {
+    cutil_allocator* allocator = cutil_current_allocator();
+    cutil_writer* writer = NULL;
+
+    if (write_func == NULL) {
+        return writer;
+    }
+
+    if (buffer_size == 0) {
+        buffer_size = CUTIL_STREAM_DEFAULT_BUFFER_SIZE;
+    }
+
+    writer = allocator->malloc(sizeof(cutil_writer), allocator->user_data);
+    writer->write_func = write_func;
+    writer->user_data = user_data;
+    writer->buffer = allocator->malloc(buffer_size, allocator->user_data);
+    writer->capacity = buffer_size;
+    writer->used = 0;
+    writer->failed = 0;
+
+    return writer;
+}
+
+void cutil_writer_destroy(cutil_writer* writer) {
+    cutil_allocator* allocator = cutil_current_allocator();
+
+    allocator->free(writer->buffer, allocator->user_data);
+    allocator->free(writer, allocator->user_data);
+}
+
+int _writer_output(cutil_writer* writer, void* data, size_t size) {
+    if (writer->write_func(data, size, writer->user_data) != size) {
+        writer->failed = 1;
+    }
+
+    return !writer->failed;
+}
+
+int cutil_writer_flush(cutil_writer* writer) {
+    if (writer->failed) {
+        return 0;
+    }
+
+    if (writer->used > 0) {
+        _writer_output(writer, writer->buffer, writer->used);
+        writer->used = 0;
+    }
+
+    return !writer->failed;
+}
+
+int cutil_writer_write(cutil_writer* writer, void* data, size_t size) {
+    if (writer->failed) {
+        return 0;
+    }
+
+    if (size > writer->capacity - writer->used) {
+        if (!cutil_writer_flush(writer)) {
+            return 0;
+        }
+
+        /* large writes bypass the buffer entirely */
+        if (size >= writer->capacity) {
+            return _writer_output(writer, data, size);
+        }
+    }
+
+    memcpy(writer->buffer + writer->used, data, size);
+    writer->used += size;
+
+    return 1;
+}
+
+int cutil_writer_write_size(cutil_writer* writer, size_t value) {
+    unsigned char bytes[STREAM_SIZE_BYTES];
+    size_t i;
+
+    for (i = 0; i < STREAM_SIZE_BYTES; i++) {
+        bytes[i] = (unsigned char)(value & 0xFF);
+        value >>= 8;
+    }
+
+    return cutil_writer_write(writer, bytes, STREAM_SIZE_BYTES);
+}
+
+cutil_reader* cutil_reader_create(cutil_stream_read_func read_func, void* user_data, size_t buffer_size) {
+    cutil_allocator* allocator = cutil_current_allocator();
+    cutil_reader* reader = NULL;
+
+    if (read_func == NULL) {
+        return reader;
+    }
+
+    if (buffer_size == 0) {
+        buffer_size = CUTIL_STREAM_DEFAULT_BUFFER_SIZE;
+    }
+
+    reader = allocator->malloc(sizeof(cutil_reader), allocator->user_data);
+    reader->read_func = read_func;
+    reader->user_data = user_data;
+    reader->buffer = allocator->malloc(buffer_size, allocator->user_data);
+    reader->capacity = buffer_size;
+    reader->position = 0;
+    reader->end = 0;
+
+    return reader;
+}
+
+void cutil_reader_destroy(cutil_reader* reader) {
+    cutil_allocator* allocator = cutil_current_allocator();
+
+    allocator->free(reader->buffer, allocator->user_data);
+    allocator->free(reader, allocator->user_data);
+}
+
+int cutil_reader_read(cutil_reader* reader, void* data, size_t size) {
+    char* dest = (char*)data;
+
+    while (size > 0) {
+        size_t count;
+
+        if (reader->position < reader->end) {
+            count = reader->end - reader->position;
+            count = count < size ? count : size;
+
+            memcpy(dest, reader->buffer + reader->position, count);
+            reader->position += count;
+        }
+        else if (size >= reader->capacity) {
+            /* large reads are copied directly into the destination */
+            count = reader->read_func(dest, size, reader->user_data);
+
+            if (count == 0) {
+                return 0;
+            }
+        }
+        else {
+            reader->position = 0;
+            reader->end = reader->read_func(reader->buffer, reader->capacity, reader->user_data);
+
+            if (reader->end == 0) {
+                return 0;
+            }
+
+            continue;
+        }
+
+        dest += count;
+        size -= count;
+    }
+
+    return 1;
+}
+
+int cutil_reader_read_size(cutil_reader* reader, size_t* value) {
+    unsigned char bytes[STREAM_SIZE_BYTES];
+    size_t result = 0;
+    int i;
+
+    if (!cutil_reader_read(reader, bytes, STREAM_SIZE_BYTES)) {
+        return 0;
+    }
+
+    for (i = STREAM_SIZE_BYTES - 1; i >= 0; i--) {
+        /* values which do not fit in a size_t are rejected */
+        if (((result << 8) >> 8) != result) {
+            return 0;
+        }
+
+        result = (result << 8) | bytes[i];
+    }
+
+    *value = result;
+
+    return 1;
+}
+
+size_t cutil_stream_file_write(void* data, size_t size, void* user_data) {
+    return fwrite(data, 1, size, (FILE*)user_data);
+}
+
+size_t cutil_stream_file_read(void* buffer, size_t size, void* user_data) {
+    return fread(buffer, 1, size, (FILE*)user_data);
+}
+
+int _stream_trait_writable(cutil_trait* trait) {
+    return trait->serialize_func || (trait->copy_func == NULL && trait->destroy_func == NULL);
+}
+
+int _stream_trait_readable(cutil_trait* trait) {
+    return trait->deserialize_func || (trait->copy_func == NULL && trait->destroy_func == NULL);
+}
+
+int _stream_write_header(cutil_writer* writer, cutil_trait* trait, size_t count) {
+    return cutil_writer_write_size(writer, trait->size) && cutil_writer_write_size(writer, count);
+}
+
+int _stream_read_header(cutil_reader* reader, cutil_trait* trait, size_t* count) {
+    size_t item_size;
+
+    if (!cutil_reader_read_size(reader, &item_size) || item_size != trait->size) {
+        return 0;
+    }
+
+    return cutil_reader_read_size(reader, count);
+}
+
+int _stream_write_item(cutil_writer* writer, cutil_trait* trait, void* item) {
+    if (trait->serialize_func) {
+        return trait->serialize_func(item, writer, trait->user_data);
+    }
+    else {
+        return cutil_writer_write(writer, item, trait->size);
+    }
+}
+
+int _stream_read_item(cutil_reader* reader, cutil_trait* trait, void* item) {
+    if (trait->deserialize_func) {
+        return trait->deserialize_func(item, reader, trait->user_data);
+    }
+    else {
+        return cutil_reader_read(reader, item, trait->size);
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef CUTIL_STREAM_PRIVATE_H
+#define CUTIL_STREAM_PRIVATE_H
+
+#include "cutil/stream.h"
+#include "cutil/trait.h"
+
+/*
+Helper functions used by the containers to write and read their items.
+Items whose trait has a serialize function are written with it, otherwise the raw bytes of the item are written.
+Traits that define a copy or destroy function own memory that raw bytes cannot describe, so they must define serialize functions in order to be written.
+*/
+
+int _stream_trait_writable(cutil_trait* trait);
+int _stream_trait_readable(cutil_trait* trait);
+
+/*
+Each container begins with the size of its items and the item count.
+Reading a header fails if the item size does not match the trait.
+*/
+int _stream_write_header(cutil_writer* writer, cutil_trait* trait, size_t count);
+int _stream_read_header(cutil_reader* reader, cutil_trait* trait, size_t* count);
+
+int _stream_write_item(cutil_writer* writer, cutil_trait* trait, void* item);
+
+/*
+Reads an item into uninitialized memory.
+If reading fails the item does not hold any resources and must not be destroyed.
+*/
+int _stream_read_item(cutil_reader* reader, cutil_trait* trait, void* item);
+
+#endif
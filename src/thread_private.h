@@ -0,0 +1,37 @@
+#ifndef CUTIL_THREAD_PRIVATE_H
+#define CUTIL_THREAD_PRIVATE_H
+
+/*
+Reader / writer lock used to latch data structures that are shared between threads.
+Windows slim reader / writer locks must be released in the same mode they were acquired, so separate unlock functions are provided for each mode.
+RWLOCK_INITIALIZER statically initializes a lock with static storage duration, which does not need to be destroyed.
+*/
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+
+    typedef SRWLOCK _rwlock;
+
+    #define RWLOCK_INITIALIZER SRWLOCK_INIT
+    #define rwlock_init_func(lock) InitializeSRWLock(lock)
+    #define rwlock_destroy_func(lock) ((void)(lock))
+    #define rwlock_read_lock_func(lock) AcquireSRWLockShared(lock)
+    #define rwlock_read_unlock_func(lock) ReleaseSRWLockShared(lock)
+    #define rwlock_write_lock_func(lock) AcquireSRWLockExclusive(lock)
+    #define rwlock_write_unlock_func(lock) ReleaseSRWLockExclusive(lock)
+#else
+    #include <pthread.h>
+
+    typedef pthread_rwlock_t _rwlock;
+
+    #define RWLOCK_INITIALIZER PTHREAD_RWLOCK_INITIALIZER
+    #define rwlock_init_func(lock) pthread_rwlock_init((lock), NULL)
+    #define rwlock_destroy_func(lock) pthread_rwlock_destroy(lock)
+    #define rwlock_read_lock_func(lock) pthread_rwlock_rdlock(lock)
+    #define rwlock_read_unlock_func(lock) pthread_rwlock_unlock(lock)
+    #define rwlock_write_lock_func(lock) pthread_rwlock_wrlock(lock)
+    #define rwlock_write_unlock_func(lock) pthread_rwlock_unlock(lock)
+#endif
+
+#endif
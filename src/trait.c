@@ -1,4 +1,5 @@
 #include "cutil/trait.h"
+#include "trait_private.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -21,8 +22,8 @@ int cutil_trait_int_compare(void* a, void* b, void* user_data) {
 }
 
 int cutil_trait_uint_compare(void* a, void* b, void* user_data) {
-    int uint_a = *(unsigned int*)a;
-    int uint_b = *(unsigned int*)b;
+    unsigned int uint_a = *(unsigned int*)a;
+    unsigned int uint_b = *(unsigned int*)b;
 
     (void)user_data;
 
@@ -100,6 +101,89 @@ void cutil_trait_cstring_destroy(void* item, void* user_data) {
     free(item_ptr);
 }
 
+int cutil_trait_cstring_serialize(void* item, cutil_writer* writer, void* user_data) {
+    char* item_ptr = *((char**)item);
+    size_t length = strlen(item_ptr);
+
+    (void)user_data;
+
+    return cutil_writer_write_size(writer, length) && cutil_writer_write(writer, item_ptr, length);
+}
+
+int cutil_trait_cstring_deserialize(void* item, cutil_reader* reader, void* user_data) {
+    char* str;
+    size_t length;
+
+    (void)user_data;
+
+    if (!cutil_reader_read_size(reader, &length) || length == (size_t)-1) {
+        return 0;
+    }
+
+    str = malloc(length + 1);
+    if (str == NULL) {
+        return 0;
+    }
+
+    if (!cutil_reader_read(reader, str, length)) {
+        free(str);
+        return 0;
+    }
+
+    str[length] = '\0';
+    memcpy(item, &str, sizeof(char*));
+
+    return 1;
+}
+
+#define TRAIT_FNV_OFFSET_BASIS 2166136261UL
+#define TRAIT_FNV_PRIME 16777619UL
+
+size_t _trait_hash_bytes(const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    unsigned long hash = TRAIT_FNV_OFFSET_BASIS;
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        hash = ((hash ^ bytes[i]) * TRAIT_FNV_PRIME) & 0xFFFFFFFFUL;
+    }
+
+    return (size_t)hash;
+}
+
+int _trait_hashable(cutil_trait* trait) {
+    return trait->hash_func != NULL || trait->copy_func == NULL;
+}
+
+size_t _trait_hash_item(cutil_trait* trait, void* item) {
+    if (trait->hash_func) {
+        return trait->hash_func(item, trait->user_data);
+    }
+
+    return _trait_hash_bytes(item, trait->size);
+}
+
+size_t cutil_trait_float_hash(void* item, void* user_data) {
+    float value = *(float*)item;
+
+    (void)user_data;
+
+    /* positive and negative zero compare equal */
+    if (value == 0.0f) {
+        value = 0.0f;
+    }
+
+    return _trait_hash_bytes(&value, sizeof(float));
+}
+
+size_t cutil_trait_cstring_hash(void* item, void* user_data) {
+    char* item_ptr = *((char**)item);
+
+    (void)user_data;
+
+    return _trait_hash_bytes(item_ptr, strlen(item_ptr));
+}
+
 static cutil_trait* default_traits = NULL;
 
 typedef enum {
@@ -131,6 +215,7 @@ void init_default_traits() {
     /* int trait */
     trait = default_traits + CUTIL_DEFAULT_TRAIT_FLOAT;
     trait->compare_func = cutil_trait_float_compare;
+    trait->hash_func = cutil_trait_float_hash;
     trait->size = sizeof(float);
 
     /* ptr trait */
@@ -143,6 +228,9 @@ void init_default_traits() {
     trait->compare_func = cutil_trait_cstring_compare;
     trait->destroy_func = cutil_trait_cstring_destroy;
     trait->copy_func = cutil_trait_cstring_copy;
+    trait->serialize_func = cutil_trait_cstring_serialize;
+    trait->deserialize_func = cutil_trait_cstring_deserialize;
+    trait->hash_func = cutil_trait_cstring_hash;
     trait->size = sizeof(char*);
 }
 
@@ -0,0 +1,28 @@
+#ifndef CUTIL_TRAIT_PRIVATE_H
+#define CUTIL_TRAIT_PRIVATE_H
+
+#include "cutil/trait.h"
+
+/*
+Comparison functions used by the built in traits.
+Containers may check for these functions in order to select specialized code paths for the built in types.
+*/
+int cutil_trait_int_compare(void* a, void* b, void* user_data);
+int cutil_trait_uint_compare(void* a, void* b, void* user_data);
+int cutil_trait_float_compare(void* a, void* b, void* user_data);
+int cutil_trait_ptr_compare(void* a, void* b, void* user_data);
+int cutil_trait_cstring_compare(void* a, void* b, void* user_data);
+
+/* Hashes a block of bytes with the 32 bit FNV-1a function. */
+size_t _trait_hash_bytes(const void* data, size_t size);
+
+/*
+Returns non zero if items of the trait can be hashed.
+Traits which define a copy function must also define a hash function, as the raw bytes of their items are not meaningful.
+*/
+int _trait_hashable(cutil_trait* trait);
+
+/* Hashes an item with its trait's hash function, or its raw bytes if the trait does not define one. */
+size_t _trait_hash_item(cutil_trait* trait, void* item);
+
+#endif
@@ -0,0 +1,373 @@
+#include "cutil/unrolled_list.h"
+#include "cutil/allocator.h"
+
+#include <string.h>
+
+#define UNROLLED_LIST_CACHE_LINE_SIZE 64
+#define UNROLLED_LIST_DEFAULT_NODE_SIZE 256
+#define UNROLLED_LIST_MIN_DEFAULT_NODE_CAPACITY 4
+#define UNROLLED_LIST_ITEM_ALIGNMENT 16
+
+/*
+Each node is a single allocation holding this header followed by an array of node_capacity items.
+The items of a node occupy the slots [start, start + count), which lets items be added before the first item as well as after the last.
+Nodes are linked into a circular list around the list's base node, which never holds items.
+*/
+typedef struct cutil_unrolled_list_node {
+    struct cutil_unrolled_list_node* prev;
+    struct cutil_unrolled_list_node* next;
+    unsigned int start;
+    unsigned int count;
+} cutil_unrolled_list_node;
+
+struct cutil_unrolled_list {
+    unsigned int size;
+    cutil_unrolled_list_node base;
+    cutil_trait* trait;
+
+    size_t node_size;
+    size_t items_offset;
+    unsigned int node_capacity;
+
+    /* the most recently emptied node is kept so that a list used as a queue does not allocate a node each time it crosses a node boundary */
+    cutil_unrolled_list_node* spare_node;
+};
+
+size_t _cutil_unrolled_list_round_up(size_t size, size_t multiple) {
+    return (size + multiple - 1) / multiple * multiple;
+}
+
+size_t _cutil_unrolled_list_items_offset() {
+    return _cutil_unrolled_list_round_up(sizeof(cutil_unrolled_list_node), UNROLLED_LIST_ITEM_ALIGNMENT);
+}
+
+cutil_unrolled_list* cutil_unrolled_list_create(cutil_trait* trait) {
+    size_t min_node_size;
+
+    if (trait == NULL) {
+        return NULL;
+    }
+
+    min_node_size = _cutil_unrolled_list_items_offset() + UNROLLED_LIST_MIN_DEFAULT_NODE_CAPACITY * trait->size;
+
+    return cutil_unrolled_list_create_with_node_size(trait, min_node_size > UNROLLED_LIST_DEFAULT_NODE_SIZE ? min_node_size : UNROLLED_LIST_DEFAULT_NODE_SIZE);
+}
+
+cutil_unrolled_list* cutil_unrolled_list_create_with_node_size(cutil_trait* trait, size_t node_bytes) {
+    cutil_allocator* allocator = cutil_current_allocator();
+    cutil_unrolled_list* list;
+    size_t items_offset = _cutil_unrolled_list_items_offset();
+
+    if (trait == NULL || trait->size == 0) {
+        return NULL;
+    }
+
+    node_bytes = _cutil_unrolled_list_round_up(node_bytes, UNROLLED_LIST_CACHE_LINE_SIZE);
+
+    if (node_bytes < items_offset + trait->size) {
+        return NULL;
+    }
+
+    list = allocator->malloc(sizeof(cutil_unrolled_list), allocator->user_data);
+
+    list->size = 0;
+    list->base.prev = &list->base;
+    list->base.next = &list->base;
+    list->base.start = 0;
+    list->base.count = 0;
+    list->trait = trait;
+
+    list->node_size = node_bytes;
+    list->items_offset = items_offset;
+    list->node_capacity = (unsigned int)((node_bytes - items_offset) / trait->size);
+    list->spare_node = NULL;
+
+    return list;
+}
+
+void cutil_unrolled_list_destroy(cutil_unrolled_list* list) {
+    cutil_allocator* allocator = cutil_current_allocator();
+
+    cutil_unrolled_list_clear(list);
+
+    if (list->spare_node) {
+        allocator->free(list->spare_node, allocator->user_data);
+    }
+
+    allocator->free(list, allocator->user_data);
+}
+
+unsigned int cutil_unrolled_list_size(cutil_unrolled_list* list) {
+    return list->size;
+}
+
+unsigned int cutil_unrolled_list_node_capacity(cutil_unrolled_list* list) {
+    return list->node_capacity;
+}
+
+void* _cutil_unrolled_list_item(cutil_unrolled_list* list, cutil_unrolled_list_node* node, unsigned int index) {
+    return (char*)node + list->items_offset + index * list->trait->size;
+}
+
+void _cutil_unrolled_list_copy_item(cutil_unrolled_list* list, void* dest, void* data) {
+    if (list->trait->copy_func) {
+        list->trait->copy_func(dest, data, list->trait->user_data);
+    }
+    else {
+        memcpy(dest, data, list->trait->size);
+    }
+}
+
+void _cutil_unrolled_list_destroy_item(cutil_unrolled_list* list, cutil_unrolled_list_node* node, unsigned int index) {
+    if (list->trait->destroy_func) {
+        list->trait->destroy_func(_cutil_unrolled_list_item(list, node, index), list->trait->user_data);
+    }
+}
+
+/* Creates an empty node and links it in front of the supplied position, which may be the list's base node. */
+cutil_unrolled_list_node* _cutil_unrolled_list_node_create(cutil_unrolled_list* list, cutil_unrolled_list_node* position, unsigned int start) {
+    cutil_allocator* allocator = cutil_current_allocator();
+    cutil_unrolled_list_node* node = list->spare_node;
+
+    if (node) {
+        list->spare_node = NULL;
+    }
+    else {
+        node = allocator->malloc(list->node_size, allocator->user_data);
+    }
+
+    node->start = start;
+    node->count = 0;
+
+    node->prev = position->prev;
+    node->next = position;
+    position->prev->next = node;
+    position->prev = node;
+
+    return node;
+}
+
+/* Unlinks an empty node, keeping it as the spare node if there is not one already. */
+void _cutil_unrolled_list_node_destroy(cutil_unrolled_list* list, cutil_unrolled_list_node* node) {
+    cutil_allocator* allocator = cutil_current_allocator();
+
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+
+    if (list->spare_node) {
+        allocator->free(node, allocator->user_data);
+    }
+    else {
+        list->spare_node = node;
+    }
+}
+
+void cutil_unrolled_list_clear(cutil_unrolled_list* list) {
+    while (list->base.next != &list->base) {
+        cutil_unrolled_list_node* node = list->base.next;
+        unsigned int i;
+
+        for (i = node->start; i < node->start + node->count; i++) {
+            _cutil_unrolled_list_destroy_item(list, node, i);
+        }
+
+        node->count = 0;
+        _cutil_unrolled_list_node_destroy(list, node);
+    }
+
+    list->size = 0;
+}
+
+void cutil_unrolled_list_push_front(cutil_unrolled_list* list, void* data) {
+    cutil_unrolled_list_node* node = list->base.next;
+
+    /* new front nodes are filled from their last slot so that further pushes to the front use the same node */
+    if (node == &list->base || node->start == 0) {
+        node = _cutil_unrolled_list_node_create(list, list->base.next, list->node_capacity);
+    }
+
+    node->start -= 1;
+    node->count += 1;
+    _cutil_unrolled_list_copy_item(list, _cutil_unrolled_list_item(list, node, node->start), data);
+
+    list->size += 1;
+}
+
+void cutil_unrolled_list_push_back(cutil_unrolled_list* list, void* data) {
+    cutil_unrolled_list_node* node = list->base.prev;
+
+    if (node == &list->base || node->start + node->count == list->node_capacity) {
+        node = _cutil_unrolled_list_node_create(list, &list->base, 0);
+    }
+
+    _cutil_unrolled_list_copy_item(list, _cutil_unrolled_list_item(list, node, node->start + node->count), data);
+    node->count += 1;
+
+    list->size += 1;
+}
+
+int cutil_unrolled_list_pop_front(cutil_unrolled_list* list) {
+    cutil_unrolled_list_node* node = list->base.next;
+
+    if (node == &list->base) {
+        return 0;
+    }
+
+    _cutil_unrolled_list_destroy_item(list, node, node->start);
+    node->start += 1;
+    node->count -= 1;
+
+    if (node->count == 0) {
+        _cutil_unrolled_list_node_destroy(list, node);
+    }
+
+    list->size -= 1;
+
+    return 1;
+}
+
+int cutil_unrolled_list_pop_back(cutil_unrolled_list* list) {
+    cutil_unrolled_list_node* node = list->base.prev;
+
+    if (node == &list->base) {
+        return 0;
+    }
+
+    node->count -= 1;
+    _cutil_unrolled_list_destroy_item(list, node, node->start + node->count);
+
+    if (node->count == 0) {
+        _cutil_unrolled_list_node_destroy(list, node);
+    }
+
+    list->size -= 1;
+
+    return 1;
+}
+
+int cutil_unrolled_list_front(cutil_unrolled_list* list, void* out) {
+    cutil_unrolled_list_node* node = list->base.next;
+
+    if (node == &list->base) {
+        return 0;
+    }
+
+    memcpy(out, _cutil_unrolled_list_item(list, node, node->start), list->trait->size);
+
+    return 1;
+}
+
+int cutil_unrolled_list_back(cutil_unrolled_list* list, void* out) {
+    cutil_unrolled_list_node* node = list->base.prev;
+
+    if (node == &list->base) {
+        return 0;
+    }
+
+    memcpy(out, _cutil_unrolled_list_item(list, node, node->start + node->count - 1), list->trait->size);
+
+    return 1;
+}
+
+size_t cutil_unrolled_list_foreach(cutil_unrolled_list* list, cutil_unrolled_list_foreach_func callback, void* user_data) {
+    cutil_unrolled_list_node* node = list->base.next;
+    size_t item_size = list->trait->size;
+    size_t count = 0;
+
+    while (node != &list->base) {
+        char* item = _cutil_unrolled_list_item(list, node, node->start);
+        char* end = item + node->count * item_size;
+
+        for (; item < end; item += item_size) {
+            count += 1;
+
+            if (!callback(item, user_data)) {
+                return count;
+            }
+        }
+
+        node = node->next;
+    }
+
+    return count;
+}
+
+cutil_unrolled_list_itr* cutil_unrolled_list_itr_create(cutil_unrolled_list* list) {
+    cutil_allocator* allocator = cutil_current_allocator();
+    cutil_unrolled_list_itr* itr = allocator->malloc(sizeof(cutil_unrolled_list_itr), allocator->user_data);
+
+    cutil_unrolled_list_itr_init(itr, list);
+
+    return itr;
+}
+
+void cutil_unrolled_list_itr_init(cutil_unrolled_list_itr* itr, cutil_unrolled_list* list) {
+    itr->list = list;
+    itr->node = &list->base;
+    itr->index = 0;
+}
+
+void cutil_unrolled_list_itr_destroy(cutil_unrolled_list_itr* itr) {
+    cutil_allocator* allocator = cutil_current_allocator();
+    allocator->free(itr, allocator->user_data);
+}
+
+int cutil_unrolled_list_itr_has_next(cutil_unrolled_list_itr* itr) {
+    cutil_unrolled_list_node* node = itr->node;
+
+    if (node == &itr->list->base) {
+        return node->next != node;
+    }
+
+    return itr->index + 1 < node->start + node->count || node->next != &itr->list->base;
+}
+
+int cutil_unrolled_list_itr_next(cutil_unrolled_list_itr* itr, void* out) {
+    if (!cutil_unrolled_list_itr_has_next(itr)) {
+        return 0;
+    }
+
+    if (itr->node != &itr->list->base && itr->index + 1 < itr->node->start + itr->node->count) {
+        itr->index += 1;
+    }
+    else {
+        itr->node = itr->node->next;
+        itr->index = itr->node->start;
+    }
+
+    if (out) {
+        memcpy(out, _cutil_unrolled_list_item(itr->list, itr->node, itr->index), itr->list->trait->size);
+    }
+
+    return 1;
+}
+
+int cutil_unrolled_list_itr_has_prev(cutil_unrolled_list_itr* itr) {
+    cutil_unrolled_list_node* node = itr->node;
+
+    if (node == &itr->list->base) {
+        return node->prev != node;
+    }
+
+    return itr->index > node->start || node->prev != &itr->list->base;
+}
+
+int cutil_unrolled_list_itr_prev(cutil_unrolled_list_itr* itr, void* out) {
+    if (!cutil_unrolled_list_itr_has_prev(itr)) {
+        return 0;
+    }
+
+    if (itr->node != &itr->list->base && itr->index > itr->node->start) {
+        itr->index -= 1;
+    }
+    else {
+        itr->node = itr->node->prev;
+        itr->index = itr->node->start + itr->node->count - 1;
+    }
+
+    if (out) {
+        memcpy(out, _cutil_unrolled_list_item(itr->list, itr->node, itr->index), itr->list->trait->size);
+    }
+
+    return 1;
+}
@@ -2,6 +2,7 @@
 #include "cutil/allocator.h"
 
 #include "vector_private.h"
+#include "stream_private.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -181,6 +182,21 @@ cutil_trait* cutil_vector_trait(cutil_vector* vector) {
     return vector->trait;
 }
 
+size_t cutil_vector_foreach(cutil_vector* vector, cutil_vector_foreach_func callback, void* user_data) {
+    char* item = (char*)vector->data;
+    size_t i;
+
+    for (i = 0; i < vector->size; i++) {
+        if (!callback(item, user_data)) {
+            return i + 1;
+        }
+
+        item += vector->trait->size;
+    }
+
+    return vector->size;
+}
+
 size_t cutil_vector_capacity(cutil_vector* vector) {
     return vector->capacity;
 }
@@ -210,3 +226,84 @@ int cutil_vector_equals(cutil_vector* a, cutil_vector* b) {
         return memcmp(a->data, b->data, a->size * a->trait->size) == 0;
     }
 }
+
+int cutil_vector_write(cutil_vector* vector, cutil_writer* writer) {
+    size_t i;
+
+    if (!_stream_trait_writable(vector->trait) || !_stream_write_header(writer, vector->trait, vector->size)) {
+        return 0;
+    }
+
+    if (vector->trait->serialize_func) {
+        for (i = 0; i < vector->size; i++) {
+            if (!_stream_write_item(writer, vector->trait, _get_object(vector, i))) {
+                return 0;
+            }
+        }
+    }
+    else if (vector->size > 0) {
+        /* plain data items are written in a single block */
+        if (!cutil_writer_write(writer, vector->data, vector->size * vector->trait->size)) {
+            return 0;
+        }
+    }
+
+    return cutil_writer_flush(writer);
+}
+
+int _vector_read_items(cutil_vector* vector, cutil_reader* reader) {
+    cutil_allocator* allocator = cutil_current_allocator();
+    size_t count, item_size = vector->trait->size;
+    void* new_data;
+
+    if (!_stream_trait_readable(vector->trait) || !_stream_read_header(reader, vector->trait, &count)) {
+        return 0;
+    }
+
+    if (count == 0) {
+        return 1;
+    }
+
+    if (count > ((size_t)-1) / item_size) {
+        return 0;
+    }
+
+    new_data = allocator->realloc(vector->data, count * item_size, allocator->user_data);
+    if (!new_data) {
+        return 0;
+    }
+
+    vector->data = new_data;
+    vector->capacity = count;
+
+    if (vector->trait->deserialize_func) {
+        while (vector->size < count) {
+            if (!_stream_read_item(reader, vector->trait, _get_object(vector, vector->size))) {
+                return 0;
+            }
+
+            vector->size += 1;
+        }
+    }
+    else {
+        /* plain data items are read directly into the vector's storage */
+        if (!cutil_reader_read(reader, vector->data, count * item_size)) {
+            return 0;
+        }
+
+        vector->size = count;
+    }
+
+    return 1;
+}
+
+cutil_vector* cutil_vector_read(cutil_reader* reader, cutil_trait* trait) {
+    cutil_vector* vector = cutil_vector_create(trait);
+
+    if (!_vector_read_items(vector, reader)) {
+        cutil_vector_destroy(vector);
+        return NULL;
+    }
+
+    return vector;
+}
@@ -20,6 +20,9 @@ typedef btree_test btree_create_test;
 typedef btree_test btree_size_test;
 typedef btree_test btree_clear_test;
 typedef btree_test btree_contains_test;
+typedef btree_test btree_get_or_insert_test;
+typedef btree_test btree_upsert_test;
+typedef btree_test btree_get_many_test;
 typedef btree_expect_test btree_insert_test;
 typedef btree_expect_test btree_delete_test;
 
@@ -32,6 +35,9 @@ CTEST_FIXTURE(btree_delete, btree_delete_test, btree_expect_test_setup, btree_ex
 CTEST_FIXTURE(btree_trait, btree_trait_test, btree_test_setup, btree_test_teardown)
 CTEST_FIXTURE(btree_get, btree_get_test, btree_get_test_setup, btree_get_test_teardown)
 CTEST_FIXTURE(btree_trait_func, btree_trait_func_test, btree_trait_func_test_setup, btree_trait_func_test_teardown)
+CTEST_FIXTURE(btree_get_or_insert, btree_get_or_insert_test, btree_test_setup, btree_test_teardown)
+CTEST_FIXTURE(btree_upsert, btree_upsert_test, btree_test_setup, btree_test_teardown)
+CTEST_FIXTURE(btree_get_many, btree_get_many_test, btree_test_setup, btree_test_teardown)
 
 void invalid_key_trait_no_compare_func(btree_create_test* test) {
     cutil_trait* bogus_trait = malloc(sizeof(cutil_trait));
@@ -718,6 +724,236 @@ void val_insert_replace(btree_trait_func_test* test) {
     CTEST_ASSERT_INT_EQ(cutil_test_trait_tracker_destroy_count(test->val_trait_tracker), destroy_count + 1);
 }
 
+void inserts_default_value_when_key_not_present(btree_get_or_insert_test* test) {
+    int key = 10, default_value = 100, actual_value = 0;
+    int inserted = 0;
+    int* value_ptr;
+
+    test->btree = cutil_btree_create(DEFAULT_ODD_BTREE_ORDER, cutil_trait_int(), cutil_trait_int());
+
+    value_ptr = cutil_btree_get_or_insert(test->btree, &key, &default_value, &inserted);
+    CTEST_ASSERT_PTR_NOT_NULL(value_ptr);
+    CTEST_ASSERT_TRUE(inserted);
+    CTEST_ASSERT_INT_EQ(*value_ptr, default_value);
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->btree), 1);
+
+    CTEST_ASSERT_TRUE(cutil_btree_get(test->btree, &key, &actual_value));
+    CTEST_ASSERT_INT_EQ(actual_value, default_value);
+}
+
+void returns_existing_value_when_key_present(btree_get_or_insert_test* test) {
+    int key = 10, existing_value = 55, default_value = 100;
+    int inserted = 1;
+    int* value_ptr;
+
+    test->btree = cutil_btree_create(DEFAULT_ODD_BTREE_ORDER, cutil_trait_int(), cutil_trait_int());
+    cutil_btree_insert(test->btree, &key, &existing_value);
+
+    value_ptr = cutil_btree_get_or_insert(test->btree, &key, &default_value, &inserted);
+    CTEST_ASSERT_PTR_NOT_NULL(value_ptr);
+    CTEST_ASSERT_FALSE(inserted);
+    CTEST_ASSERT_INT_EQ(*value_ptr, existing_value);
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->btree), 1);
+}
+
+/* Updates values through the returned pointer while inserting enough keys to force node splits. */
+void modifies_value_in_place(btree_get_or_insert_test* test) {
+    int i, key, zero = 0, actual_value = 0, item_count = 50;
+
+    test->btree = cutil_btree_create(DEFAULT_EVEN_BTREE_ORDER, cutil_trait_int(), cutil_trait_int());
+
+    for (i = 0; i < item_count * 3; i++) {
+        int* value_ptr;
+        key = (i * 7) % item_count;
+
+        value_ptr = cutil_btree_get_or_insert(test->btree, &key, &zero, NULL);
+        *value_ptr += 1;
+    }
+
+    CTEST_ASSERT_TRUE(validate_btree(test->btree));
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->btree), item_count);
+
+    for (key = 0; key < item_count; key++) {
+        CTEST_ASSERT_TRUE(cutil_btree_get(test->btree, &key, &actual_value));
+        CTEST_ASSERT_INT_EQ(actual_value, 3);
+    }
+}
+
+/* Writes through the returned pointer as each key is inserted, so a pointer to the wrong item after a split of the leaf, the pivot or the right node is detected. */
+void returns_inserted_value_after_split(btree_get_or_insert_test* test) {
+    unsigned int orders[] = {3, 4, 5, 8};
+    int i, key, zero = 0, actual_value = 0, item_count = 200;
+    unsigned int j;
+
+    for (j = 0; j < sizeof(orders) / sizeof(orders[0]); j++) {
+        test->btree = cutil_btree_create(orders[j], cutil_trait_int(), cutil_trait_int());
+
+        for (i = 0; i < item_count; i++) {
+            int* value_ptr;
+            key = (i * 73) % item_count;
+
+            value_ptr = cutil_btree_get_or_insert(test->btree, &key, &zero, NULL);
+            CTEST_ASSERT_INT_EQ(*value_ptr, 0);
+            *value_ptr = key + 1;
+        }
+
+        CTEST_ASSERT_TRUE(validate_btree(test->btree));
+
+        for (key = 0; key < item_count; key++) {
+            CTEST_ASSERT_TRUE(cutil_btree_get(test->btree, &key, &actual_value));
+            CTEST_ASSERT_INT_EQ(actual_value, key + 1);
+        }
+
+        cutil_btree_destroy(test->btree);
+        test->btree = NULL;
+    }
+}
+
+void upsert_increment_func(void* value, int inserted, void* user_data) {
+    int* int_value = (int*)value;
+    int* insert_count = (int*)user_data;
+
+    if (inserted) {
+        *insert_count += 1;
+        CTEST_EXPECT_INT_EQ(*int_value, 0);
+    }
+
+    *int_value += 1;
+}
+
+void counts_occurrences(btree_upsert_test* test) {
+    int i, key, insert_count = 0, actual_value = 0, item_count = 40;
+
+    test->btree = cutil_btree_create(DEFAULT_ODD_BTREE_ORDER, cutil_trait_int(), cutil_trait_int());
+
+    for (i = 0; i < item_count * 4; i++) {
+        key = (i * 3) % item_count;
+        cutil_btree_upsert(test->btree, &key, upsert_increment_func, &insert_count);
+    }
+
+    CTEST_ASSERT_TRUE(validate_btree(test->btree));
+    CTEST_ASSERT_INT_EQ(insert_count, item_count);
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->btree), item_count);
+
+    for (key = 0; key < item_count; key++) {
+        CTEST_ASSERT_TRUE(cutil_btree_get(test->btree, &key, &actual_value));
+        CTEST_ASSERT_INT_EQ(actual_value, 4);
+    }
+}
+
+void returns_true_only_when_inserting(btree_upsert_test* test) {
+    int key = 5, insert_count = 0;
+
+    test->btree = cutil_btree_create(DEFAULT_ODD_BTREE_ORDER, cutil_trait_int(), cutil_trait_int());
+
+    CTEST_ASSERT_TRUE(cutil_btree_upsert(test->btree, &key, upsert_increment_func, &insert_count));
+    CTEST_ASSERT_FALSE(cutil_btree_upsert(test->btree, &key, upsert_increment_func, &insert_count));
+    CTEST_ASSERT_INT_EQ(insert_count, 1);
+}
+
+void upsert_string_value_func(void* value, int inserted, void* user_data) {
+    (void)user_data;
+
+    if (inserted) {
+        char* str = malloc(8);
+        strcpy(str, "new");
+        *(char**)value = str;
+    }
+    else {
+        (*(char**)value)[0] = 'N';
+    }
+}
+
+void upsert_copies_key_and_does_not_copy_value(btree_trait_func_test* test) {
+    char* key = "test key";
+    char* actual_value = NULL;
+
+    cutil_btree_upsert(test->btree, &key, upsert_string_value_func, NULL);
+    CTEST_ASSERT_INT_EQ(cutil_test_trait_tracker_copy_count(test->key_trait_tracker), 1);
+    CTEST_ASSERT_INT_EQ(cutil_test_trait_tracker_copy_count(test->val_trait_tracker), 0);
+
+    cutil_btree_upsert(test->btree, &key, upsert_string_value_func, NULL);
+    CTEST_ASSERT_INT_EQ(cutil_test_trait_tracker_copy_count(test->val_trait_tracker), 0);
+    CTEST_ASSERT_INT_EQ(cutil_test_trait_tracker_destroy_count(test->val_trait_tracker), 0);
+
+    CTEST_ASSERT_TRUE(cutil_btree_get(test->btree, &key, &actual_value));
+    CTEST_ASSERT_INT_EQ(strcmp(actual_value, "New"), 0);
+}
+
+/* Creates a tree containing the even keys in the range [0, item_count * 2) with each value equal to its key * 10. */
+cutil_btree* create_get_many_test_tree(int item_count) {
+    int i;
+    cutil_btree* btree = cutil_btree_create(DEFAULT_EVEN_BTREE_ORDER, cutil_trait_int(), cutil_trait_int());
+
+    for (i = 0; i < item_count; i++) {
+        int key = i * 2;
+        int value = key * 10;
+        cutil_btree_insert(btree, &key, &value);
+    }
+
+    return btree;
+}
+
+void get_many_sorted_keys(btree_get_many_test* test) {
+    int keys[100], values[100];
+    int i, key_count = 100;
+
+    test->btree = create_get_many_test_tree(key_count);
+
+    for (i = 0; i < key_count; i++) {
+        keys[i] = i * 2;
+    }
+
+    CTEST_ASSERT_INT_EQ(cutil_btree_get_many(test->btree, keys, key_count, values, NULL), key_count);
+
+    for (i = 0; i < key_count; i++) {
+        CTEST_ASSERT_INT_EQ(values[i], keys[i] * 10);
+    }
+}
+
+void get_many_unsorted_keys_with_missing(btree_get_many_test* test) {
+    int keys[150], values[150];
+    unsigned char found_mask[150];
+    int i, key_count = 150;
+
+    test->btree = create_get_many_test_tree(100);
+
+    /* visits keys in a scattered order, odd keys and keys >= 200 are not present */
+    for (i = 0; i < key_count; i++) {
+        keys[i] = (i * 37) % 250;
+        values[i] = -1;
+    }
+
+    cutil_btree_get_many(test->btree, keys, key_count, values, found_mask);
+
+    for (i = 0; i < key_count; i++) {
+        int expected_found = keys[i] % 2 == 0 && keys[i] < 200;
+
+        CTEST_ASSERT_INT_EQ(found_mask[i] != 0, expected_found);
+        CTEST_ASSERT_INT_EQ(values[i], expected_found ? keys[i] * 10 : -1);
+    }
+}
+
+void get_many_returns_found_count(btree_get_many_test* test) {
+    int keys[] = {-1, 0, 1, 2, 3, 198, 199, 200};
+    int values[8];
+
+    test->btree = create_get_many_test_tree(100);
+
+    CTEST_ASSERT_INT_EQ(cutil_btree_get_many(test->btree, keys, 8, values, NULL), 3);
+}
+
+void get_many_empty_tree(btree_get_many_test* test) {
+    int keys[] = {1, 2, 3};
+    int values[3];
+    unsigned char found_mask[] = {1, 1, 1};
+
+    test->btree = cutil_btree_create(DEFAULT_ODD_BTREE_ORDER, cutil_trait_int(), cutil_trait_int());
+
+    CTEST_ASSERT_INT_EQ(cutil_btree_get_many(test->btree, keys, 3, values, found_mask), 0);
+    CTEST_ASSERT_FALSE(found_mask[0] || found_mask[1] || found_mask[2]);
+}
+
 void add_btree_tests() {
     CTEST_ADD_TEST_F(btree_create, invalid_parameters);
     CTEST_ADD_TEST_F(btree_create, invalid_key_trait_no_compare_func);
@@ -787,4 +1023,18 @@ void add_btree_tests() {
     CTEST_ADD_TEST_F(btree_trait_func, val_destroy_on_destroy);
 
     CTEST_ADD_TEST_F(btree_trait_func, val_insert_replace);
+    CTEST_ADD_TEST_F(btree_trait_func, upsert_copies_key_and_does_not_copy_value);
+
+    CTEST_ADD_TEST_F(btree_get_or_insert, inserts_default_value_when_key_not_present);
+    CTEST_ADD_TEST_F(btree_get_or_insert, returns_existing_value_when_key_present);
+    CTEST_ADD_TEST_F(btree_get_or_insert, modifies_value_in_place);
+    CTEST_ADD_TEST_F(btree_get_or_insert, returns_inserted_value_after_split);
+
+    CTEST_ADD_TEST_F(btree_upsert, counts_occurrences);
+    CTEST_ADD_TEST_F(btree_upsert, returns_true_only_when_inserting);
+
+    CTEST_ADD_TEST_F(btree_get_many, get_many_sorted_keys);
+    CTEST_ADD_TEST_F(btree_get_many, get_many_unsorted_keys_with_missing);
+    CTEST_ADD_TEST_F(btree_get_many, get_many_returns_found_count);
+    CTEST_ADD_TEST_F(btree_get_many, get_many_empty_tree);
 }
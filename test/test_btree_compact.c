@@ -0,0 +1,199 @@
+#include "cutil/btree.h"
+
+#include "ctest/ctest.h"
+#include "test_suites.h"
+
+#include "test_btree_util.h"
+#include "test_btree_fixtures.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#define COMPACT_BTREE_ORDER 7
+#define COMPACT_ITEM_COUNT 2000
+
+CTEST_FIXTURE(btree_compact, btree_test, btree_test_setup, btree_test_teardown)
+
+/* Creates a btree containing the multiples of the step less than the count, with each value equal to twice the key */
+cutil_btree* create_compact_test_tree(unsigned int order, int count, int step) {
+    cutil_btree* btree = cutil_btree_create(order, cutil_trait_int(), cutil_trait_int());
+    int i, value;
+
+    for (i = 0; i < count; i++) {
+        value = i * 2;
+        cutil_btree_insert(btree, &i, &value);
+    }
+
+    for (i = 0; i < count; i++) {
+        if (i % step != 0) {
+            cutil_btree_erase(btree, &i);
+        }
+    }
+
+    return btree;
+}
+
+/* Checks that a btree is valid and contains exactly the multiples of the step less than the count */
+int compact_tree_contains_multiples(cutil_btree* btree, int count, int step) {
+    cutil_btree_itr* itr;
+    int key, value, expected_key = 0, ok;
+
+    if (!validate_btree(btree) || !validate_btree_balance(btree)) {
+        return 0;
+    }
+
+    ok = cutil_btree_size(btree) == (size_t)((count + step - 1) / step);
+    itr = cutil_btree_itr_create(btree);
+
+    while (ok && cutil_btree_itr_next(itr)) {
+        cutil_btree_itr_get_key(itr, &key);
+        cutil_btree_itr_get_value(itr, &value);
+
+        ok = key == expected_key && value == key * 2;
+        expected_key += step;
+    }
+
+    cutil_btree_itr_destroy(itr);
+
+    return ok && expected_key >= count;
+}
+
+void btree_compact_after_erase(btree_test* test) {
+    cutil_btree_statistics before, after;
+
+    test->btree = create_compact_test_tree(COMPACT_BTREE_ORDER, COMPACT_ITEM_COUNT, 5);
+    cutil_btree_stats(test->btree, &before);
+
+    CTEST_ASSERT_TRUE(cutil_btree_compact(test->btree, 1.0));
+    cutil_btree_stats(test->btree, &after);
+
+    CTEST_ASSERT_TRUE(compact_tree_contains_multiples(test->btree, COMPACT_ITEM_COUNT, 5));
+    CTEST_ASSERT_TRUE(after.node_count < before.node_count);
+    CTEST_ASSERT_TRUE(after.average_fill > 0.9);
+    CTEST_ASSERT_TRUE(after.average_fill > before.average_fill);
+}
+
+void btree_compact_target_fill(btree_test* test) {
+    cutil_btree_statistics stats;
+
+    /* nodes of order 7 hold at most 6 items, so a target of half fills leaves with 3 items */
+    test->btree = create_compact_test_tree(COMPACT_BTREE_ORDER, COMPACT_ITEM_COUNT, 1);
+    CTEST_ASSERT_TRUE(cutil_btree_compact(test->btree, 0.5));
+    cutil_btree_stats(test->btree, &stats);
+
+    CTEST_ASSERT_TRUE(compact_tree_contains_multiples(test->btree, COMPACT_ITEM_COUNT, 1));
+    CTEST_ASSERT_TRUE(stats.average_fill > 0.45 && stats.average_fill < 0.6);
+
+    /* targets below the minimum fill of the order are raised to the minimum */
+    CTEST_ASSERT_TRUE(cutil_btree_compact(test->btree, 0.01));
+    cutil_btree_stats(test->btree, &stats);
+
+    CTEST_ASSERT_TRUE(compact_tree_contains_multiples(test->btree, COMPACT_ITEM_COUNT, 1));
+    CTEST_ASSERT_TRUE(stats.min_fill >= 0.5);
+}
+
+/* trees of every size up to several levels are compacted for each small order and a range of targets, covering the repair of the right border */
+void btree_compact_all_sizes(btree_test* test) {
+    double targets[4] = {0.01, 0.5, 0.8, 1.0};
+    unsigned int order, t;
+    int count, failures = 0;
+
+    for (order = 3; order <= 8; order++) {
+        for (t = 0; t < 4; t++) {
+            for (count = 0; count < 150; count++) {
+                test->btree = create_compact_test_tree(order, count * 2, 2);
+
+                if (!cutil_btree_compact(test->btree, targets[t]) || !compact_tree_contains_multiples(test->btree, count * 2, 2)) {
+                    failures += 1;
+                }
+
+                cutil_btree_destroy(test->btree);
+                test->btree = NULL;
+            }
+        }
+    }
+
+    CTEST_ASSERT_INT_EQ(failures, 0);
+}
+
+void btree_compact_then_modify(btree_test* test) {
+    int i, value;
+
+    test->btree = create_compact_test_tree(COMPACT_BTREE_ORDER, COMPACT_ITEM_COUNT, 2);
+    CTEST_ASSERT_TRUE(cutil_btree_compact(test->btree, 1.0));
+
+    for (i = 1; i < COMPACT_ITEM_COUNT; i += 2) {
+        value = i * 2;
+        cutil_btree_insert(test->btree, &i, &value);
+    }
+
+    CTEST_ASSERT_TRUE(compact_tree_contains_multiples(test->btree, COMPACT_ITEM_COUNT, 1));
+
+    for (i = 0; i < COMPACT_ITEM_COUNT; i++) {
+        if (i % 3 != 0) {
+            cutil_btree_erase(test->btree, &i);
+        }
+    }
+
+    CTEST_ASSERT_TRUE(compact_tree_contains_multiples(test->btree, COMPACT_ITEM_COUNT, 3));
+}
+
+/* items of nodes shared with the snapshot are copied while the remaining items are moved, string keys ensure each is released exactly once */
+void btree_compact_preserves_snapshot(btree_test* test) {
+    char key[16];
+    char* key_ptr = key;
+    cutil_btree* snapshot;
+    int i, value;
+
+    test->btree = cutil_btree_create(COMPACT_BTREE_ORDER, cutil_trait_cstring(), cutil_trait_int());
+
+    for (i = 0; i < COMPACT_ITEM_COUNT; i++) {
+        sprintf(key, "key%05d", i);
+        cutil_btree_insert(test->btree, &key_ptr, &i);
+    }
+
+    snapshot = cutil_btree_snapshot(test->btree);
+
+    for (i = 0; i < COMPACT_ITEM_COUNT / 2; i++) {
+        sprintf(key, "key%05d", i);
+        cutil_btree_erase(test->btree, &key_ptr);
+    }
+
+    CTEST_ASSERT_TRUE(cutil_btree_compact(test->btree, 1.0));
+    CTEST_ASSERT_TRUE(validate_btree_balance(test->btree));
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->btree), COMPACT_ITEM_COUNT / 2);
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(snapshot), COMPACT_ITEM_COUNT);
+    CTEST_ASSERT_FALSE(cutil_btree_compact(snapshot, 1.0));
+
+    for (i = 0; i < COMPACT_ITEM_COUNT; i++) {
+        sprintf(key, "key%05d", i);
+        CTEST_ASSERT_INT_EQ(cutil_btree_contains(test->btree, &key_ptr), i >= COMPACT_ITEM_COUNT / 2);
+        CTEST_ASSERT_TRUE(cutil_btree_get(snapshot, &key_ptr, &value));
+        CTEST_ASSERT_INT_EQ(value, i);
+    }
+
+    cutil_btree_destroy(snapshot);
+}
+
+void btree_compact_invalid(btree_test* test) {
+    cutil_btree* concurrent = cutil_btree_create_concurrent(COMPACT_BTREE_ORDER, cutil_trait_int(), cutil_trait_int());
+
+    test->btree = create_compact_test_tree(COMPACT_BTREE_ORDER, 100, 1);
+
+    CTEST_ASSERT_FALSE(cutil_btree_compact(test->btree, 0.0));
+    CTEST_ASSERT_FALSE(cutil_btree_compact(test->btree, 1.5));
+    CTEST_ASSERT_FALSE(cutil_btree_compact(concurrent, 1.0));
+    CTEST_ASSERT_TRUE(compact_tree_contains_multiples(test->btree, 100, 1));
+
+    cutil_btree_destroy(concurrent);
+}
+
+void add_btree_compact_tests() {
+    CTEST_ADD_TEST_F(btree_compact, btree_compact_after_erase);
+    CTEST_ADD_TEST_F(btree_compact, btree_compact_target_fill);
+    CTEST_ADD_TEST_F(btree_compact, btree_compact_all_sizes);
+    CTEST_ADD_TEST_F(btree_compact, btree_compact_then_modify);
+    CTEST_ADD_TEST_F(btree_compact, btree_compact_preserves_snapshot);
+    CTEST_ADD_TEST_F(btree_compact, btree_compact_invalid);
+}
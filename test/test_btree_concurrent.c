@@ -0,0 +1,301 @@
+#include "cutil/btree.h"
+
+#include "ctest/ctest.h"
+#include "test_suites.h"
+
+#include "test_btree_util.h"
+#include "test_btree_fixtures.h"
+#include "test_util/thread.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define CONCURRENT_BTREE_ORDER 5
+#define CONCURRENT_THREAD_COUNT 4
+#define CONCURRENT_KEY_COUNT 2000
+#define CONCURRENT_OPERATION_COUNT 20000
+
+typedef btree_test btree_concurrent_test;
+
+CTEST_FIXTURE(btree_concurrent, btree_concurrent_test, btree_test_setup, btree_test_teardown)
+
+typedef struct {
+    cutil_btree* btree;
+    unsigned int seed;
+    int first_key;
+    int key_count;
+    int key_step;
+    int failures;
+} concurrent_worker;
+
+/* rand is not required to be thread safe, so each worker uses its own generator */
+int concurrent_worker_rand(concurrent_worker* worker) {
+    worker->seed = worker->seed * 1103515245 + 12345;
+    return (int)((worker->seed >> 16) & 0x7FFF);
+}
+
+void run_concurrent_workers(cutil_btree* btree, concurrent_worker* workers, cutil_test_thread_func func) {
+    cutil_test_thread* threads[CONCURRENT_THREAD_COUNT];
+    int i;
+
+    for (i = 0; i < CONCURRENT_THREAD_COUNT; i++) {
+        workers[i].btree = btree;
+        workers[i].seed = (unsigned int)i + 1;
+        workers[i].failures = 0;
+        threads[i] = cutil_test_thread_create(func, &workers[i]);
+    }
+
+    for (i = 0; i < CONCURRENT_THREAD_COUNT; i++) {
+        cutil_test_thread_join(threads[i]);
+    }
+}
+
+int concurrent_worker_failures(concurrent_worker* workers) {
+    int i, failures = 0;
+
+    for (i = 0; i < CONCURRENT_THREAD_COUNT; i++) {
+        failures += workers[i].failures;
+    }
+
+    return failures;
+}
+
+/* Checks that the btree is valid and that its size matches the number of items that can be iterated */
+int concurrent_btree_consistent(cutil_btree* btree) {
+    cutil_btree_itr* itr = cutil_btree_itr_create(btree);
+    size_t item_count = 0;
+
+    while (cutil_btree_itr_next(itr)) {
+        item_count += 1;
+    }
+
+    cutil_btree_itr_destroy(itr);
+
+    return validate_btree(btree) && item_count == cutil_btree_size(btree);
+}
+
+void concurrent_insert_range(void* arg) {
+    concurrent_worker* worker = (concurrent_worker*)arg;
+    int i, key, value;
+
+    for (i = 0; i < worker->key_count; i++) {
+        key = worker->first_key + i * worker->key_step;
+        value = key * 3;
+        cutil_btree_insert(worker->btree, &key, &value);
+    }
+}
+
+void concurrent_erase_range(void* arg) {
+    concurrent_worker* worker = (concurrent_worker*)arg;
+    int i, key;
+
+    for (i = 0; i < worker->key_count; i++) {
+        key = worker->first_key + i * worker->key_step;
+
+        if (!cutil_btree_erase(worker->btree, &key)) {
+            worker->failures += 1;
+        }
+    }
+}
+
+void concurrent_upsert_func(void* value, int inserted, void* user_data) {
+    int expected_value = *(int*)user_data;
+
+    if (inserted) {
+        *(int*)value = expected_value;
+    }
+}
+
+/* Performs random operations on a shared range of keys.  Every value stored is three times its key. */
+void concurrent_mixed_operations(void* arg) {
+    concurrent_worker* worker = (concurrent_worker*)arg;
+    int i;
+
+    for (i = 0; i < CONCURRENT_OPERATION_COUNT; i++) {
+        int key = concurrent_worker_rand(worker) % CONCURRENT_KEY_COUNT;
+        int value = key * 3, actual_value = -1;
+
+        switch (concurrent_worker_rand(worker) % 4) {
+            case 0:
+                cutil_btree_insert(worker->btree, &key, &value);
+                break;
+
+            case 1:
+                cutil_btree_erase(worker->btree, &key);
+                break;
+
+            case 2:
+                cutil_btree_upsert(worker->btree, &key, concurrent_upsert_func, &value);
+                break;
+
+            default:
+                if (cutil_btree_get(worker->btree, &key, &actual_value) && actual_value != value) {
+                    worker->failures += 1;
+                }
+        }
+    }
+}
+
+/* Reads keys which are never erased while other workers modify the rest of the tree */
+void concurrent_read_stable_keys(void* arg) {
+    concurrent_worker* worker = (concurrent_worker*)arg;
+    int i;
+
+    for (i = 0; i < CONCURRENT_OPERATION_COUNT; i++) {
+        int key = -1 - concurrent_worker_rand(worker) % CONCURRENT_KEY_COUNT;
+        int value = -1;
+
+        if (!cutil_btree_get(worker->btree, &key, &value) || value != key * 3) {
+            worker->failures += 1;
+        }
+    }
+}
+
+void concurrent_reads_and_writes(void* arg) {
+    concurrent_worker* worker = (concurrent_worker*)arg;
+
+    if (worker->first_key == 0) {
+        concurrent_mixed_operations(arg);
+    }
+    else {
+        concurrent_read_stable_keys(arg);
+    }
+}
+
+void create_concurrent(btree_concurrent_test* test) {
+    int key = 1, value = 1;
+    test->btree = cutil_btree_create_concurrent(CONCURRENT_BTREE_ORDER, cutil_trait_int(), cutil_trait_int());
+
+    CTEST_ASSERT_TRUE(cutil_btree_is_concurrent(test->btree));
+    CTEST_ASSERT_TRUE(cutil_btree_snapshot(test->btree) == NULL);
+    CTEST_ASSERT_TRUE(cutil_btree_get_or_insert(test->btree, &key, &value, NULL) == NULL);
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->btree), 0);
+}
+
+void single_thread_operations(btree_concurrent_test* test) {
+    int key, value;
+    test->btree = cutil_btree_create_concurrent(CONCURRENT_BTREE_ORDER, cutil_trait_int(), cutil_trait_int());
+
+    for (key = 0; key < CONCURRENT_KEY_COUNT; key++) {
+        value = key * 3;
+        cutil_btree_insert(test->btree, &key, &value);
+    }
+
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->btree), CONCURRENT_KEY_COUNT);
+    CTEST_ASSERT_TRUE(concurrent_btree_consistent(test->btree));
+
+    for (key = 0; key < CONCURRENT_KEY_COUNT; key += 2) {
+        CTEST_ASSERT_TRUE(cutil_btree_erase(test->btree, &key));
+    }
+
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->btree), CONCURRENT_KEY_COUNT / 2);
+    CTEST_ASSERT_TRUE(concurrent_btree_consistent(test->btree));
+
+    for (key = 0; key < CONCURRENT_KEY_COUNT; key++) {
+        CTEST_ASSERT_INT_EQ(cutil_btree_contains(test->btree, &key), key % 2);
+
+        if (key % 2) {
+            CTEST_ASSERT_TRUE(cutil_btree_get(test->btree, &key, &value));
+            CTEST_ASSERT_INT_EQ(value, key * 3);
+        }
+    }
+
+    cutil_btree_clear(test->btree);
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->btree), 0);
+}
+
+void parallel_inserts(btree_concurrent_test* test) {
+    concurrent_worker workers[CONCURRENT_THREAD_COUNT];
+    int i, key, value;
+
+    test->btree = cutil_btree_create_concurrent(CONCURRENT_BTREE_ORDER, cutil_trait_int(), cutil_trait_int());
+
+    for (i = 0; i < CONCURRENT_THREAD_COUNT; i++) {
+        workers[i].first_key = i * CONCURRENT_KEY_COUNT;
+        workers[i].key_count = CONCURRENT_KEY_COUNT;
+        workers[i].key_step = 1;
+    }
+
+    run_concurrent_workers(test->btree, workers, concurrent_insert_range);
+
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->btree), CONCURRENT_THREAD_COUNT * CONCURRENT_KEY_COUNT);
+    CTEST_ASSERT_TRUE(concurrent_btree_consistent(test->btree));
+
+    for (key = 0; key < CONCURRENT_THREAD_COUNT * CONCURRENT_KEY_COUNT; key++) {
+        CTEST_ASSERT_TRUE(cutil_btree_get(test->btree, &key, &value));
+        CTEST_ASSERT_INT_EQ(value, key * 3);
+    }
+}
+
+void parallel_erases(btree_concurrent_test* test) {
+    concurrent_worker workers[CONCURRENT_THREAD_COUNT];
+    int i, key, value;
+
+    test->btree = cutil_btree_create_concurrent(CONCURRENT_BTREE_ORDER, cutil_trait_int(), cutil_trait_int());
+
+    for (key = 0; key < CONCURRENT_THREAD_COUNT * CONCURRENT_KEY_COUNT; key++) {
+        value = key * 3;
+        cutil_btree_insert(test->btree, &key, &value);
+    }
+
+    /* interleave the keys of each worker so that they frequently rebalance neighboring nodes */
+    for (i = 0; i < CONCURRENT_THREAD_COUNT; i++) {
+        workers[i].first_key = i;
+        workers[i].key_count = CONCURRENT_KEY_COUNT;
+        workers[i].key_step = CONCURRENT_THREAD_COUNT;
+    }
+
+    run_concurrent_workers(test->btree, workers, concurrent_erase_range);
+
+    CTEST_ASSERT_INT_EQ(concurrent_worker_failures(workers), 0);
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->btree), 0);
+    CTEST_ASSERT_TRUE(concurrent_btree_consistent(test->btree));
+}
+
+void parallel_mixed_operations(btree_concurrent_test* test) {
+    concurrent_worker workers[CONCURRENT_THREAD_COUNT];
+    int key, value;
+
+    test->btree = cutil_btree_create_concurrent(CONCURRENT_BTREE_ORDER, cutil_trait_int(), cutil_trait_int());
+    run_concurrent_workers(test->btree, workers, concurrent_mixed_operations);
+
+    CTEST_ASSERT_INT_EQ(concurrent_worker_failures(workers), 0);
+    CTEST_ASSERT_TRUE(concurrent_btree_consistent(test->btree));
+
+    for (key = 0; key < CONCURRENT_KEY_COUNT; key++) {
+        if (cutil_btree_get(test->btree, &key, &value)) {
+            CTEST_ASSERT_INT_EQ(value, key * 3);
+        }
+    }
+}
+
+void readers_see_stable_keys_during_writes(btree_concurrent_test* test) {
+    concurrent_worker workers[CONCURRENT_THREAD_COUNT];
+    int i, key, value;
+
+    test->btree = cutil_btree_create_concurrent(CONCURRENT_BTREE_ORDER, cutil_trait_int(), cutil_trait_int());
+
+    /* stable keys are negative, the writer only modifies non negative keys */
+    for (key = -CONCURRENT_KEY_COUNT; key < 0; key++) {
+        value = key * 3;
+        cutil_btree_insert(test->btree, &key, &value);
+    }
+
+    for (i = 0; i < CONCURRENT_THREAD_COUNT; i++) {
+        workers[i].first_key = i;
+    }
+
+    run_concurrent_workers(test->btree, workers, concurrent_reads_and_writes);
+
+    CTEST_ASSERT_INT_EQ(concurrent_worker_failures(workers), 0);
+    CTEST_ASSERT_TRUE(concurrent_btree_consistent(test->btree));
+}
+
+void add_btree_concurrent_tests() {
+    CTEST_ADD_TEST_F(btree_concurrent, create_concurrent);
+    CTEST_ADD_TEST_F(btree_concurrent, single_thread_operations);
+    CTEST_ADD_TEST_F(btree_concurrent, parallel_inserts);
+    CTEST_ADD_TEST_F(btree_concurrent, parallel_erases);
+    CTEST_ADD_TEST_F(btree_concurrent, parallel_mixed_operations);
+    CTEST_ADD_TEST_F(btree_concurrent, readers_see_stable_keys_during_writes);
+}
@@ -0,0 +1,407 @@
+#include "cutil/btree.h"
+
+#include "ctest/ctest.h"
+#include "test_suites.h"
+
+#include "test_btree_fixtures.h"
+#include "btree_file_private.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#define FILE_BTREE_ORDER 5
+#define FILE_ITEM_COUNT 2000
+
+CTEST_FIXTURE(btree_file, btree_file_test, btree_file_test_setup, btree_file_test_teardown)
+
+/* Creates a btree containing the keys [0, count) with each value equal to the key multiplied by the supplied factor */
+cutil_btree* create_file_test_tree(unsigned int order, int count, int factor) {
+    cutil_btree* btree = cutil_btree_create(order, cutil_trait_int(), cutil_trait_int());
+    int i, value;
+
+    for (i = 0; i < count; i++) {
+        value = i * factor;
+        cutil_btree_insert(btree, &i, &value);
+    }
+
+    return btree;
+}
+
+/* Checks that a btree contains exactly the keys [0, count) with each value equal to the key multiplied by the supplied factor */
+int file_tree_contains_sequence(cutil_btree* btree, int count, int factor) {
+    cutil_btree_itr* itr = cutil_btree_itr_create(btree);
+    int key, value, expected_key = 0, ok = 1;
+
+    if (cutil_btree_size(btree) != (size_t)count) {
+        ok = 0;
+    }
+
+    while (ok && cutil_btree_itr_next(itr)) {
+        cutil_btree_itr_get_key(itr, &key);
+        cutil_btree_itr_get_value(itr, &value);
+
+        ok = key == expected_key && value == key * factor;
+        expected_key += 1;
+    }
+
+    cutil_btree_itr_destroy(itr);
+
+    return ok && expected_key == count;
+}
+
+cutil_btree* save_and_open(cutil_btree* btree) {
+    if (!cutil_btree_save(btree, BTREE_FILE_TEST_PATH)) {
+        return NULL;
+    }
+
+    return cutil_btree_open_mapped(BTREE_FILE_TEST_PATH, cutil_btree_get_key_trait(btree), cutil_btree_get_value_trait(btree));
+}
+
+void write_test_file(const char* data, size_t size) {
+    FILE* file = fopen(BTREE_FILE_TEST_PATH, "wb");
+
+    fwrite(data, 1, size, file);
+    fclose(file);
+}
+
+void file_save_empty(btree_file_test* test) {
+    test->btree = cutil_btree_create(FILE_BTREE_ORDER, cutil_trait_int(), cutil_trait_int());
+    test->mapped_btree = save_and_open(test->btree);
+
+    CTEST_ASSERT_PTR_NOT_NULL(test->mapped_btree);
+    CTEST_ASSERT_TRUE(cutil_btree_is_mapped(test->mapped_btree));
+    CTEST_ASSERT_FALSE(cutil_btree_is_mapped(test->btree));
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->mapped_btree), 0);
+    CTEST_ASSERT_TRUE(cutil_btree_equals(test->btree, test->mapped_btree));
+}
+
+void file_save_preserves_items(btree_file_test* test) {
+    test->btree = create_file_test_tree(FILE_BTREE_ORDER, FILE_ITEM_COUNT, 3);
+    test->mapped_btree = save_and_open(test->btree);
+
+    CTEST_ASSERT_PTR_NOT_NULL(test->mapped_btree);
+    CTEST_ASSERT_INT_EQ(cutil_btree_get_order(test->mapped_btree), FILE_BTREE_ORDER);
+    CTEST_ASSERT_TRUE(cutil_btree_equals(test->btree, test->mapped_btree));
+    CTEST_ASSERT_TRUE(file_tree_contains_sequence(test->mapped_btree, FILE_ITEM_COUNT, 3));
+}
+
+void file_mapped_stats(btree_file_test* test) {
+    cutil_btree_statistics btree_stats, mapped_stats;
+    size_t interior_count;
+
+    test->btree = create_file_test_tree(FILE_BTREE_ORDER, FILE_ITEM_COUNT, 1);
+    test->mapped_btree = save_and_open(test->btree);
+    CTEST_ASSERT_PTR_NOT_NULL(test->mapped_btree);
+
+    cutil_btree_stats(test->btree, &btree_stats);
+    cutil_btree_stats(test->mapped_btree, &mapped_stats);
+
+    CTEST_ASSERT_INT_EQ(mapped_stats.height, btree_stats.height);
+    CTEST_ASSERT_INT_EQ(mapped_stats.node_count, btree_stats.node_count);
+    CTEST_ASSERT_TRUE(memcmp(mapped_stats.level_node_counts, btree_stats.level_node_counts, sizeof(btree_stats.level_node_counts)) == 0);
+    CTEST_ASSERT_TRUE(mapped_stats.average_fill == btree_stats.average_fill);
+    CTEST_ASSERT_TRUE(mapped_stats.min_fill == btree_stats.min_fill);
+
+    /* keys and values remain in the mapped file */
+    CTEST_ASSERT_INT_EQ(mapped_stats.key_bytes, 0);
+    CTEST_ASSERT_INT_EQ(mapped_stats.value_bytes, 0);
+
+    /* interior nodes have a branch array each, all leaves share one more */
+    interior_count = btree_stats.node_count - btree_stats.level_node_counts[btree_stats.height - 1];
+    CTEST_ASSERT_INT_EQ(mapped_stats.branch_bytes, (interior_count + 1) * FILE_BTREE_ORDER * sizeof(void*));
+    CTEST_ASSERT_TRUE(mapped_stats.allocation_count < btree_stats.allocation_count);
+}
+
+void file_save_large_order(btree_file_test* test) {
+    /* nodes of this order are larger than a page */
+    test->btree = create_file_test_tree(700, FILE_ITEM_COUNT, 2);
+    test->mapped_btree = save_and_open(test->btree);
+
+    CTEST_ASSERT_PTR_NOT_NULL(test->mapped_btree);
+    CTEST_ASSERT_TRUE(file_tree_contains_sequence(test->mapped_btree, FILE_ITEM_COUNT, 2));
+}
+
+void file_mapped_get(btree_file_test* test) {
+    int i, value, found_count = 0;
+    int keys[4] = {-1, 0, FILE_ITEM_COUNT / 2, FILE_ITEM_COUNT};
+    int values[4];
+    unsigned char found_mask[4];
+
+    test->btree = create_file_test_tree(FILE_BTREE_ORDER, FILE_ITEM_COUNT, 3);
+    test->mapped_btree = save_and_open(test->btree);
+
+    for (i = 0; i < FILE_ITEM_COUNT; i++) {
+        found_count += cutil_btree_get(test->mapped_btree, &i, &value) && value == i * 3;
+    }
+
+    CTEST_ASSERT_INT_EQ(found_count, FILE_ITEM_COUNT);
+    CTEST_ASSERT_FALSE(cutil_btree_contains(test->mapped_btree, &i));
+
+    CTEST_ASSERT_INT_EQ(cutil_btree_get_many(test->mapped_btree, keys, 4, values, found_mask), 2);
+    CTEST_ASSERT_FALSE(found_mask[0]);
+    CTEST_ASSERT_TRUE(found_mask[1]);
+    CTEST_ASSERT_TRUE(found_mask[2]);
+    CTEST_ASSERT_FALSE(found_mask[3]);
+    CTEST_ASSERT_INT_EQ(values[2], (FILE_ITEM_COUNT / 2) * 3);
+}
+
+void file_mapped_is_read_only(btree_file_test* test) {
+    int key = FILE_ITEM_COUNT, value = 1;
+
+    test->btree = create_file_test_tree(FILE_BTREE_ORDER, FILE_ITEM_COUNT, 3);
+    test->mapped_btree = save_and_open(test->btree);
+
+    cutil_btree_insert(test->mapped_btree, &key, &value);
+    key = 1;
+    CTEST_ASSERT_FALSE(cutil_btree_erase(test->mapped_btree, &key));
+    CTEST_ASSERT_TRUE(cutil_btree_get_or_insert(test->mapped_btree, &key, &value, NULL) == NULL);
+    cutil_btree_clear(test->mapped_btree);
+
+    CTEST_ASSERT_TRUE(cutil_btree_snapshot(test->mapped_btree) == NULL);
+    CTEST_ASSERT_FALSE(cutil_btree_is_snapshot(test->mapped_btree));
+    CTEST_ASSERT_TRUE(file_tree_contains_sequence(test->mapped_btree, FILE_ITEM_COUNT, 3));
+}
+
+void file_mapped_outlives_source(btree_file_test* test) {
+    test->btree = create_file_test_tree(FILE_BTREE_ORDER, FILE_ITEM_COUNT, 3);
+    test->mapped_btree = save_and_open(test->btree);
+
+    cutil_btree_destroy(test->btree);
+    test->btree = NULL;
+
+    CTEST_ASSERT_TRUE(file_tree_contains_sequence(test->mapped_btree, FILE_ITEM_COUNT, 3));
+}
+
+void file_save_rejects_owned_memory(btree_file_test* test) {
+    test->btree = cutil_btree_create(FILE_BTREE_ORDER, cutil_trait_cstring(), cutil_trait_int());
+
+    CTEST_ASSERT_FALSE(cutil_btree_save(test->btree, BTREE_FILE_TEST_PATH));
+    CTEST_ASSERT_TRUE(cutil_btree_open_mapped(BTREE_FILE_TEST_PATH, cutil_trait_cstring(), cutil_trait_int()) == NULL);
+}
+
+void file_open_rejects_mismatched_traits(btree_file_test* test) {
+    cutil_trait double_trait;
+
+    memset(&double_trait, 0, sizeof(cutil_trait));
+    double_trait.size = sizeof(double);
+
+    test->btree = create_file_test_tree(FILE_BTREE_ORDER, FILE_ITEM_COUNT, 3);
+    CTEST_ASSERT_TRUE(cutil_btree_save(test->btree, BTREE_FILE_TEST_PATH));
+
+    CTEST_ASSERT_TRUE(cutil_btree_open_mapped(BTREE_FILE_TEST_PATH, cutil_trait_int(), &double_trait) == NULL);
+}
+
+void file_open_rejects_invalid_file(btree_file_test* test) {
+    char data[8192];
+    (void)test;
+
+    CTEST_ASSERT_TRUE(cutil_btree_open_mapped("cutil_test_missing_file.bin", cutil_trait_int(), cutil_trait_int()) == NULL);
+
+    write_test_file("btree", 5);
+    CTEST_ASSERT_TRUE(cutil_btree_open_mapped(BTREE_FILE_TEST_PATH, cutil_trait_int(), cutil_trait_int()) == NULL);
+
+    memset(data, 0xAB, sizeof(data));
+    write_test_file(data, sizeof(data));
+    CTEST_ASSERT_TRUE(cutil_btree_open_mapped(BTREE_FILE_TEST_PATH, cutil_trait_int(), cutil_trait_int()) == NULL);
+}
+
+void file_open_rejects_truncated_file(btree_file_test* test) {
+    FILE* file;
+    char* data;
+    long size;
+
+    test->btree = create_file_test_tree(FILE_BTREE_ORDER, FILE_ITEM_COUNT, 3);
+    CTEST_ASSERT_TRUE(cutil_btree_save(test->btree, BTREE_FILE_TEST_PATH));
+
+    file = fopen(BTREE_FILE_TEST_PATH, "rb");
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    data = malloc(size);
+    CTEST_ASSERT_INT_EQ(fread(data, 1, size, file), size);
+    fclose(file);
+
+    write_test_file(data, size - 1);
+    free(data);
+
+    CTEST_ASSERT_TRUE(cutil_btree_open_mapped(BTREE_FILE_TEST_PATH, cutil_trait_int(), cutil_trait_int()) == NULL);
+}
+
+/* Reads the file written for a btree into memory */
+char* read_test_file(cutil_btree* btree, size_t* size) {
+    FILE* file;
+    char* data;
+
+    if (!cutil_btree_save(btree, BTREE_FILE_TEST_PATH)) {
+        return NULL;
+    }
+
+    file = fopen(BTREE_FILE_TEST_PATH, "rb");
+    fseek(file, 0, SEEK_END);
+    *size = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    data = malloc(*size);
+    *size = fread(data, 1, *size, file);
+    fclose(file);
+
+    return data;
+}
+
+/* Checks that a modified copy of a valid file is rejected, restoring the original contents afterwards */
+int modified_file_rejected(char* data, size_t size, void* field, void* value, size_t value_size) {
+    char* original = malloc(value_size);
+    cutil_btree* btree;
+
+    memcpy(original, field, value_size);
+    memcpy(field, value, value_size);
+    write_test_file(data, size);
+    memcpy(field, original, value_size);
+    free(original);
+
+    btree = cutil_btree_open_mapped(BTREE_FILE_TEST_PATH, cutil_trait_int(), cutil_trait_int());
+
+    if (btree) {
+        cutil_btree_destroy(btree);
+        return 0;
+    }
+
+    return 1;
+}
+
+/* files whose nodes do not form a tree holding the recorded number of items are rejected */
+void file_open_rejects_invalid_structure(btree_file_test* test) {
+    _btree_file_header* header;
+    _btree_file_node* root;
+    _btree_file_layout layout;
+    size_t size, *root_children, value;
+    unsigned int count;
+    char* data;
+
+    test->btree = create_file_test_tree(FILE_BTREE_ORDER, FILE_ITEM_COUNT, 3);
+    data = read_test_file(test->btree, &size);
+    CTEST_ASSERT_PTR_NOT_NULL(data);
+
+    header = (_btree_file_header*)data;
+    _btree_file_compute_layout(&layout, header->order, header->key_size, header->value_size);
+    root = (_btree_file_node*)(data + BTREE_FILE_PAGE_SIZE);
+    root_children = (size_t*)((char*)root + layout.branches_offset);
+
+    /* the unmodified file is valid */
+    write_test_file(data, size);
+    test->mapped_btree = cutil_btree_open_mapped(BTREE_FILE_TEST_PATH, cutil_trait_int(), cutil_trait_int());
+    CTEST_ASSERT_TRUE(file_tree_contains_sequence(test->mapped_btree, FILE_ITEM_COUNT, 3));
+
+    value = header->item_count + 1;
+    CTEST_EXPECT_TRUE(modified_file_rejected(data, size, &header->item_count, &value, sizeof(size_t)));
+
+    /* a child referenced by two nodes */
+    CTEST_EXPECT_TRUE(modified_file_rejected(data, size, &root_children[1], &root_children[0], sizeof(size_t)));
+
+    /* an empty interior node */
+    count = 0;
+    CTEST_EXPECT_TRUE(modified_file_rejected(data, size, &root->item_count, &count, sizeof(unsigned int)));
+
+    free(data);
+}
+
+typedef struct {
+    unsigned int item_count;
+    unsigned int is_leaf;
+    size_t children[2];
+} file_test_node;
+
+/* Writes a file with the supplied node structure.  Keys and values are left zeroed. */
+void write_structure_test_file(file_test_node* nodes, unsigned int node_count, size_t item_count) {
+    _btree_file_header* header;
+    _btree_file_layout layout;
+    unsigned int i;
+    size_t size;
+    char* data;
+
+    _btree_file_compute_layout(&layout, FILE_BTREE_ORDER, sizeof(int), sizeof(int));
+    size = BTREE_FILE_PAGE_SIZE + node_count * layout.record_size;
+    data = calloc(1, size);
+
+    header = (_btree_file_header*)data;
+    memcpy(header->magic, BTREE_FILE_MAGIC, sizeof(BTREE_FILE_MAGIC));
+    header->version = BTREE_FILE_VERSION;
+    header->header_size = sizeof(_btree_file_header);
+    header->order = FILE_BTREE_ORDER;
+    header->page_size = BTREE_FILE_PAGE_SIZE;
+    header->key_size = sizeof(int);
+    header->value_size = sizeof(int);
+    header->item_count = item_count;
+    header->node_count = node_count;
+    header->record_size = layout.record_size;
+
+    for (i = 0; i < node_count; i++) {
+        char* record = data + BTREE_FILE_PAGE_SIZE + i * layout.record_size;
+        _btree_file_node* node = (_btree_file_node*)record;
+
+        node->item_count = nodes[i].item_count;
+        node->is_leaf = nodes[i].is_leaf;
+        memcpy(record + layout.branches_offset, nodes[i].children, sizeof(nodes[i].children));
+    }
+
+    write_test_file(data, size);
+    free(data);
+}
+
+/* leaves at different depths are rejected */
+void file_open_rejects_unbalanced_tree(btree_file_test* test) {
+    file_test_node nodes[5] = {
+        {1, 0, {1, 2}},
+        {1, 1, {0, 0}},
+        {1, 0, {3, 4}},
+        {1, 1, {0, 0}},
+        {1, 1, {0, 0}}
+    };
+    (void)test;
+
+    write_structure_test_file(nodes, 5, 5);
+    CTEST_ASSERT_PTR_NULL(cutil_btree_open_mapped(BTREE_FILE_TEST_PATH, cutil_trait_int(), cutil_trait_int()));
+
+    /* the same nodes form a valid tree once the subtree is balanced */
+    nodes[2].is_leaf = 1;
+    write_structure_test_file(nodes, 3, 3);
+    test->mapped_btree = cutil_btree_open_mapped(BTREE_FILE_TEST_PATH, cutil_trait_int(), cutil_trait_int());
+    CTEST_ASSERT_PTR_NOT_NULL(test->mapped_btree);
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->mapped_btree), 3);
+}
+
+/* a chain of empty interior nodes deeper than an iterator can track is rejected */
+void file_open_rejects_deep_chain(btree_file_test* test) {
+    file_test_node nodes[CUTIL_BTREE_ITR_MAX_DEPTH + 8];
+    unsigned int i, node_count = CUTIL_BTREE_ITR_MAX_DEPTH + 8;
+    (void)test;
+
+    for (i = 0; i < node_count; i++) {
+        nodes[i].item_count = 0;
+        nodes[i].is_leaf = i == node_count - 1;
+        nodes[i].children[0] = i + 1;
+        nodes[i].children[1] = 0;
+    }
+
+    write_structure_test_file(nodes, node_count, 0);
+    CTEST_ASSERT_PTR_NULL(cutil_btree_open_mapped(BTREE_FILE_TEST_PATH, cutil_trait_int(), cutil_trait_int()));
+}
+
+void add_btree_file_tests() {
+    CTEST_ADD_TEST_F(btree_file, file_save_empty);
+    CTEST_ADD_TEST_F(btree_file, file_save_preserves_items);
+    CTEST_ADD_TEST_F(btree_file, file_save_large_order);
+    CTEST_ADD_TEST_F(btree_file, file_mapped_stats);
+    CTEST_ADD_TEST_F(btree_file, file_mapped_get);
+    CTEST_ADD_TEST_F(btree_file, file_mapped_is_read_only);
+    CTEST_ADD_TEST_F(btree_file, file_mapped_outlives_source);
+    CTEST_ADD_TEST_F(btree_file, file_save_rejects_owned_memory);
+    CTEST_ADD_TEST_F(btree_file, file_open_rejects_mismatched_traits);
+    CTEST_ADD_TEST_F(btree_file, file_open_rejects_invalid_file);
+    CTEST_ADD_TEST_F(btree_file, file_open_rejects_truncated_file);
+    CTEST_ADD_TEST_F(btree_file, file_open_rejects_invalid_structure);
+    CTEST_ADD_TEST_F(btree_file, file_open_rejects_unbalanced_tree);
+    CTEST_ADD_TEST_F(btree_file, file_open_rejects_deep_chain);
+}
@@ -5,6 +5,7 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <stdio.h>
 
 void btree_test_setup(btree_test* test) {
     memset(test, 0, sizeof(btree_test));
@@ -71,3 +72,72 @@ void btree_trait_func_test_teardown(btree_trait_func_test* test) {
 
     cutil_trait_destroy();
 }
+
+void btree_snapshot_test_setup(btree_snapshot_test* test) {
+    memset(test, 0, sizeof(btree_snapshot_test));
+}
+
+void btree_snapshot_test_teardown(btree_snapshot_test* test) {
+    if (test->snapshot) {
+        cutil_btree_destroy(test->snapshot);
+    }
+
+    if (test->btree) {
+        cutil_btree_destroy(test->btree);
+    }
+
+    cutil_trait_destroy();
+}
+
+void btree_file_test_setup(btree_file_test* test) {
+    memset(test, 0, sizeof(btree_file_test));
+}
+
+void btree_file_test_teardown(btree_file_test* test) {
+    if (test->mapped_btree) {
+        cutil_btree_destroy(test->mapped_btree);
+    }
+
+    if (test->btree) {
+        cutil_btree_destroy(test->btree);
+    }
+
+    remove(BTREE_FILE_TEST_PATH);
+    cutil_trait_destroy();
+}
+
+void btree_split_test_setup(btree_split_test* test) {
+    memset(test, 0, sizeof(btree_split_test));
+}
+
+void btree_split_test_teardown(btree_split_test* test) {
+    if (test->btree) {
+        cutil_btree_destroy(test->btree);
+    }
+
+    if (test->right) {
+        cutil_btree_destroy(test->right);
+    }
+
+    cutil_trait_destroy();
+}
+
+void btree_merge_test_setup(btree_merge_test* test) {
+    memset(test, 0, sizeof(btree_merge_test));
+}
+
+void btree_merge_test_teardown(btree_merge_test* test) {
+    if (test->a) {
+        cutil_btree_destroy(test->a);
+    }
+
+    if (test->b) {
+        cutil_btree_destroy(test->b);
+    }
+
+    if (test->result) {
+        cutil_btree_destroy(test->result);
+    }
+
+    cutil_trait_destroy();
+}
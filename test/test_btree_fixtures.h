@@ -41,4 +41,40 @@ typedef struct {
 void btree_trait_func_test_setup(btree_trait_func_test* test);
 void btree_trait_func_test_teardown(btree_trait_func_test* test);
 
+typedef struct {
+    cutil_btree* btree;
+    cutil_btree* snapshot;
+} btree_snapshot_test;
+
+void btree_snapshot_test_setup(btree_snapshot_test* test);
+void btree_snapshot_test_teardown(btree_snapshot_test* test);
+
+/* file written by the btree file tests, it is removed when each test completes */
+#define BTREE_FILE_TEST_PATH "cutil_test_btree_file.bin"
+
+typedef struct {
+    cutil_btree* btree;
+    cutil_btree* mapped_btree;
+} btree_file_test;
+
+void btree_file_test_setup(btree_file_test* test);
+void btree_file_test_teardown(btree_file_test* test);
+
+typedef struct {
+    cutil_btree* btree;
+    cutil_btree* right;
+} btree_split_test;
+
+void btree_split_test_setup(btree_split_test* test);
+void btree_split_test_teardown(btree_split_test* test);
+
+typedef struct {
+    cutil_btree* a;
+    cutil_btree* b;
+    cutil_btree* result;
+} btree_merge_test;
+
+void btree_merge_test_setup(btree_merge_test* test);
+void btree_merge_test_teardown(btree_merge_test* test);
+
 #endif
@@ -4,6 +4,7 @@
 #include "test_suites.h"
 
 #include "test_util/defs.h"
+#include "test_util/allocation_tracker.h"
 #include "test_btree_util.h"
 
 #include <stdlib.h>
@@ -193,9 +194,126 @@ void forward_ptr(btree_itr_ptr_test* test) {
     }
 }
 
+/* iterators initialized in caller provided storage do not allocate */
+void forward_init_no_allocation(btree_itr_test* test) {
+    cutil_btree_itr itr;
+    int i, key, value, expected_key = 0, failures = 0;
+    size_t allocation_count;
+
+    test->btree = cutil_btree_create(5, cutil_trait_int(), cutil_trait_int());
+
+    for (i = 0; i < 1000; i++) {
+        value = i * 10;
+        cutil_btree_insert(test->btree, &i, &value);
+    }
+
+    cutil_test_allocation_tracker_begin();
+    cutil_btree_itr_init(&itr, test->btree);
+
+    while (cutil_btree_itr_next(&itr)) {
+        cutil_btree_itr_get_key(&itr, &key);
+        cutil_btree_itr_get_value(&itr, &value);
+
+        failures += key != expected_key || value != key * 10;
+        expected_key += 1;
+    }
+
+    allocation_count = cutil_test_allocation_tracker_allocation_count();
+    cutil_test_allocation_tracker_end();
+
+    CTEST_ASSERT_INT_EQ(allocation_count, 0);
+    CTEST_ASSERT_INT_EQ(failures, 0);
+    CTEST_ASSERT_INT_EQ(expected_key, 1000);
+}
+
+/* checks that keys are visited in order with their values, stopping once the limit is reached */
+typedef struct {
+    int expected_key;
+    int limit;
+    int failures;
+} btree_foreach_visitor;
+
+int btree_foreach_visit(void* key, void* value, void* user_data) {
+    btree_foreach_visitor* visitor = (btree_foreach_visitor*)user_data;
+
+    visitor->failures += *(int*)key != visitor->expected_key || *(int*)value != *(int*)key * 10;
+    visitor->expected_key += 1;
+
+    return visitor->expected_key < visitor->limit;
+}
+
+void foreach_all(btree_itr_test* test) {
+    btree_foreach_visitor visitor;
+    int i, value;
+
+    test->btree = cutil_btree_create(5, cutil_trait_int(), cutil_trait_int());
+
+    visitor.expected_key = 0;
+    visitor.limit = 1000;
+    visitor.failures = 0;
+    CTEST_ASSERT_INT_EQ(cutil_btree_foreach(test->btree, btree_foreach_visit, &visitor), 0);
+
+    for (i = 999; i >= 0; i--) {
+        value = i * 10;
+        cutil_btree_insert(test->btree, &i, &value);
+    }
+
+    CTEST_ASSERT_INT_EQ(cutil_btree_foreach(test->btree, btree_foreach_visit, &visitor), 1000);
+    CTEST_ASSERT_INT_EQ(visitor.expected_key, 1000);
+    CTEST_ASSERT_INT_EQ(visitor.failures, 0);
+}
+
+/* the traversal stops at items held in both leaves and interior nodes */
+void foreach_early_exit(btree_itr_test* test) {
+    btree_foreach_visitor visitor;
+    int i, value, limit;
+
+    test->btree = cutil_btree_create(3, cutil_trait_int(), cutil_trait_int());
+
+    for (i = 0; i < 100; i++) {
+        value = i * 10;
+        cutil_btree_insert(test->btree, &i, &value);
+    }
+
+    for (limit = 1; limit <= 100; limit++) {
+        visitor.expected_key = 0;
+        visitor.limit = limit;
+        visitor.failures = 0;
+
+        CTEST_ASSERT_INT_EQ(cutil_btree_foreach(test->btree, btree_foreach_visit, &visitor), limit);
+        CTEST_ASSERT_INT_EQ(visitor.expected_key, limit);
+        CTEST_ASSERT_INT_EQ(visitor.failures, 0);
+    }
+}
+
+int btree_foreach_cstring_visit(void* key, void* value, void* user_data) {
+    char** expected_keys = (char**)user_data;
+    int index = *(int*)value;
+
+    return strcmp(*(char**)key, expected_keys[index]) == 0;
+}
+
+void foreach_cstring(btree_itr_cstring_test* test) {
+    char* keys[3] = {"apple", "banana", "cherry"};
+    int i;
+
+    test->base.btree = cutil_btree_create(5, cutil_trait_cstring(), cutil_trait_int());
+
+    for (i = 2; i >= 0; i--) {
+        cutil_btree_insert(test->base.btree, &keys[i], &i);
+    }
+
+    CTEST_ASSERT_INT_EQ(cutil_btree_foreach(test->base.btree, btree_foreach_cstring_visit, keys), 3);
+}
+
 void add_btree_itr_tests() {
     CTEST_ADD_TEST_F(btree_itr, forward_empty);
     CTEST_ADD_TEST_F(btree_itr, forward_pod);
+    CTEST_ADD_TEST_F(btree_itr, forward_init_no_allocation);
     CTEST_ADD_TEST_F(btree_itr_cstring, forward_cstring);
     CTEST_ADD_TEST_F(btree_itr_ptr, forward_ptr);
+
+    CTEST_ADD_TEST_F(btree_itr, foreach_all);
+    CTEST_ADD_TEST_F(btree_itr, foreach_early_exit);
+    CTEST_ADD_TEST_F(btree_itr_cstring, foreach_cstring);
 }
@@ -0,0 +1,267 @@
+#include "cutil/btree.h"
+
+#include "ctest/ctest.h"
+#include "test_suites.h"
+
+#include "test_btree_util.h"
+#include "test_btree_fixtures.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#define MERGE_BTREE_ORDER 5
+
+/* tree a holds the multiples of 2 less than 2000 and tree b holds the multiples of 3 less than 3000 */
+#define MERGE_A_LIMIT 2000
+#define MERGE_B_LIMIT 3000
+
+CTEST_FIXTURE(btree_merge, btree_merge_test, btree_merge_test_setup, btree_merge_test_teardown)
+
+/* Determines if a key is expected in a result and the value it should have */
+typedef int (*merge_expected_func)(int key, int* value);
+
+/* Creates a btree holding the multiples of the step less than the limit with each value equal to the key multiplied by the supplied factor */
+cutil_btree* create_merge_test_tree(unsigned int order, int step, int limit, int factor) {
+    cutil_btree* btree = cutil_btree_create(order, cutil_trait_int(), cutil_trait_int());
+    int i, value;
+
+    for (i = 0; i < limit; i += step) {
+        value = i * factor;
+        cutil_btree_insert(btree, &i, &value);
+    }
+
+    return btree;
+}
+
+int in_a(int key) {
+    return key % 2 == 0 && key < MERGE_A_LIMIT;
+}
+
+int in_b(int key) {
+    return key % 3 == 0 && key < MERGE_B_LIMIT;
+}
+
+int expected_union(int key, int* value) {
+    *value = in_b(key) ? key * 10 : key;
+    return in_a(key) || in_b(key);
+}
+
+int expected_union_sum(int key, int* value) {
+    *value = (in_a(key) ? key : 0) + (in_b(key) ? key * 10 : 0);
+    return in_a(key) || in_b(key);
+}
+
+int expected_intersection(int key, int* value) {
+    *value = key * 10;
+    return in_a(key) && in_b(key);
+}
+
+int expected_difference(int key, int* value) {
+    *value = key;
+    return in_a(key) && !in_b(key);
+}
+
+void merge_sum(void* value, void* other_value, void* user_data) {
+    *(int*)value += *(int*)other_value;
+    *(int*)user_data += 1;
+}
+
+/* Checks that a btree is valid and holds exactly the expected items for keys less than the limit */
+int merge_tree_matches(cutil_btree* btree, int limit, merge_expected_func expected_func) {
+    cutil_btree_itr* itr;
+    int key, value, expected_value, expected_key = -1, ok = 1;
+    size_t expected_size = 0;
+
+    if (btree == NULL || !validate_btree(btree) || !validate_btree_balance(btree)) {
+        return 0;
+    }
+
+    for (key = 0; key < limit; key++) {
+        expected_size += expected_func(key, &expected_value);
+    }
+
+    if (cutil_btree_size(btree) != expected_size) {
+        return 0;
+    }
+
+    itr = cutil_btree_itr_create(btree);
+
+    while (ok && cutil_btree_itr_next(itr)) {
+        do {
+            expected_key += 1;
+        } while (expected_key < limit && !expected_func(expected_key, &expected_value));
+
+        cutil_btree_itr_get_key(itr, &key);
+        cutil_btree_itr_get_value(itr, &value);
+
+        ok = key == expected_key && value == expected_value;
+    }
+
+    cutil_btree_itr_destroy(itr);
+
+    return ok;
+}
+
+void create_merge_trees(btree_merge_test* test) {
+    test->a = create_merge_test_tree(MERGE_BTREE_ORDER, 2, MERGE_A_LIMIT, 1);
+    test->b = create_merge_test_tree(MERGE_BTREE_ORDER, 3, MERGE_B_LIMIT, 10);
+}
+
+void btree_merge_union(btree_merge_test* test) {
+    create_merge_trees(test);
+    test->result = cutil_btree_union(test->a, test->b, NULL, NULL);
+
+    CTEST_ASSERT_INT_EQ(cutil_btree_get_order(test->result), MERGE_BTREE_ORDER);
+    CTEST_ASSERT_TRUE(merge_tree_matches(test->result, MERGE_B_LIMIT, expected_union));
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->a), MERGE_A_LIMIT / 2);
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->b), MERGE_B_LIMIT / 3);
+}
+
+void btree_merge_union_merge_func(btree_merge_test* test) {
+    int merge_count = 0;
+
+    create_merge_trees(test);
+    test->result = cutil_btree_union(test->a, test->b, merge_sum, &merge_count);
+
+    CTEST_ASSERT_TRUE(merge_tree_matches(test->result, MERGE_B_LIMIT, expected_union_sum));
+    CTEST_ASSERT_INT_EQ(merge_count, (MERGE_A_LIMIT + 5) / 6);
+}
+
+void btree_merge_intersection(btree_merge_test* test) {
+    create_merge_trees(test);
+    test->result = cutil_btree_intersection(test->a, test->b, NULL, NULL);
+
+    CTEST_ASSERT_TRUE(merge_tree_matches(test->result, MERGE_B_LIMIT, expected_intersection));
+}
+
+void btree_merge_difference(btree_merge_test* test) {
+    create_merge_trees(test);
+    test->result = cutil_btree_difference(test->a, test->b);
+
+    CTEST_ASSERT_TRUE(merge_tree_matches(test->result, MERGE_B_LIMIT, expected_difference));
+}
+
+void btree_merge_into_dest(btree_merge_test* test) {
+    int merge_count = 0;
+    cutil_btree* snapshot;
+
+    create_merge_trees(test);
+    snapshot = cutil_btree_snapshot(test->a);
+
+    CTEST_ASSERT_TRUE(cutil_btree_merge(test->a, test->b, merge_sum, &merge_count));
+    CTEST_ASSERT_TRUE(merge_tree_matches(test->a, MERGE_B_LIMIT, expected_union_sum));
+    CTEST_ASSERT_FALSE(cutil_btree_merge(snapshot, test->b, NULL, NULL));
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(snapshot), MERGE_A_LIMIT / 2);
+
+    cutil_btree_destroy(snapshot);
+}
+
+void btree_merge_empty(btree_merge_test* test) {
+    test->a = cutil_btree_create(MERGE_BTREE_ORDER, cutil_trait_int(), cutil_trait_int());
+    test->b = create_merge_test_tree(MERGE_BTREE_ORDER, 3, MERGE_B_LIMIT, 10);
+
+    test->result = cutil_btree_intersection(test->a, test->b, NULL, NULL);
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->result), 0);
+    CTEST_ASSERT_TRUE(validate_btree_balance(test->result));
+
+    CTEST_ASSERT_TRUE(cutil_btree_merge(test->a, test->b, NULL, NULL));
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->a), MERGE_B_LIMIT / 3);
+    CTEST_ASSERT_TRUE(validate_btree_balance(test->a));
+}
+
+/* results of every size up to several levels are built for each small order, covering the repair of the right border */
+void btree_merge_all_sizes(btree_merge_test* test) {
+    unsigned int order;
+    int count, failures = 0;
+
+    for (order = 3; order <= 6; order++) {
+        for (count = 0; count < 200; count++) {
+            test->a = create_merge_test_tree(order, 1, count, 1);
+            test->b = cutil_btree_create(order, cutil_trait_int(), cutil_trait_int());
+            test->result = cutil_btree_union(test->a, test->b, NULL, NULL);
+
+            if (cutil_btree_size(test->result) != (size_t)count || !validate_btree(test->result) || !validate_btree_balance(test->result)) {
+                failures += 1;
+            }
+
+            cutil_btree_destroy(test->a);
+            cutil_btree_destroy(test->b);
+            cutil_btree_destroy(test->result);
+            test->a = test->b = test->result = NULL;
+        }
+    }
+
+    CTEST_ASSERT_INT_EQ(failures, 0);
+}
+
+void btree_merge_result_is_modifiable(btree_merge_test* test) {
+    int i, value, expected_size = 0;
+
+    create_merge_trees(test);
+    test->result = cutil_btree_difference(test->a, test->b);
+
+    for (i = 0; i < MERGE_A_LIMIT; i++) {
+        if (i % 2 == 0 && i % 3 == 0) {
+            value = i;
+            cutil_btree_insert(test->result, &i, &value);
+        }
+        else if (i % 4 == 0) {
+            cutil_btree_erase(test->result, &i);
+        }
+
+        expected_size += i % 2 == 0 && (i % 4 != 0 || i % 3 == 0);
+    }
+
+    CTEST_ASSERT_TRUE(validate_btree(test->result));
+    CTEST_ASSERT_TRUE(validate_btree_balance(test->result));
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->result), expected_size);
+}
+
+void btree_merge_copies_items(btree_merge_test* test) {
+    char key[16];
+    char* key_ptr = key;
+    int i;
+
+    test->a = cutil_btree_create(MERGE_BTREE_ORDER, cutil_trait_cstring(), cutil_trait_int());
+    test->b = cutil_btree_create(MERGE_BTREE_ORDER, cutil_trait_cstring(), cutil_trait_int());
+
+    for (i = 0; i < 500; i++) {
+        sprintf(key, "key%04d", i);
+        cutil_btree_insert(i % 2 ? test->a : test->b, &key_ptr, &i);
+    }
+
+    test->result = cutil_btree_union(test->a, test->b, NULL, NULL);
+    CTEST_ASSERT_TRUE(validate_btree_balance(test->result));
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->result), 500);
+
+    cutil_btree_destroy(test->a);
+    test->a = NULL;
+
+    key_ptr = "key0123";
+    CTEST_ASSERT_TRUE(cutil_btree_get(test->result, &key_ptr, &i));
+    CTEST_ASSERT_INT_EQ(i, 123);
+}
+
+void btree_merge_mismatched_traits(btree_merge_test* test) {
+    test->a = cutil_btree_create(MERGE_BTREE_ORDER, cutil_trait_int(), cutil_trait_int());
+    test->b = cutil_btree_create(MERGE_BTREE_ORDER, cutil_trait_int(), cutil_trait_float());
+
+    CTEST_ASSERT_TRUE(cutil_btree_union(test->a, test->b, NULL, NULL) == NULL);
+    CTEST_ASSERT_TRUE(cutil_btree_intersection(test->a, test->b, NULL, NULL) == NULL);
+    CTEST_ASSERT_TRUE(cutil_btree_difference(test->a, test->b) == NULL);
+    CTEST_ASSERT_FALSE(cutil_btree_merge(test->a, test->b, NULL, NULL));
+}
+
+void add_btree_merge_tests() {
+    CTEST_ADD_TEST_F(btree_merge, btree_merge_union);
+    CTEST_ADD_TEST_F(btree_merge, btree_merge_union_merge_func);
+    CTEST_ADD_TEST_F(btree_merge, btree_merge_intersection);
+    CTEST_ADD_TEST_F(btree_merge, btree_merge_difference);
+    CTEST_ADD_TEST_F(btree_merge, btree_merge_into_dest);
+    CTEST_ADD_TEST_F(btree_merge, btree_merge_empty);
+    CTEST_ADD_TEST_F(btree_merge, btree_merge_all_sizes);
+    CTEST_ADD_TEST_F(btree_merge, btree_merge_result_is_modifiable);
+    CTEST_ADD_TEST_F(btree_merge, btree_merge_copies_items);
+    CTEST_ADD_TEST_F(btree_merge, btree_merge_mismatched_traits);
+}
@@ -0,0 +1,154 @@
+#include "cutil/btree.h"
+#include "btree_private.h"
+
+#include "ctest/ctest.h"
+#include "test_suites.h"
+
+#include "test_btree_util.h"
+#include "test_btree_fixtures.h"
+
+#include <stdio.h>
+
+#define PAGE_SIZE_COUNT 4
+#define PAGE_ITEM_COUNT 5000
+
+CTEST_FIXTURE(btree_page, btree_test, btree_test_setup, btree_test_teardown)
+
+/* Checks that the order of a btree is the largest whose nodes fit in the page */
+int page_order_is_largest(cutil_btree* btree, size_t page_bytes) {
+    _btree_node_layout layout;
+
+    _btree_node_layout_init(&layout, btree->order, btree->key_trait->size, btree->value_trait->size, btree->key_prefixes, 0);
+
+    if (layout.size > page_bytes) {
+        return 0;
+    }
+
+    _btree_node_layout_init(&layout, btree->order + 1, btree->key_trait->size, btree->value_trait->size, btree->key_prefixes, 0);
+
+    return layout.size > page_bytes;
+}
+
+/* Checks that every node in the subtree is cache line aligned and that its arrays lie within its block */
+int page_nodes_aligned(cutil_btree* btree, _btree_node* node) {
+    char* block = (char*)node;
+    char* block_end = block + btree->node_layout.size;
+    unsigned int i;
+
+    if ((size_t)node % BTREE_NODE_ALIGNMENT != 0) {
+        return 0;
+    }
+
+    if ((char*)node->keys < block || (char*)node->branches + btree->order * sizeof(_btree_node*) > block_end) {
+        return 0;
+    }
+
+    if (node->key_prefixes && (char*)node->key_prefixes + (btree->order - 1) * BTREE_KEY_PREFIX_SIZE > block_end) {
+        return 0;
+    }
+
+    if (_node_is_leaf(node)) {
+        return 1;
+    }
+
+    for (i = 0; i <= node->item_count; i++) {
+        if (!page_nodes_aligned(btree, node->branches[i])) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+void btree_page_order(btree_test* test) {
+    size_t page_sizes[PAGE_SIZE_COUNT] = {192, 256, 1024, 4096};
+    unsigned int previous_order = 0;
+    int i;
+
+    for (i = 0; i < PAGE_SIZE_COUNT; i++) {
+        test->btree = cutil_btree_create_for_page(page_sizes[i], cutil_trait_int(), cutil_trait_int());
+
+        CTEST_ASSERT_PTR_NOT_NULL(test->btree);
+        CTEST_ASSERT_TRUE(page_order_is_largest(test->btree, page_sizes[i]));
+        CTEST_ASSERT_TRUE(cutil_btree_get_order(test->btree) > previous_order);
+
+        previous_order = cutil_btree_get_order(test->btree);
+        cutil_btree_destroy(test->btree);
+    }
+
+    test->btree = NULL;
+}
+
+/* larger keys and values leave room for fewer items in the same page */
+void btree_page_item_size(btree_test* test) {
+    cutil_btree* pointer_btree = cutil_btree_create_for_page(4096, cutil_trait_ptr(), cutil_trait_ptr());
+
+    test->btree = cutil_btree_create_for_page(4096, cutil_trait_int(), cutil_trait_int());
+
+    CTEST_ASSERT_TRUE(page_order_is_largest(pointer_btree, 4096));
+    CTEST_ASSERT_TRUE(cutil_btree_get_order(pointer_btree) < cutil_btree_get_order(test->btree));
+
+    cutil_btree_destroy(pointer_btree);
+}
+
+void btree_page_too_small(btree_test* test) {
+    (void)test;
+
+    CTEST_ASSERT_PTR_NULL(cutil_btree_create_for_page(64, cutil_trait_int(), cutil_trait_int()));
+    CTEST_ASSERT_PTR_NULL(cutil_btree_create_for_page(0, cutil_trait_int(), cutil_trait_int()));
+    CTEST_ASSERT_PTR_NULL(cutil_btree_create_for_page(4096, NULL, cutil_trait_int()));
+    CTEST_ASSERT_PTR_NULL(cutil_btree_create_for_page(4096, cutil_trait_int(), NULL));
+}
+
+void btree_page_nodes_aligned(btree_test* test) {
+    int i;
+
+    test->btree = cutil_btree_create_for_page(256, cutil_trait_int(), cutil_trait_int());
+
+    for (i = 0; i < PAGE_ITEM_COUNT; i++) {
+        cutil_btree_insert(test->btree, &i, &i);
+    }
+
+    CTEST_ASSERT_TRUE(validate_btree(test->btree));
+    CTEST_ASSERT_TRUE(page_nodes_aligned(test->btree, test->btree->root));
+
+    for (i = 0; i < PAGE_ITEM_COUNT; i += 2) {
+        cutil_btree_erase(test->btree, &i);
+    }
+
+    CTEST_ASSERT_TRUE(validate_btree(test->btree));
+    CTEST_ASSERT_TRUE(page_nodes_aligned(test->btree, test->btree->root));
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->btree), PAGE_ITEM_COUNT / 2);
+}
+
+/* the key prefixes of string keyed btrees are held in the node block and count towards the page */
+void btree_page_string_keys(btree_test* test) {
+    char key[16];
+    char* key_ptr = key;
+    int i, value;
+
+    test->btree = cutil_btree_create_for_page(4096, cutil_trait_cstring(), cutil_trait_int());
+    CTEST_ASSERT_TRUE(page_order_is_largest(test->btree, 4096));
+
+    for (i = 0; i < PAGE_ITEM_COUNT; i++) {
+        sprintf(key, "key%05d", i);
+        cutil_btree_insert(test->btree, &key_ptr, &i);
+    }
+
+    CTEST_ASSERT_TRUE(validate_btree_balance(test->btree));
+    CTEST_ASSERT_TRUE(page_nodes_aligned(test->btree, test->btree->root));
+
+    for (i = 0; i < PAGE_ITEM_COUNT; i++) {
+        sprintf(key, "key%05d", i);
+        CTEST_ASSERT_TRUE(cutil_btree_get(test->btree, &key_ptr, &value));
+        CTEST_ASSERT_INT_EQ(value, i);
+    }
+}
+
+void add_btree_page_tests() {
+    CTEST_ADD_TEST_F(btree_page, btree_page_order);
+    CTEST_ADD_TEST_F(btree_page, btree_page_item_size);
+    CTEST_ADD_TEST_F(btree_page, btree_page_too_small);
+    CTEST_ADD_TEST_F(btree_page, btree_page_nodes_aligned);
+    CTEST_ADD_TEST_F(btree_page, btree_page_string_keys);
+}
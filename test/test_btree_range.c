@@ -0,0 +1,378 @@
+#include "cutil/btree.h"
+
+#include "ctest/ctest.h"
+#include "test_suites.h"
+
+#include "test_btree_util.h"
+#include "test_btree_fixtures.h"
+#include "test_util/trait_tracker.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#define RANGE_BTREE_ORDER 5
+#define RANGE_ITEM_COUNT 1000
+
+CTEST_FIXTURE(btree_range, btree_test, btree_test_setup, btree_test_teardown)
+
+/* Creates a btree containing the keys [0, count) with each value equal to twice the key */
+cutil_btree* create_range_test_tree(unsigned int order, int count) {
+    cutil_btree* btree = cutil_btree_create(order, cutil_trait_int(), cutil_trait_int());
+    int i, value;
+
+    for (i = 0; i < count; i++) {
+        value = i * 2;
+        cutil_btree_insert(btree, &i, &value);
+    }
+
+    return btree;
+}
+
+/* Checks that a btree contains exactly the keys [0, count) which are outside of [lo, hi] */
+int range_tree_contains_remainder(cutil_btree* btree, int count, int lo, int hi) {
+    cutil_btree_itr* itr = cutil_btree_itr_create(btree);
+    int key, value, expected_key = 0, expected_size = 0, ok = 1;
+
+    for (key = 0; key < count; key++) {
+        expected_size += key < lo || key > hi;
+    }
+
+    if (cutil_btree_size(btree) != (size_t)expected_size) {
+        ok = 0;
+    }
+
+    while (ok && cutil_btree_itr_next(itr)) {
+        if (expected_key >= lo && expected_key <= hi) {
+            expected_key = hi + 1;
+        }
+
+        cutil_btree_itr_get_key(itr, &key);
+        cutil_btree_itr_get_value(itr, &value);
+
+        ok = key == expected_key && value == key * 2;
+        expected_key += 1;
+    }
+
+    cutil_btree_itr_destroy(itr);
+
+    if (expected_key >= lo && expected_key <= hi) {
+        expected_key = hi + 1;
+    }
+
+    return ok && expected_key >= count;
+}
+
+void btree_erase_range_middle(btree_test* test) {
+    int lo = 200, hi = 699;
+    test->btree = create_range_test_tree(RANGE_BTREE_ORDER, RANGE_ITEM_COUNT);
+
+    CTEST_ASSERT_INT_EQ(cutil_btree_erase_range(test->btree, &lo, &hi), 500);
+    CTEST_ASSERT_TRUE(validate_btree_balance(test->btree));
+    CTEST_ASSERT_TRUE(range_tree_contains_remainder(test->btree, RANGE_ITEM_COUNT, lo, hi));
+    CTEST_ASSERT_FALSE(cutil_btree_contains(test->btree, &lo));
+    CTEST_ASSERT_FALSE(cutil_btree_contains(test->btree, &hi));
+}
+
+void btree_erase_range_unbounded(btree_test* test) {
+    int lo = 900, hi = 99;
+    test->btree = create_range_test_tree(RANGE_BTREE_ORDER, RANGE_ITEM_COUNT);
+
+    CTEST_ASSERT_INT_EQ(cutil_btree_erase_range(test->btree, NULL, &hi), 100);
+    CTEST_ASSERT_TRUE(validate_btree_balance(test->btree));
+    CTEST_ASSERT_TRUE(range_tree_contains_remainder(test->btree, RANGE_ITEM_COUNT, 0, hi));
+
+    CTEST_ASSERT_INT_EQ(cutil_btree_erase_range(test->btree, &lo, NULL), 100);
+    CTEST_ASSERT_TRUE(validate_btree_balance(test->btree));
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->btree), 800);
+
+    CTEST_ASSERT_INT_EQ(cutil_btree_erase_range(test->btree, NULL, NULL), 800);
+    CTEST_ASSERT_TRUE(validate_btree_balance(test->btree));
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->btree), 0);
+}
+
+void btree_erase_range_no_items(btree_test* test) {
+    int lo = 10, hi = 5;
+    test->btree = create_range_test_tree(RANGE_BTREE_ORDER, RANGE_ITEM_COUNT);
+
+    CTEST_ASSERT_INT_EQ(cutil_btree_erase_range(test->btree, &lo, &hi), 0);
+
+    lo = RANGE_ITEM_COUNT;
+    hi = RANGE_ITEM_COUNT * 2;
+    CTEST_ASSERT_INT_EQ(cutil_btree_erase_range(test->btree, &lo, &hi), 0);
+    CTEST_ASSERT_TRUE(validate_btree_balance(test->btree));
+    CTEST_ASSERT_TRUE(range_tree_contains_remainder(test->btree, RANGE_ITEM_COUNT, lo, hi));
+}
+
+/* every range of small trees of several orders is erased, covering each way the border nodes can be repaired */
+void btree_erase_range_all_ranges(btree_test* test) {
+    unsigned int order;
+    int count = 40, lo, hi, failures = 0;
+
+    for (order = 3; order <= 6; order++) {
+        for (lo = -1; lo <= count; lo++) {
+            for (hi = lo; hi <= count; hi++) {
+                size_t expected_count = (size_t)((hi < count - 1 ? hi : count - 1) - (lo > 0 ? lo : 0) + 1);
+
+                test->btree = create_range_test_tree(order, count);
+
+                if (cutil_btree_erase_range(test->btree, &lo, &hi) != expected_count ||
+                    !validate_btree_balance(test->btree) ||
+                    !range_tree_contains_remainder(test->btree, count, lo, hi)) {
+                    failures += 1;
+                }
+
+                cutil_btree_destroy(test->btree);
+                test->btree = NULL;
+            }
+        }
+    }
+
+    CTEST_ASSERT_INT_EQ(failures, 0);
+}
+
+void btree_erase_range_then_modify(btree_test* test) {
+    int lo = 100, hi = 899, i, value;
+    test->btree = create_range_test_tree(4, RANGE_ITEM_COUNT);
+
+    cutil_btree_erase_range(test->btree, &lo, &hi);
+
+    for (i = lo; i <= hi; i++) {
+        value = i * 2;
+        cutil_btree_insert(test->btree, &i, &value);
+    }
+
+    CTEST_ASSERT_TRUE(validate_btree_balance(test->btree));
+    CTEST_ASSERT_TRUE(range_tree_contains_remainder(test->btree, RANGE_ITEM_COUNT, RANGE_ITEM_COUNT, RANGE_ITEM_COUNT));
+
+    for (i = 0; i < RANGE_ITEM_COUNT; i += 2) {
+        cutil_btree_erase(test->btree, &i);
+    }
+
+    CTEST_ASSERT_TRUE(validate_btree_balance(test->btree));
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->btree), RANGE_ITEM_COUNT / 2);
+}
+
+void btree_erase_range_destroys_items(btree_test* test) {
+    cutil_trait* key_trait = cutil_test_create_trait_tracker(cutil_trait_cstring());
+    char key[16];
+    char* key_ptr = key;
+    char* lo = "key0250";
+    char* hi = "key0749";
+    int i;
+
+    test->btree = cutil_btree_create(RANGE_BTREE_ORDER, key_trait, cutil_trait_int());
+
+    for (i = 0; i < RANGE_ITEM_COUNT; i++) {
+        sprintf(key, "key%04d", i);
+        cutil_btree_insert(test->btree, &key_ptr, &i);
+    }
+
+    cutil_test_trait_tracker_reset_counts(key_trait);
+
+    CTEST_ASSERT_INT_EQ(cutil_btree_erase_range(test->btree, &lo, &hi), 500);
+    CTEST_ASSERT_INT_EQ(cutil_test_trait_tracker_destroy_count(key_trait), 500);
+    CTEST_ASSERT_TRUE(validate_btree_balance(test->btree));
+    CTEST_ASSERT_FALSE(cutil_btree_contains(test->btree, &lo));
+    CTEST_ASSERT_FALSE(cutil_btree_contains(test->btree, &hi));
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->btree), RANGE_ITEM_COUNT - 500);
+
+    cutil_btree_destroy(test->btree);
+    test->btree = NULL;
+
+    cutil_test_destroy_trait_tracker(key_trait);
+}
+
+void btree_erase_range_preserves_snapshot(btree_test* test) {
+    int lo = 100, hi = 899;
+    cutil_btree* snapshot;
+    test->btree = create_range_test_tree(RANGE_BTREE_ORDER, RANGE_ITEM_COUNT);
+    snapshot = cutil_btree_snapshot(test->btree);
+
+    CTEST_ASSERT_INT_EQ(cutil_btree_erase_range(snapshot, &lo, &hi), 0);
+    CTEST_ASSERT_INT_EQ(cutil_btree_erase_range(test->btree, &lo, &hi), 800);
+
+    CTEST_ASSERT_TRUE(validate_btree_balance(test->btree));
+    CTEST_ASSERT_TRUE(range_tree_contains_remainder(test->btree, RANGE_ITEM_COUNT, lo, hi));
+    CTEST_ASSERT_TRUE(range_tree_contains_remainder(snapshot, RANGE_ITEM_COUNT, RANGE_ITEM_COUNT, RANGE_ITEM_COUNT));
+
+    cutil_btree_destroy(snapshot);
+}
+
+void btree_erase_range_concurrent(btree_test* test) {
+    int lo = 0, hi = 10, value = 0;
+    test->btree = cutil_btree_create_concurrent(RANGE_BTREE_ORDER, cutil_trait_int(), cutil_trait_int());
+    cutil_btree_insert(test->btree, &lo, &value);
+
+    CTEST_ASSERT_INT_EQ(cutil_btree_erase_range(test->btree, &lo, &hi), 0);
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->btree), 1);
+}
+
+CTEST_FIXTURE(btree_split, btree_split_test, btree_split_test_setup, btree_split_test_teardown)
+
+void btree_split_middle(btree_split_test* test) {
+    int key = 400;
+    test->btree = create_range_test_tree(RANGE_BTREE_ORDER, RANGE_ITEM_COUNT);
+
+    CTEST_ASSERT_TRUE(cutil_btree_split(test->btree, &key, &test->right));
+    CTEST_ASSERT_TRUE(validate_btree(test->btree) && validate_btree_balance(test->btree));
+    CTEST_ASSERT_TRUE(validate_btree(test->right) && validate_btree_balance(test->right));
+    CTEST_ASSERT_TRUE(range_tree_contains_remainder(test->btree, RANGE_ITEM_COUNT, key, RANGE_ITEM_COUNT));
+    CTEST_ASSERT_TRUE(range_tree_contains_remainder(test->right, RANGE_ITEM_COUNT, 0, key - 1));
+    CTEST_ASSERT_INT_EQ(cutil_btree_get_order(test->right), RANGE_BTREE_ORDER);
+}
+
+void btree_split_outside_keys(btree_split_test* test) {
+    int key = -1;
+    test->btree = create_range_test_tree(RANGE_BTREE_ORDER, RANGE_ITEM_COUNT);
+
+    CTEST_ASSERT_TRUE(cutil_btree_split(test->btree, &key, &test->right));
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->btree), 0);
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->right), RANGE_ITEM_COUNT);
+    CTEST_ASSERT_TRUE(validate_btree_balance(test->btree));
+    CTEST_ASSERT_TRUE(validate_btree_balance(test->right));
+
+    /* moving the items back leaves the split tree empty */
+    CTEST_ASSERT_TRUE(cutil_btree_join(test->btree, test->right));
+    cutil_btree_destroy(test->right);
+
+    key = RANGE_ITEM_COUNT;
+    CTEST_ASSERT_TRUE(cutil_btree_split(test->btree, &key, &test->right));
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->btree), RANGE_ITEM_COUNT);
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->right), 0);
+    CTEST_ASSERT_TRUE(range_tree_contains_remainder(test->btree, RANGE_ITEM_COUNT, key, key));
+}
+
+/* every split point of small trees of several orders is tested, followed by joining the two halves back together */
+void btree_split_join_all_keys(btree_split_test* test) {
+    unsigned int order;
+    int count = 60, key, failures = 0;
+
+    for (order = 3; order <= 6; order++) {
+        for (key = 0; key <= count; key++) {
+            test->btree = create_range_test_tree(order, count);
+
+            if (!cutil_btree_split(test->btree, &key, &test->right) ||
+                !validate_btree_balance(test->btree) || !validate_btree_balance(test->right) ||
+                !range_tree_contains_remainder(test->btree, count, key, count) ||
+                !range_tree_contains_remainder(test->right, count, 0, key - 1)) {
+                failures += 1;
+            }
+
+            if (!cutil_btree_join(test->btree, test->right) ||
+                !validate_btree(test->btree) || !validate_btree_balance(test->btree) ||
+                !range_tree_contains_remainder(test->btree, count, count, count) ||
+                cutil_btree_size(test->right) != 0) {
+                failures += 1;
+            }
+
+            cutil_btree_destroy(test->btree);
+            cutil_btree_destroy(test->right);
+            test->btree = test->right = NULL;
+        }
+    }
+
+    CTEST_ASSERT_INT_EQ(failures, 0);
+}
+
+/* trees of very different heights are joined in both directions */
+void btree_join_different_heights(btree_split_test* test) {
+    int i, value, small_count;
+
+    for (small_count = 0; small_count < 20; small_count++) {
+        test->btree = create_range_test_tree(3, small_count);
+        test->right = cutil_btree_create(3, cutil_trait_int(), cutil_trait_int());
+
+        for (i = small_count; i < RANGE_ITEM_COUNT; i++) {
+            value = i * 2;
+            cutil_btree_insert(test->right, &i, &value);
+        }
+
+        CTEST_ASSERT_TRUE(cutil_btree_join(test->btree, test->right));
+        CTEST_ASSERT_TRUE(validate_btree(test->btree) && validate_btree_balance(test->btree));
+        CTEST_ASSERT_TRUE(range_tree_contains_remainder(test->btree, RANGE_ITEM_COUNT, RANGE_ITEM_COUNT, RANGE_ITEM_COUNT));
+
+        cutil_btree_destroy(test->right);
+        test->right = create_range_test_tree(3, 0);
+
+        for (i = RANGE_ITEM_COUNT; i < RANGE_ITEM_COUNT + small_count; i++) {
+            value = i * 2;
+            cutil_btree_insert(test->right, &i, &value);
+        }
+
+        CTEST_ASSERT_TRUE(cutil_btree_join(test->btree, test->right));
+        CTEST_ASSERT_TRUE(validate_btree(test->btree) && validate_btree_balance(test->btree));
+        CTEST_ASSERT_TRUE(range_tree_contains_remainder(test->btree, RANGE_ITEM_COUNT + small_count, RANGE_ITEM_COUNT + small_count, RANGE_ITEM_COUNT + small_count));
+
+        cutil_btree_destroy(test->btree);
+        cutil_btree_destroy(test->right);
+        test->btree = test->right = NULL;
+    }
+}
+
+void btree_join_rejects_overlap(btree_split_test* test) {
+    int key = 500, value = 0;
+    test->btree = create_range_test_tree(RANGE_BTREE_ORDER, RANGE_ITEM_COUNT);
+    test->right = cutil_btree_create(RANGE_BTREE_ORDER, cutil_trait_int(), cutil_trait_int());
+
+    cutil_btree_insert(test->right, &key, &value);
+    CTEST_ASSERT_FALSE(cutil_btree_join(test->btree, test->right));
+
+    key = RANGE_ITEM_COUNT - 1;
+    cutil_btree_clear(test->right);
+    cutil_btree_insert(test->right, &key, &value);
+    CTEST_ASSERT_FALSE(cutil_btree_join(test->btree, test->right));
+    CTEST_ASSERT_FALSE(cutil_btree_join(test->btree, test->btree));
+
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->btree), RANGE_ITEM_COUNT);
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->right), 1);
+}
+
+void btree_join_rejects_mismatched_trees(btree_split_test* test) {
+    test->btree = create_range_test_tree(RANGE_BTREE_ORDER, 10);
+    test->right = create_range_test_tree(RANGE_BTREE_ORDER + 1, 0);
+    CTEST_ASSERT_FALSE(cutil_btree_join(test->btree, test->right));
+
+    cutil_btree_destroy(test->right);
+    test->right = cutil_btree_create(RANGE_BTREE_ORDER, cutil_trait_int(), cutil_trait_float());
+    CTEST_ASSERT_FALSE(cutil_btree_join(test->btree, test->right));
+}
+
+void btree_split_join_preserve_snapshots(btree_split_test* test) {
+    int key = 300;
+    cutil_btree *snapshot, *right_snapshot;
+    test->btree = create_range_test_tree(RANGE_BTREE_ORDER, RANGE_ITEM_COUNT);
+    snapshot = cutil_btree_snapshot(test->btree);
+
+    CTEST_ASSERT_FALSE(cutil_btree_split(snapshot, &key, &test->right));
+    CTEST_ASSERT_TRUE(cutil_btree_split(test->btree, &key, &test->right));
+    right_snapshot = cutil_btree_snapshot(test->right);
+
+    CTEST_ASSERT_TRUE(cutil_btree_join(test->btree, test->right));
+    cutil_btree_erase_range(test->btree, NULL, NULL);
+
+    CTEST_ASSERT_TRUE(range_tree_contains_remainder(snapshot, RANGE_ITEM_COUNT, RANGE_ITEM_COUNT, RANGE_ITEM_COUNT));
+    CTEST_ASSERT_TRUE(range_tree_contains_remainder(right_snapshot, RANGE_ITEM_COUNT, 0, key - 1));
+
+    cutil_btree_destroy(snapshot);
+    cutil_btree_destroy(right_snapshot);
+}
+
+void add_btree_range_tests() {
+    CTEST_ADD_TEST_F(btree_range, btree_erase_range_middle);
+    CTEST_ADD_TEST_F(btree_range, btree_erase_range_unbounded);
+    CTEST_ADD_TEST_F(btree_range, btree_erase_range_no_items);
+    CTEST_ADD_TEST_F(btree_range, btree_erase_range_all_ranges);
+    CTEST_ADD_TEST_F(btree_range, btree_erase_range_then_modify);
+    CTEST_ADD_TEST_F(btree_range, btree_erase_range_destroys_items);
+    CTEST_ADD_TEST_F(btree_range, btree_erase_range_preserves_snapshot);
+    CTEST_ADD_TEST_F(btree_range, btree_erase_range_concurrent);
+
+    CTEST_ADD_TEST_F(btree_split, btree_split_middle);
+    CTEST_ADD_TEST_F(btree_split, btree_split_outside_keys);
+    CTEST_ADD_TEST_F(btree_split, btree_split_join_all_keys);
+    CTEST_ADD_TEST_F(btree_split, btree_join_different_heights);
+    CTEST_ADD_TEST_F(btree_split, btree_join_rejects_overlap);
+    CTEST_ADD_TEST_F(btree_split, btree_join_rejects_mismatched_trees);
+    CTEST_ADD_TEST_F(btree_split, btree_split_join_preserve_snapshots);
+}
@@ -0,0 +1,275 @@
+#include "cutil/btree.h"
+
+#include "ctest/ctest.h"
+#include "test_suites.h"
+
+#include "test_btree_util.h"
+#include "test_btree_fixtures.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define REBALANCE_BTREE_ORDER 7
+#define REBALANCE_ITEM_COUNT 2000
+
+CTEST_FIXTURE(btree_rebalance, btree_test, btree_test_setup, btree_test_teardown)
+
+/* Creates a relaxed btree containing the keys [0, count) with each value equal to twice the key */
+cutil_btree* create_relaxed_test_tree(unsigned int order, int count) {
+    cutil_btree* btree = cutil_btree_create(order, cutil_trait_int(), cutil_trait_int());
+    int i, value;
+
+    cutil_btree_set_relaxed_rebalance(btree, 1);
+
+    for (i = 0; i < count; i++) {
+        value = i * 2;
+        cutil_btree_insert(btree, &i, &value);
+    }
+
+    return btree;
+}
+
+/* Erases every key in [0, count) which is not a multiple of the step */
+void erase_non_multiples(cutil_btree* btree, int count, int step) {
+    int i;
+
+    for (i = 0; i < count; i++) {
+        if (i % step != 0) {
+            cutil_btree_erase(btree, &i);
+        }
+    }
+}
+
+/* Checks that the items of a btree are exactly the keys in [0, count) marked in the present array, with each value equal to twice the key */
+int relaxed_tree_matches(cutil_btree* btree, const char* present, int count) {
+    cutil_btree_itr* itr = cutil_btree_itr_create(btree);
+    int key, value, expected_key = -1, ok = 1;
+    size_t expected_size = 0;
+
+    for (key = 0; key < count; key++) {
+        expected_size += present[key];
+    }
+
+    ok = cutil_btree_size(btree) == expected_size;
+
+    while (ok && cutil_btree_itr_next(itr)) {
+        do {
+            expected_key += 1;
+        } while (expected_key < count && !present[expected_key]);
+
+        cutil_btree_itr_get_key(itr, &key);
+        cutil_btree_itr_get_value(itr, &value);
+
+        ok = key == expected_key && value == key * 2;
+    }
+
+    cutil_btree_itr_destroy(itr);
+
+    for (key = 0; ok && key < count; key++) {
+        ok = cutil_btree_contains(btree, &key) == present[key];
+    }
+
+    return ok;
+}
+
+/* Builds the present array for the keys in [0, count) which are multiples of the step */
+char* multiples_present(int count, int step) {
+    char* present = malloc(count);
+    int i;
+
+    for (i = 0; i < count; i++) {
+        present[i] = i % step == 0;
+    }
+
+    return present;
+}
+
+void btree_rebalance_relaxed_erase(btree_test* test) {
+    char* present = multiples_present(REBALANCE_ITEM_COUNT, 4);
+    cutil_btree_statistics relaxed_stats, flushed_stats;
+
+    test->btree = create_relaxed_test_tree(REBALANCE_BTREE_ORDER, REBALANCE_ITEM_COUNT);
+    erase_non_multiples(test->btree, REBALANCE_ITEM_COUNT, 4);
+    cutil_btree_stats(test->btree, &relaxed_stats);
+
+    /* short nodes are left in place until the btree is flushed */
+    CTEST_ASSERT_TRUE(relaxed_tree_matches(test->btree, present, REBALANCE_ITEM_COUNT));
+    CTEST_ASSERT_FALSE(validate_btree_balance(test->btree));
+    CTEST_ASSERT_TRUE(relaxed_stats.min_fill > 0.0);
+
+    cutil_btree_flush_rebalance(test->btree);
+    cutil_btree_stats(test->btree, &flushed_stats);
+
+    CTEST_ASSERT_TRUE(validate_btree_balance(test->btree));
+    CTEST_ASSERT_TRUE(relaxed_tree_matches(test->btree, present, REBALANCE_ITEM_COUNT));
+    CTEST_ASSERT_TRUE(flushed_stats.node_count < relaxed_stats.node_count);
+
+    free(present);
+}
+
+void btree_rebalance_relaxed_erase_all(btree_test* test) {
+    char* present = multiples_present(REBALANCE_ITEM_COUNT, 1);
+    int i;
+
+    test->btree = create_relaxed_test_tree(REBALANCE_BTREE_ORDER, REBALANCE_ITEM_COUNT);
+
+    for (i = 0; i < REBALANCE_ITEM_COUNT; i++) {
+        CTEST_ASSERT_TRUE(cutil_btree_erase(test->btree, &i));
+    }
+
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->btree), 0);
+    cutil_btree_flush_rebalance(test->btree);
+    CTEST_ASSERT_TRUE(validate_btree_balance(test->btree));
+
+    for (i = 0; i < REBALANCE_ITEM_COUNT; i++) {
+        int value = i * 2;
+        cutil_btree_insert(test->btree, &i, &value);
+    }
+
+    CTEST_ASSERT_TRUE(relaxed_tree_matches(test->btree, present, REBALANCE_ITEM_COUNT));
+
+    free(present);
+}
+
+/* a stream of inserts and erases over a small key space with occasional flushes is checked against the expected contents for each small order */
+void btree_rebalance_mixed_stream(btree_test* test) {
+    int key_count = 500, i, key, value, failures = 0;
+    char* present = malloc(key_count);
+    unsigned int order, seed = 12345;
+
+    for (order = 3; order <= 8; order++) {
+        memset(present, 0, key_count);
+        test->btree = create_relaxed_test_tree(order, 0);
+
+        for (i = 0; i < 20000; i++) {
+            seed = seed * 1103515245U + 12345U;
+            key = (int)((seed >> 8) % (unsigned int)key_count);
+
+            /* inserts are slightly more likely than erases so that the btree keeps several levels */
+            if ((seed >> 4) % 9 < 5) {
+                value = key * 2;
+                cutil_btree_insert(test->btree, &key, &value);
+                present[key] = 1;
+            }
+            else {
+                cutil_btree_erase(test->btree, &key);
+                present[key] = 0;
+            }
+
+            if (i % 5000 == 4999) {
+                cutil_btree_flush_rebalance(test->btree);
+                failures += !validate_btree_balance(test->btree);
+            }
+        }
+
+        failures += !relaxed_tree_matches(test->btree, present, key_count);
+
+        cutil_btree_destroy(test->btree);
+        test->btree = NULL;
+    }
+
+    CTEST_ASSERT_INT_EQ(failures, 0);
+    free(present);
+}
+
+void btree_rebalance_disable_flushes(btree_test* test) {
+    char* present = multiples_present(REBALANCE_ITEM_COUNT, 3);
+
+    test->btree = create_relaxed_test_tree(REBALANCE_BTREE_ORDER, REBALANCE_ITEM_COUNT);
+    erase_non_multiples(test->btree, REBALANCE_ITEM_COUNT, 3);
+
+    CTEST_ASSERT_TRUE(cutil_btree_set_relaxed_rebalance(test->btree, 0));
+    CTEST_ASSERT_TRUE(validate_btree_balance(test->btree));
+
+    /* erases in the default mode keep the btree balanced */
+    erase_non_multiples(test->btree, REBALANCE_ITEM_COUNT, 6);
+    CTEST_ASSERT_TRUE(validate_btree_balance(test->btree));
+
+    free(present);
+    present = multiples_present(REBALANCE_ITEM_COUNT, 6);
+    CTEST_ASSERT_TRUE(relaxed_tree_matches(test->btree, present, REBALANCE_ITEM_COUNT));
+
+    free(present);
+}
+
+void btree_rebalance_flush_preserves_snapshot(btree_test* test) {
+    char* present = multiples_present(REBALANCE_ITEM_COUNT, 2);
+    char* snapshot_present = multiples_present(REBALANCE_ITEM_COUNT, 1);
+    cutil_btree* snapshot;
+    int i;
+
+    test->btree = create_relaxed_test_tree(REBALANCE_BTREE_ORDER, REBALANCE_ITEM_COUNT);
+
+    for (i = 0; i < REBALANCE_ITEM_COUNT / 2; i++) {
+        if (i % 2) {
+            cutil_btree_erase(test->btree, &i);
+        }
+    }
+
+    /* the snapshot shares short nodes with the btree, which are copied as they are repaired */
+    for (i = 0; i < REBALANCE_ITEM_COUNT / 2; i++) {
+        snapshot_present[i] = present[i];
+    }
+
+    snapshot = cutil_btree_snapshot(test->btree);
+    erase_non_multiples(test->btree, REBALANCE_ITEM_COUNT, 2);
+    cutil_btree_flush_rebalance(test->btree);
+    cutil_btree_flush_rebalance(snapshot);
+
+    CTEST_ASSERT_TRUE(validate_btree_balance(test->btree));
+    CTEST_ASSERT_TRUE(relaxed_tree_matches(test->btree, present, REBALANCE_ITEM_COUNT));
+    CTEST_ASSERT_TRUE(relaxed_tree_matches(snapshot, snapshot_present, REBALANCE_ITEM_COUNT));
+
+    cutil_btree_destroy(snapshot);
+    free(snapshot_present);
+    free(present);
+}
+
+void btree_rebalance_range_operations(btree_test* test) {
+    int lo = 500, hi = 1499;
+    cutil_btree* right;
+
+    test->btree = create_relaxed_test_tree(REBALANCE_BTREE_ORDER, REBALANCE_ITEM_COUNT);
+    erase_non_multiples(test->btree, REBALANCE_ITEM_COUNT, 5);
+
+    CTEST_ASSERT_INT_EQ(cutil_btree_erase_range(test->btree, &lo, &hi), 200);
+    CTEST_ASSERT_TRUE(validate_btree_balance(test->btree));
+
+    erase_non_multiples(test->btree, REBALANCE_ITEM_COUNT, 10);
+    CTEST_ASSERT_TRUE(cutil_btree_split(test->btree, &hi, &right));
+    CTEST_ASSERT_TRUE(validate_btree_balance(test->btree));
+    CTEST_ASSERT_TRUE(validate_btree_balance(right));
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->btree) + cutil_btree_size(right), 100);
+
+    erase_non_multiples(right, REBALANCE_ITEM_COUNT, 20);
+    CTEST_ASSERT_TRUE(cutil_btree_join(test->btree, right));
+    CTEST_ASSERT_TRUE(validate_btree_balance(test->btree));
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->btree), 75);
+
+    cutil_btree_destroy(right);
+}
+
+void btree_rebalance_invalid(btree_test* test) {
+    cutil_btree* concurrent = cutil_btree_create_concurrent(REBALANCE_BTREE_ORDER, cutil_trait_int(), cutil_trait_int());
+    cutil_btree* snapshot;
+
+    test->btree = cutil_btree_create(REBALANCE_BTREE_ORDER, cutil_trait_int(), cutil_trait_int());
+    snapshot = cutil_btree_snapshot(test->btree);
+
+    CTEST_ASSERT_FALSE(cutil_btree_set_relaxed_rebalance(concurrent, 1));
+    CTEST_ASSERT_FALSE(cutil_btree_set_relaxed_rebalance(snapshot, 1));
+    CTEST_ASSERT_TRUE(cutil_btree_set_relaxed_rebalance(test->btree, 1));
+
+    cutil_btree_destroy(snapshot);
+    cutil_btree_destroy(concurrent);
+}
+
+void add_btree_rebalance_tests() {
+    CTEST_ADD_TEST_F(btree_rebalance, btree_rebalance_relaxed_erase);
+    CTEST_ADD_TEST_F(btree_rebalance, btree_rebalance_relaxed_erase_all);
+    CTEST_ADD_TEST_F(btree_rebalance, btree_rebalance_mixed_stream);
+    CTEST_ADD_TEST_F(btree_rebalance, btree_rebalance_disable_flushes);
+    CTEST_ADD_TEST_F(btree_rebalance, btree_rebalance_flush_preserves_snapshot);
+    CTEST_ADD_TEST_F(btree_rebalance, btree_rebalance_range_operations);
+    CTEST_ADD_TEST_F(btree_rebalance, btree_rebalance_invalid);
+}
@@ -0,0 +1,345 @@
+#include "cutil/btree.h"
+#include "btree_private.h"
+
+#include "ctest/ctest.h"
+#include "test_suites.h"
+
+#include "test_btree_fixtures.h"
+#include "test_btree_util.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdio.h>
+
+#define MAX_SEARCH_KEY_COUNT 70
+
+typedef btree_test btree_search_test;
+
+CTEST_FIXTURE(btree_search, btree_search_test, btree_test_setup, btree_test_teardown)
+
+int compare_ints(const void* a, const void* b) {
+    return cutil_trait_int()->compare_func((void*)a, (void*)b, NULL);
+}
+
+int compare_ints_trait_func(void* a, void* b, void* user_data) {
+    (void)user_data;
+    return compare_ints(a, b);
+}
+
+int compare_uints(const void* a, const void* b) {
+    return cutil_trait_uint()->compare_func((void*)a, (void*)b, NULL);
+}
+
+int compare_floats(const void* a, const void* b) {
+    return cutil_trait_float()->compare_func((void*)a, (void*)b, NULL);
+}
+
+/*
+Runs the specialized search function for a trait against the generic search for every key count up to MAX_SEARCH_KEY_COUNT.
+The keys array should be sorted and the search keys should contain a mix of present and missing keys.
+*/
+int search_matches_generic(cutil_trait* trait, void* keys, void* search_keys, int search_key_count) {
+    _btree_key_search_func search_func = _btree_key_search_func_for_trait(trait);
+    unsigned int count;
+    int i;
+
+    if (search_func == NULL) {
+        return 0;
+    }
+
+    for (count = 0; count <= MAX_SEARCH_KEY_COUNT; count++) {
+        for (i = 0; i < search_key_count; i++) {
+            void* search_key = (char*)search_keys + trait->size * i;
+            int expected_found = -1, actual_found = -1;
+            unsigned int expected = _btree_search_generic(trait, keys, count, search_key, &expected_found);
+            unsigned int actual = search_func(keys, count, search_key, &actual_found);
+
+            if (expected != actual || expected_found != actual_found) {
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+void int_search_matches_generic(btree_search_test* test) {
+    int keys[MAX_SEARCH_KEY_COUNT], search_keys[MAX_SEARCH_KEY_COUNT * 2 + 2];
+    int i;
+    (void)test;
+
+    for (i = 0; i < MAX_SEARCH_KEY_COUNT; i++) {
+        keys[i] = (i - MAX_SEARCH_KEY_COUNT / 2) * 2;
+        search_keys[i * 2] = keys[i];
+        search_keys[i * 2 + 1] = keys[i] + 1;
+    }
+
+    search_keys[MAX_SEARCH_KEY_COUNT * 2] = INT_MIN;
+    search_keys[MAX_SEARCH_KEY_COUNT * 2 + 1] = INT_MAX;
+    qsort(keys, MAX_SEARCH_KEY_COUNT, sizeof(int), compare_ints);
+
+    CTEST_ASSERT_TRUE(search_matches_generic(cutil_trait_int(), keys, search_keys, MAX_SEARCH_KEY_COUNT * 2 + 2));
+}
+
+void uint_search_matches_generic(btree_search_test* test) {
+    unsigned int keys[MAX_SEARCH_KEY_COUNT], search_keys[MAX_SEARCH_KEY_COUNT * 2 + 2];
+    int i;
+    (void)test;
+
+    /* keys span both sides of INT_MAX to ensure the search does not use signed comparisons */
+    for (i = 0; i < MAX_SEARCH_KEY_COUNT; i++) {
+        keys[i] = (unsigned int)INT_MAX - MAX_SEARCH_KEY_COUNT + (unsigned int)i * 2;
+        search_keys[i * 2] = keys[i];
+        search_keys[i * 2 + 1] = keys[i] + 1;
+    }
+
+    search_keys[MAX_SEARCH_KEY_COUNT * 2] = 0;
+    search_keys[MAX_SEARCH_KEY_COUNT * 2 + 1] = UINT_MAX;
+    qsort(keys, MAX_SEARCH_KEY_COUNT, sizeof(unsigned int), compare_uints);
+
+    CTEST_ASSERT_TRUE(search_matches_generic(cutil_trait_uint(), keys, search_keys, MAX_SEARCH_KEY_COUNT * 2 + 2));
+}
+
+void float_search_matches_generic(btree_search_test* test) {
+    float keys[MAX_SEARCH_KEY_COUNT], search_keys[MAX_SEARCH_KEY_COUNT * 2];
+    int i;
+    (void)test;
+
+    for (i = 0; i < MAX_SEARCH_KEY_COUNT; i++) {
+        keys[i] = (float)(i - MAX_SEARCH_KEY_COUNT / 2) * 1.5f;
+        search_keys[i * 2] = keys[i];
+        search_keys[i * 2 + 1] = keys[i] + 0.25f;
+    }
+
+    qsort(keys, MAX_SEARCH_KEY_COUNT, sizeof(float), compare_floats);
+
+    CTEST_ASSERT_TRUE(search_matches_generic(cutil_trait_float(), keys, search_keys, MAX_SEARCH_KEY_COUNT * 2));
+}
+
+void user_trait_uses_generic_search(btree_search_test* test) {
+    cutil_trait user_trait;
+    (void)test;
+
+    memcpy(&user_trait, cutil_trait_int(), sizeof(cutil_trait));
+    user_trait.compare_func = compare_ints_trait_func;
+
+    CTEST_ASSERT_TRUE(_btree_key_search_func_for_trait(&user_trait) == NULL);
+    CTEST_ASSERT_TRUE(_btree_key_search_func_for_trait(cutil_trait_cstring()) == NULL);
+}
+
+void uint_keys_above_int_max_are_ordered(btree_search_test* test) {
+    unsigned int i, key, previous_key = 0, item_count = 200;
+    unsigned int start_key = (unsigned int)INT_MAX - item_count / 2;
+    cutil_btree_itr* itr;
+
+    test->btree = cutil_btree_create(7, cutil_trait_uint(), cutil_trait_uint());
+
+    for (i = 0; i < item_count; i++) {
+        key = start_key + ((i * 37) % item_count);
+        cutil_btree_insert(test->btree, &key, &key);
+    }
+
+    CTEST_ASSERT_TRUE(validate_btree(test->btree));
+
+    itr = cutil_btree_itr_create(test->btree);
+    for (i = 0; i < item_count; i++) {
+        CTEST_ASSERT_TRUE(cutil_btree_itr_next(itr));
+        cutil_btree_itr_get_key(itr, &key);
+
+        if (i > 0) {
+            CTEST_EXPECT_TRUE(key > previous_key);
+        }
+
+        previous_key = key;
+    }
+    cutil_btree_itr_destroy(itr);
+
+    key = start_key + item_count;
+    CTEST_ASSERT_FALSE(cutil_btree_contains(test->btree, &key));
+}
+
+void int_tree_large_order(btree_search_test* test) {
+    int i, key, value, item_count = 1000;
+
+    test->btree = cutil_btree_create(64, cutil_trait_int(), cutil_trait_int());
+
+    for (i = 0; i < item_count; i++) {
+        key = ((i * 7919) % item_count) - item_count / 2;
+        value = key * 2;
+        cutil_btree_insert(test->btree, &key, &value);
+    }
+
+    CTEST_ASSERT_TRUE(validate_btree(test->btree));
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->btree), item_count);
+
+    for (key = -item_count / 2; key < item_count / 2; key++) {
+        CTEST_ASSERT_TRUE(cutil_btree_get(test->btree, &key, &value));
+        CTEST_ASSERT_INT_EQ(value, key * 2);
+    }
+
+    key = item_count;
+    CTEST_ASSERT_FALSE(cutil_btree_contains(test->btree, &key));
+}
+
+int compare_cstrings(const void* a, const void* b) {
+    return strcmp(*(char**)a, *(char**)b);
+}
+
+/* Checks that the prefix stored for every key of a node and its children matches the key */
+int node_key_prefixes_valid(cutil_btree* btree, _btree_node* node) {
+    unsigned char prefix[BTREE_KEY_PREFIX_SIZE];
+    unsigned int i;
+
+    if (node->key_prefixes == NULL) {
+        return 0;
+    }
+
+    for (i = 0; i < node->item_count; i++) {
+        _btree_key_prefix(prefix, _node_get_key(node, btree->key_trait, i));
+
+        if (memcmp(prefix, node->key_prefixes + i * BTREE_KEY_PREFIX_SIZE, BTREE_KEY_PREFIX_SIZE) != 0) {
+            return 0;
+        }
+    }
+
+    if (!_node_is_leaf(node)) {
+        for (i = 0; i <= node->item_count; i++) {
+            if (!node_key_prefixes_valid(btree, node->branches[i])) {
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+/* keys are chosen to differ before, at and after the end of the prefix, and to include empty strings and bytes above 127 */
+void cstring_prefix_search_matches_generic(btree_search_test* test) {
+    char* keys[] = {
+        "", "a", "abcdefghijklmno", "abcdefghijklmnop", "abcdefghijklmnopq", "abcdefghijklmnoq",
+        "http://example.com/a", "http://example.com/b", "https://example.com/index.html", "https://example.com/index.htm",
+        "https://example.com/index.html?q=1", "zz", "\x7f", "\x80", "\xff\xff"
+    };
+    char* search_keys[] = {
+        "", "0", "a", "aa", "abcdefghijklmno", "abcdefghijklmnoa", "abcdefghijklmnop", "abcdefghijklmnopp", "abcdefghijklmnopq",
+        "abcdefghijklmnopqr", "http://example.com/", "http://example.com/ab", "https://example.com/index.htm",
+        "https://example.com/index.html", "https://example.com/index.html?", "z", "\x7f", "\x80\x80", "\xff", "\xff\xff\xff"
+    };
+    unsigned int key_count = sizeof(keys) / sizeof(char*), search_key_count = sizeof(search_keys) / sizeof(char*);
+    unsigned char prefixes[sizeof(keys) / sizeof(char*) * BTREE_KEY_PREFIX_SIZE];
+    cutil_trait* trait = cutil_trait_cstring();
+    unsigned int count, i;
+    int failures = 0;
+    (void)test;
+
+    qsort(keys, key_count, sizeof(char*), compare_cstrings);
+
+    for (i = 0; i < key_count; i++) {
+        _btree_key_prefix(prefixes + i * BTREE_KEY_PREFIX_SIZE, &keys[i]);
+    }
+
+    for (count = 0; count <= key_count; count++) {
+        for (i = 0; i < search_key_count; i++) {
+            int expected_found = -1, actual_found = -1;
+            unsigned int expected = _btree_search_generic(trait, keys, count, &search_keys[i], &expected_found);
+            unsigned int actual = _btree_search_prefixed(trait, prefixes, keys, count, &search_keys[i], &actual_found);
+
+            failures += expected != actual || expected_found != actual_found;
+        }
+    }
+
+    CTEST_ASSERT_INT_EQ(failures, 0);
+}
+
+/* url like keys share a prefix longer than the stored prefix, so every search needs to fall back to comparing the strings */
+void cstring_tree_shared_prefixes(btree_search_test* test) {
+    char key[64];
+    char* key_ptr = key;
+    int i, value, item_count = 500;
+    cutil_btree* snapshot;
+
+    test->btree = cutil_btree_create_string(5, cutil_trait_int());
+
+    for (i = 0; i < item_count; i++) {
+        value = (i * 7919) % item_count;
+        sprintf(key, "https://example.com/%s/%d", value % 2 ? "a" : "b", value);
+        cutil_btree_insert(test->btree, &key_ptr, &value);
+    }
+
+    snapshot = cutil_btree_snapshot(test->btree);
+
+    for (i = 0; i < item_count; i += 3) {
+        sprintf(key, "https://example.com/%s/%d", i % 2 ? "a" : "b", i);
+        cutil_btree_erase(test->btree, &key_ptr);
+    }
+
+    CTEST_ASSERT_TRUE(validate_btree_balance(test->btree));
+    CTEST_ASSERT_TRUE(node_key_prefixes_valid(test->btree, test->btree->root));
+    CTEST_ASSERT_TRUE(node_key_prefixes_valid(snapshot, snapshot->root));
+
+    for (i = 0; i < item_count; i++) {
+        sprintf(key, "https://example.com/%s/%d", i % 2 ? "a" : "b", i);
+
+        CTEST_ASSERT_INT_EQ(cutil_btree_contains(test->btree, &key_ptr), i % 3 != 0);
+        CTEST_ASSERT_TRUE(cutil_btree_get(snapshot, &key_ptr, &value));
+        CTEST_ASSERT_INT_EQ(value, i);
+    }
+
+    key_ptr = "https://example.com/";
+    CTEST_ASSERT_FALSE(cutil_btree_contains(test->btree, &key_ptr));
+
+    cutil_btree_destroy(snapshot);
+}
+
+/* key prefixes are only kept by btrees created for string keys, and btrees derived from them keep the same node layout */
+void cstring_key_prefixes_opt_in(btree_search_test* test) {
+    char key[16];
+    char* key_ptr = key;
+    cutil_btree *plain, *right = NULL, *merged;
+    int i;
+
+    plain = cutil_btree_create(5, cutil_trait_cstring(), cutil_trait_int());
+    test->btree = cutil_btree_create_string(5, cutil_trait_int());
+
+    CTEST_ASSERT_PTR_NOT_NULL(test->btree);
+    CTEST_ASSERT_PTR_NULL(cutil_btree_create_string(2, cutil_trait_int()));
+    CTEST_ASSERT_TRUE(cutil_btree_get_key_trait(test->btree) == cutil_trait_cstring());
+
+    for (i = 0; i < 50; i++) {
+        sprintf(key, "key%02d", i);
+        cutil_btree_insert(i < 25 ? test->btree : plain, &key_ptr, &i);
+    }
+
+    CTEST_ASSERT_PTR_NULL(plain->root->key_prefixes);
+    CTEST_ASSERT_PTR_NOT_NULL(test->btree->root->key_prefixes);
+
+    /* nodes cannot be moved between btrees whose nodes have different layouts */
+    CTEST_ASSERT_FALSE(cutil_btree_join(test->btree, plain));
+
+    merged = cutil_btree_union(test->btree, plain, NULL, NULL);
+    CTEST_ASSERT_TRUE(node_key_prefixes_valid(merged, merged->root));
+
+    key_ptr = "key10";
+    CTEST_ASSERT_TRUE(cutil_btree_split(test->btree, &key_ptr, &right));
+    CTEST_ASSERT_TRUE(node_key_prefixes_valid(right, right->root));
+    CTEST_ASSERT_TRUE(cutil_btree_join(test->btree, right));
+    CTEST_ASSERT_TRUE(node_key_prefixes_valid(test->btree, test->btree->root));
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->btree), 25);
+
+    cutil_btree_destroy(right);
+    cutil_btree_destroy(merged);
+    cutil_btree_destroy(plain);
+}
+
+void add_btree_search_tests() {
+    CTEST_ADD_TEST_F(btree_search, int_search_matches_generic);
+    CTEST_ADD_TEST_F(btree_search, uint_search_matches_generic);
+    CTEST_ADD_TEST_F(btree_search, float_search_matches_generic);
+    CTEST_ADD_TEST_F(btree_search, user_trait_uses_generic_search);
+    CTEST_ADD_TEST_F(btree_search, uint_keys_above_int_max_are_ordered);
+    CTEST_ADD_TEST_F(btree_search, int_tree_large_order);
+    CTEST_ADD_TEST_F(btree_search, cstring_prefix_search_matches_generic);
+    CTEST_ADD_TEST_F(btree_search, cstring_tree_shared_prefixes);
+    CTEST_ADD_TEST_F(btree_search, cstring_key_prefixes_opt_in);
+}
@@ -0,0 +1,216 @@
+#include "cutil/btree.h"
+
+#include "ctest/ctest.h"
+#include "test_suites.h"
+
+#include "test_btree_util.h"
+#include "test_btree_fixtures.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#define SNAPSHOT_BTREE_ORDER 5
+#define SNAPSHOT_ITEM_COUNT 100
+
+CTEST_FIXTURE(btree_snapshot, btree_snapshot_test, btree_snapshot_test_setup, btree_snapshot_test_teardown)
+
+/* Creates a btree containing the keys [0, count) with each value equal to the key multiplied by the supplied factor */
+cutil_btree* create_snapshot_test_tree(int count, int factor) {
+    cutil_btree* btree = cutil_btree_create(SNAPSHOT_BTREE_ORDER, cutil_trait_int(), cutil_trait_int());
+    int i, value;
+
+    for (i = 0; i < count; i++) {
+        value = i * factor;
+        cutil_btree_insert(btree, &i, &value);
+    }
+
+    return btree;
+}
+
+/* Checks that a btree contains exactly the keys [0, count) with each value equal to the key multiplied by the supplied factor */
+int snapshot_tree_contains_sequence(cutil_btree* btree, int count, int factor) {
+    cutil_btree_itr* itr = cutil_btree_itr_create(btree);
+    int key, value, expected_key = 0, ok = 1;
+
+    if (cutil_btree_size(btree) != (size_t)count) {
+        ok = 0;
+    }
+
+    while (ok && cutil_btree_itr_next(itr)) {
+        cutil_btree_itr_get_key(itr, &key);
+        cutil_btree_itr_get_value(itr, &value);
+
+        ok = key == expected_key && value == key * factor;
+        expected_key += 1;
+    }
+
+    cutil_btree_itr_destroy(itr);
+
+    return ok && expected_key == count;
+}
+
+void snapshot_equals_source(btree_snapshot_test* test) {
+    test->btree = create_snapshot_test_tree(SNAPSHOT_ITEM_COUNT, 2);
+    test->snapshot = cutil_btree_snapshot(test->btree);
+
+    CTEST_ASSERT_TRUE(cutil_btree_is_snapshot(test->snapshot));
+    CTEST_ASSERT_FALSE(cutil_btree_is_snapshot(test->btree));
+    CTEST_ASSERT_TRUE(cutil_btree_equals(test->btree, test->snapshot));
+    CTEST_ASSERT_TRUE(snapshot_tree_contains_sequence(test->snapshot, SNAPSHOT_ITEM_COUNT, 2));
+}
+
+void snapshot_ignores_modification(btree_snapshot_test* test) {
+    int key = 1, value = 1;
+
+    test->btree = create_snapshot_test_tree(SNAPSHOT_ITEM_COUNT, 2);
+    test->snapshot = cutil_btree_snapshot(test->btree);
+
+    cutil_btree_insert(test->snapshot, &key, &value);
+    CTEST_ASSERT_TRUE(cutil_btree_get_or_insert(test->snapshot, &key, &value, NULL) == NULL);
+    CTEST_ASSERT_FALSE(cutil_btree_erase(test->snapshot, &key));
+    cutil_btree_clear(test->snapshot);
+
+    CTEST_ASSERT_TRUE(snapshot_tree_contains_sequence(test->snapshot, SNAPSHOT_ITEM_COUNT, 2));
+    CTEST_ASSERT_TRUE(snapshot_tree_contains_sequence(test->btree, SNAPSHOT_ITEM_COUNT, 2));
+}
+
+void snapshot_unchanged_by_insert(btree_snapshot_test* test) {
+    int i, value;
+
+    test->btree = create_snapshot_test_tree(SNAPSHOT_ITEM_COUNT, 2);
+    test->snapshot = cutil_btree_snapshot(test->btree);
+
+    /* replace the existing values and add enough new items to split nodes along the right edge of the tree */
+    for (i = 0; i < SNAPSHOT_ITEM_COUNT * 2; i++) {
+        value = i * 3;
+        cutil_btree_insert(test->btree, &i, &value);
+    }
+
+    CTEST_ASSERT_TRUE(validate_btree(test->btree));
+    CTEST_ASSERT_TRUE(snapshot_tree_contains_sequence(test->btree, SNAPSHOT_ITEM_COUNT * 2, 3));
+    CTEST_ASSERT_TRUE(snapshot_tree_contains_sequence(test->snapshot, SNAPSHOT_ITEM_COUNT, 2));
+}
+
+void snapshot_unchanged_by_erase(btree_snapshot_test* test) {
+    int i, value;
+
+    test->btree = create_snapshot_test_tree(SNAPSHOT_ITEM_COUNT, 2);
+    test->snapshot = cutil_btree_snapshot(test->btree);
+
+    for (i = SNAPSHOT_ITEM_COUNT / 2; i < SNAPSHOT_ITEM_COUNT; i++) {
+        CTEST_ASSERT_TRUE(cutil_btree_erase(test->btree, &i));
+    }
+
+    CTEST_ASSERT_TRUE(validate_btree(test->btree));
+    CTEST_ASSERT_TRUE(snapshot_tree_contains_sequence(test->btree, SNAPSHOT_ITEM_COUNT / 2, 2));
+    CTEST_ASSERT_TRUE(snapshot_tree_contains_sequence(test->snapshot, SNAPSHOT_ITEM_COUNT, 2));
+
+    for (i = 0; i < SNAPSHOT_ITEM_COUNT; i++) {
+        CTEST_ASSERT_TRUE(cutil_btree_get(test->snapshot, &i, &value));
+        CTEST_ASSERT_INT_EQ(value, i * 2);
+    }
+}
+
+void snapshot_unchanged_by_clear(btree_snapshot_test* test) {
+    test->btree = create_snapshot_test_tree(SNAPSHOT_ITEM_COUNT, 2);
+    test->snapshot = cutil_btree_snapshot(test->btree);
+
+    cutil_btree_clear(test->btree);
+
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->btree), 0);
+    CTEST_ASSERT_TRUE(snapshot_tree_contains_sequence(test->snapshot, SNAPSHOT_ITEM_COUNT, 2));
+}
+
+void snapshot_outlives_source(btree_snapshot_test* test) {
+    test->btree = create_snapshot_test_tree(SNAPSHOT_ITEM_COUNT, 2);
+    test->snapshot = cutil_btree_snapshot(test->btree);
+
+    cutil_btree_destroy(test->btree);
+    test->btree = NULL;
+
+    CTEST_ASSERT_TRUE(snapshot_tree_contains_sequence(test->snapshot, SNAPSHOT_ITEM_COUNT, 2));
+}
+
+void snapshot_of_snapshot(btree_snapshot_test* test) {
+    cutil_btree* nested_snapshot;
+    int key = 0;
+
+    test->btree = create_snapshot_test_tree(SNAPSHOT_ITEM_COUNT, 2);
+    test->snapshot = cutil_btree_snapshot(test->btree);
+    nested_snapshot = cutil_btree_snapshot(test->snapshot);
+
+    cutil_btree_destroy(test->snapshot);
+    test->snapshot = nested_snapshot;
+
+    cutil_btree_erase(test->btree, &key);
+
+    CTEST_ASSERT_TRUE(cutil_btree_is_snapshot(test->snapshot));
+    CTEST_ASSERT_TRUE(snapshot_tree_contains_sequence(test->snapshot, SNAPSHOT_ITEM_COUNT, 2));
+}
+
+void snapshot_get_many(btree_snapshot_test* test) {
+    int keys[SNAPSHOT_ITEM_COUNT], values[SNAPSHOT_ITEM_COUNT];
+    int i;
+
+    test->btree = create_snapshot_test_tree(SNAPSHOT_ITEM_COUNT, 2);
+    test->snapshot = cutil_btree_snapshot(test->btree);
+    cutil_btree_clear(test->btree);
+
+    for (i = 0; i < SNAPSHOT_ITEM_COUNT; i++) {
+        keys[i] = i;
+    }
+
+    CTEST_ASSERT_INT_EQ(cutil_btree_get_many(test->snapshot, keys, SNAPSHOT_ITEM_COUNT, values, NULL), SNAPSHOT_ITEM_COUNT);
+
+    for (i = 0; i < SNAPSHOT_ITEM_COUNT; i++) {
+        CTEST_ASSERT_INT_EQ(values[i], i * 2);
+    }
+}
+
+void snapshot_keeps_copied_strings(btree_snapshot_test* test) {
+    char key_str[32], value_str[32];
+    char* key = key_str, *value = value_str, *actual_value;
+    int i;
+
+    test->btree = cutil_btree_create(SNAPSHOT_BTREE_ORDER, cutil_trait_cstring(), cutil_trait_cstring());
+
+    for (i = 0; i < SNAPSHOT_ITEM_COUNT; i++) {
+        sprintf(key_str, "key%03i", i);
+        sprintf(value_str, "value%03i", i);
+        cutil_btree_insert(test->btree, &key, &value);
+    }
+
+    test->snapshot = cutil_btree_snapshot(test->btree);
+
+    /* modified nodes own copies of their strings, destroying them must not affect the snapshot */
+    for (i = 0; i < SNAPSHOT_ITEM_COUNT; i += 2) {
+        sprintf(key_str, "key%03i", i);
+        cutil_btree_erase(test->btree, &key);
+    }
+
+    cutil_btree_destroy(test->btree);
+    test->btree = NULL;
+
+    CTEST_ASSERT_INT_EQ(cutil_btree_size(test->snapshot), SNAPSHOT_ITEM_COUNT);
+
+    for (i = 0; i < SNAPSHOT_ITEM_COUNT; i++) {
+        sprintf(key_str, "key%03i", i);
+        sprintf(value_str, "value%03i", i);
+
+        CTEST_ASSERT_TRUE(cutil_btree_get(test->snapshot, &key, &actual_value));
+        CTEST_ASSERT_TRUE(strcmp(actual_value, value_str) == 0);
+    }
+}
+
+void add_btree_snapshot_tests() {
+    CTEST_ADD_TEST_F(btree_snapshot, snapshot_equals_source);
+    CTEST_ADD_TEST_F(btree_snapshot, snapshot_ignores_modification);
+    CTEST_ADD_TEST_F(btree_snapshot, snapshot_unchanged_by_insert);
+    CTEST_ADD_TEST_F(btree_snapshot, snapshot_unchanged_by_erase);
+    CTEST_ADD_TEST_F(btree_snapshot, snapshot_unchanged_by_clear);
+    CTEST_ADD_TEST_F(btree_snapshot, snapshot_outlives_source);
+    CTEST_ADD_TEST_F(btree_snapshot, snapshot_of_snapshot);
+    CTEST_ADD_TEST_F(btree_snapshot, snapshot_get_many);
+    CTEST_ADD_TEST_F(btree_snapshot, snapshot_keeps_copied_strings);
+}
@@ -0,0 +1,162 @@
+#include "cutil/btree.h"
+
+#include "ctest/ctest.h"
+#include "test_suites.h"
+
+#include "test_btree_fixtures.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#define STATS_BTREE_ORDER 5
+
+typedef btree_test btree_stats_test;
+
+CTEST_FIXTURE(btree_stats, btree_stats_test, btree_test_setup, btree_test_teardown)
+
+/* Inserts the keys [0, count) into the btree in an order that does not follow the keys */
+void insert_stats_test_items(cutil_btree* btree, int count) {
+    int i, key;
+
+    for (i = 0; i < count; i++) {
+        key = (i * 7919) % count;
+        cutil_btree_insert(btree, &key, &i);
+    }
+}
+
+/* Checks the relationships between the fields of the statistics which hold for every btree */
+int stats_consistent(cutil_btree* btree, cutil_btree_statistics* stats) {
+    unsigned int order = cutil_btree_get_order(btree);
+    size_t level_total = 0;
+    unsigned int i;
+
+    for (i = 0; i < stats->height; i++) {
+        if (stats->level_node_counts[i] == 0) {
+            return 0;
+        }
+
+        level_total += stats->level_node_counts[i];
+    }
+
+    return stats->level_node_counts[0] == 1 &&
+        level_total == stats->node_count &&
+        stats->item_count == cutil_btree_size(btree) &&
+        stats->average_fill == (double)stats->item_count / (double)(stats->node_count * (order - 1)) &&
+        stats->min_fill <= 1.0 &&
+        stats->value_bytes == stats->node_count * (order - 1) * sizeof(int) &&
+        stats->total_bytes > stats->key_bytes + stats->value_bytes + stats->branch_bytes + stats->node_bytes;
+}
+
+void btree_stats_empty(btree_stats_test* test) {
+    cutil_btree_statistics stats;
+
+    test->btree = cutil_btree_create(STATS_BTREE_ORDER, cutil_trait_int(), cutil_trait_int());
+    cutil_btree_stats(test->btree, &stats);
+
+    CTEST_ASSERT_TRUE(stats_consistent(test->btree, &stats));
+    CTEST_ASSERT_INT_EQ(stats.height, 1);
+    CTEST_ASSERT_INT_EQ(stats.node_count, 1);
+    CTEST_ASSERT_INT_EQ(stats.item_count, 0);
+    CTEST_ASSERT_TRUE(stats.average_fill == 0.0);
+    CTEST_ASSERT_TRUE(stats.min_fill == 0.0);
+
+    /* the node, which holds its key, value and branch arrays, and the btree itself */
+    CTEST_ASSERT_INT_EQ(stats.allocation_count, 2);
+    CTEST_ASSERT_INT_EQ(stats.key_bytes, (STATS_BTREE_ORDER - 1) * sizeof(int));
+    CTEST_ASSERT_INT_EQ(stats.branch_bytes, STATS_BTREE_ORDER * sizeof(void*));
+}
+
+void btree_stats_structure(btree_stats_test* test) {
+    cutil_btree_statistics stats;
+    unsigned int i;
+
+    test->btree = cutil_btree_create(STATS_BTREE_ORDER, cutil_trait_int(), cutil_trait_int());
+    insert_stats_test_items(test->btree, 1000);
+    cutil_btree_stats(test->btree, &stats);
+
+    CTEST_ASSERT_TRUE(stats_consistent(test->btree, &stats));
+    CTEST_ASSERT_INT_EQ(stats.item_count, 1000);
+    CTEST_ASSERT_INT_EQ(stats.allocation_count, stats.node_count + 1);
+
+    /* every node other than the root holds at least the minimum number of items */
+    CTEST_ASSERT_TRUE(stats.min_fill >= 0.5);
+
+    /* each level of a btree of order 5 holds at least twice as many nodes as the level above it */
+    for (i = 1; i < stats.height; i++) {
+        CTEST_ASSERT_TRUE(stats.level_node_counts[i] >= stats.level_node_counts[i - 1] * 2);
+    }
+
+    for (i = stats.height; i < CUTIL_BTREE_STATS_MAX_LEVELS; i++) {
+        CTEST_ASSERT_INT_EQ(stats.level_node_counts[i], 0);
+    }
+}
+
+void btree_stats_after_erase(btree_stats_test* test) {
+    cutil_btree_statistics before, after;
+    int key;
+
+    test->btree = cutil_btree_create(STATS_BTREE_ORDER, cutil_trait_int(), cutil_trait_int());
+    insert_stats_test_items(test->btree, 1000);
+    cutil_btree_stats(test->btree, &before);
+
+    for (key = 0; key < 1000; key++) {
+        if (key % 10 != 0) {
+            cutil_btree_erase(test->btree, &key);
+        }
+    }
+
+    cutil_btree_stats(test->btree, &after);
+
+    CTEST_ASSERT_TRUE(stats_consistent(test->btree, &after));
+    CTEST_ASSERT_INT_EQ(after.item_count, 100);
+    CTEST_ASSERT_TRUE(after.node_count < before.node_count);
+    CTEST_ASSERT_TRUE(after.height <= before.height);
+    CTEST_ASSERT_TRUE(after.total_bytes < before.total_bytes);
+}
+
+void btree_stats_string_keys(btree_stats_test* test) {
+    cutil_btree_statistics stats;
+    char key[16];
+    char* key_ptr = key;
+    int i;
+
+    test->btree = cutil_btree_create_string(STATS_BTREE_ORDER, cutil_trait_int());
+
+    for (i = 0; i < 200; i++) {
+        sprintf(key, "key%04d", i);
+        cutil_btree_insert(test->btree, &key_ptr, &i);
+    }
+
+    cutil_btree_stats(test->btree, &stats);
+
+    CTEST_ASSERT_TRUE(stats_consistent(test->btree, &stats));
+
+    /* the key prefixes are held in the node allocation and counted as key bytes */
+    CTEST_ASSERT_INT_EQ(stats.allocation_count, stats.node_count + 1);
+    CTEST_ASSERT_TRUE(stats.key_bytes > stats.node_count * (STATS_BTREE_ORDER - 1) * sizeof(char*));
+}
+
+void btree_stats_snapshot(btree_stats_test* test) {
+    cutil_btree_statistics btree_stats, snapshot_stats;
+    cutil_btree* snapshot;
+
+    test->btree = cutil_btree_create(STATS_BTREE_ORDER, cutil_trait_int(), cutil_trait_int());
+    insert_stats_test_items(test->btree, 500);
+    snapshot = cutil_btree_snapshot(test->btree);
+
+    cutil_btree_stats(test->btree, &btree_stats);
+    cutil_btree_stats(snapshot, &snapshot_stats);
+
+    CTEST_ASSERT_TRUE(memcmp(&btree_stats, &snapshot_stats, sizeof(cutil_btree_statistics)) == 0);
+
+    cutil_btree_destroy(snapshot);
+}
+
+void add_btree_stats_tests() {
+    CTEST_ADD_TEST_F(btree_stats, btree_stats_empty);
+    CTEST_ADD_TEST_F(btree_stats, btree_stats_structure);
+    CTEST_ADD_TEST_F(btree_stats, btree_stats_after_erase);
+    CTEST_ADD_TEST_F(btree_stats, btree_stats_string_keys);
+    CTEST_ADD_TEST_F(btree_stats, btree_stats_snapshot);
+}
@@ -80,7 +80,7 @@ cutil_btree* read_btree(const char* data) {
 _btree_node* read_btree_node(cutil_btree* btree, _btree_node* parent, int* item_counter, const char* data, int* string_pos) {
     int bytes_read = 0;
     int item_count = 0;
-    char node_type[2];
+    char node_type[3];
 
     sscanf(data + *string_pos, "%2s%n", node_type, &bytes_read);
     *string_pos += bytes_read;
@@ -298,6 +298,40 @@ int validate_btree(cutil_btree* btree) {
     }
 }
 
+int validate_btree_node_balance(cutil_btree* btree, _btree_node* node) {
+    unsigned int i;
+
+    if (node->item_count >= btree->order) {
+        return 0;
+    }
+
+    if (!_node_is_root(node) && node->item_count < _btree_node_min_item_count(btree)) {
+        return 0;
+    }
+
+    if (!_node_is_leaf(node)) {
+        for (i = 0; i <= node->item_count; i++) {
+            _btree_node* child = node->branches[i];
+
+            if (child == NULL || child->parent != node || child->position != i) {
+                return 0;
+            }
+
+            if (!validate_btree_node_balance(btree, child)) {
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
+int validate_btree_balance(cutil_btree* btree) {
+    int leaf_depth = determine_leaf_depth(btree->root, 0);
+
+    return validate_leaf_depths(btree->root, 0, leaf_depth) && validate_btree_node_balance(btree, btree->root);
+}
+
 int insert_char_sequence(cutil_btree* btree, const char* sequence, cutil_btree_value_xform_func xform_func) {
     size_t i, len;
 
@@ -16,4 +16,7 @@ void dump_btree(cutil_btree* btree, const char* path);
 
 int validate_btree(cutil_btree* btree);
 
+/* Checks that all leaves are at the same depth, that every node other than the root holds at least the minimum number of items and that the parent and position of each node are correct.  Keys are not compared. */
+int validate_btree_balance(cutil_btree* btree);
+
 #endif
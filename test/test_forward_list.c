@@ -1,5 +1,6 @@
 #include "test_util/defs.h"
 #include "test_util/trait_tracker.h"
+#include "test_util/allocation_tracker.h"
 
 #include "cutil/forward_list.h"
 #include "ctest/ctest.h"
@@ -142,6 +143,296 @@ void pop_front_removes_items_forward_list(forward_list_test* test) {
     CTEST_ASSERT_TRUE(cutil_forward_list_empty(test->forward_list));
 }
 
+/* records the items visited by foreach, stopping once the limit is reached */
+typedef struct {
+    int items[10];
+    int count;
+    int limit;
+} forward_list_foreach_visitor;
+
+int forward_list_foreach_visit(void* item, void* user_data) {
+    forward_list_foreach_visitor* visitor = (forward_list_foreach_visitor*)user_data;
+
+    visitor->items[visitor->count++] = *(int*)item;
+
+    return visitor->count < visitor->limit;
+}
+
+void forward_list_foreach_empty(forward_list_test* test) {
+    forward_list_foreach_visitor visitor;
+
+    memset(&visitor, 0, sizeof(visitor));
+    visitor.limit = 10;
+    test->forward_list = cutil_forward_list_create(cutil_trait_int());
+
+    CTEST_ASSERT_INT_EQ(cutil_forward_list_foreach(test->forward_list, forward_list_foreach_visit, &visitor), 0);
+    CTEST_ASSERT_INT_EQ(visitor.count, 0);
+}
+
+void forward_list_foreach_all(forward_list_test* test) {
+    forward_list_foreach_visitor visitor;
+    int i;
+
+    memset(&visitor, 0, sizeof(visitor));
+    visitor.limit = 10;
+    test->forward_list = cutil_forward_list_create(cutil_trait_int());
+
+    for (i = 0; i < 10; i++) {
+        cutil_forward_list_push_front(test->forward_list, &i);
+    }
+
+    CTEST_ASSERT_INT_EQ(cutil_forward_list_foreach(test->forward_list, forward_list_foreach_visit, &visitor), 10);
+    CTEST_ASSERT_INT_EQ(visitor.count, 10);
+
+    for (i = 0; i < 10; i++) {
+        CTEST_ASSERT_INT_EQ(visitor.items[i], 9 - i);
+    }
+}
+
+void forward_list_foreach_early_exit(forward_list_test* test) {
+    forward_list_foreach_visitor visitor;
+    int i;
+
+    memset(&visitor, 0, sizeof(visitor));
+    visitor.limit = 3;
+    test->forward_list = cutil_forward_list_create(cutil_trait_int());
+
+    for (i = 0; i < 10; i++) {
+        cutil_forward_list_push_front(test->forward_list, &i);
+    }
+
+    CTEST_ASSERT_INT_EQ(cutil_forward_list_foreach(test->forward_list, forward_list_foreach_visit, &visitor), 3);
+    CTEST_ASSERT_INT_EQ(visitor.count, 3);
+
+    for (i = 0; i < 3; i++) {
+        CTEST_ASSERT_INT_EQ(visitor.items[i], 9 - i);
+    }
+}
+
+/* items whose order is compared by key alone, the sequence records their original order */
+typedef struct {
+    int key;
+    int sequence;
+} forward_list_sort_item;
+
+int forward_list_sort_item_compare(void* a, void* b, void* user_data) {
+    (void)user_data;
+
+    return ((forward_list_sort_item*)a)->key - ((forward_list_sort_item*)b)->key;
+}
+
+void forward_list_sort_random(forward_list_test* test) {
+    unsigned int seed = 12345U;
+    int i, value, previous = -1, count = 0;
+
+    test->forward_list = cutil_forward_list_create(cutil_trait_int());
+
+    for (i = 0; i < 1000; i++) {
+        seed = seed * 1103515245U + 12345U;
+        value = (int)((seed >> 8) % 100);
+        cutil_forward_list_push_front(test->forward_list, &value);
+    }
+
+    CTEST_ASSERT_TRUE(cutil_forward_list_sort(test->forward_list));
+
+    test->itr = cutil_forward_list_itr_create(test->forward_list);
+
+    while (cutil_forward_list_itr_next(test->itr, &value)) {
+        CTEST_ASSERT_TRUE(value >= previous);
+        previous = value;
+        count += 1;
+    }
+
+    CTEST_ASSERT_INT_EQ(count, 1000);
+}
+
+void forward_list_sort_empty(forward_list_test* test) {
+    test->forward_list = cutil_forward_list_create(cutil_trait_int());
+
+    CTEST_ASSERT_TRUE(cutil_forward_list_sort(test->forward_list));
+    CTEST_ASSERT_TRUE(cutil_forward_list_empty(test->forward_list));
+}
+
+/* equal items keep the order they had before sorting */
+void forward_list_sort_stable(forward_list_test* test) {
+    cutil_trait item_trait;
+    forward_list_sort_item item, previous;
+    int i;
+
+    memset(&item_trait, 0, sizeof(cutil_trait));
+    item_trait.size = sizeof(forward_list_sort_item);
+    item_trait.compare_func = forward_list_sort_item_compare;
+    test->forward_list = cutil_forward_list_create(&item_trait);
+
+    /* items are pushed to the front, so the sequence increases from front to back */
+    for (i = 0; i < 100; i++) {
+        item.key = (i * 7) % 5;
+        item.sequence = 100 - i;
+        cutil_forward_list_push_front(test->forward_list, &item);
+    }
+
+    CTEST_ASSERT_TRUE(cutil_forward_list_sort(test->forward_list));
+
+    test->itr = cutil_forward_list_itr_create(test->forward_list);
+    cutil_forward_list_itr_next(test->itr, &previous);
+
+    while (cutil_forward_list_itr_next(test->itr, &item)) {
+        CTEST_ASSERT_TRUE(item.key > previous.key || (item.key == previous.key && item.sequence > previous.sequence));
+        previous = item;
+    }
+
+    cutil_forward_list_itr_destroy(test->itr);
+    cutil_forward_list_destroy(test->forward_list);
+    test->itr = NULL;
+    test->forward_list = NULL;
+}
+
+/* checks that the items of the list are the supplied values, from front to back */
+int forward_list_items_equal(cutil_forward_list* list, int* values, int count) {
+    cutil_forward_list_itr itr;
+    int value, i = 0;
+
+    cutil_forward_list_itr_init(&itr, list);
+
+    while (cutil_forward_list_itr_next(&itr, &value)) {
+        if (i >= count || value != values[i]) {
+            return 0;
+        }
+
+        i += 1;
+    }
+
+    return i == count && cutil_forward_list_size(list) == (unsigned int)count;
+}
+
+void size_forward_list(forward_list_test* test) {
+    int i;
+
+    test->forward_list = cutil_forward_list_create(cutil_trait_int());
+    CTEST_ASSERT_INT_EQ(cutil_forward_list_size(test->forward_list), 0);
+
+    for (i = 0; i < 5; i++) {
+        cutil_forward_list_push_front(test->forward_list, &i);
+        cutil_forward_list_push_back(test->forward_list, &i);
+    }
+
+    CTEST_ASSERT_INT_EQ(cutil_forward_list_size(test->forward_list), 10);
+
+    cutil_forward_list_pop_front(test->forward_list);
+    CTEST_ASSERT_INT_EQ(cutil_forward_list_size(test->forward_list), 9);
+
+    cutil_forward_list_clear(test->forward_list);
+    CTEST_ASSERT_INT_EQ(cutil_forward_list_size(test->forward_list), 0);
+}
+
+void push_back_forward_list(forward_list_test* test) {
+    int expected[4] = {0, 1, 2, 3};
+    int i;
+
+    test->forward_list = cutil_forward_list_create(cutil_trait_int());
+
+    for (i = 1; i < 4; i++) {
+        cutil_forward_list_push_back(test->forward_list, &i);
+    }
+
+    i = 0;
+    cutil_forward_list_push_front(test->forward_list, &i);
+
+    CTEST_ASSERT_TRUE(forward_list_items_equal(test->forward_list, expected, 4));
+}
+
+/* items pushed to the back are popped from the front in the same order, including after the list has been emptied */
+void push_back_queue_forward_list(forward_list_test* test) {
+    int i, value;
+
+    test->forward_list = cutil_forward_list_create(cutil_trait_int());
+
+    for (i = 0; i < 3; i++) {
+        cutil_forward_list_push_back(test->forward_list, &i);
+    }
+
+    for (i = 0; i < 3; i++) {
+        CTEST_ASSERT_TRUE(cutil_forward_list_front(test->forward_list, &value));
+        CTEST_ASSERT_INT_EQ(value, i);
+        cutil_forward_list_pop_front(test->forward_list);
+    }
+
+    CTEST_ASSERT_TRUE(cutil_forward_list_empty(test->forward_list));
+
+    i = 10;
+    cutil_forward_list_push_back(test->forward_list, &i);
+    CTEST_ASSERT_TRUE(forward_list_items_equal(test->forward_list, &i, 1));
+}
+
+/* sorting moves the last node, which must still be followed by items pushed to the back */
+void push_back_after_sort_forward_list(forward_list_test* test) {
+    int values[4] = {3, 1, 2, 0};
+    int expected[4] = {1, 2, 3, 0};
+    int i;
+
+    test->forward_list = cutil_forward_list_create(cutil_trait_int());
+
+    for (i = 0; i < 3; i++) {
+        cutil_forward_list_push_back(test->forward_list, &values[i]);
+    }
+
+    cutil_forward_list_sort(test->forward_list);
+    cutil_forward_list_push_back(test->forward_list, &values[3]);
+
+    CTEST_ASSERT_TRUE(forward_list_items_equal(test->forward_list, expected, 4));
+}
+
+/* a list used as a queue reuses the nodes of popped items once the cache holds enough of them */
+void node_cache_queue_forward_list(forward_list_test* test) {
+    int i, value;
+
+    test->forward_list = cutil_forward_list_create(cutil_trait_int());
+    cutil_forward_list_set_node_cache_capacity(test->forward_list, 4);
+
+    for (i = 0; i < 4; i++) {
+        cutil_forward_list_push_back(test->forward_list, &i);
+    }
+
+    cutil_test_allocation_tracker_begin();
+
+    for (i = 4; i < 1000; i++) {
+        cutil_forward_list_pop_front(test->forward_list);
+        cutil_forward_list_push_back(test->forward_list, &i);
+    }
+
+    CTEST_ASSERT_INT_EQ(cutil_test_allocation_tracker_allocation_count(), 0);
+    CTEST_ASSERT_INT_EQ(cutil_test_allocation_tracker_free_count(), 0);
+
+    cutil_test_allocation_tracker_end();
+
+    CTEST_ASSERT_INT_EQ(cutil_forward_list_node_cache_hit_count(test->forward_list), 996);
+    CTEST_ASSERT_INT_EQ(cutil_forward_list_node_cache_miss_count(test->forward_list), 4);
+    CTEST_ASSERT_TRUE(cutil_forward_list_front(test->forward_list, &value));
+    CTEST_ASSERT_INT_EQ(value, 996);
+}
+
+/* the cache holds at most its capacity, and reducing the capacity frees the excess nodes */
+void node_cache_capacity_forward_list(forward_list_test* test) {
+    int i;
+
+    test->forward_list = cutil_forward_list_create(cutil_trait_int());
+    CTEST_ASSERT_INT_EQ(cutil_forward_list_get_node_cache_capacity(test->forward_list), 0);
+    cutil_forward_list_set_node_cache_capacity(test->forward_list, 3);
+
+    for (i = 0; i < 10; i++) {
+        cutil_forward_list_push_front(test->forward_list, &i);
+    }
+
+    cutil_forward_list_clear(test->forward_list);
+    CTEST_ASSERT_INT_EQ(cutil_forward_list_node_cache_size(test->forward_list), 3);
+
+    cutil_forward_list_set_node_cache_capacity(test->forward_list, 0);
+    CTEST_ASSERT_INT_EQ(cutil_forward_list_node_cache_size(test->forward_list), 0);
+
+    cutil_forward_list_reset_node_cache_counters(test->forward_list);
+    CTEST_ASSERT_INT_EQ(cutil_forward_list_node_cache_miss_count(test->forward_list), 0);
+}
+
 void add_forward_list_tests() {
     CTEST_ADD_TEST_F(forward_list, clear_empty_forward_list);
 
@@ -150,6 +441,14 @@ void add_forward_list_tests() {
 
     CTEST_ADD_TEST_F(forward_list, push_front_multiple_forward_list);
 
+    CTEST_ADD_TEST_F(forward_list, size_forward_list);
+    CTEST_ADD_TEST_F(forward_list, push_back_forward_list);
+    CTEST_ADD_TEST_F(forward_list, push_back_queue_forward_list);
+    CTEST_ADD_TEST_F(forward_list, push_back_after_sort_forward_list);
+
+    CTEST_ADD_TEST_F(forward_list, node_cache_queue_forward_list);
+    CTEST_ADD_TEST_F(forward_list, node_cache_capacity_forward_list);
+
     CTEST_ADD_TEST_F(forward_list, front_empty_forward_list);
     CTEST_ADD_TEST_F(forward_list, front_pod_forward_list);
     CTEST_ADD_TEST_F(forward_list, front_pointer_forward_list);
@@ -157,4 +456,12 @@ void add_forward_list_tests() {
     CTEST_ADD_TEST_F(forward_list, pop_front_empty_forward_list);
     CTEST_ADD_TEST_F(forward_list, pop_front_one_item_forward_list);
     CTEST_ADD_TEST_F(forward_list, pop_front_removes_items_forward_list);
+
+    CTEST_ADD_TEST_F(forward_list, forward_list_foreach_empty);
+    CTEST_ADD_TEST_F(forward_list, forward_list_foreach_all);
+    CTEST_ADD_TEST_F(forward_list, forward_list_foreach_early_exit);
+
+    CTEST_ADD_TEST_F(forward_list, forward_list_sort_random);
+    CTEST_ADD_TEST_F(forward_list, forward_list_sort_empty);
+    CTEST_ADD_TEST_F(forward_list, forward_list_sort_stable);
 }
@@ -1,6 +1,7 @@
 #include "cutil/forward_list.h"
 
 #include "ctest/ctest.h"
+#include "test_util/allocation_tracker.h"
 
 #include <string.h>
 
@@ -92,6 +93,124 @@ void iterate_forward_list_next(forward_list_itr_test* test) {
     CTEST_ASSERT_INT_EQ(i, item_count);
 }
 
+/* iterators initialized in caller provided storage do not allocate */
+void init_no_allocation_forward_list(forward_list_itr_test* test) {
+    cutil_forward_list_itr itr;
+    int i, value, sum = 0;
+    size_t allocation_count;
+
+    test->forward_list = cutil_forward_list_create(cutil_trait_int());
+
+    for (i = 1; i <= 10; i++) {
+        cutil_forward_list_push_front(test->forward_list, &i);
+    }
+
+    cutil_test_allocation_tracker_begin();
+    cutil_forward_list_itr_init(&itr, test->forward_list);
+
+    while (cutil_forward_list_itr_next(&itr, &value)) {
+        sum += value;
+    }
+
+    allocation_count = cutil_test_allocation_tracker_allocation_count();
+    cutil_test_allocation_tracker_end();
+
+    CTEST_ASSERT_INT_EQ(allocation_count, 0);
+    CTEST_ASSERT_INT_EQ(sum, 55);
+}
+
+/* checks that the items of the list are the supplied values, from front to back */
+int forward_list_itr_items_equal(cutil_forward_list* list, int* values, int count) {
+    cutil_forward_list_itr itr;
+    int value, i = 0;
+
+    cutil_forward_list_itr_init(&itr, list);
+
+    while (cutil_forward_list_itr_next(&itr, &value)) {
+        if (i >= count || value != values[i]) {
+            return 0;
+        }
+
+        i += 1;
+    }
+
+    return i == count && cutil_forward_list_size(list) == (unsigned int)count;
+}
+
+void insert_after_forward_list(forward_list_itr_test* test) {
+    int expected[5] = {0, 1, 2, 3, 4};
+    int value;
+
+    test->forward_list = cutil_forward_list_create(cutil_trait_int());
+    test->itr = cutil_forward_list_itr_create(test->forward_list);
+
+    /* inserting before the front into an empty list */
+    value = 2;
+    cutil_forward_list_insert_after(test->itr, &value);
+    value = 0;
+    cutil_forward_list_insert_after(test->itr, &value);
+
+    CTEST_ASSERT_TRUE(cutil_forward_list_itr_next(test->itr, &value));
+    CTEST_ASSERT_INT_EQ(value, 0);
+
+    value = 1;
+    cutil_forward_list_insert_after(test->itr, &value);
+
+    /* inserting after the last item moves the back of the list */
+    cutil_forward_list_itr_next(test->itr, NULL);
+    cutil_forward_list_itr_next(test->itr, NULL);
+    value = 3;
+    cutil_forward_list_insert_after(test->itr, &value);
+    value = 4;
+    cutil_forward_list_push_back(test->forward_list, &value);
+
+    CTEST_ASSERT_TRUE(forward_list_itr_items_equal(test->forward_list, expected, 5));
+}
+
+void erase_after_forward_list(forward_list_itr_test* test) {
+    int expected[3] = {1, 3, 5};
+    int i;
+
+    test->forward_list = cutil_forward_list_create(cutil_trait_int());
+
+    for (i = 0; i < 5; i++) {
+        cutil_forward_list_push_back(test->forward_list, &i);
+    }
+
+    test->itr = cutil_forward_list_itr_create(test->forward_list);
+
+    /* removes the front, then every other item */
+    CTEST_ASSERT_TRUE(cutil_forward_list_erase_after(test->itr));
+
+    while (cutil_forward_list_itr_next(test->itr, NULL)) {
+        cutil_forward_list_erase_after(test->itr);
+    }
+
+    CTEST_ASSERT_FALSE(cutil_forward_list_erase_after(test->itr));
+
+    /* the last item was removed, so the new back follows the remaining items */
+    i = 5;
+    cutil_forward_list_push_back(test->forward_list, &i);
+
+    CTEST_ASSERT_TRUE(forward_list_itr_items_equal(test->forward_list, expected, 3));
+}
+
+void erase_after_empty_forward_list(forward_list_itr_test* test) {
+    int value = 1;
+
+    test->forward_list = cutil_forward_list_create(cutil_trait_int());
+    test->itr = cutil_forward_list_itr_create(test->forward_list);
+
+    CTEST_ASSERT_FALSE(cutil_forward_list_erase_after(test->itr));
+
+    cutil_forward_list_push_back(test->forward_list, &value);
+    CTEST_ASSERT_TRUE(cutil_forward_list_erase_after(test->itr));
+    CTEST_ASSERT_TRUE(cutil_forward_list_empty(test->forward_list));
+
+    cutil_forward_list_push_back(test->forward_list, &value);
+    CTEST_ASSERT_TRUE(forward_list_itr_items_equal(test->forward_list, &value, 1));
+}
+
 void add_forward_list_itr_tests() {
     CTEST_ADD_TEST_F(forward_list_itr, has_next_empty_forward_list);
     CTEST_ADD_TEST_F(forward_list_itr, has_next_forward_list);
@@ -100,4 +219,10 @@ void add_forward_list_itr_tests() {
     CTEST_ADD_TEST_F(forward_list_itr, next_null_forward_list);
 
     CTEST_ADD_TEST_F(forward_list_itr, iterate_forward_list_next);
+
+    CTEST_ADD_TEST_F(forward_list_itr, init_no_allocation_forward_list);
+
+    CTEST_ADD_TEST_F(forward_list_itr, insert_after_forward_list);
+    CTEST_ADD_TEST_F(forward_list_itr, erase_after_forward_list);
+    CTEST_ADD_TEST_F(forward_list_itr, erase_after_empty_forward_list);
 }
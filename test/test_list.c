@@ -1,5 +1,6 @@
 #include "test_util/defs.h"
 #include "test_util/trait_tracker.h"
+#include "test_util/allocation_tracker.h"
 
 #include "cutil/list.h"
 #include "ctest/ctest.h"
@@ -379,6 +380,365 @@ void delete_on_clear(list_trait_func_test* test) {
     CTEST_ASSERT_INT_EQ(cutil_test_trait_tracker_destroy_count(test->trait_tracker), expected_destroy_count);
 }
 
+/* records the items visited by foreach, stopping once the limit is reached */
+typedef struct {
+    int items[10];
+    int count;
+    int limit;
+} list_foreach_visitor;
+
+int list_foreach_visit(void* item, void* user_data) {
+    list_foreach_visitor* visitor = (list_foreach_visitor*)user_data;
+
+    visitor->items[visitor->count++] = *(int*)item;
+
+    return visitor->count < visitor->limit;
+}
+
+void list_foreach_empty(list_test* test) {
+    list_foreach_visitor visitor;
+
+    memset(&visitor, 0, sizeof(visitor));
+    visitor.limit = 10;
+    test->list = cutil_list_create(cutil_trait_int());
+
+    CTEST_ASSERT_INT_EQ(cutil_list_foreach(test->list, list_foreach_visit, &visitor), 0);
+    CTEST_ASSERT_INT_EQ(visitor.count, 0);
+}
+
+void list_foreach_all(list_test* test) {
+    list_foreach_visitor visitor;
+    int i;
+
+    memset(&visitor, 0, sizeof(visitor));
+    visitor.limit = 10;
+    test->list = cutil_list_create(cutil_trait_int());
+
+    for (i = 0; i < 10; i++) {
+        cutil_list_push_back(test->list, &i);
+    }
+
+    CTEST_ASSERT_INT_EQ(cutil_list_foreach(test->list, list_foreach_visit, &visitor), 10);
+    CTEST_ASSERT_INT_EQ(visitor.count, 10);
+
+    for (i = 0; i < 10; i++) {
+        CTEST_ASSERT_INT_EQ(visitor.items[i], i);
+    }
+}
+
+void list_foreach_early_exit(list_test* test) {
+    list_foreach_visitor visitor;
+    int i;
+
+    memset(&visitor, 0, sizeof(visitor));
+    visitor.limit = 3;
+    test->list = cutil_list_create(cutil_trait_int());
+
+    for (i = 0; i < 10; i++) {
+        cutil_list_push_back(test->list, &i);
+    }
+
+    CTEST_ASSERT_INT_EQ(cutil_list_foreach(test->list, list_foreach_visit, &visitor), 3);
+    CTEST_ASSERT_INT_EQ(visitor.count, 3);
+
+    for (i = 0; i < 3; i++) {
+        CTEST_ASSERT_INT_EQ(visitor.items[i], i);
+    }
+}
+
+/* items whose order is compared by key alone, the sequence records their original order */
+typedef struct {
+    int key;
+    int sequence;
+} list_sort_item;
+
+int list_sort_item_compare(void* a, void* b, void* user_data) {
+    (void)user_data;
+
+    return ((list_sort_item*)a)->key - ((list_sort_item*)b)->key;
+}
+
+/* checks that the list is sorted and that its items are reached in reverse order when iterating backwards */
+int list_sorted(cutil_list* list, int expected_size) {
+    cutil_list_itr itr;
+    int previous = 0, value, count = 0;
+
+    cutil_list_itr_init(&itr, list);
+
+    while (cutil_list_itr_next(&itr, &value)) {
+        if (count > 0 && value < previous) {
+            return 0;
+        }
+
+        previous = value;
+        count += 1;
+    }
+
+    while (cutil_list_itr_prev(&itr, &value)) {
+        if (value > previous) {
+            return 0;
+        }
+
+        previous = value;
+        count -= 1;
+    }
+
+    return count == 1 && cutil_list_size(list) == (unsigned int)expected_size;
+}
+
+void list_sort_random(list_test* test) {
+    unsigned int seed = 12345U;
+    int i, value;
+
+    test->list = cutil_list_create(cutil_trait_int());
+
+    for (i = 0; i < 1000; i++) {
+        seed = seed * 1103515245U + 12345U;
+        value = (int)((seed >> 8) % 100);
+        cutil_list_push_back(test->list, &value);
+    }
+
+    CTEST_ASSERT_TRUE(cutil_list_sort(test->list));
+    CTEST_ASSERT_TRUE(list_sorted(test->list, 1000));
+}
+
+void list_sort_small(list_test* test) {
+    int i;
+
+    test->list = cutil_list_create(cutil_trait_int());
+    CTEST_ASSERT_TRUE(cutil_list_sort(test->list));
+    CTEST_ASSERT_INT_EQ(cutil_list_size(test->list), 0);
+
+    for (i = 3; i > 0; i--) {
+        cutil_list_push_back(test->list, &i);
+        CTEST_ASSERT_TRUE(cutil_list_sort(test->list));
+        CTEST_ASSERT_TRUE(list_sorted(test->list, 4 - i));
+    }
+}
+
+/* equal items keep the order they had before sorting */
+void list_sort_stable(list_test* test) {
+    cutil_trait item_trait;
+    cutil_list_itr itr;
+    list_sort_item item, previous;
+    int i;
+
+    memset(&item_trait, 0, sizeof(cutil_trait));
+    item_trait.size = sizeof(list_sort_item);
+    item_trait.compare_func = list_sort_item_compare;
+    test->list = cutil_list_create(&item_trait);
+
+    for (i = 0; i < 100; i++) {
+        item.key = (i * 7) % 5;
+        item.sequence = i;
+        cutil_list_push_back(test->list, &item);
+    }
+
+    CTEST_ASSERT_TRUE(cutil_list_sort(test->list));
+
+    cutil_list_itr_init(&itr, test->list);
+    cutil_list_itr_next(&itr, &previous);
+
+    while (cutil_list_itr_next(&itr, &item)) {
+        CTEST_ASSERT_TRUE(item.key > previous.key || (item.key == previous.key && item.sequence > previous.sequence));
+        previous = item;
+    }
+
+    cutil_list_destroy(test->list);
+    test->list = NULL;
+}
+
+/* sorting relinks the existing nodes and does not copy items */
+void list_sort_no_copy(list_trait_func_test* test) {
+    char* str;
+    char* strs[3] = {"c", "a", "b"};
+    int i;
+
+    test->trait_tracker = cutil_test_create_trait_tracker(cutil_trait_cstring());
+    test->list = cutil_list_create(test->trait_tracker);
+
+    for (i = 0; i < 3; i++) {
+        cutil_list_push_back(test->list, &strs[i]);
+    }
+
+    cutil_test_trait_tracker_reset_counts(test->trait_tracker);
+    CTEST_ASSERT_TRUE(cutil_list_sort(test->list));
+
+    CTEST_ASSERT_INT_EQ(cutil_test_trait_tracker_copy_count(test->trait_tracker), 0);
+    CTEST_ASSERT_INT_EQ(cutil_test_trait_tracker_destroy_count(test->trait_tracker), 0);
+    CTEST_ASSERT_TRUE(cutil_test_trait_tracker_compare_count(test->trait_tracker) > 0);
+
+    cutil_list_front(test->list, &str);
+    CTEST_ASSERT_TRUE(strcmp(str, "a") == 0);
+    cutil_list_back(test->list, &str);
+    CTEST_ASSERT_TRUE(strcmp(str, "c") == 0);
+}
+
+void list_sort_no_compare(list_test* test) {
+    cutil_trait item_trait;
+    int value = 1;
+
+    memset(&item_trait, 0, sizeof(cutil_trait));
+    item_trait.size = sizeof(int);
+    test->list = cutil_list_create(&item_trait);
+    cutil_list_push_back(test->list, &value);
+
+    CTEST_ASSERT_FALSE(cutil_list_sort(test->list));
+
+    cutil_list_destroy(test->list);
+    test->list = NULL;
+}
+
+void list_merge_sorted(list_test* test) {
+    cutil_list* other;
+    int i;
+
+    test->list = cutil_list_create(cutil_trait_int());
+    other = cutil_list_create(cutil_trait_int());
+
+    for (i = 0; i < 20; i++) {
+        cutil_list_push_back(i % 3 == 0 ? test->list : other, &i);
+    }
+
+    CTEST_ASSERT_TRUE(cutil_list_merge(test->list, other));
+    CTEST_ASSERT_TRUE(list_sorted(test->list, 20));
+    CTEST_ASSERT_INT_EQ(cutil_list_size(other), 0);
+
+    /* the other list remains usable */
+    cutil_list_push_back(other, &i);
+    CTEST_ASSERT_TRUE(cutil_list_merge(test->list, other));
+    CTEST_ASSERT_TRUE(list_sorted(test->list, 21));
+
+    cutil_list_destroy(other);
+}
+
+void list_merge_empty(list_test* test) {
+    cutil_list* other;
+    int i;
+
+    test->list = cutil_list_create(cutil_trait_int());
+    other = cutil_list_create(cutil_trait_int());
+
+    for (i = 0; i < 5; i++) {
+        cutil_list_push_back(other, &i);
+    }
+
+    CTEST_ASSERT_TRUE(cutil_list_merge(test->list, other));
+    CTEST_ASSERT_TRUE(list_sorted(test->list, 5));
+
+    CTEST_ASSERT_TRUE(cutil_list_merge(test->list, other));
+    CTEST_ASSERT_TRUE(list_sorted(test->list, 5));
+
+    cutil_list_destroy(other);
+}
+
+void list_merge_different_traits(list_test* test) {
+    cutil_list* other;
+    float value = 1.0f;
+
+    test->list = cutil_list_create(cutil_trait_int());
+    other = cutil_list_create(cutil_trait_float());
+    cutil_list_push_back(other, &value);
+
+    CTEST_ASSERT_FALSE(cutil_list_merge(test->list, other));
+    CTEST_ASSERT_INT_EQ(cutil_list_size(other), 1);
+
+    cutil_list_destroy(other);
+}
+
+void list_node_cache_disabled(list_test* test) {
+    int i;
+
+    test->list = cutil_list_create(cutil_trait_int());
+
+    for (i = 0; i < 10; i++) {
+        cutil_list_push_back(test->list, &i);
+        cutil_list_pop_front(test->list);
+    }
+
+    CTEST_ASSERT_INT_EQ(cutil_list_get_node_cache_capacity(test->list), 0);
+    CTEST_ASSERT_INT_EQ(cutil_list_node_cache_size(test->list), 0);
+    CTEST_ASSERT_INT_EQ(cutil_list_node_cache_hit_count(test->list), 0);
+    CTEST_ASSERT_INT_EQ(cutil_list_node_cache_miss_count(test->list), 10);
+}
+
+/* a list used as a queue reuses the nodes of popped items once the cache holds enough of them */
+void list_node_cache_queue_no_allocation(list_test* test) {
+    int i, value;
+
+    test->list = cutil_list_create(cutil_trait_int());
+    cutil_list_set_node_cache_capacity(test->list, 4);
+
+    for (i = 0; i < 4; i++) {
+        cutil_list_push_back(test->list, &i);
+    }
+
+    cutil_test_allocation_tracker_begin();
+
+    for (i = 4; i < 1000; i++) {
+        cutil_list_pop_front(test->list);
+        cutil_list_push_back(test->list, &i);
+    }
+
+    CTEST_ASSERT_INT_EQ(cutil_test_allocation_tracker_allocation_count(), 0);
+    CTEST_ASSERT_INT_EQ(cutil_test_allocation_tracker_free_count(), 0);
+
+    cutil_test_allocation_tracker_end();
+
+    CTEST_ASSERT_INT_EQ(cutil_list_node_cache_hit_count(test->list), 996);
+    CTEST_ASSERT_INT_EQ(cutil_list_node_cache_miss_count(test->list), 4);
+    CTEST_ASSERT_TRUE(cutil_list_front(test->list, &value));
+    CTEST_ASSERT_INT_EQ(value, 996);
+
+    cutil_list_reset_node_cache_counters(test->list);
+    CTEST_ASSERT_INT_EQ(cutil_list_node_cache_hit_count(test->list), 0);
+    CTEST_ASSERT_INT_EQ(cutil_list_node_cache_miss_count(test->list), 0);
+}
+
+/* the cache holds at most its capacity, and reducing the capacity frees the excess nodes */
+void list_node_cache_capacity(list_test* test) {
+    int i;
+
+    test->list = cutil_list_create(cutil_trait_int());
+    cutil_list_set_node_cache_capacity(test->list, 3);
+
+    for (i = 0; i < 10; i++) {
+        cutil_list_push_back(test->list, &i);
+    }
+
+    cutil_list_clear(test->list);
+    CTEST_ASSERT_INT_EQ(cutil_list_node_cache_size(test->list), 3);
+
+    cutil_test_allocation_tracker_begin();
+    cutil_list_set_node_cache_capacity(test->list, 1);
+    CTEST_ASSERT_INT_EQ(cutil_test_allocation_tracker_free_count(), 4);
+    cutil_test_allocation_tracker_end();
+
+    CTEST_ASSERT_INT_EQ(cutil_list_node_cache_size(test->list), 1);
+    CTEST_ASSERT_INT_EQ(cutil_list_get_node_cache_capacity(test->list), 1);
+}
+
+/* items are destroyed when they are removed even though their nodes are cached */
+void list_node_cache_destroys_items(list_trait_func_test* test) {
+    char* strs[2] = {"first", "second"};
+    char* str;
+
+    test->trait_tracker = cutil_test_create_trait_tracker(cutil_trait_cstring());
+    test->list = cutil_list_create(test->trait_tracker);
+    cutil_list_set_node_cache_capacity(test->list, 2);
+
+    cutil_list_push_back(test->list, &strs[0]);
+    cutil_list_pop_back(test->list);
+    CTEST_ASSERT_INT_EQ(cutil_test_trait_tracker_destroy_count(test->trait_tracker), 1);
+
+    cutil_list_push_front(test->list, &strs[1]);
+    CTEST_ASSERT_INT_EQ(cutil_test_trait_tracker_copy_count(test->trait_tracker), 2);
+    CTEST_ASSERT_INT_EQ(cutil_list_node_cache_hit_count(test->list), 1);
+
+    cutil_list_front(test->list, &str);
+    CTEST_ASSERT_TRUE(strcmp(str, "second") == 0);
+}
+
 void add_list_tests(){
     CTEST_ADD_TEST_F(list, init_size_0_list);
 
@@ -413,4 +773,22 @@ void add_list_tests(){
     CTEST_ADD_TEST_F(list_trait_func, delete_pop_back);
     CTEST_ADD_TEST_F(list_trait_func, delete_on_destroy);
     CTEST_ADD_TEST_F(list_trait_func, delete_on_clear);
+
+    CTEST_ADD_TEST_F(list, list_foreach_empty);
+    CTEST_ADD_TEST_F(list, list_foreach_all);
+    CTEST_ADD_TEST_F(list, list_foreach_early_exit);
+
+    CTEST_ADD_TEST_F(list, list_sort_random);
+    CTEST_ADD_TEST_F(list, list_sort_small);
+    CTEST_ADD_TEST_F(list, list_sort_stable);
+    CTEST_ADD_TEST_F(list_trait_func, list_sort_no_copy);
+    CTEST_ADD_TEST_F(list, list_sort_no_compare);
+    CTEST_ADD_TEST_F(list, list_merge_sorted);
+    CTEST_ADD_TEST_F(list, list_merge_empty);
+    CTEST_ADD_TEST_F(list, list_merge_different_traits);
+
+    CTEST_ADD_TEST_F(list, list_node_cache_disabled);
+    CTEST_ADD_TEST_F(list, list_node_cache_queue_no_allocation);
+    CTEST_ADD_TEST_F(list, list_node_cache_capacity);
+    CTEST_ADD_TEST_F(list_trait_func, list_node_cache_destroys_items);
 }
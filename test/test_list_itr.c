@@ -4,6 +4,7 @@
 #include "cutil/allocator.h"
 
 #include "ctest/ctest.h"
+#include "test_util/allocation_tracker.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -262,6 +263,235 @@ void back_forward(list_itr_test* test) {
     CTEST_ASSERT_FALSE(cutil_list_itr_prev(test->itr, NULL));
 }
 
+/* iterators initialized in caller provided storage do not allocate */
+void init_no_allocation(list_itr_test* test) {
+    cutil_list_itr itr;
+    int i, value, sum = 0;
+    size_t allocation_count;
+
+    test->list = cutil_list_create(cutil_trait_int());
+
+    for (i = 1; i <= 10; i++) {
+        cutil_list_push_back(test->list, &i);
+    }
+
+    cutil_test_allocation_tracker_begin();
+    cutil_list_itr_init(&itr, test->list);
+
+    while (cutil_list_itr_next(&itr, &value)) {
+        sum += value;
+    }
+
+    while (cutil_list_itr_prev(&itr, &value)) {
+        sum += value;
+    }
+
+    allocation_count = cutil_test_allocation_tracker_allocation_count();
+    cutil_test_allocation_tracker_end();
+
+    CTEST_ASSERT_INT_EQ(allocation_count, 0);
+    CTEST_ASSERT_INT_EQ(sum, 55 + 45);
+}
+
+/* Creates a list holding the integers [0, count) */
+cutil_list* create_sequence_list(int count) {
+    cutil_list* list = cutil_list_create(cutil_trait_int());
+    int i;
+
+    for (i = 0; i < count; i++) {
+        cutil_list_push_back(list, &i);
+    }
+
+    return list;
+}
+
+/* Checks the items of a list in both directions */
+int list_matches(cutil_list* list, int* expected, int count) {
+    cutil_list_itr itr;
+    int i = 0, value;
+
+    if (cutil_list_size(list) != (unsigned int)count) {
+        return 0;
+    }
+
+    cutil_list_itr_init(&itr, list);
+
+    while (cutil_list_itr_next(&itr, &value)) {
+        if (i >= count || value != expected[i++]) {
+            return 0;
+        }
+    }
+
+    cutil_list_itr_init(&itr, list);
+
+    while (cutil_list_itr_prev(&itr, &value)) {
+        if (i <= 0 || value != expected[--i]) {
+            return 0;
+        }
+    }
+
+    return i == 0;
+}
+
+void insert_before_item(list_itr_test* test) {
+    int expected[5] = {0, 1, 10, 2, 3};
+    int value = 10;
+
+    test->list = create_sequence_list(4);
+    test->itr = cutil_list_itr_create(test->list);
+
+    cutil_list_itr_next(test->itr, NULL);
+    cutil_list_itr_next(test->itr, NULL);
+    cutil_list_itr_next(test->itr, NULL);
+    cutil_list_insert_before(test->itr, &value);
+
+    CTEST_ASSERT_TRUE(list_matches(test->list, expected, 5));
+
+    /* the iterator remains at its item */
+    CTEST_ASSERT_TRUE(cutil_list_itr_prev(test->itr, &value));
+    CTEST_ASSERT_INT_EQ(value, 10);
+}
+
+void insert_before_front(list_itr_test* test) {
+    int expected[3] = {0, 1, 2};
+    int i;
+
+    test->list = cutil_list_create(cutil_trait_int());
+    test->itr = cutil_list_itr_create(test->list);
+
+    /* an iterator positioned before the front inserts at the back */
+    for (i = 0; i < 3; i++) {
+        cutil_list_insert_before(test->itr, &i);
+    }
+
+    CTEST_ASSERT_TRUE(list_matches(test->list, expected, 3));
+}
+
+void erase_while_iterating(list_itr_test* test) {
+    int expected[5] = {1, 3, 5, 7, 9};
+    int value;
+
+    test->list = create_sequence_list(10);
+    test->itr = cutil_list_itr_create(test->list);
+
+    CTEST_ASSERT_FALSE(cutil_list_erase(test->itr));
+
+    while (cutil_list_itr_next(test->itr, &value)) {
+        if (value % 2 == 0) {
+            CTEST_ASSERT_TRUE(cutil_list_erase(test->itr));
+        }
+    }
+
+    CTEST_ASSERT_TRUE(list_matches(test->list, expected, 5));
+}
+
+void splice_between_lists(list_itr_test* test) {
+    int expected_dst[5] = {0, 12, 1, 2, 3};
+    int expected_src[2] = {10, 11};
+    cutil_list* src_list = cutil_list_create(cutil_trait_int());
+    cutil_list_itr dst_itr, src_itr;
+    size_t allocation_count;
+    int i, value;
+
+    test->list = create_sequence_list(4);
+
+    for (i = 10; i < 13; i++) {
+        cutil_list_push_back(src_list, &i);
+    }
+
+    cutil_list_itr_init(&dst_itr, test->list);
+    cutil_list_itr_next(&dst_itr, NULL);
+    cutil_list_itr_next(&dst_itr, NULL);
+
+    cutil_list_itr_init(&src_itr, src_list);
+    cutil_list_itr_prev(&src_itr, NULL);
+
+    cutil_test_allocation_tracker_begin();
+    CTEST_ASSERT_TRUE(cutil_list_splice(&dst_itr, src_list, &src_itr));
+    allocation_count = cutil_test_allocation_tracker_allocation_count() + cutil_test_allocation_tracker_free_count();
+    cutil_test_allocation_tracker_end();
+
+    CTEST_ASSERT_INT_EQ(allocation_count, 0);
+    CTEST_ASSERT_TRUE(list_matches(test->list, expected_dst, 5));
+    CTEST_ASSERT_TRUE(list_matches(src_list, expected_src, 2));
+
+    /* the source iterator is moved to the preceding item */
+    CTEST_ASSERT_TRUE(cutil_list_itr_next(&src_itr, &value) == 0);
+    cutil_list_itr_prev(&src_itr, &value);
+    CTEST_ASSERT_INT_EQ(value, 10);
+
+    cutil_list_destroy(src_list);
+}
+
+/* moving an item to the front of its own list, as a recently used list does */
+void splice_to_front(list_itr_test* test) {
+    int expected[5] = {3, 0, 1, 2, 4};
+    int expected_after_back[5] = {0, 1, 2, 4, 3};
+    cutil_list_itr front_itr, itr, end_itr;
+    int value;
+
+    test->list = create_sequence_list(5);
+
+    cutil_list_itr_init(&itr, test->list);
+
+    do {
+        cutil_list_itr_next(&itr, &value);
+    } while (value != 3);
+
+    cutil_list_itr_init(&front_itr, test->list);
+    cutil_list_itr_next(&front_itr, NULL);
+
+    CTEST_ASSERT_TRUE(cutil_list_splice(&front_itr, test->list, &itr));
+    CTEST_ASSERT_TRUE(list_matches(test->list, expected, 5));
+
+    /* splicing an item in front of itself or its successor leaves the list unchanged */
+    cutil_list_itr_init(&itr, test->list);
+    cutil_list_itr_next(&itr, NULL);
+    front_itr = itr;
+    CTEST_ASSERT_TRUE(cutil_list_splice(&front_itr, test->list, &itr));
+    CTEST_ASSERT_TRUE(list_matches(test->list, expected, 5));
+
+    /* a destination positioned before the front moves the item to the back */
+    cutil_list_itr_init(&end_itr, test->list);
+    cutil_list_itr_init(&itr, test->list);
+    cutil_list_itr_next(&itr, NULL);
+
+    CTEST_ASSERT_TRUE(cutil_list_splice(&end_itr, test->list, &itr));
+    CTEST_ASSERT_TRUE(list_matches(test->list, expected_after_back, 5));
+}
+
+void splice_invalid(list_itr_test* test) {
+    cutil_list* other_list = cutil_list_create(cutil_trait_float());
+    cutil_list* src_list = create_sequence_list(3);
+    cutil_list_itr dst_itr, src_itr, other_itr;
+    float f = 1.0f;
+
+    test->list = create_sequence_list(3);
+    cutil_list_push_back(other_list, &f);
+
+    cutil_list_itr_init(&dst_itr, test->list);
+    cutil_list_itr_init(&src_itr, src_list);
+    cutil_list_itr_init(&other_itr, other_list);
+
+    /* the source iterator is not positioned at an item */
+    CTEST_ASSERT_FALSE(cutil_list_splice(&dst_itr, src_list, &src_itr));
+
+    /* the source iterator belongs to a different list */
+    cutil_list_itr_next(&src_itr, NULL);
+    CTEST_ASSERT_FALSE(cutil_list_splice(&dst_itr, other_list, &src_itr));
+
+    /* the lists have different traits */
+    cutil_list_itr_next(&other_itr, NULL);
+    CTEST_ASSERT_FALSE(cutil_list_splice(&dst_itr, other_list, &other_itr));
+
+    CTEST_ASSERT_INT_EQ(cutil_list_size(test->list), 3);
+    CTEST_ASSERT_INT_EQ(cutil_list_size(src_list), 3);
+    CTEST_ASSERT_INT_EQ(cutil_list_size(other_list), 1);
+
+    cutil_list_destroy(src_list);
+    cutil_list_destroy(other_list);
+}
+
 void add_list_itr_tests() {
     CTEST_ADD_TEST_F(list_itr, has_next_empty);
     CTEST_ADD_TEST_F(list_itr, has_next);
@@ -285,4 +515,13 @@ void add_list_itr_tests() {
 
     CTEST_ADD_TEST_F(list_itr, forward_back);
     CTEST_ADD_TEST_F(list_itr, back_forward);
+
+    CTEST_ADD_TEST_F(list_itr, init_no_allocation);
+
+    CTEST_ADD_TEST_F(list_itr, insert_before_item);
+    CTEST_ADD_TEST_F(list_itr, insert_before_front);
+    CTEST_ADD_TEST_F(list_itr, erase_while_iterating);
+    CTEST_ADD_TEST_F(list_itr, splice_between_lists);
+    CTEST_ADD_TEST_F(list_itr, splice_to_front);
+    CTEST_ADD_TEST_F(list_itr, splice_invalid);
 }
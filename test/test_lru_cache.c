@@ -0,0 +1,275 @@
+#include "cutil/lru_cache.h"
+
+#include "ctest/ctest.h"
+#include "test_util/defs.h"
+#include "test_util/trait_tracker.h"
+#include "test_util/allocation_tracker.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define LRU_CACHE_TEST_COUNT 8
+
+typedef struct {
+    cutil_lru_cache* cache;
+    cutil_trait* trait_tracker;
+} lru_cache_test;
+
+void lru_cache_test_setup(lru_cache_test* test) {
+    memset(test, 0, sizeof(lru_cache_test));
+}
+
+void lru_cache_test_teardown(lru_cache_test* test) {
+    if (test->cache) {
+        cutil_lru_cache_destroy(test->cache);
+    }
+
+    if (test->trait_tracker) {
+        cutil_test_destroy_trait_tracker(test->trait_tracker);
+    }
+
+    cutil_trait_destroy();
+}
+
+CTEST_FIXTURE(lru_cache, lru_cache_test, lru_cache_test_setup, lru_cache_test_teardown)
+
+void lru_cache_put_int_range(cutil_lru_cache* cache, int min, int max) {
+    int i, value;
+
+    for (i = min; i < max; i++) {
+        value = i * 10;
+        cutil_lru_cache_put(cache, &i, &value);
+    }
+}
+
+void lru_cache_create_invalid(lru_cache_test* test) {
+    cutil_trait unhashable_trait;
+
+    (void)test;
+    memcpy(&unhashable_trait, cutil_trait_cstring(), sizeof(cutil_trait));
+    unhashable_trait.hash_func = NULL;
+
+    CTEST_ASSERT_PTR_NULL(cutil_lru_cache_create(cutil_trait_int(), cutil_trait_int(), 0));
+    CTEST_ASSERT_PTR_NULL(cutil_lru_cache_create_with_byte_limit(cutil_trait_int(), cutil_trait_int(), 0, NULL, NULL));
+    CTEST_ASSERT_PTR_NULL(cutil_lru_cache_create(&unhashable_trait, cutil_trait_int(), LRU_CACHE_TEST_COUNT));
+    CTEST_ASSERT_PTR_NULL(cutil_lru_cache_create(NULL, cutil_trait_int(), LRU_CACHE_TEST_COUNT));
+}
+
+void lru_cache_put_get(lru_cache_test* test) {
+    int i, value;
+
+    test->cache = cutil_lru_cache_create(cutil_trait_int(), cutil_trait_int(), LRU_CACHE_TEST_COUNT);
+    lru_cache_put_int_range(test->cache, 0, LRU_CACHE_TEST_COUNT);
+
+    CTEST_ASSERT_INT_EQ(cutil_lru_cache_size(test->cache), LRU_CACHE_TEST_COUNT);
+
+    for (i = 0; i < LRU_CACHE_TEST_COUNT; i++) {
+        CTEST_ASSERT_TRUE(cutil_lru_cache_get(test->cache, &i, &value));
+        CTEST_ASSERT_INT_EQ(value, i * 10);
+    }
+
+    CTEST_ASSERT_INT_EQ(cutil_lru_cache_hit_count(test->cache), LRU_CACHE_TEST_COUNT);
+    CTEST_ASSERT_INT_EQ(cutil_lru_cache_miss_count(test->cache), 0);
+    CTEST_ASSERT_INT_EQ(cutil_lru_cache_eviction_count(test->cache), 0);
+}
+
+void lru_cache_get_miss(lru_cache_test* test) {
+    int key = 100, value = -1;
+
+    test->cache = cutil_lru_cache_create(cutil_trait_int(), cutil_trait_int(), LRU_CACHE_TEST_COUNT);
+    lru_cache_put_int_range(test->cache, 0, 4);
+
+    CTEST_ASSERT_FALSE(cutil_lru_cache_get(test->cache, &key, &value));
+    CTEST_ASSERT_INT_EQ(value, -1);
+    CTEST_ASSERT_INT_EQ(cutil_lru_cache_miss_count(test->cache), 1);
+    CTEST_ASSERT_INT_EQ(cutil_lru_cache_hit_count(test->cache), 0);
+
+    cutil_lru_cache_reset_counters(test->cache);
+    CTEST_ASSERT_INT_EQ(cutil_lru_cache_miss_count(test->cache), 0);
+}
+
+/* once the cache is full the items inserted first are evicted first */
+void lru_cache_eviction_order(lru_cache_test* test) {
+    int i;
+
+    test->cache = cutil_lru_cache_create(cutil_trait_int(), cutil_trait_int(), LRU_CACHE_TEST_COUNT);
+    lru_cache_put_int_range(test->cache, 0, LRU_CACHE_TEST_COUNT + 3);
+
+    CTEST_ASSERT_INT_EQ(cutil_lru_cache_size(test->cache), LRU_CACHE_TEST_COUNT);
+    CTEST_ASSERT_INT_EQ(cutil_lru_cache_eviction_count(test->cache), 3);
+
+    for (i = 0; i < LRU_CACHE_TEST_COUNT + 3; i++) {
+        CTEST_ASSERT_INT_EQ(cutil_lru_cache_contains(test->cache, &i), i >= 3);
+    }
+}
+
+/* getting an item protects it from the next eviction while checking for it does not */
+void lru_cache_get_refreshes(lru_cache_test* test) {
+    int first = 0, second = 1, key = LRU_CACHE_TEST_COUNT, value = 0;
+
+    test->cache = cutil_lru_cache_create(cutil_trait_int(), cutil_trait_int(), LRU_CACHE_TEST_COUNT);
+    lru_cache_put_int_range(test->cache, 0, LRU_CACHE_TEST_COUNT);
+
+    CTEST_ASSERT_TRUE(cutil_lru_cache_get(test->cache, &first, &value));
+    CTEST_ASSERT_TRUE(cutil_lru_cache_contains(test->cache, &second));
+
+    cutil_lru_cache_put(test->cache, &key, &value);
+
+    CTEST_ASSERT_TRUE(cutil_lru_cache_contains(test->cache, &first));
+    CTEST_ASSERT_FALSE(cutil_lru_cache_contains(test->cache, &second));
+    CTEST_ASSERT_INT_EQ(cutil_lru_cache_hit_count(test->cache), 1);
+}
+
+/* replacing a value destroys the previous value and does not change the number of items */
+void lru_cache_replace(lru_cache_test* test) {
+    int key = 5;
+    char* str = "first";
+    char* result = NULL;
+
+    test->trait_tracker = cutil_test_create_trait_tracker(cutil_trait_cstring());
+    test->cache = cutil_lru_cache_create(cutil_trait_int(), test->trait_tracker, LRU_CACHE_TEST_COUNT);
+
+    cutil_lru_cache_put(test->cache, &key, &str);
+    str = "second";
+    cutil_lru_cache_put(test->cache, &key, &str);
+
+    CTEST_ASSERT_INT_EQ(cutil_lru_cache_size(test->cache), 1);
+    CTEST_ASSERT_INT_EQ(cutil_test_trait_tracker_copy_count(test->trait_tracker), 2);
+    CTEST_ASSERT_INT_EQ(cutil_test_trait_tracker_destroy_count(test->trait_tracker), 1);
+
+    CTEST_ASSERT_TRUE(cutil_lru_cache_get(test->cache, &key, &result));
+    CTEST_ASSERT_TRUE(strcmp(result, "second") == 0);
+
+    cutil_lru_cache_clear(test->cache);
+    CTEST_ASSERT_INT_EQ(cutil_lru_cache_size(test->cache), 0);
+    CTEST_ASSERT_INT_EQ(cutil_test_trait_tracker_destroy_count(test->trait_tracker), 2);
+}
+
+/* string keys are hashed by their contents rather than their pointers */
+void lru_cache_cstring_keys(lru_cache_test* test) {
+    char key[16];
+    char* key_ptr = key;
+    int i, value;
+
+    test->trait_tracker = cutil_test_create_trait_tracker(cutil_trait_cstring());
+    test->cache = cutil_lru_cache_create(test->trait_tracker, cutil_trait_int(), LRU_CACHE_TEST_COUNT);
+
+    for (i = 0; i < LRU_CACHE_TEST_COUNT * 2; i++) {
+        sprintf(key, "key%d", i);
+        cutil_lru_cache_put(test->cache, &key_ptr, &i);
+    }
+
+    CTEST_ASSERT_INT_EQ(cutil_test_trait_tracker_destroy_count(test->trait_tracker), LRU_CACHE_TEST_COUNT);
+
+    for (i = 0; i < LRU_CACHE_TEST_COUNT * 2; i++) {
+        sprintf(key, "key%d", i);
+        CTEST_ASSERT_INT_EQ(cutil_lru_cache_get(test->cache, &key_ptr, &value), i >= LRU_CACHE_TEST_COUNT);
+
+        if (i >= LRU_CACHE_TEST_COUNT) {
+            CTEST_ASSERT_INT_EQ(value, i);
+        }
+    }
+}
+
+size_t lru_cache_test_string_size(void* key, void* value, void* user_data) {
+    (void)key;
+    (void)user_data;
+
+    return strlen(*(char**)value);
+}
+
+/* items are evicted until the new item fits within the byte limit, items larger than the limit are rejected */
+void lru_cache_byte_limit(lru_cache_test* test) {
+    int key;
+    char* value;
+
+    test->cache = cutil_lru_cache_create_with_byte_limit(cutil_trait_int(), cutil_trait_cstring(), 10, lru_cache_test_string_size, NULL);
+
+    key = 1; value = "aaaa";
+    cutil_lru_cache_put(test->cache, &key, &value);
+    key = 2; value = "bbbb";
+    cutil_lru_cache_put(test->cache, &key, &value);
+    CTEST_ASSERT_INT_EQ(cutil_lru_cache_byte_size(test->cache), 8);
+
+    key = 3; value = "cccccc";
+    CTEST_ASSERT_TRUE(cutil_lru_cache_put(test->cache, &key, &value));
+    CTEST_ASSERT_INT_EQ(cutil_lru_cache_byte_size(test->cache), 10);
+    CTEST_ASSERT_INT_EQ(cutil_lru_cache_size(test->cache), 2);
+    CTEST_ASSERT_INT_EQ(cutil_lru_cache_eviction_count(test->cache), 1);
+
+    key = 4; value = "too large to fit";
+    CTEST_ASSERT_FALSE(cutil_lru_cache_put(test->cache, &key, &value));
+    CTEST_ASSERT_INT_EQ(cutil_lru_cache_size(test->cache), 2);
+    CTEST_ASSERT_INT_EQ(cutil_lru_cache_byte_size(test->cache), 10);
+
+    /* growing an existing item evicts the others */
+    key = 3; value = "cccccccccc";
+    CTEST_ASSERT_TRUE(cutil_lru_cache_put(test->cache, &key, &value));
+    CTEST_ASSERT_INT_EQ(cutil_lru_cache_size(test->cache), 1);
+    CTEST_ASSERT_INT_EQ(cutil_lru_cache_byte_size(test->cache), 10);
+}
+
+void lru_cache_erase(lru_cache_test* test) {
+    int key = 3;
+
+    test->cache = cutil_lru_cache_create(cutil_trait_int(), cutil_trait_int(), LRU_CACHE_TEST_COUNT);
+    lru_cache_put_int_range(test->cache, 0, LRU_CACHE_TEST_COUNT);
+
+    CTEST_ASSERT_TRUE(cutil_lru_cache_erase(test->cache, &key));
+    CTEST_ASSERT_FALSE(cutil_lru_cache_erase(test->cache, &key));
+    CTEST_ASSERT_FALSE(cutil_lru_cache_contains(test->cache, &key));
+    CTEST_ASSERT_INT_EQ(cutil_lru_cache_size(test->cache), LRU_CACHE_TEST_COUNT - 1);
+    CTEST_ASSERT_INT_EQ(cutil_lru_cache_eviction_count(test->cache), 0);
+}
+
+/* a full cache reuses the memory of evicted items */
+void lru_cache_steady_state_no_allocation(lru_cache_test* test) {
+    int i, value;
+
+    test->cache = cutil_lru_cache_create(cutil_trait_int(), cutil_trait_int(), LRU_CACHE_TEST_COUNT);
+    lru_cache_put_int_range(test->cache, 0, LRU_CACHE_TEST_COUNT);
+
+    cutil_test_allocation_tracker_begin();
+
+    lru_cache_put_int_range(test->cache, LRU_CACHE_TEST_COUNT, LRU_CACHE_TEST_COUNT * 100);
+
+    for (i = 0; i < LRU_CACHE_TEST_COUNT * 100; i++) {
+        cutil_lru_cache_get(test->cache, &i, &value);
+    }
+
+    CTEST_ASSERT_INT_EQ(cutil_test_allocation_tracker_allocation_count(), 0);
+    CTEST_ASSERT_INT_EQ(cutil_test_allocation_tracker_free_count(), 0);
+
+    cutil_test_allocation_tracker_end();
+
+    CTEST_ASSERT_INT_EQ(cutil_lru_cache_hit_count(test->cache), LRU_CACHE_TEST_COUNT);
+}
+
+/* byte limited caches grow their index as they fill */
+void lru_cache_many_items(lru_cache_test* test) {
+    int i, value;
+
+    test->cache = cutil_lru_cache_create_with_byte_limit(cutil_trait_int(), cutil_trait_int(), 1000 * 2 * sizeof(int), NULL, NULL);
+    lru_cache_put_int_range(test->cache, 0, 2000);
+
+    CTEST_ASSERT_INT_EQ(cutil_lru_cache_size(test->cache), 1000);
+
+    for (i = 1000; i < 2000; i++) {
+        CTEST_ASSERT_TRUE(cutil_lru_cache_get(test->cache, &i, &value));
+        CTEST_ASSERT_INT_EQ(value, i * 10);
+    }
+}
+
+void add_lru_cache_tests() {
+    CTEST_ADD_TEST_F(lru_cache, lru_cache_create_invalid);
+    CTEST_ADD_TEST_F(lru_cache, lru_cache_put_get);
+    CTEST_ADD_TEST_F(lru_cache, lru_cache_get_miss);
+    CTEST_ADD_TEST_F(lru_cache, lru_cache_eviction_order);
+    CTEST_ADD_TEST_F(lru_cache, lru_cache_get_refreshes);
+    CTEST_ADD_TEST_F(lru_cache, lru_cache_replace);
+    CTEST_ADD_TEST_F(lru_cache, lru_cache_cstring_keys);
+    CTEST_ADD_TEST_F(lru_cache, lru_cache_byte_limit);
+    CTEST_ADD_TEST_F(lru_cache, lru_cache_erase);
+    CTEST_ADD_TEST_F(lru_cache, lru_cache_steady_state_no_allocation);
+    CTEST_ADD_TEST_F(lru_cache, lru_cache_many_items);
+}
@@ -20,10 +20,25 @@ int main(int argc, char** argv) {
     add_forward_list_tests();
     add_forward_list_itr_tests();
     add_list_itr_tests();
+    add_unrolled_list_tests();
     add_btree_tests();
     add_btree_itr_tests();
+    add_btree_search_tests();
+    add_btree_snapshot_tests();
+    add_btree_concurrent_tests();
+    add_btree_file_tests();
+    add_btree_range_tests();
+    add_btree_merge_tests();
+    add_btree_stats_tests();
+    add_btree_compact_tests();
+    add_btree_rebalance_tests();
+    add_btree_page_tests();
     add_trait_tests();
+    add_stream_tests();
     add_heap_tests();
+    add_lru_cache_tests();
+    add_mpsc_queue_tests();
+    add_ring_tests();
     add_default_allocator_tests();
 
     filter_string = cutil_test_get_filter_string();
@@ -0,0 +1,190 @@
+#include "cutil/mpsc_queue.h"
+
+#include "ctest/ctest.h"
+#include "test_util/thread.h"
+#include "test_util/allocation_tracker.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define MPSC_QUEUE_NODE_COUNT 16
+#define MPSC_QUEUE_PRODUCER_COUNT 4
+#define MPSC_QUEUE_ITEMS_PER_PRODUCER 20000
+
+typedef struct {
+    cutil_mpsc_queue* queue;
+    cutil_mpsc_queue_node nodes[MPSC_QUEUE_NODE_COUNT];
+    int values[MPSC_QUEUE_NODE_COUNT];
+} mpsc_queue_test;
+
+void mpsc_queue_test_setup(mpsc_queue_test* test) {
+    int i;
+
+    memset(test, 0, sizeof(mpsc_queue_test));
+
+    for (i = 0; i < MPSC_QUEUE_NODE_COUNT; i++) {
+        test->values[i] = i;
+        test->nodes[i].data = &test->values[i];
+    }
+
+    test->queue = cutil_mpsc_queue_create();
+}
+
+void mpsc_queue_test_teardown(mpsc_queue_test* test) {
+    cutil_mpsc_queue_destroy(test->queue);
+}
+
+CTEST_FIXTURE(mpsc_queue, mpsc_queue_test, mpsc_queue_test_setup, mpsc_queue_test_teardown)
+
+void mpsc_queue_pop_empty(mpsc_queue_test* test) {
+    CTEST_ASSERT_TRUE(cutil_mpsc_queue_empty(test->queue));
+    CTEST_ASSERT_PTR_NULL(cutil_mpsc_queue_pop(test->queue));
+    CTEST_ASSERT_INT_EQ(cutil_mpsc_queue_pop_batch(test->queue, NULL, 0), 0);
+}
+
+/* nodes are popped in the order they were pushed, including after the queue has been emptied */
+void mpsc_queue_fifo(mpsc_queue_test* test) {
+    cutil_mpsc_queue_node* node;
+    int round, i;
+
+    for (round = 0; round < 3; round++) {
+        for (i = 0; i < MPSC_QUEUE_NODE_COUNT; i++) {
+            cutil_mpsc_queue_push(test->queue, &test->nodes[i]);
+        }
+
+        CTEST_ASSERT_FALSE(cutil_mpsc_queue_empty(test->queue));
+
+        for (i = 0; i < MPSC_QUEUE_NODE_COUNT; i++) {
+            node = cutil_mpsc_queue_pop(test->queue);
+            CTEST_ASSERT_PTR_EQ(node, &test->nodes[i]);
+            CTEST_ASSERT_INT_EQ(*(int*)node->data, i);
+        }
+
+        CTEST_ASSERT_TRUE(cutil_mpsc_queue_empty(test->queue));
+        CTEST_ASSERT_PTR_NULL(cutil_mpsc_queue_pop(test->queue));
+    }
+}
+
+/* a single node can be pushed and popped repeatedly */
+void mpsc_queue_single_node(mpsc_queue_test* test) {
+    int i;
+
+    for (i = 0; i < 3; i++) {
+        cutil_mpsc_queue_push(test->queue, &test->nodes[0]);
+        CTEST_ASSERT_PTR_EQ(cutil_mpsc_queue_pop(test->queue), &test->nodes[0]);
+        CTEST_ASSERT_PTR_NULL(cutil_mpsc_queue_pop(test->queue));
+    }
+}
+
+void mpsc_queue_batch(mpsc_queue_test* test) {
+    cutil_mpsc_queue_node* nodes[MPSC_QUEUE_NODE_COUNT];
+    size_t i;
+
+    for (i = 0; i < MPSC_QUEUE_NODE_COUNT; i++) {
+        cutil_mpsc_queue_push(test->queue, &test->nodes[i]);
+    }
+
+    CTEST_ASSERT_INT_EQ(cutil_mpsc_queue_pop_batch(test->queue, nodes, 10), 10);
+
+    for (i = 0; i < 10; i++) {
+        CTEST_ASSERT_PTR_EQ(nodes[i], &test->nodes[i]);
+    }
+
+    CTEST_ASSERT_INT_EQ(cutil_mpsc_queue_pop_batch(test->queue, nodes, MPSC_QUEUE_NODE_COUNT), MPSC_QUEUE_NODE_COUNT - 10);
+    CTEST_ASSERT_PTR_EQ(nodes[0], &test->nodes[10]);
+    CTEST_ASSERT_TRUE(cutil_mpsc_queue_empty(test->queue));
+}
+
+void mpsc_queue_no_allocation(mpsc_queue_test* test) {
+    int i;
+
+    cutil_test_allocation_tracker_begin();
+
+    for (i = 0; i < MPSC_QUEUE_NODE_COUNT; i++) {
+        cutil_mpsc_queue_push(test->queue, &test->nodes[i]);
+    }
+
+    while (cutil_mpsc_queue_pop(test->queue));
+
+    CTEST_ASSERT_INT_EQ(cutil_test_allocation_tracker_allocation_count(), 0);
+    CTEST_ASSERT_INT_EQ(cutil_test_allocation_tracker_free_count(), 0);
+
+    cutil_test_allocation_tracker_end();
+}
+
+typedef struct {
+    cutil_mpsc_queue_node node;
+    int producer;
+    int sequence;
+} mpsc_queue_item;
+
+typedef struct {
+    cutil_mpsc_queue* queue;
+    mpsc_queue_item* items;
+} mpsc_queue_producer;
+
+void mpsc_queue_produce(void* arg) {
+    mpsc_queue_producer* producer = (mpsc_queue_producer*)arg;
+    int i;
+
+    for (i = 0; i < MPSC_QUEUE_ITEMS_PER_PRODUCER; i++) {
+        cutil_mpsc_queue_push(producer->queue, &producer->items[i].node);
+    }
+}
+
+/* every node pushed by concurrent producers is popped once, in the order each producer pushed them */
+void mpsc_queue_concurrent_producers(mpsc_queue_test* test) {
+    cutil_test_thread* threads[MPSC_QUEUE_PRODUCER_COUNT];
+    mpsc_queue_producer producers[MPSC_QUEUE_PRODUCER_COUNT];
+    int next_sequence[MPSC_QUEUE_PRODUCER_COUNT];
+    cutil_mpsc_queue_node* nodes[MPSC_QUEUE_NODE_COUNT];
+    mpsc_queue_item* items = malloc(sizeof(mpsc_queue_item) * MPSC_QUEUE_PRODUCER_COUNT * MPSC_QUEUE_ITEMS_PER_PRODUCER);
+    int i, j, received = 0, in_order = 1;
+
+    for (i = 0; i < MPSC_QUEUE_PRODUCER_COUNT; i++) {
+        producers[i].queue = test->queue;
+        producers[i].items = items + i * MPSC_QUEUE_ITEMS_PER_PRODUCER;
+        next_sequence[i] = 0;
+
+        for (j = 0; j < MPSC_QUEUE_ITEMS_PER_PRODUCER; j++) {
+            producers[i].items[j].producer = i;
+            producers[i].items[j].sequence = j;
+        }
+    }
+
+    for (i = 0; i < MPSC_QUEUE_PRODUCER_COUNT; i++) {
+        threads[i] = cutil_test_thread_create(mpsc_queue_produce, &producers[i]);
+    }
+
+    while (received < MPSC_QUEUE_PRODUCER_COUNT * MPSC_QUEUE_ITEMS_PER_PRODUCER) {
+        size_t count = cutil_mpsc_queue_pop_batch(test->queue, nodes, MPSC_QUEUE_NODE_COUNT);
+        size_t k;
+
+        for (k = 0; k < count; k++) {
+            mpsc_queue_item* item = (mpsc_queue_item*)nodes[k];
+
+            in_order = in_order && item->sequence == next_sequence[item->producer];
+            next_sequence[item->producer] = item->sequence + 1;
+        }
+
+        received += (int)count;
+    }
+
+    for (i = 0; i < MPSC_QUEUE_PRODUCER_COUNT; i++) {
+        cutil_test_thread_join(threads[i]);
+    }
+
+    free(items);
+
+    CTEST_ASSERT_TRUE(in_order);
+    CTEST_ASSERT_TRUE(cutil_mpsc_queue_empty(test->queue));
+}
+
+void add_mpsc_queue_tests() {
+    CTEST_ADD_TEST_F(mpsc_queue, mpsc_queue_pop_empty);
+    CTEST_ADD_TEST_F(mpsc_queue, mpsc_queue_fifo);
+    CTEST_ADD_TEST_F(mpsc_queue, mpsc_queue_single_node);
+    CTEST_ADD_TEST_F(mpsc_queue, mpsc_queue_batch);
+    CTEST_ADD_TEST_F(mpsc_queue, mpsc_queue_no_allocation);
+    CTEST_ADD_TEST_F(mpsc_queue, mpsc_queue_concurrent_producers);
+}
@@ -0,0 +1,304 @@
+#include "cutil/ring.h"
+
+#include "ctest/ctest.h"
+#include "test_util/thread.h"
+#include "test_util/trait_tracker.h"
+#include "test_util/allocation_tracker.h"
+
+#include <string.h>
+
+#define RING_TEST_CAPACITY 8
+#define RING_THREAD_COUNT 2
+#define RING_ITEMS_PER_THREAD 20000
+
+typedef struct {
+    cutil_ring* ring;
+    cutil_trait* trait_tracker;
+} ring_test;
+
+void ring_test_setup(ring_test* test) {
+    memset(test, 0, sizeof(ring_test));
+}
+
+void ring_test_teardown(ring_test* test) {
+    if (test->ring) {
+        cutil_ring_destroy(test->ring);
+    }
+
+    if (test->trait_tracker) {
+        cutil_test_destroy_trait_tracker(test->trait_tracker);
+    }
+
+    cutil_trait_destroy();
+}
+
+CTEST_FIXTURE(ring, ring_test, ring_test_setup, ring_test_teardown)
+
+void ring_create_invalid(ring_test* test) {
+    (void)test;
+
+    CTEST_ASSERT_PTR_NULL(cutil_ring_create(NULL, RING_TEST_CAPACITY));
+    CTEST_ASSERT_PTR_NULL(cutil_ring_create(cutil_trait_int(), 0));
+    CTEST_ASSERT_PTR_NULL(cutil_ring_create_mpmc(cutil_trait_int(), 0));
+    CTEST_ASSERT_PTR_NULL(cutil_ring_create_mpmc(cutil_trait_int(), (size_t)-1));
+}
+
+/* capacities are rounded up to a power of two */
+void ring_capacity(ring_test* test) {
+    test->ring = cutil_ring_create(cutil_trait_int(), 5);
+    CTEST_ASSERT_INT_EQ(cutil_ring_capacity(test->ring), 8);
+    CTEST_ASSERT_FALSE(cutil_ring_is_mpmc(test->ring));
+    cutil_ring_destroy(test->ring);
+
+    test->ring = cutil_ring_create_mpmc(cutil_trait_int(), 16);
+    CTEST_ASSERT_INT_EQ(cutil_ring_capacity(test->ring), 16);
+    CTEST_ASSERT_TRUE(cutil_ring_is_mpmc(test->ring));
+}
+
+/* items are popped in the order they were pushed, and pushes fail once the ring is full */
+void ring_push_pop(cutil_ring* ring) {
+    int i, round, value = -1;
+
+    CTEST_ASSERT_FALSE(cutil_ring_pop(ring, &value));
+    CTEST_ASSERT_INT_EQ(value, -1);
+
+    /* several rounds wrap the positions around the slots */
+    for (round = 0; round < 3; round++) {
+        for (i = 0; i < RING_TEST_CAPACITY; i++) {
+            CTEST_ASSERT_TRUE(cutil_ring_push(ring, &i));
+        }
+
+        CTEST_ASSERT_FALSE(cutil_ring_push(ring, &i));
+        CTEST_ASSERT_INT_EQ(cutil_ring_size(ring), RING_TEST_CAPACITY);
+
+        for (i = 0; i < RING_TEST_CAPACITY; i++) {
+            CTEST_ASSERT_TRUE(cutil_ring_pop(ring, &value));
+            CTEST_ASSERT_INT_EQ(value, i);
+        }
+
+        CTEST_ASSERT_FALSE(cutil_ring_pop(ring, &value));
+        CTEST_ASSERT_INT_EQ(cutil_ring_size(ring), 0);
+
+        /* offset the positions for the next round */
+        cutil_ring_push(ring, &i);
+        cutil_ring_pop(ring, &value);
+    }
+}
+
+void ring_spsc_push_pop(ring_test* test) {
+    test->ring = cutil_ring_create(cutil_trait_int(), RING_TEST_CAPACITY);
+    ring_push_pop(test->ring);
+}
+
+void ring_mpmc_push_pop(ring_test* test) {
+    test->ring = cutil_ring_create_mpmc(cutil_trait_int(), RING_TEST_CAPACITY);
+    ring_push_pop(test->ring);
+}
+
+/* batches are limited by the free space and the number of items, and wrap around the end of the slots */
+void ring_batch(cutil_ring* ring) {
+    int values[RING_TEST_CAPACITY * 2];
+    int out[RING_TEST_CAPACITY * 2];
+    int i;
+
+    for (i = 0; i < RING_TEST_CAPACITY * 2; i++) {
+        values[i] = i;
+    }
+
+    CTEST_ASSERT_INT_EQ(cutil_ring_push_batch(ring, values, 5), 5);
+    CTEST_ASSERT_INT_EQ(cutil_ring_pop_batch(ring, out, 3), 3);
+    CTEST_ASSERT_INT_EQ(cutil_ring_push_batch(ring, values + 5, RING_TEST_CAPACITY * 2 - 5), RING_TEST_CAPACITY - 2);
+    CTEST_ASSERT_INT_EQ(cutil_ring_push_batch(ring, values, 1), 0);
+
+    CTEST_ASSERT_INT_EQ(cutil_ring_pop_batch(ring, out + 3, RING_TEST_CAPACITY * 2), RING_TEST_CAPACITY);
+    CTEST_ASSERT_INT_EQ(cutil_ring_pop_batch(ring, out, 1), 0);
+    CTEST_ASSERT_INT_EQ(cutil_ring_pop_batch(ring, out, 0), 0);
+
+    for (i = 0; i < RING_TEST_CAPACITY + 3; i++) {
+        CTEST_ASSERT_INT_EQ(out[i], i);
+    }
+}
+
+void ring_spsc_batch(ring_test* test) {
+    test->ring = cutil_ring_create(cutil_trait_int(), RING_TEST_CAPACITY);
+    ring_batch(test->ring);
+}
+
+void ring_mpmc_batch(ring_test* test) {
+    test->ring = cutil_ring_create_mpmc(cutil_trait_int(), RING_TEST_CAPACITY);
+    ring_batch(test->ring);
+}
+
+/* items are copied when pushed, popped items are owned by the caller and remaining items are destroyed with the ring */
+void ring_trait_funcs(ring_test* test) {
+    char* strs[3] = {"one", "two", "three"};
+    char* str = NULL;
+
+    test->trait_tracker = cutil_test_create_trait_tracker(cutil_trait_cstring());
+    test->ring = cutil_ring_create_mpmc(test->trait_tracker, RING_TEST_CAPACITY);
+
+    CTEST_ASSERT_INT_EQ(cutil_ring_push_batch(test->ring, strs, 3), 3);
+    CTEST_ASSERT_INT_EQ(cutil_test_trait_tracker_copy_count(test->trait_tracker), 3);
+
+    CTEST_ASSERT_TRUE(cutil_ring_pop(test->ring, &str));
+    CTEST_ASSERT_TRUE(str != strs[0] && strcmp(str, "one") == 0);
+    CTEST_ASSERT_INT_EQ(cutil_test_trait_tracker_destroy_count(test->trait_tracker), 0);
+    test->trait_tracker->destroy_func(&str, test->trait_tracker->user_data);
+
+    cutil_ring_destroy(test->ring);
+    test->ring = NULL;
+
+    CTEST_ASSERT_INT_EQ(cutil_test_trait_tracker_destroy_count(test->trait_tracker), 3);
+}
+
+void ring_no_allocation(ring_test* test) {
+    int i, value;
+
+    test->ring = cutil_ring_create(cutil_trait_int(), RING_TEST_CAPACITY);
+    cutil_test_allocation_tracker_begin();
+
+    for (i = 0; i < RING_TEST_CAPACITY * 4; i++) {
+        cutil_ring_push(test->ring, &i);
+        cutil_ring_pop(test->ring, &value);
+    }
+
+    CTEST_ASSERT_INT_EQ(cutil_test_allocation_tracker_allocation_count(), 0);
+    CTEST_ASSERT_INT_EQ(cutil_test_allocation_tracker_free_count(), 0);
+
+    cutil_test_allocation_tracker_end();
+}
+
+typedef struct {
+    cutil_ring* ring;
+    int first_value;
+    int item_count;
+    int in_order;
+    double sum;
+} ring_worker;
+
+void ring_produce(void* arg) {
+    ring_worker* worker = (ring_worker*)arg;
+    int values[4];
+    int i = 0, j;
+
+    /* items are pushed individually and in batches */
+    while (i < worker->item_count) {
+        int count = worker->item_count - i < 4 ? worker->item_count - i : 4;
+
+        if (i % 8 == 0) {
+            for (j = 0; j < count; j++) {
+                values[j] = worker->first_value + i + j;
+            }
+
+            count = (int)cutil_ring_push_batch(worker->ring, values, (size_t)count);
+        }
+        else {
+            values[0] = worker->first_value + i;
+            count = cutil_ring_push(worker->ring, &values[0]);
+        }
+
+        /* the ring is full, let a consumer run rather than spinning through its time slice */
+        if (count == 0) {
+            cutil_test_thread_yield();
+        }
+
+        i += count;
+    }
+}
+
+void ring_consume(void* arg) {
+    ring_worker* worker = (ring_worker*)arg;
+    int values[4];
+    int received = 0, previous = -1;
+    size_t count, i;
+
+    worker->in_order = 1;
+
+    while (received < worker->item_count) {
+        count = cutil_ring_pop_batch(worker->ring, values, 4);
+
+        if (count == 0) {
+            cutil_test_thread_yield();
+        }
+
+        for (i = 0; i < count; i++) {
+            worker->in_order = worker->in_order && values[i] > previous;
+            previous = values[i];
+            worker->sum += values[i];
+        }
+
+        received += (int)count;
+    }
+}
+
+/* a single consumer receives every item from a single producer in order */
+void ring_spsc_threads(ring_test* test) {
+    cutil_test_thread* producer_thread;
+    ring_worker producer, consumer;
+
+    test->ring = cutil_ring_create(cutil_trait_int(), 64);
+
+    memset(&producer, 0, sizeof(ring_worker));
+    producer.ring = test->ring;
+    producer.item_count = RING_ITEMS_PER_THREAD;
+    consumer = producer;
+
+    producer_thread = cutil_test_thread_create(ring_produce, &producer);
+    ring_consume(&consumer);
+    cutil_test_thread_join(producer_thread);
+
+    CTEST_ASSERT_TRUE(consumer.in_order);
+    CTEST_ASSERT_TRUE(consumer.sum == (double)RING_ITEMS_PER_THREAD * (RING_ITEMS_PER_THREAD - 1) / 2);
+}
+
+/* every item from multiple producers is received once by one of multiple consumers */
+void ring_mpmc_threads(ring_test* test) {
+    cutil_test_thread* threads[RING_THREAD_COUNT * 2];
+    ring_worker producers[RING_THREAD_COUNT];
+    ring_worker consumers[RING_THREAD_COUNT];
+    double expected_sum, sum = 0.0;
+    int i, total_count = RING_THREAD_COUNT * RING_ITEMS_PER_THREAD;
+
+    test->ring = cutil_ring_create_mpmc(cutil_trait_int(), 64);
+
+    for (i = 0; i < RING_THREAD_COUNT; i++) {
+        memset(&producers[i], 0, sizeof(ring_worker));
+        producers[i].ring = test->ring;
+        producers[i].first_value = i * RING_ITEMS_PER_THREAD;
+        producers[i].item_count = RING_ITEMS_PER_THREAD;
+
+        consumers[i] = producers[i];
+        consumers[i].first_value = 0;
+    }
+
+    for (i = 0; i < RING_THREAD_COUNT; i++) {
+        threads[i] = cutil_test_thread_create(ring_produce, &producers[i]);
+        threads[RING_THREAD_COUNT + i] = cutil_test_thread_create(ring_consume, &consumers[i]);
+    }
+
+    for (i = 0; i < RING_THREAD_COUNT * 2; i++) {
+        cutil_test_thread_join(threads[i]);
+    }
+
+    for (i = 0; i < RING_THREAD_COUNT; i++) {
+        sum += consumers[i].sum;
+    }
+
+    expected_sum = (double)total_count * (total_count - 1) / 2;
+
+    CTEST_ASSERT_TRUE(sum == expected_sum);
+    CTEST_ASSERT_INT_EQ(cutil_ring_size(test->ring), 0);
+}
+
+void add_ring_tests() {
+    CTEST_ADD_TEST_F(ring, ring_create_invalid);
+    CTEST_ADD_TEST_F(ring, ring_capacity);
+    CTEST_ADD_TEST_F(ring, ring_spsc_push_pop);
+    CTEST_ADD_TEST_F(ring, ring_mpmc_push_pop);
+    CTEST_ADD_TEST_F(ring, ring_spsc_batch);
+    CTEST_ADD_TEST_F(ring, ring_mpmc_batch);
+    CTEST_ADD_TEST_F(ring, ring_trait_funcs);
+    CTEST_ADD_TEST_F(ring, ring_no_allocation);
+    CTEST_ADD_TEST_F(ring, ring_spsc_threads);
+    CTEST_ADD_TEST_F(ring, ring_mpmc_threads);
+}
@@ -0,0 +1,414 @@
+#include "cutil/stream.h"
+#include "cutil/vector.h"
+#include "cutil/list.h"
+#include "cutil/forward_list.h"
+#include "cutil/heap.h"
+#include "cutil/btree.h"
+
+#include "ctest/ctest.h"
+#include "test_suites.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define STREAM_TEST_BUFFER_SIZE 64
+#define STREAM_TEST_ITEM_COUNT 1000
+
+/* In memory stream which returns at most max_read bytes from each read in order to exercise partial reads */
+typedef struct {
+    char* data;
+    size_t size;
+    size_t capacity;
+    size_t read_position;
+    size_t max_read;
+    size_t write_call_count;
+} memory_stream;
+
+typedef struct {
+    memory_stream stream;
+    cutil_writer* writer;
+    cutil_reader* reader;
+} stream_test;
+
+size_t memory_stream_write(void* data, size_t size, void* user_data) {
+    memory_stream* stream = (memory_stream*)user_data;
+
+    if (stream->size + size > stream->capacity) {
+        stream->capacity = (stream->size + size) * 2;
+        stream->data = realloc(stream->data, stream->capacity);
+    }
+
+    memcpy(stream->data + stream->size, data, size);
+    stream->size += size;
+    stream->write_call_count += 1;
+
+    return size;
+}
+
+size_t memory_stream_read(void* buffer, size_t size, void* user_data) {
+    memory_stream* stream = (memory_stream*)user_data;
+    size_t available = stream->size - stream->read_position;
+
+    if (size > available) {
+        size = available;
+    }
+
+    if (size > stream->max_read) {
+        size = stream->max_read;
+    }
+
+    memcpy(buffer, stream->data + stream->read_position, size);
+    stream->read_position += size;
+
+    return size;
+}
+
+size_t failing_stream_write(void* data, size_t size, void* user_data) {
+    (void)data;
+    (void)size;
+    (void)user_data;
+
+    return 0;
+}
+
+void stream_test_setup(stream_test* test) {
+    memset(test, 0, sizeof(stream_test));
+    test->stream.max_read = 37;
+
+    test->writer = cutil_writer_create(memory_stream_write, &test->stream, STREAM_TEST_BUFFER_SIZE);
+    test->reader = cutil_reader_create(memory_stream_read, &test->stream, STREAM_TEST_BUFFER_SIZE);
+}
+
+void stream_test_teardown(stream_test* test) {
+    cutil_writer_destroy(test->writer);
+    cutil_reader_destroy(test->reader);
+
+    if (test->stream.data) {
+        free(test->stream.data);
+    }
+
+    cutil_trait_destroy();
+}
+
+CTEST_FIXTURE(stream, stream_test, stream_test_setup, stream_test_teardown)
+
+void stream_create_requires_func(stream_test* test) {
+    (void)test;
+
+    CTEST_ASSERT_PTR_NULL(cutil_writer_create(NULL, NULL, 0));
+    CTEST_ASSERT_PTR_NULL(cutil_reader_create(NULL, NULL, 0));
+}
+
+void stream_small_writes_are_buffered(stream_test* test) {
+    int i, value;
+
+    for (i = 0; i < 10; i++) {
+        CTEST_ASSERT_TRUE(cutil_writer_write(test->writer, &i, sizeof(int)));
+    }
+
+    CTEST_ASSERT_INT_EQ(test->stream.write_call_count, 0);
+    CTEST_ASSERT_TRUE(cutil_writer_flush(test->writer));
+    CTEST_ASSERT_INT_EQ(test->stream.write_call_count, 1);
+    CTEST_ASSERT_INT_EQ(test->stream.size, 10 * sizeof(int));
+
+    for (i = 0; i < 10; i++) {
+        CTEST_ASSERT_TRUE(cutil_reader_read(test->reader, &value, sizeof(int)));
+        CTEST_ASSERT_INT_EQ(value, i);
+    }
+
+    CTEST_ASSERT_FALSE(cutil_reader_read(test->reader, &value, sizeof(int)));
+}
+
+void stream_large_writes_bypass_buffer(stream_test* test) {
+    int values[STREAM_TEST_ITEM_COUNT], result[STREAM_TEST_ITEM_COUNT];
+    int i;
+
+    for (i = 0; i < STREAM_TEST_ITEM_COUNT; i++) {
+        values[i] = i * 7;
+    }
+
+    CTEST_ASSERT_TRUE(cutil_writer_write(test->writer, values, sizeof(values)));
+    CTEST_ASSERT_INT_EQ(test->stream.write_call_count, 1);
+    CTEST_ASSERT_TRUE(cutil_writer_flush(test->writer));
+    CTEST_ASSERT_INT_EQ(test->stream.write_call_count, 1);
+
+    CTEST_ASSERT_TRUE(cutil_reader_read(test->reader, result, sizeof(result)));
+    CTEST_ASSERT_TRUE(memcmp(values, result, sizeof(values)) == 0);
+}
+
+void stream_sizes(stream_test* test) {
+    size_t value;
+
+    CTEST_ASSERT_TRUE(cutil_writer_write_size(test->writer, 0));
+    CTEST_ASSERT_TRUE(cutil_writer_write_size(test->writer, 123456789));
+    CTEST_ASSERT_TRUE(cutil_writer_flush(test->writer));
+    CTEST_ASSERT_INT_EQ(test->stream.size, 16);
+
+    CTEST_ASSERT_TRUE(cutil_reader_read_size(test->reader, &value));
+    CTEST_ASSERT_INT_EQ(value, 0);
+    CTEST_ASSERT_TRUE(cutil_reader_read_size(test->reader, &value));
+    CTEST_ASSERT_INT_EQ(value, 123456789);
+}
+
+void stream_write_failure_is_sticky(stream_test* test) {
+    cutil_writer* writer = cutil_writer_create(failing_stream_write, NULL, STREAM_TEST_BUFFER_SIZE);
+    cutil_vector* vector = cutil_vector_create(cutil_trait_int());
+    int i = 1;
+    (void)test;
+
+    cutil_vector_push_back(vector, &i);
+
+    CTEST_ASSERT_TRUE(cutil_writer_write(writer, &i, sizeof(int)));
+    CTEST_ASSERT_FALSE(cutil_writer_flush(writer));
+    CTEST_ASSERT_FALSE(cutil_writer_write(writer, &i, sizeof(int)));
+    CTEST_ASSERT_FALSE(cutil_vector_write(vector, writer));
+
+    cutil_vector_destroy(vector);
+    cutil_writer_destroy(writer);
+}
+
+void stream_vector_round_trip(stream_test* test) {
+    cutil_vector* vector = cutil_vector_create(cutil_trait_int());
+    cutil_vector* result;
+    int i;
+
+    for (i = 0; i < STREAM_TEST_ITEM_COUNT; i++) {
+        cutil_vector_push_back(vector, &i);
+    }
+
+    CTEST_ASSERT_TRUE(cutil_vector_write(vector, test->writer));
+    result = cutil_vector_read(test->reader, cutil_trait_int());
+
+    CTEST_ASSERT_PTR_NOT_NULL(result);
+    CTEST_ASSERT_TRUE(cutil_vector_equals(vector, result));
+    CTEST_ASSERT_INT_EQ(cutil_vector_capacity(result), STREAM_TEST_ITEM_COUNT);
+
+    cutil_vector_destroy(result);
+    cutil_vector_destroy(vector);
+}
+
+void stream_vector_cstring_round_trip(stream_test* test) {
+    cutil_vector* vector = cutil_vector_create(cutil_trait_cstring());
+    cutil_vector* result;
+    const char* strings[3] = {"first", "", "the third string is longer than the writer buffer used by this test"};
+    char* str;
+    int i;
+
+    for (i = 0; i < 3; i++) {
+        cutil_vector_push_back(vector, &strings[i]);
+    }
+
+    CTEST_ASSERT_TRUE(cutil_vector_write(vector, test->writer));
+    result = cutil_vector_read(test->reader, cutil_trait_cstring());
+
+    CTEST_ASSERT_PTR_NOT_NULL(result);
+    CTEST_ASSERT_INT_EQ(cutil_vector_size(result), 3);
+
+    for (i = 0; i < 3; i++) {
+        cutil_vector_get(result, i, &str);
+        CTEST_ASSERT_TRUE(strcmp(str, strings[i]) == 0);
+    }
+
+    cutil_vector_destroy(result);
+    cutil_vector_destroy(vector);
+}
+
+void stream_read_rejects_mismatched_trait(stream_test* test) {
+    cutil_vector* vector = cutil_vector_create(cutil_trait_int());
+    cutil_trait double_trait;
+    int i = 1;
+
+    memset(&double_trait, 0, sizeof(cutil_trait));
+    double_trait.size = sizeof(double);
+
+    cutil_vector_push_back(vector, &i);
+
+    CTEST_ASSERT_TRUE(cutil_vector_write(vector, test->writer));
+    CTEST_ASSERT_PTR_NULL(cutil_vector_read(test->reader, &double_trait));
+
+    cutil_vector_destroy(vector);
+}
+
+void stream_read_truncated(stream_test* test) {
+    cutil_list* list = cutil_list_create(cutil_trait_cstring());
+    const char* str = "truncated";
+    int i;
+
+    for (i = 0; i < 10; i++) {
+        cutil_list_push_back(list, &str);
+    }
+
+    CTEST_ASSERT_TRUE(cutil_list_write(list, test->writer));
+    test->stream.size -= 3;
+
+    CTEST_ASSERT_PTR_NULL(cutil_list_read(test->reader, cutil_trait_cstring()));
+
+    cutil_list_destroy(list);
+}
+
+void stream_write_requires_serialize_func(stream_test* test) {
+    cutil_trait owning_trait;
+    cutil_list* list;
+
+    memcpy(&owning_trait, cutil_trait_cstring(), sizeof(cutil_trait));
+    owning_trait.serialize_func = NULL;
+    owning_trait.deserialize_func = NULL;
+
+    list = cutil_list_create(&owning_trait);
+
+    CTEST_ASSERT_FALSE(cutil_list_write(list, test->writer));
+    CTEST_ASSERT_INT_EQ(test->stream.size, 0);
+    CTEST_ASSERT_PTR_NULL(cutil_list_read(test->reader, &owning_trait));
+
+    cutil_list_destroy(list);
+}
+
+void stream_list_round_trip(stream_test* test) {
+    cutil_list* list = cutil_list_create(cutil_trait_int());
+    cutil_list* result;
+    cutil_list_itr* itr;
+    int i, value;
+
+    for (i = 0; i < STREAM_TEST_ITEM_COUNT; i++) {
+        cutil_list_push_back(list, &i);
+    }
+
+    CTEST_ASSERT_TRUE(cutil_list_write(list, test->writer));
+    result = cutil_list_read(test->reader, cutil_trait_int());
+
+    CTEST_ASSERT_PTR_NOT_NULL(result);
+    CTEST_ASSERT_INT_EQ(cutil_list_size(result), STREAM_TEST_ITEM_COUNT);
+
+    itr = cutil_list_itr_create(result);
+    for (i = 0; i < STREAM_TEST_ITEM_COUNT; i++) {
+        CTEST_ASSERT_TRUE(cutil_list_itr_next(itr, &value));
+        CTEST_ASSERT_INT_EQ(value, i);
+    }
+
+    CTEST_ASSERT_TRUE(cutil_list_back(result, &value));
+    CTEST_ASSERT_INT_EQ(value, STREAM_TEST_ITEM_COUNT - 1);
+
+    cutil_list_itr_destroy(itr);
+    cutil_list_destroy(result);
+    cutil_list_destroy(list);
+}
+
+void stream_forward_list_round_trip(stream_test* test) {
+    cutil_forward_list* list = cutil_forward_list_create(cutil_trait_int());
+    cutil_forward_list* result;
+    cutil_forward_list_itr* itr;
+    int i, value;
+
+    for (i = 0; i < STREAM_TEST_ITEM_COUNT; i++) {
+        cutil_forward_list_push_front(list, &i);
+    }
+
+    CTEST_ASSERT_TRUE(cutil_forward_list_write(list, test->writer));
+    result = cutil_forward_list_read(test->reader, cutil_trait_int());
+
+    CTEST_ASSERT_PTR_NOT_NULL(result);
+
+    itr = cutil_forward_list_itr_create(result);
+    for (i = STREAM_TEST_ITEM_COUNT - 1; i >= 0; i--) {
+        CTEST_ASSERT_TRUE(cutil_forward_list_itr_next(itr, &value));
+        CTEST_ASSERT_INT_EQ(value, i);
+    }
+
+    CTEST_ASSERT_FALSE(cutil_forward_list_itr_has_next(itr));
+
+    cutil_forward_list_itr_destroy(itr);
+    cutil_forward_list_destroy(result);
+    cutil_forward_list_destroy(list);
+}
+
+void stream_heap_round_trip(stream_test* test) {
+    cutil_heap* heap = cutil_heap_create(cutil_trait_int());
+    cutil_heap* result;
+    int i, value;
+
+    for (i = 0; i < STREAM_TEST_ITEM_COUNT; i++) {
+        value = (i * 7919) % STREAM_TEST_ITEM_COUNT;
+        cutil_heap_insert(heap, &value);
+    }
+
+    CTEST_ASSERT_TRUE(cutil_heap_write(heap, test->writer));
+    result = cutil_heap_read(test->reader, cutil_trait_int());
+
+    CTEST_ASSERT_PTR_NOT_NULL(result);
+    CTEST_ASSERT_INT_EQ(cutil_heap_size(result), STREAM_TEST_ITEM_COUNT);
+
+    for (i = 0; i < STREAM_TEST_ITEM_COUNT; i++) {
+        CTEST_ASSERT_TRUE(cutil_heap_peek(result, &value));
+        CTEST_ASSERT_INT_EQ(value, i);
+        cutil_heap_pop(result);
+    }
+
+    cutil_heap_destroy(result);
+    cutil_heap_destroy(heap);
+}
+
+void stream_btree_round_trip(stream_test* test) {
+    cutil_btree* btree = cutil_btree_create(5, cutil_trait_int(), cutil_trait_cstring());
+    cutil_btree* result;
+    const char* strings[2] = {"even", "odd"};
+    int i;
+
+    for (i = 0; i < STREAM_TEST_ITEM_COUNT; i++) {
+        cutil_btree_insert(btree, &i, &strings[i % 2]);
+    }
+
+    CTEST_ASSERT_TRUE(cutil_btree_write(btree, test->writer));
+    result = cutil_btree_read(test->reader, cutil_trait_int(), cutil_trait_cstring());
+
+    CTEST_ASSERT_PTR_NOT_NULL(result);
+    CTEST_ASSERT_INT_EQ(cutil_btree_get_order(result), 5);
+    CTEST_ASSERT_TRUE(cutil_btree_equals(btree, result));
+
+    cutil_btree_destroy(result);
+    cutil_btree_destroy(btree);
+}
+
+void stream_multiple_containers(stream_test* test) {
+    cutil_vector* vector = cutil_vector_create(cutil_trait_int());
+    cutil_btree* btree = cutil_btree_create(3, cutil_trait_int(), cutil_trait_int());
+    cutil_vector* vector_result;
+    cutil_btree* btree_result;
+    int i;
+
+    for (i = 0; i < 100; i++) {
+        cutil_vector_push_back(vector, &i);
+        cutil_btree_insert(btree, &i, &i);
+    }
+
+    CTEST_ASSERT_TRUE(cutil_vector_write(vector, test->writer));
+    CTEST_ASSERT_TRUE(cutil_btree_write(btree, test->writer));
+
+    vector_result = cutil_vector_read(test->reader, cutil_trait_int());
+    btree_result = cutil_btree_read(test->reader, cutil_trait_int(), cutil_trait_int());
+
+    CTEST_ASSERT_TRUE(cutil_vector_equals(vector, vector_result));
+    CTEST_ASSERT_TRUE(cutil_btree_equals(btree, btree_result));
+
+    cutil_btree_destroy(btree_result);
+    cutil_vector_destroy(vector_result);
+    cutil_btree_destroy(btree);
+    cutil_vector_destroy(vector);
+}
+
+void add_stream_tests() {
+    CTEST_ADD_TEST_F(stream, stream_create_requires_func);
+    CTEST_ADD_TEST_F(stream, stream_small_writes_are_buffered);
+    CTEST_ADD_TEST_F(stream, stream_large_writes_bypass_buffer);
+    CTEST_ADD_TEST_F(stream, stream_sizes);
+    CTEST_ADD_TEST_F(stream, stream_write_failure_is_sticky);
+    CTEST_ADD_TEST_F(stream, stream_vector_round_trip);
+    CTEST_ADD_TEST_F(stream, stream_vector_cstring_round_trip);
+    CTEST_ADD_TEST_F(stream, stream_read_rejects_mismatched_trait);
+    CTEST_ADD_TEST_F(stream, stream_read_truncated);
+    CTEST_ADD_TEST_F(stream, stream_write_requires_serialize_func);
+    CTEST_ADD_TEST_F(stream, stream_list_round_trip);
+    CTEST_ADD_TEST_F(stream, stream_forward_list_round_trip);
+    CTEST_ADD_TEST_F(stream, stream_heap_round_trip);
+    CTEST_ADD_TEST_F(stream, stream_btree_round_trip);
+    CTEST_ADD_TEST_F(stream, stream_multiple_containers);
+}
@@ -6,10 +6,25 @@ void add_list_tests();
 void add_forward_list_tests();
 void add_forward_list_itr_tests();
 void add_list_itr_tests();
+void add_unrolled_list_tests();
 void add_btree_tests();
 void add_btree_itr_tests();
+void add_btree_search_tests();
+void add_btree_snapshot_tests();
+void add_btree_concurrent_tests();
+void add_btree_file_tests();
+void add_btree_range_tests();
+void add_btree_merge_tests();
+void add_btree_stats_tests();
+void add_btree_compact_tests();
+void add_btree_rebalance_tests();
+void add_btree_page_tests();
 void add_trait_tests();
+void add_stream_tests();
 void add_heap_tests();
+void add_lru_cache_tests();
+void add_mpsc_queue_tests();
+void add_ring_tests();
 void add_default_allocator_tests();
 
 #endif
@@ -0,0 +1,299 @@
+#include "test_util/defs.h"
+#include "test_util/trait_tracker.h"
+#include "test_util/allocation_tracker.h"
+
+#include "cutil/unrolled_list.h"
+#include "ctest/ctest.h"
+
+#include <string.h>
+
+#define UNROLLED_LIST_TEST_COUNT 100
+
+typedef struct {
+    cutil_unrolled_list* list;
+    cutil_trait* trait_tracker;
+} unrolled_list_test;
+
+void unrolled_list_test_setup(unrolled_list_test* test) {
+    memset(test, 0, sizeof(unrolled_list_test));
+}
+
+void unrolled_list_test_teardown(unrolled_list_test* test) {
+    if (test->list) {
+        cutil_unrolled_list_destroy(test->list);
+    }
+
+    if (test->trait_tracker) {
+        cutil_test_destroy_trait_tracker(test->trait_tracker);
+    }
+
+    cutil_trait_destroy();
+}
+
+CTEST_FIXTURE(unrolled_list, unrolled_list_test, unrolled_list_test_setup, unrolled_list_test_teardown)
+
+/* checks that the items of the list are the supplied values in both directions */
+int unrolled_list_items_equal(cutil_unrolled_list* list, int* values, int count) {
+    cutil_unrolled_list_itr itr;
+    int value, i = 0;
+
+    cutil_unrolled_list_itr_init(&itr, list);
+
+    while (cutil_unrolled_list_itr_next(&itr, &value)) {
+        if (i >= count || value != values[i]) {
+            return 0;
+        }
+
+        i += 1;
+    }
+
+    if (i != count || cutil_unrolled_list_size(list) != (unsigned int)count) {
+        return 0;
+    }
+
+    /* the iterator is at the back item, so walking back starts with the item before it */
+    for (i = count - 2; i >= 0; i--) {
+        if (!cutil_unrolled_list_itr_prev(&itr, &value) || value != values[i]) {
+            return 0;
+        }
+    }
+
+    return !cutil_unrolled_list_itr_has_prev(&itr);
+}
+
+void unrolled_list_create_node_size(unrolled_list_test* test) {
+    test->list = cutil_unrolled_list_create(cutil_trait_int());
+    CTEST_ASSERT_INT_EQ(cutil_unrolled_list_size(test->list), 0);
+    CTEST_ASSERT_TRUE(cutil_unrolled_list_node_capacity(test->list) > 4);
+
+    cutil_unrolled_list_destroy(test->list);
+
+    /* node sizes are rounded up to the cache line size */
+    test->list = cutil_unrolled_list_create_with_node_size(cutil_trait_int(), 100);
+    CTEST_ASSERT_PTR_NOT_NULL(test->list);
+    CTEST_ASSERT_TRUE(cutil_unrolled_list_node_capacity(test->list) * sizeof(int) > 100 - 64);
+
+    CTEST_ASSERT_PTR_NULL(cutil_unrolled_list_create_with_node_size(cutil_trait_int(), 0));
+    CTEST_ASSERT_PTR_NULL(cutil_unrolled_list_create(NULL));
+}
+
+void unrolled_list_push_back(unrolled_list_test* test) {
+    int values[UNROLLED_LIST_TEST_COUNT];
+    int i, value;
+
+    test->list = cutil_unrolled_list_create(cutil_trait_int());
+
+    for (i = 0; i < UNROLLED_LIST_TEST_COUNT; i++) {
+        values[i] = i;
+        cutil_unrolled_list_push_back(test->list, &i);
+    }
+
+    CTEST_ASSERT_TRUE(unrolled_list_items_equal(test->list, values, UNROLLED_LIST_TEST_COUNT));
+
+    CTEST_ASSERT_TRUE(cutil_unrolled_list_front(test->list, &value));
+    CTEST_ASSERT_INT_EQ(value, 0);
+    CTEST_ASSERT_TRUE(cutil_unrolled_list_back(test->list, &value));
+    CTEST_ASSERT_INT_EQ(value, UNROLLED_LIST_TEST_COUNT - 1);
+}
+
+void unrolled_list_push_front(unrolled_list_test* test) {
+    int values[UNROLLED_LIST_TEST_COUNT];
+    int i;
+
+    test->list = cutil_unrolled_list_create(cutil_trait_int());
+
+    for (i = 0; i < UNROLLED_LIST_TEST_COUNT; i++) {
+        values[UNROLLED_LIST_TEST_COUNT - 1 - i] = i;
+        cutil_unrolled_list_push_front(test->list, &i);
+    }
+
+    CTEST_ASSERT_TRUE(unrolled_list_items_equal(test->list, values, UNROLLED_LIST_TEST_COUNT));
+}
+
+/* items pushed to both ends of a list with small nodes are kept in order */
+void unrolled_list_push_both_ends(unrolled_list_test* test) {
+    int values[UNROLLED_LIST_TEST_COUNT];
+    int i, front = UNROLLED_LIST_TEST_COUNT / 2 - 1, back = UNROLLED_LIST_TEST_COUNT / 2;
+
+    test->list = cutil_unrolled_list_create_with_node_size(cutil_trait_int(), 64);
+
+    for (i = 0; i < UNROLLED_LIST_TEST_COUNT; i++) {
+        values[i] = i;
+    }
+
+    while (front >= 0) {
+        cutil_unrolled_list_push_front(test->list, &values[front--]);
+        cutil_unrolled_list_push_back(test->list, &values[back++]);
+    }
+
+    CTEST_ASSERT_TRUE(unrolled_list_items_equal(test->list, values, UNROLLED_LIST_TEST_COUNT));
+}
+
+void unrolled_list_pop(unrolled_list_test* test) {
+    int values[UNROLLED_LIST_TEST_COUNT];
+    int i, value;
+
+    test->list = cutil_unrolled_list_create_with_node_size(cutil_trait_int(), 64);
+
+    for (i = 0; i < UNROLLED_LIST_TEST_COUNT; i++) {
+        values[i] = i;
+        cutil_unrolled_list_push_back(test->list, &i);
+    }
+
+    for (i = 0; i < 10; i++) {
+        CTEST_ASSERT_TRUE(cutil_unrolled_list_pop_front(test->list));
+        CTEST_ASSERT_TRUE(cutil_unrolled_list_pop_back(test->list));
+    }
+
+    CTEST_ASSERT_TRUE(unrolled_list_items_equal(test->list, values + 10, UNROLLED_LIST_TEST_COUNT - 20));
+
+    while (cutil_unrolled_list_pop_front(test->list));
+
+    CTEST_ASSERT_INT_EQ(cutil_unrolled_list_size(test->list), 0);
+    CTEST_ASSERT_FALSE(cutil_unrolled_list_pop_back(test->list));
+    CTEST_ASSERT_FALSE(cutil_unrolled_list_front(test->list, &value));
+    CTEST_ASSERT_FALSE(cutil_unrolled_list_back(test->list, &value));
+}
+
+/* items are copied and destroyed with the list's trait */
+void unrolled_list_trait_funcs(unrolled_list_test* test) {
+    char* strs[3] = {"one", "two", "three"};
+    char* str;
+    int i;
+
+    test->trait_tracker = cutil_test_create_trait_tracker(cutil_trait_cstring());
+    test->list = cutil_unrolled_list_create(test->trait_tracker);
+
+    for (i = 0; i < 3; i++) {
+        cutil_unrolled_list_push_back(test->list, &strs[i]);
+    }
+
+    CTEST_ASSERT_INT_EQ(cutil_test_trait_tracker_copy_count(test->trait_tracker), 3);
+
+    cutil_unrolled_list_front(test->list, &str);
+    CTEST_ASSERT_TRUE(str != strs[0] && strcmp(str, "one") == 0);
+
+    cutil_unrolled_list_pop_back(test->list);
+    CTEST_ASSERT_INT_EQ(cutil_test_trait_tracker_destroy_count(test->trait_tracker), 1);
+
+    cutil_unrolled_list_clear(test->list);
+    CTEST_ASSERT_INT_EQ(cutil_test_trait_tracker_destroy_count(test->trait_tracker), 3);
+    CTEST_ASSERT_INT_EQ(cutil_unrolled_list_size(test->list), 0);
+}
+
+/* a list used as a queue reuses its emptied node when crossing node boundaries */
+void unrolled_list_queue_no_allocation(unrolled_list_test* test) {
+    int i, value;
+
+    test->list = cutil_unrolled_list_create_with_node_size(cutil_trait_int(), 64);
+
+    for (i = 0; i < UNROLLED_LIST_TEST_COUNT; i++) {
+        cutil_unrolled_list_push_back(test->list, &i);
+    }
+
+    /* emptying the front node leaves it as the spare for the next node the back of the queue needs */
+    for (i = 0; i < (int)cutil_unrolled_list_node_capacity(test->list); i++) {
+        cutil_unrolled_list_pop_front(test->list);
+    }
+
+    cutil_test_allocation_tracker_begin();
+
+    for (i = UNROLLED_LIST_TEST_COUNT; i < UNROLLED_LIST_TEST_COUNT * 10; i++) {
+        cutil_unrolled_list_push_back(test->list, &i);
+        cutil_unrolled_list_pop_front(test->list);
+    }
+
+    CTEST_ASSERT_INT_EQ(cutil_test_allocation_tracker_allocation_count(), 0);
+    CTEST_ASSERT_INT_EQ(cutil_test_allocation_tracker_free_count(), 0);
+
+    cutil_test_allocation_tracker_end();
+
+    CTEST_ASSERT_TRUE(cutil_unrolled_list_front(test->list, &value));
+    CTEST_ASSERT_INT_EQ(value, UNROLLED_LIST_TEST_COUNT * 9 + (int)cutil_unrolled_list_node_capacity(test->list));
+}
+
+typedef struct {
+    int sum;
+    int count;
+    int limit;
+} unrolled_list_foreach_visitor;
+
+int unrolled_list_foreach_visit(void* item, void* user_data) {
+    unrolled_list_foreach_visitor* visitor = (unrolled_list_foreach_visitor*)user_data;
+
+    visitor->sum += *(int*)item;
+    visitor->count += 1;
+
+    return visitor->count < visitor->limit;
+}
+
+void unrolled_list_foreach(unrolled_list_test* test) {
+    unrolled_list_foreach_visitor visitor;
+    int i;
+
+    memset(&visitor, 0, sizeof(visitor));
+    visitor.limit = UNROLLED_LIST_TEST_COUNT;
+    test->list = cutil_unrolled_list_create_with_node_size(cutil_trait_int(), 64);
+
+    CTEST_ASSERT_INT_EQ(cutil_unrolled_list_foreach(test->list, unrolled_list_foreach_visit, &visitor), 0);
+
+    for (i = 0; i < UNROLLED_LIST_TEST_COUNT; i++) {
+        cutil_unrolled_list_push_front(test->list, &i);
+    }
+
+    CTEST_ASSERT_INT_EQ(cutil_unrolled_list_foreach(test->list, unrolled_list_foreach_visit, &visitor), UNROLLED_LIST_TEST_COUNT);
+    CTEST_ASSERT_INT_EQ(visitor.sum, UNROLLED_LIST_TEST_COUNT * (UNROLLED_LIST_TEST_COUNT - 1) / 2);
+
+    memset(&visitor, 0, sizeof(visitor));
+    visitor.limit = 20;
+
+    CTEST_ASSERT_INT_EQ(cutil_unrolled_list_foreach(test->list, unrolled_list_foreach_visit, &visitor), 20);
+    CTEST_ASSERT_INT_EQ(visitor.count, 20);
+}
+
+void unrolled_list_itr_empty(unrolled_list_test* test) {
+    cutil_unrolled_list_itr* itr;
+    int value = 7;
+
+    test->list = cutil_unrolled_list_create(cutil_trait_int());
+    itr = cutil_unrolled_list_itr_create(test->list);
+
+    CTEST_ASSERT_FALSE(cutil_unrolled_list_itr_has_next(itr));
+    CTEST_ASSERT_FALSE(cutil_unrolled_list_itr_has_prev(itr));
+    CTEST_ASSERT_FALSE(cutil_unrolled_list_itr_next(itr, &value));
+    CTEST_ASSERT_FALSE(cutil_unrolled_list_itr_prev(itr, &value));
+    CTEST_ASSERT_INT_EQ(value, 7);
+
+    cutil_unrolled_list_itr_destroy(itr);
+}
+
+/* an iterator before the front of the list moves to the back when it is decremented */
+void unrolled_list_itr_prev_from_start(unrolled_list_test* test) {
+    cutil_unrolled_list_itr itr;
+    int i, value;
+
+    test->list = cutil_unrolled_list_create_with_node_size(cutil_trait_int(), 64);
+
+    for (i = 0; i < UNROLLED_LIST_TEST_COUNT; i++) {
+        cutil_unrolled_list_push_back(test->list, &i);
+    }
+
+    cutil_unrolled_list_itr_init(&itr, test->list);
+
+    CTEST_ASSERT_TRUE(cutil_unrolled_list_itr_prev(&itr, &value));
+    CTEST_ASSERT_INT_EQ(value, UNROLLED_LIST_TEST_COUNT - 1);
+    CTEST_ASSERT_FALSE(cutil_unrolled_list_itr_has_next(&itr));
+}
+
+void add_unrolled_list_tests() {
+    CTEST_ADD_TEST_F(unrolled_list, unrolled_list_create_node_size);
+    CTEST_ADD_TEST_F(unrolled_list, unrolled_list_push_back);
+    CTEST_ADD_TEST_F(unrolled_list, unrolled_list_push_front);
+    CTEST_ADD_TEST_F(unrolled_list, unrolled_list_push_both_ends);
+    CTEST_ADD_TEST_F(unrolled_list, unrolled_list_pop);
+    CTEST_ADD_TEST_F(unrolled_list, unrolled_list_trait_funcs);
+    CTEST_ADD_TEST_F(unrolled_list, unrolled_list_queue_no_allocation);
+    CTEST_ADD_TEST_F(unrolled_list, unrolled_list_foreach);
+    CTEST_ADD_TEST_F(unrolled_list, unrolled_list_itr_empty);
+    CTEST_ADD_TEST_F(unrolled_list, unrolled_list_itr_prev_from_start);
+}
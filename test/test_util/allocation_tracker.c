@@ -0,0 +1,72 @@
+#include "allocation_tracker.h"
+
+#include "cutil/allocator.h"
+
+#include <stddef.h>
+
+typedef struct {
+    cutil_allocator allocator;
+    cutil_allocator* tracked_allocator;
+    size_t allocation_count;
+    size_t free_count;
+} cutil_test_allocation_tracker;
+
+static cutil_test_allocation_tracker allocation_tracker;
+
+void* cutil_test_allocation_tracker_malloc(size_t count, void* user_data) {
+    cutil_allocator* tracked = allocation_tracker.tracked_allocator;
+    (void)user_data;
+
+    allocation_tracker.allocation_count += 1;
+    return tracked->malloc(count, tracked->user_data);
+}
+
+void* cutil_test_allocation_tracker_calloc(size_t count, size_t size, void* user_data) {
+    cutil_allocator* tracked = allocation_tracker.tracked_allocator;
+    (void)user_data;
+
+    allocation_tracker.allocation_count += 1;
+    return tracked->calloc(count, size, tracked->user_data);
+}
+
+void* cutil_test_allocation_tracker_realloc(void* ptr, size_t size, void* user_data) {
+    cutil_allocator* tracked = allocation_tracker.tracked_allocator;
+    (void)user_data;
+
+    allocation_tracker.allocation_count += 1;
+    return tracked->realloc(ptr, size, tracked->user_data);
+}
+
+void cutil_test_allocation_tracker_free(void* ptr, void* user_data) {
+    cutil_allocator* tracked = allocation_tracker.tracked_allocator;
+    (void)user_data;
+
+    allocation_tracker.free_count += 1;
+    tracked->free(ptr, tracked->user_data);
+}
+
+void cutil_test_allocation_tracker_begin() {
+    allocation_tracker.tracked_allocator = cutil_current_allocator();
+    allocation_tracker.allocation_count = 0;
+    allocation_tracker.free_count = 0;
+
+    allocation_tracker.allocator.malloc = cutil_test_allocation_tracker_malloc;
+    allocation_tracker.allocator.calloc = cutil_test_allocation_tracker_calloc;
+    allocation_tracker.allocator.realloc = cutil_test_allocation_tracker_realloc;
+    allocation_tracker.allocator.free = cutil_test_allocation_tracker_free;
+    allocation_tracker.allocator.user_data = NULL;
+
+    cutil_set_current_allocator(&allocation_tracker.allocator);
+}
+
+void cutil_test_allocation_tracker_end() {
+    cutil_set_current_allocator(allocation_tracker.tracked_allocator);
+}
+
+size_t cutil_test_allocation_tracker_allocation_count() {
+    return allocation_tracker.allocation_count;
+}
+
+size_t cutil_test_allocation_tracker_free_count() {
+    return allocation_tracker.free_count;
+}
@@ -0,0 +1,17 @@
+#ifndef TEST_ALLOCATION_TRACKER_H
+#define TEST_ALLOCATION_TRACKER_H
+
+#include <stddef.h>
+
+/*
+Installs an allocator which forwards to the current allocator while counting calls to it.
+The previous allocator is restored by cutil_test_allocation_tracker_end.
+*/
+void cutil_test_allocation_tracker_begin();
+void cutil_test_allocation_tracker_end();
+
+/* Returns the number of calls to malloc, calloc and realloc since the tracker began */
+size_t cutil_test_allocation_tracker_allocation_count();
+size_t cutil_test_allocation_tracker_free_count();
+
+#endif
@@ -0,0 +1,71 @@
+#include "thread.h"
+
+#include <stdlib.h>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+struct cutil_test_thread {
+    cutil_test_thread_func func;
+    void* arg;
+
+#ifdef _WIN32
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+};
+
+#ifdef _WIN32
+DWORD WINAPI _cutil_test_thread_entry(LPVOID param) {
+    cutil_test_thread* thread = (cutil_test_thread*)param;
+    thread->func(thread->arg);
+
+    return 0;
+}
+#else
+void* _cutil_test_thread_entry(void* param) {
+    cutil_test_thread* thread = (cutil_test_thread*)param;
+    thread->func(thread->arg);
+
+    return NULL;
+}
+#endif
+
+cutil_test_thread* cutil_test_thread_create(cutil_test_thread_func func, void* arg) {
+    cutil_test_thread* thread = malloc(sizeof(cutil_test_thread));
+    thread->func = func;
+    thread->arg = arg;
+
+#ifdef _WIN32
+    thread->handle = CreateThread(NULL, 0, _cutil_test_thread_entry, thread, 0, NULL);
+#else
+    pthread_create(&thread->handle, NULL, _cutil_test_thread_entry, thread);
+#endif
+
+    return thread;
+}
+
+void cutil_test_thread_join(cutil_test_thread* thread) {
+#ifdef _WIN32
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+#else
+    pthread_join(thread->handle, NULL);
+#endif
+
+    free(thread);
+}
+
+void cutil_test_thread_yield() {
+#ifdef _WIN32
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
@@ -0,0 +1,16 @@
+#ifndef TEST_THREAD_H
+#define TEST_THREAD_H
+
+typedef struct cutil_test_thread cutil_test_thread;
+typedef void (*cutil_test_thread_func)(void* arg);
+
+/* Starts a new thread running the supplied function. */
+cutil_test_thread* cutil_test_thread_create(cutil_test_thread_func func, void* arg);
+
+/* Waits for a thread to finish and frees all resources used by it. */
+void cutil_test_thread_join(cutil_test_thread* thread);
+
+/* Gives up the processor to another thread, allowing a thread that is waiting on another to let it make progress. */
+void cutil_test_thread_yield();
+
+#endif
@@ -31,6 +31,12 @@ void cutil_test_trait_tracker_destroy(void* item, void* user_data) {
     trait_tracker->tracked_trait->destroy_func(item, trait_tracker->tracked_trait->user_data);
 }
 
+size_t cutil_test_trait_tracker_hash(void* item, void* user_data) {
+    cutil_test_trait_tracker* trait_tracker = (cutil_test_trait_tracker*)user_data;
+
+    return trait_tracker->tracked_trait->hash_func(item, trait_tracker->tracked_trait->user_data);
+}
+
 cutil_trait* cutil_test_create_trait_tracker(cutil_trait* tracked_trait) {
     cutil_trait* trait = (cutil_trait*) calloc(1, sizeof(cutil_trait));
     cutil_test_trait_tracker* trait_tracker = calloc(1, sizeof(cutil_test_trait_tracker));
@@ -49,6 +55,10 @@ cutil_trait* cutil_test_create_trait_tracker(cutil_trait* tracked_trait) {
         trait->destroy_func = cutil_test_trait_tracker_destroy;
     }
 
+    if (tracked_trait->hash_func) {
+        trait->hash_func = cutil_test_trait_tracker_hash;
+    }
+
     trait->size = tracked_trait->size;
     trait->user_data = trait_tracker;
     
@@ -686,6 +686,72 @@ void comparison_on_vector_equals(vector_trait_func_test* test) {
     cutil_vector_destroy(vector2);
 }
 
+/* records the items visited by foreach, stopping once the limit is reached */
+typedef struct {
+    int items[10];
+    int count;
+    int limit;
+} vector_foreach_visitor;
+
+int vector_foreach_visit(void* item, void* user_data) {
+    vector_foreach_visitor* visitor = (vector_foreach_visitor*)user_data;
+
+    visitor->items[visitor->count++] = *(int*)item;
+
+    return visitor->count < visitor->limit;
+}
+
+void vector_foreach_empty(vector_test* test) {
+    vector_foreach_visitor visitor;
+
+    memset(&visitor, 0, sizeof(visitor));
+    visitor.limit = 10;
+    test->vector = cutil_vector_create(cutil_trait_int());
+
+    CTEST_ASSERT_INT_EQ(cutil_vector_foreach(test->vector, vector_foreach_visit, &visitor), 0);
+    CTEST_ASSERT_INT_EQ(visitor.count, 0);
+}
+
+void vector_foreach_all(vector_test* test) {
+    vector_foreach_visitor visitor;
+    int i;
+
+    memset(&visitor, 0, sizeof(visitor));
+    visitor.limit = 10;
+    test->vector = cutil_vector_create(cutil_trait_int());
+
+    for (i = 0; i < 10; i++) {
+        cutil_vector_push_back(test->vector, &i);
+    }
+
+    CTEST_ASSERT_INT_EQ(cutil_vector_foreach(test->vector, vector_foreach_visit, &visitor), 10);
+    CTEST_ASSERT_INT_EQ(visitor.count, 10);
+
+    for (i = 0; i < 10; i++) {
+        CTEST_ASSERT_INT_EQ(visitor.items[i], i);
+    }
+}
+
+void vector_foreach_early_exit(vector_test* test) {
+    vector_foreach_visitor visitor;
+    int i;
+
+    memset(&visitor, 0, sizeof(visitor));
+    visitor.limit = 3;
+    test->vector = cutil_vector_create(cutil_trait_int());
+
+    for (i = 0; i < 10; i++) {
+        cutil_vector_push_back(test->vector, &i);
+    }
+
+    CTEST_ASSERT_INT_EQ(cutil_vector_foreach(test->vector, vector_foreach_visit, &visitor), 3);
+    CTEST_ASSERT_INT_EQ(visitor.count, 3);
+
+    for (i = 0; i < 3; i++) {
+        CTEST_ASSERT_INT_EQ(visitor.items[i], i);
+    }
+}
+
 void add_vector_tests(){
     CTEST_ADD_TEST_F(vector, init_size_0_vec);
     CTEST_ADD_TEST_F(vector, empty_vec);
@@ -739,4 +805,8 @@ void add_vector_tests(){
     CTEST_ADD_TEST_F(vector_trait_func, destroy_on_vec_remove);
 
     CTEST_ADD_TEST_F(vector_trait_func, comparison_on_vector_equals);
+
+    CTEST_ADD_TEST_F(vector, vector_foreach_empty);
+    CTEST_ADD_TEST_F(vector, vector_foreach_all);
+    CTEST_ADD_TEST_F(vector, vector_foreach_early_exit);
 }